@@ -12,12 +12,24 @@ import { CryptoContext, EncryptionLevel, PacketNumberSpace } from '../crypto/cry
 import { HeaderType } from "../packet/header/base.header";
 import { EndpointType } from "../types/endpoint.type";
 import { PacketNumber } from "../packet/header/header.properties";
+import { InitialPacket } from "../packet/packet/initial";
+import { PacketFactory } from "../utilities/factories/packet.factory";
+import { HandshakeState } from "../crypto/qtls";
+import { TransportParameterId } from "../crypto/transport.parameters";
+import { FlowControl } from "../flow-control/flow.control";
+import { BaseEncryptedPacket } from "../packet/base.encrypted.packet";
+import { FrameType } from "../frame/base.frame";
 
 
 export class CongestionControl extends EventEmitter {
 
     private connection: Connection;
+    // new packets are pulled from FlowControl only when the congestion window has room for them
+    private flowControl: FlowControl;
+    // packets that were built before they could be sent (e.g., retransmissions, or control packets while the window is full)
     private packetsQueue: BasePacket[];
+    // true while the application is filling a send opportunity: if it calls sendPackets() itself, we don't ask it again from there
+    private offeringSendOpportunity: boolean = false;
 
     ///////////////////////////
     // Constants of interest
@@ -53,9 +65,10 @@ export class CongestionControl extends EventEmitter {
     // the number of bytes acknowledged.
     private sshtresh: Bignum;
 
-    public constructor(connection: Connection, lossDetectionInstances: Array<LossDetection>) {
+    public constructor(connection: Connection, flowControl: FlowControl, lossDetectionInstances: Array<LossDetection>) {
         super();
         this.connection = connection;
+        this.flowControl = flowControl;
         this.congestionWindow = new Bignum(CongestionControl.INITIAL_WINDOW);
         this.bytesInFlight = new Bignum(0);
         this.endOfRecovery = new Bignum(0);
@@ -73,8 +86,11 @@ export class CongestionControl extends EventEmitter {
             lossDetection.on(LossDetectionEvents.PACKETS_LOST, (lostPackets: BasePacket[]) => {
                 this.onPacketsLost(lostPackets);
             });
-            lossDetection.on(LossDetectionEvents.RETRANSMISSION_TIMEOUT_VERIFIED, () => {
-                this.onRetransmissionTimeoutVerified();
+            lossDetection.on(LossDetectionEvents.PACKETS_RETIRED, (retiredPackets: BasePacket[]) => {
+                this.onPacketsRetired(retiredPackets);
+            });
+            lossDetection.on(LossDetectionEvents.PERSISTENT_CONGESTION, () => {
+                this.onPersistentCongestion();
             });
         }
     }
@@ -86,9 +102,7 @@ export class CongestionControl extends EventEmitter {
 
     private onPacketSent(packetSent: BasePacket) {
         if (!packetSent.isAckOnly()) {
-            let bytesSent = packetSent.getBufferedByteLength();
-            if( bytesSent < 0 )
-                bytesSent = packetSent.toBuffer(this.connection).byteLength;
+            let bytesSent = this.getPacketByteSize(packetSent);
 
             // Add bytes sent to bytesInFlight.
             this.bytesInFlight = this.bytesInFlight.add(bytesSent);
@@ -100,9 +114,7 @@ export class CongestionControl extends EventEmitter {
         if (ackedPacket.isAckOnly())
             return;
 
-        let packetByteSize = ackedPacket.getBufferedByteLength();
-        if( packetByteSize < 0) 
-            packetByteSize = ackedPacket.toBuffer(this.connection).byteLength;
+        let packetByteSize = this.getPacketByteSize(ackedPacket);
 
         // Remove from bytesInFlight.
         this.bytesInFlight = this.bytesInFlight.subtract(packetByteSize);
@@ -117,7 +129,9 @@ export class CongestionControl extends EventEmitter {
             // Congestion avoidance
             this.congestionWindow = this.congestionWindow.add(new Bignum(CongestionControl.DEFAULT_MSS * packetByteSize).divide(this.congestionWindow));
         }
-        this.sendPackets();
+        // this is called while the ACK frame is still being processed, so we only flush what was already queued
+        // new data is pulled when the connection calls sendPackets() after it's done with the incoming packet
+        this.sendQueuedPackets();
     }
 
     // TODO: REFACTOR: largestLost shouldn't be done on packet number basis since we have separate pn-spaces now! 
@@ -127,9 +141,7 @@ export class CongestionControl extends EventEmitter {
             if (lostPacket.isAckOnly())
                 return;
 
-            var packetByteSize = lostPacket.getBufferedByteLength();
-            if( packetByteSize < 0 )
-                packetByteSize = lostPacket.toBuffer(this.connection).byteLength;
+            var packetByteSize = this.getPacketByteSize(lostPacket);
                 
             // Remove lost packets from bytesInFlight.
             this.bytesInFlight = this.bytesInFlight.subtract(packetByteSize);
@@ -145,30 +157,121 @@ export class CongestionControl extends EventEmitter {
             this.congestionWindow = Bignum.max(this.congestionWindow, CongestionControl.MINIMUM_WINDOW);
             this.sshtresh = this.congestionWindow;
         }
-        this.sendPackets();
+        this.sendQueuedPackets();
     }
 
-    private onRetransmissionTimeoutVerified() {
+    // packets that are no longer tracked by loss detection, but were neither acked nor lost (e.g., re-sent as PTO probes)
+    // they simply stop counting towards bytesInFlight, without any congestion response
+    private onPacketsRetired(retiredPackets: BasePacket[]) {
+        retiredPackets.forEach((retiredPacket: BasePacket) => {
+            if (retiredPacket.isAckOnly())
+                return;
+
+            let packetByteSize = this.getPacketByteSize(retiredPacket);
+
+            this.bytesInFlight = this.bytesInFlight.subtract(packetByteSize);
+        });
+        this.sendQueuedPackets();
+    }
+
+    // only on persistent congestion (a long run of consecutive losses), not on every timeout like the old RTO logic
+    private onPersistentCongestion() {
         this.congestionWindow = new Bignum(CongestionControl.MINIMUM_WINDOW);
     }
 
 
     public queuePackets(packets: BasePacket[]) {
         this.packetsQueue = this.packetsQueue.concat(packets);
-        this.sendPackets();
+        this.sendQueuedPackets();
     }
 
-    private sendPackets() {
-        // TODO: allow coalescing of certain packets:
-        // https://tools.ietf.org/html/draft-ietf-quic-transport-12#section-4.6
+    /**
+     * Sends everything that is allowed to go out right now. 
+     * Packets that were queued before go first. After that, new packets are pulled from FlowControl one at a time, for as long as the congestion window has room for them.
+     * STREAM data is only framed at that moment, so data that can't be sent yet stays in the streams' buffers instead of in our queue.
+     */
+    public sendPackets() {
+        this.sendQueuedPackets();
+        if( this.packetsQueue.length > 0 ){
+            // window is full, no use building new packets: they would only end up in the queue
+            return;
+        }
+
+        let firstPull = true;
+        while( true ){
+            let streamDataBudget = this.getStreamDataBudget();
+
+            // the first pull is always done, even without budget: ACK, CRYPTO and flow control frames are not held back by the congestion window at this stage
+            if( !firstPull && streamDataBudget === 0 )
+                break;
+            firstPull = false;
+
+            // the application can write more data now, so it's packetized in this same pull (see Connection:offerSendOpportunity)
+            if( streamDataBudget > 0 && !this.offeringSendOpportunity ){
+                this.offeringSendOpportunity = true;
+                try {
+                    this.connection.offerSendOpportunity(streamDataBudget);
+                }
+                finally {
+                    this.offeringSendOpportunity = false;
+                }
+            }
+
+            let packets = this.flowControl.getPackets(streamDataBudget);
+            if( packets.length === 0 )
+                break;
+
+            this.packetsQueue = this.packetsQueue.concat(packets);
+            this.sendQueuedPackets();
+
+            // if we didn't get any stream data this time, there's nothing left (or everything's blocked by flow control): asking again won't help
+            if( this.packetsQueue.length > 0 || !this.containsStreamData(packets) )
+                break;
+        }
+    }
+
+    // how much STREAM data we're willing to have packetized right now
+    // we only pull new data when at least a full packet fits in the window, to prevent sending lots of small packets when the window opens up bit by bit
+    private getStreamDataBudget(): number {
+        let available = this.congestionWindow.subtract(this.bytesInFlight);
+        let minimum = Math.min( this.getMaxDatagramSize(), CongestionControl.DEFAULT_MSS );
+        if( available.lessThan(minimum) )
+            return 0;
+        return available.toNumber();
+    }
+
+    private containsStreamData(packets: BasePacket[]): boolean {
+        for( let packet of packets ){
+            if( packet.getPacketType() === PacketType.VersionNegotiation || packet.getPacketType() === PacketType.Retry )
+                continue;
+
+            let frames = (<BaseEncryptedPacket> packet).getFrames();
+            for( let frame of frames ){
+                if( frame.getType() >= FrameType.STREAM && frame.getType() <= FrameType.STREAM_MAX_NR )
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    private sendQueuedPackets() {
+        // Packets are coalesced into as few UDP datagrams as possible:
+        // https://tools.ietf.org/html/draft-ietf-quic-transport#section-12.2
+        // FlowControl hands us packets in order of encryption level (Initial, 0-RTT, Handshake, 1-RTT), which is also the order they need to be in inside a datagram
+        let datagram = new Array<BasePacket>();
+        let datagramSize = 0;
+        // the packets in the datagram only count towards bytesInFlight once it's sent, but they do have to fit in the congestion window
+        let datagramInFlight = 0;
+        let maxDatagramSize = this.getMaxDatagramSize();
 
         while (this.packetsQueue.length > 0) {
             let packet: BasePacket | undefined = this.packetsQueue[0];
             if (packet !== undefined) {
 
                 if( !packet.isAckOnly() ){
-                    if( this.bytesInFlight.greaterThanOrEqual(this.congestionWindow) ){
-                        VerboseLogging.warn("CongestionController:sendPackets: congestion window is full! Packets will not be sent until it goes down. # queued: " + this.packetsQueue.length + " : bytes in flight  : " + this.bytesInFlight.toDecimalString() + " >= " + this.congestionWindow.toDecimalString());
+                    let inFlight = this.bytesInFlight.add(datagramInFlight);
+                    if( inFlight.greaterThanOrEqual(this.congestionWindow) ){
+                        VerboseLogging.warn("CongestionController:sendPackets: congestion window is full! Packets will not be sent until it goes down. # queued: " + this.packetsQueue.length + " : bytes in flight  : " + inFlight.toDecimalString() + " >= " + this.congestionWindow.toDecimalString());
                         break;
                     }
                 }
@@ -191,122 +294,174 @@ export class CongestionControl extends EventEmitter {
                     VerboseLogging.info("CongestionControl:sendPackets : PN space \"" + PacketType[ packet.getPacketType() ] + "\" TX is now at " + pnSpace.DEBUGgetCurrent() + " (RX = " + DEBUGrxNumber + ")" );
                 }
 
-                let pktNumber = packet.getHeader().getPacketNumber();
-
-                if( Constants.DEBUG_fakeReorder && packet.getPacketType() == PacketType.Handshake && this.connection.getEndpointType() == EndpointType.Client ){
-                    // this test case delays the client's handshake packets
-                    // this leads to 1RTT requests being sent before handshake CLIENT_FINISHED
-                    // server should buffer the 1RTT request until the handshake is done before replying
-                    // TODO: move this type of test out of congestion-control into its own thing
-                    //  FIXME: probably best not to set things directly onto the socket in CongestionControl either... 
-
-                    VerboseLogging.warn("CongestionControl:sendPackets : DEBUGGING REORDERED Handshake DATA! Disable this for normal operation!");
-                    let delayedPacket = packet;
-
-                    // Robin start hier//
-                    // kijk in server logs: opeens sturen we STREAM data in een Handshake packet... geen flauw idee waarom
-                    setTimeout( () => {
-                        VerboseLogging.warn("CongestionControl:fake-reorder: sending actual Handshake after delay, should arrive after 1-RTT");
-                        this.connection.getSocket().send(delayedPacket.toBuffer(this.connection), this.connection.getRemoteInformation().port, this.connection.getRemoteInformation().address);
-                    
-                        this.onPacketSent(delayedPacket as BasePacket);    
-                        this.emit(CongestionControlEvents.PACKET_SENT, delayedPacket);
-                    }, 500);
-                }
-                else if( Constants.DEBUG_lossAndDuplicatesInHandshake &&
-                         packet.getHeader().getHeaderType() == HeaderType.LongHeader ){
-
-                    // Testing problems during the handshake
-                    // we do this differently from 1RTT because we want to have a bit more control of what we drop + handshake problems are often way worse than 1RTT problems
-                    if( pktNumber && pktNumber.getValue().toNumber() < 1 && this.connection.getEndpointType() == EndpointType.Server ){
-                        // drop all first packets from the server 
-
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                        VerboseLogging.error("CongestionControl:sendPackets : artificially DROPPING LONG HEADER PACKET : #" + ( pktNumber ? pktNumber.getValue().toNumber() : "VNEG|RETRY") + " @ " + ( ctx ? ctx!.getAckHandler().DEBUGname : "?") );
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-
-                        this.onPacketSent(packet);
-                        this.emit(CongestionControlEvents.PACKET_SENT, packet);
-                    }
-                    else if( pktNumber && pktNumber.getValue().toNumber() < 1 && this.connection.getEndpointType() == EndpointType.Client ){
-                        // all first packets from the client ARE sent correctly
-                        VerboseLogging.info("CongestionControl:sendPackets : actually sending packet : #" + ( pktNumber ? pktNumber.getValue().toNumber() : "VNEG|RETRY") );
-                        this.connection.getSocket().send(packet.toBuffer(this.connection), this.connection.getRemoteInformation().port, this.connection.getRemoteInformation().address);
-                    
-                        this.onPacketSent(packet);
-                        this.emit(CongestionControlEvents.PACKET_SENT, packet);
-
-                        /*
-                        setTimeout( () => {
-
-                            let ctx:CryptoContext|undefined = this.connection.getEncryptionContextByPacketType( packet!.getPacketType() );
-
-                            VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                            VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                            VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                            VerboseLogging.error("CongestionControl:sendPackets : artificially RE-SENDING LONG HEADER PACKET : #" + ( pktNumber ? pktNumber.getValue().toNumber() : "VNEG|RETRY") + " @ " + ( ctx ? ctx!.getAckHandler().DEBUGname : "?") );
-                            VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                            VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                            VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-
-                            packet!.getHeader().setPacketNumber( ctx!.getPacketNumberSpace().getNext(), new PacketNumber( new Bignum(0) ));
-                            this.connection.getSocket().send(packet!.toBuffer(this.connection), this.connection.getRemoteInformation().port, this.connection.getRemoteInformation().address);
-
-
-                            this.onPacketSent(packet);
-                            this.emit(CongestionControlEvents.PACKET_SENT, packet);
-                        }, 500);
-                        */
-                    }
-                    else{
-                        VerboseLogging.info("CongestionControl:sendPackets : actually sending packet : #" + ( pktNumber ? pktNumber.getValue().toNumber() : "VNEG|RETRY") );
-                        this.connection.getSocket().send(packet.toBuffer(this.connection), this.connection.getRemoteInformation().port, this.connection.getRemoteInformation().address);
-                    
-                        this.onPacketSent(packet);
-                        this.emit(CongestionControlEvents.PACKET_SENT, packet);
-                    }
+                if( this.sendPacketDEBUG(packet, ctx) )
+                    continue;
+
+                // NORMAL BEHAVIOUR
+                // we can only add a packet to the datagram if it fits, and if the previous packet has a long header (a short header packet has no length field, so it has to be last)
+                let packetSize = this.getEstimatedPacketSize(packet);
+                let canCoalesce = ctx !== undefined && datagram.length > 0 && 
+                                  datagram[datagram.length - 1].getHeader().getHeaderType() === HeaderType.LongHeader &&
+                                  datagramSize + packetSize <= maxDatagramSize;
+
+                if( !canCoalesce && datagram.length > 0 ){
+                    this.sendDatagram(datagram);
+                    datagram = [];
+                    datagramSize = 0;
+                    datagramInFlight = 0;
                 }
-                else if( Constants.DEBUG_1RTT_packetLoss_ratio > 0 &&
-                         packet.getHeader().getHeaderType() == HeaderType.ShortHeader ){
-
-                    // dropping random 1RTT data packets 
-                    let drop = Math.random() < Constants.DEBUG_1RTT_packetLoss_ratio;
-
-                    
-                    if( drop ){
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                        VerboseLogging.error("CongestionControl:sendPackets : artificially DROPPING 1RTT PACKET : #" + ( pktNumber ? pktNumber.getValue().toNumber() : "VNEG|RETRY") + " @ " + ( ctx ? ctx!.getAckHandler().DEBUGname : "?") );
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-                        VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
-
-                        this.onPacketSent(packet);
-                        this.emit(CongestionControlEvents.PACKET_SENT, packet);
-                    }
-                    else{
-                        VerboseLogging.info("CongestionControl:sendPackets : actually sending packet : #" + ( pktNumber ? pktNumber.getValue().toNumber() : "VNEG|RETRY") );
-                        this.connection.getSocket().send(packet.toBuffer(this.connection), this.connection.getRemoteInformation().port, this.connection.getRemoteInformation().address);
-                    
-                        this.onPacketSent(packet);
-                        this.emit(CongestionControlEvents.PACKET_SENT, packet);
-                    }
+
+                datagram.push(packet);
+                datagramSize += packetSize;
+                if( !packet.isAckOnly() )
+                    datagramInFlight += packetSize;
+
+                // VNEG and retry packets are always sent on their own
+                if( ctx === undefined ){
+                    this.sendDatagram(datagram);
+                    datagram = [];
+                    datagramSize = 0;
+                    datagramInFlight = 0;
                 }
-                else{
-                    // NORMAL BEHAVIOUR
-                    VerboseLogging.info("CongestionControl:sendPackets : actually sending packet : #" + ( pktNumber ? pktNumber.getValue().toNumber() : "VNEG|RETRY") );
-                    this.connection.getSocket().send(packet.toBuffer(this.connection), this.connection.getRemoteInformation().port, this.connection.getRemoteInformation().address);
-                
-                    this.onPacketSent(packet);    
-                    this.emit(CongestionControlEvents.PACKET_SENT, packet);
-                }                    
             }
         }
+
+        if( datagram.length > 0 )
+            this.sendDatagram(datagram);
+    }
+
+    private getMaxDatagramSize(): number {
+        // we only know the peer's max_packet_size after the handshake
+        if( this.connection.getQuicTLS().getHandshakeState() === HandshakeState.COMPLETED )
+            return this.connection.getRemoteTransportParameter(TransportParameterId.MAX_PACKET_SIZE);
+        else
+            return Constants.DEFAULT_MAX_PACKET_SIZE;
+    }
+
+    // size of the packet after encryption. Needs to be called after the packet number is set, since that influences the header size
+    private getEstimatedPacketSize(packet: BasePacket): number {
+        if( packet.getHeader().getPacketNumber() === undefined )
+            return packet.getSize();
+        else
+            return packet.getSize() + Constants.DEFAULT_AEAD_LENGTH;
+    }
+
+    // packets we've sent know their encrypted size. For others, we estimate, instead of encrypting the packet just to know how large it is
+    private getPacketByteSize(packet: BasePacket): number {
+        let size = packet.getBufferedByteLength();
+        if( size < 0 )
+            size = this.getEstimatedPacketSize(packet);
+        return size;
+    }
+
+    private sendDatagram(packets: BasePacket[]) {
+        // client: datagrams carrying an ack-eliciting Initial packet need to be at least 1200 bytes (to prevent amplification attacks)
+        // the Initial packet is padded, but only as much as the other packets in the same datagram don't already make up for
+        // https://tools.ietf.org/html/draft-ietf-quic-transport#section-14
+        if( this.connection.getEndpointType() === EndpointType.Client ){
+            let initial:InitialPacket|undefined = undefined;
+            let datagramSize = 0;
+            for( let packet of packets ){
+                if( packet.getPacketType() === PacketType.Initial && !packet.isAckOnly() && initial === undefined )
+                    initial = <InitialPacket> packet;
+                datagramSize += this.getEstimatedPacketSize(packet);
+            }
+
+            if( initial !== undefined && datagramSize < Constants.INITIAL_MIN_SIZE )
+                PacketFactory.padInitialPacket( initial, Constants.INITIAL_MIN_SIZE - datagramSize );
+        }
+
+        let buffers = new Array<Buffer>();
+        for( let packet of packets ){
+            let pktNumber = packet.getHeader().getPacketNumber();
+            VerboseLogging.info("CongestionControl:sendPackets : actually sending packet : #" + ( pktNumber ? pktNumber.getValue().toNumber() : "VNEG|RETRY") );
+            buffers.push( packet.toBuffer(this.connection) );
+        }
+
+        if( packets.length > 1 )
+            VerboseLogging.info("CongestionControl:sendDatagram : coalesced " + packets.length + " packets into a single datagram");
+
+        this.connection.getSocket().send(Buffer.concat(buffers), this.connection.getRemoteInformation().port, this.connection.getRemoteInformation().address);
+
+        for( let packet of packets ){
+            this.onPacketSent(packet);    
+            this.emit(CongestionControlEvents.PACKET_SENT, packet);
+        }
+    }
+
+    // testing hooks that delay or drop packets. Returns true if the packet was handled here
+    // these packets are always sent in their own datagram
+    private sendPacketDEBUG(packet: BasePacket, ctx: CryptoContext|undefined): boolean {
+        let pktNumber = packet.getHeader().getPacketNumber();
+
+        if( Constants.DEBUG_fakeReorder && packet.getPacketType() == PacketType.Handshake && this.connection.getEndpointType() == EndpointType.Client ){
+            // this test case delays the client's handshake packets
+            // this leads to 1RTT requests being sent before handshake CLIENT_FINISHED
+            // server should buffer the 1RTT request until the handshake is done before replying
+            // TODO: move this type of test out of congestion-control into its own thing
+            //  FIXME: probably best not to set things directly onto the socket in CongestionControl either... 
+
+            VerboseLogging.warn("CongestionControl:sendPackets : DEBUGGING REORDERED Handshake DATA! Disable this for normal operation!");
+            let delayedPacket = packet;
+
+            // Robin start hier//
+            // kijk in server logs: opeens sturen we STREAM data in een Handshake packet... geen flauw idee waarom
+            setTimeout( () => {
+                VerboseLogging.warn("CongestionControl:fake-reorder: sending actual Handshake after delay, should arrive after 1-RTT");
+                this.sendDatagram([delayedPacket]);
+            }, 500);
+            return true;
+        }
+        else if( Constants.DEBUG_lossAndDuplicatesInHandshake &&
+                 packet.getHeader().getHeaderType() == HeaderType.LongHeader ){
+
+            // Testing problems during the handshake
+            // we do this differently from 1RTT because we want to have a bit more control of what we drop + handshake problems are often way worse than 1RTT problems
+            if( pktNumber && pktNumber.getValue().toNumber() < 1 && this.connection.getEndpointType() == EndpointType.Server ){
+                // drop all first packets from the server 
+
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+                VerboseLogging.error("CongestionControl:sendPackets : artificially DROPPING LONG HEADER PACKET : #" + ( pktNumber ? pktNumber.getValue().toNumber() : "VNEG|RETRY") + " @ " + ( ctx ? ctx!.getAckHandler().DEBUGname : "?") );
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+
+                this.onPacketSent(packet);
+                this.emit(CongestionControlEvents.PACKET_SENT, packet);
+            }
+            else {
+                // all first packets from the client ARE sent correctly, as are all later packets
+                this.sendDatagram([packet]);
+            }
+            return true;
+        }
+        else if( Constants.DEBUG_1RTT_packetLoss_ratio > 0 &&
+                 packet.getHeader().getHeaderType() == HeaderType.ShortHeader ){
+
+            // dropping random 1RTT data packets 
+            let drop = Math.random() < Constants.DEBUG_1RTT_packetLoss_ratio;
+
+            if( drop ){
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+                VerboseLogging.error("CongestionControl:sendPackets : artificially DROPPING 1RTT PACKET : #" + ( pktNumber ? pktNumber.getValue().toNumber() : "VNEG|RETRY") + " @ " + ( ctx ? ctx!.getAckHandler().DEBUGname : "?") );
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+                VerboseLogging.error("///////////////////////////////////////////////////////////////////////////////////////////////");
+
+                this.onPacketSent(packet);
+                this.emit(CongestionControlEvents.PACKET_SENT, packet);
+            }
+            else{
+                this.sendDatagram([packet]);
+            }
+            return true;
+        }
+
+        return false;
     }
 }
 
@@ -31,7 +31,10 @@ export enum TransportParameterId {
 
     DISABLE_MIGRATION                   = 0x000c, // boolean to disable migration-related features
     PREFERRED_ADDRESS                   = 0x000d, // server address to switch to after completing handshake // UPDATE-12 TODO: actually use this in the implementation somewhere 
-    ACTIVE_CONNECTION_ID_LIMIT          = 0x000e  // The maximum number of connection IDs from the peer that an endpoint is willing to store
+    ACTIVE_CONNECTION_ID_LIMIT          = 0x000e, // The maximum number of connection IDs from the peer that an endpoint is willing to store
+
+    // extensions
+    MIN_ACK_DELAY                       = 0xde1a  // delayed ACK extension: minimum amount of MICROseconds this endpoint can delay acks. If present, the peer may send us ACK_FREQUENCY frames
 }
 
 enum TransportParameterType{
@@ -62,6 +65,8 @@ enum TransportParameterTypeLookup{
     DISABLE_MIGRATION                   = TransportParameterType.boolean,
     PREFERRED_ADDRESS                   = TransportParameterType.Buffer,
     ACTIVE_CONNECTION_ID_LIMIT          = TransportParameterType.uint64,
+
+    MIN_ACK_DELAY                       = TransportParameterType.uint64,
 }
 
 /**
@@ -545,6 +550,8 @@ export class TransportParameters {
         transportParameters.setTransportParameter(TransportParameterId.ACK_DELAY_EXPONENT,                      Constants.DEFAULT_ACK_DELAY_EXPONENT);
         transportParameters.setTransportParameter(TransportParameterId.MAX_ACK_DELAY,                           Constants.DEFAULT_MAX_ACK_DELAY);
         transportParameters.setTransportParameter(TransportParameterId.ACTIVE_CONNECTION_ID_LIMIT,              Constants.DEFAULT_ACTIVE_CONNECTION_ID_LIMIT);
+        if (Constants.ACK_FREQUENCY_ENABLED)
+            transportParameters.setTransportParameter(TransportParameterId.MIN_ACK_DELAY,                       Constants.DEFAULT_MIN_ACK_DELAY);
         
         if( Constants.DEFAULT_DISABLE_MIGRATION )
             transportParameters.setTransportParameter(TransportParameterId.DISABLE_MIGRATION,                   Constants.DEFAULT_DISABLE_MIGRATION);
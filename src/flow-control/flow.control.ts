@@ -2,7 +2,7 @@ import { ConnectionErrorCodes } from '../utilities/errors/quic.codes';
 import { QuicError } from '../utilities/errors/connection.error';
 import { Bignum } from '../types/bignum';
 import { Connection, ConnectionState } from '../quicker/connection';
-import { Stream } from '../quicker/stream';
+import { Stream, StreamType } from '../quicker/stream';
 import { BasePacket, PacketType } from '../packet/base.packet';
 import { StreamFrame } from '../frame/stream';
 import { CryptoFrame } from '../frame/crypto';
@@ -19,13 +19,14 @@ import { TransportParameterId } from '../crypto/transport.parameters';
 import { Constants } from '../utilities/constants';
 import { HandshakeState } from '../crypto/qtls';
 import { CryptoStream } from '../crypto/crypto.stream';
-import { EncryptionLevel } from '../crypto/crypto.context';
+import { EncryptionLevel, CryptoContext } from '../crypto/crypto.context';
 import { EndpointType } from '../types/endpoint.type';
 import { Time, TimeFormat } from '../types/time';
 import { ShortHeader } from '../packet/header/short.header';
 import { AckHandler } from '../utilities/handlers/ack.handler';
 import { PacketNumber } from '../packet/header/header.properties';
 import { VerboseLogging } from '../utilities/logging/verbose.logging';
+import { VLIE } from '../types/vlie';
 
 
 export class FlowControl {
@@ -49,10 +50,13 @@ export class FlowControl {
     private shortHeaderSize!: number;
     private connection: Connection;
     private bufferedFrames: BaseFrame[];
+    // control frames that can only be sent in 1-RTT packets (see queueControlFrame)
+    private pendingControlFrames: BaseFrame[];
 
     public constructor(connection: Connection) {
         this.connection = connection;
         this.bufferedFrames = [];
+        this.pendingControlFrames = [];
     }
 
     public queueFrame(baseFrame: BaseFrame): void {
@@ -62,6 +66,13 @@ export class FlowControl {
         this.bufferedFrames.push(baseFrame);
     }
 
+    // For frames that belong in 1-RTT packets (e.g., ACK_FREQUENCY): they wait until we can send 1-RTT packets and always end up in one,
+    // so they are retransmitted along with the rest of that packet if it is lost
+    public queueControlFrame(baseFrame: BaseFrame): void {
+        VerboseLogging.info("FlowControl:queueControlFrame : queueing 1-RTT control frame " + FrameType[baseFrame.getType()] );
+        this.pendingControlFrames.push(baseFrame);
+    }
+
     public isAckBuffered(): boolean {
         var containsAck = false;
         this.bufferedFrames.forEach((baseFrame: BaseFrame) => {
@@ -72,7 +83,14 @@ export class FlowControl {
         return containsAck;
     }   
 
-    public getPackets(): BasePacket[] {
+    /**
+     * Builds the packets that can be sent right now. This is called by CongestionControl whenever it can send something (pull-based):
+     * stream data is only taken out of the streams' send buffers at that moment, so data that doesn't fit the congestion window
+     * simply stays in its stream (instead of piling up as already-framed packets) and is framed with up-to-date offsets and priorities once the window opens
+     * @param streamDataBudget maximum amount of bytes of STREAM frames to pull from the streams. This is capped to a single packet's payload
+     *  ACK, CRYPTO and flow control frames are not limited by this budget: they are always included
+     */
+    public getPackets(streamDataBudget: number): BasePacket[] {
         var packets = new Array<BasePacket>();
 
         // TODO: calculate maxpacketsize better
@@ -85,144 +103,130 @@ export class FlowControl {
                 shortHeaderMax.setPacketNumber( new PacketNumber( new Bignum(0x0fffffff) ), new PacketNumber(new Bignum(0)) );
                 this.shortHeaderSize = shortHeaderMax.getSize();
             }
-            var maxPayloadSize = new Bignum(this.connection.getRemoteTransportParameter(TransportParameterId.MAX_PACKET_SIZE) - this.shortHeaderSize);
+            // the AEAD tag is added to the payload when encrypting, so it has to fit in the packet as well
+            var maxPayloadSize = new Bignum(this.connection.getRemoteTransportParameter(TransportParameterId.MAX_PACKET_SIZE) - this.shortHeaderSize - Constants.DEFAULT_AEAD_LENGTH);
         }
         
-        var frames = this.getFrames(maxPayloadSize);
-        var packetFrames = new Array<BaseFrame>();
-        var size = new Bignum(0);
-
+        var frames = this.getFrames(maxPayloadSize, Math.min(streamDataBudget, maxPayloadSize.toNumber()));
 
         var ackBuffered: boolean = this.isAckBuffered();
         if( ackBuffered )
             VerboseLogging.error("FlowControl:getPackets: we had buffered ack packets! SHOULD NOT HAPPEN!");
 
-        /*
-        if ( !this.connection.connectionIsClosingOrClosed() ) {
-            var ackFrame = this.ackHandler.getAckFrame(this.connection);
-            if (ackFrame !== undefined) {
-                packets.push(this.createNewPacket([ackFrame]));
-                packetFrames.push( ackFrame );
-            }
-        }
-        */
-
         if( frames.handshakeFrames.length > 0 ){
             VerboseLogging.error("FlowControl:getPackets : data shouldn't be in stream 0 anymore!!! !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!");
         }
-        else{
-            let DEBUGcryptoFrameCount:number = 0;
-            let DEBUGackFrameCount:number = 0;
-            // getCryptoStreamFrames' output is already scaled to maxPayloadSize, so we create a single packet per frame
-            // TODO: this is sub-optimal if we can add things like flow control or 0-RTT requests in the same packet : enable that! 
-            // logic below uses an array they fill with frames, maybe move that up to above? 
-
-            // REFACTOR TODO: should only send 3 handshake packets without client address validation
-            // https://tools.ietf.org/html/draft-ietf-quic-transport#section-4.4.3
-            // REFACTOR TODO: allow coalescing of ACKS together with other packets of the same encryption level
-            let initCTX = this.connection.getEncryptionContext(EncryptionLevel.INITIAL);
-            let cfrs = this.getCryptoStreamFrames( initCTX!.getCryptoStream(), maxPayloadSize );
-            DEBUGcryptoFrameCount += cfrs.length;
-            for( let frame of cfrs )
-                packets.push( PacketFactory.createInitialPacket(this.connection, [frame]) );
-            let ackframe = initCTX!.getAckHandler().getAckFrame(this.connection);
-            if( ackframe !== undefined ){
-                if( this.connection.getAEAD().canClearTextEncrypt(this.connection.getEndpointType()) ){
-                    DEBUGackFrameCount++;
-                    packets.push(PacketFactory.createInitialPacket(this.connection, [ackframe]));
-                }
-                else
-                    VerboseLogging.error("FlowControl:getPackets : cannot encrypt initial packets yet! TODO: buffer, dropping for now");
-            }
 
+        // Per encryption level, we bundle the ACK frame together with the CRYPTO frames (and for 1-RTT also the STREAM and flow control frames) in as few packets as possible
+        // CongestionControl then coalesces the resulting packets of the different encryption levels into as few UDP datagrams as possible (see CongestionControl:sendPackets)
+        // The order here (Initial, 0-RTT, Handshake, 1-RTT) is important: a short header packet has to be the last one in a datagram
 
-            let zeroCTX = this.connection.getEncryptionContext(EncryptionLevel.ZERO_RTT);
-            cfrs = this.getCryptoStreamFrames( zeroCTX!.getCryptoStream(), maxPayloadSize );
-            DEBUGcryptoFrameCount += cfrs.length;
-            for( let frame of cfrs )
-                packets.push( PacketFactory.createProtected0RTTPacket(this.connection, [frame]) );
-            /*
-            // ACKS for 0RTT are always sent in 1RTT packets (and they share the same Packet Number Space, so also the same ACK handler etc.)
-            ackframe = zeroCTX.getAckHandler().getAckFrame(this.connection);
-            if( ackframe !== undefined ){
-                DEBUGackFrameCount++;
-                packets.push(PacketFactory.createProtected0RTTPacket(this.connection, [ackframe]));
-            }
-            */
-
-            
-            let handshakeCTX = this.connection.getEncryptionContext(EncryptionLevel.HANDSHAKE);
-            cfrs = this.getCryptoStreamFrames( handshakeCTX!.getCryptoStream(), maxPayloadSize );
-            DEBUGcryptoFrameCount += cfrs.length;
-            for( let frame of cfrs )
-                packets.push( PacketFactory.createHandshakePacket(this.connection, [frame]) );
-            ackframe = handshakeCTX!.getAckHandler().getAckFrame(this.connection);
-            if( ackframe !== undefined ){
-                if( this.connection.getAEAD().canHandshakeEncrypt(this.connection.getEndpointType()) ){
-                    DEBUGackFrameCount++;
-                    packets.push(PacketFactory.createHandshakePacket(this.connection, [ackframe]));
-                }
-                else
-                    VerboseLogging.error("FlowControl:getPackets : cannot encrypt Handshake packets yet! TODO: buffer, dropping for now");
-            }
+        // REFACTOR TODO: should only send 3 handshake packets without client address validation
+        // https://tools.ietf.org/html/draft-ietf-quic-transport#section-4.4.3
+        let initCTX = this.connection.getEncryptionContext(EncryptionLevel.INITIAL)!;
+        let canAck = this.connection.getAEAD().canClearTextEncrypt(this.connection.getEndpointType());
+        packets = packets.concat( this.getEncryptionLevelPackets(initCTX, maxPayloadSize, canAck, [], (packetFrames: BaseFrame[]) => {
+            return PacketFactory.createInitialPacket(this.connection, packetFrames);
+        }));
 
+        // ACKS for 0RTT are always sent in 1RTT packets (and they share the same Packet Number Space, so also the same ACK handler etc.)
+        let zeroCTX = this.connection.getEncryptionContext(EncryptionLevel.ZERO_RTT)!;
+        packets = packets.concat( this.getEncryptionLevelPackets(zeroCTX, maxPayloadSize, false, [], (packetFrames: BaseFrame[]) => {
+            return PacketFactory.createProtected0RTTPacket(this.connection, packetFrames);
+        }));
 
-            let oneCTX = this.connection.getEncryptionContext(EncryptionLevel.ONE_RTT);
-            cfrs = this.getCryptoStreamFrames( oneCTX!.getCryptoStream(), maxPayloadSize );
-            DEBUGcryptoFrameCount += cfrs.length;
-            for( let frame of cfrs )
-                packets.push( PacketFactory.createShortHeaderPacket(this.connection, [frame]) );
-            ackframe = oneCTX!.getAckHandler().getAckFrame(this.connection);
-            if( ackframe !== undefined ){
-                if( this.connection.getAEAD().can1RTTEncrypt(this.connection.getEndpointType()) ){
-                    DEBUGackFrameCount++;
-                    packets.push(PacketFactory.createShortHeaderPacket(this.connection, [ackframe])); 
-                }
-                else
-                    VerboseLogging.error("FlowControl:getPackets : cannot encrypt 1RTT packets yet! TODO: buffer, dropping for now");
-            }
+        let handshakeCTX = this.connection.getEncryptionContext(EncryptionLevel.HANDSHAKE)!;
+        canAck = this.connection.getAEAD().canHandshakeEncrypt(this.connection.getEndpointType());
+        packets = packets.concat( this.getEncryptionLevelPackets(handshakeCTX, maxPayloadSize, canAck, [], (packetFrames: BaseFrame[]) => {
+            return PacketFactory.createHandshakePacket(this.connection, packetFrames);
+        }));
 
-            VerboseLogging.info("FlowControl:getPackets : created " + DEBUGcryptoFrameCount + " CRYPTO frames");
+
+        var applicationFrames = new Array<BaseFrame>();
+        if (this.connection.getQuicTLS().getHandshakeState() >= HandshakeState.CLIENT_COMPLETED) {
+            applicationFrames = applicationFrames.concat(frames.flowControlFrames);
+        }
+        applicationFrames = applicationFrames.concat(this.bufferedFrames);
+        this.bufferedFrames = [];
+        applicationFrames = applicationFrames.concat(frames.streamFrames);
+
+        // during the handshake, application data can still end up in 0-RTT (or even Handshake) packets, which cannot carry our 1-RTT ACK
+        // in that case, they get their own packets and the ACK goes in a separate short header packet
+        let applicationPacketType = PacketType.Protected1RTT;
+        if( applicationFrames.length > 0 )
+            applicationPacketType = this.getPacketType(applicationFrames);
+
+        let oneCTX = this.connection.getEncryptionContext(EncryptionLevel.ONE_RTT)!;
+        canAck = this.connection.getAEAD().can1RTTEncrypt(this.connection.getEndpointType());
+        let oneRTTFrames = (applicationPacketType === PacketType.Protected1RTT) ? applicationFrames : [];
+        if( canAck && this.pendingControlFrames.length > 0 ){
+            oneRTTFrames = this.pendingControlFrames.concat(oneRTTFrames);
+            this.pendingControlFrames = [];
+        }
+        packets = packets.concat( this.getEncryptionLevelPackets(oneCTX, maxPayloadSize, canAck, oneRTTFrames, (packetFrames: BaseFrame[]) => {
+            return PacketFactory.createShortHeaderPacket(this.connection, packetFrames);
+        }));
+
+        if( applicationPacketType !== PacketType.Protected1RTT ){
+            packets = packets.concat( this.packFrames([], applicationFrames, maxPayloadSize, (packetFrames: BaseFrame[]) => {
+                return this.createNewPacket(packetFrames);
+            }));
         }
 
-        /*
-        frames.handshakeFrames.forEach((frame: BaseFrame) => {
-            // handshake frames are only more than one with server hello and they need to be in different packets
-            // TODO: draft-13 : this is no longer correct, same encryption level can be in same packet
-            packets.push(this.createNewPacket([frame]));
-        });
-        */
+        return packets;
+    }
 
-        if (this.connection.getQuicTLS().getHandshakeState() >= HandshakeState.CLIENT_COMPLETED) {
-            frames.flowControlFrames.forEach((frame: BaseFrame) => {
-                var frameSize = frame.toBuffer().byteLength
-                if (size.add(frameSize).greaterThan(maxPayloadSize) && !size.equals(0)) {
-                    packets.push(this.createNewPacket(packetFrames));
-                    size = new Bignum(0);
-                    packetFrames = [];
-                }
-                size = size.add(frameSize);
-                packetFrames.push(frame);
-            });
+    /**
+     * Builds the packets for a single encryption level: its ACK frame (if any), its CRYPTO data and then the given other frames, in as few packets as possible
+     * @param canAck false if we cannot encrypt packets for this level yet, or if ACKs are never sent at this level (0-RTT). The ACK then stays pending in the AckHandler
+     */
+    private getEncryptionLevelPackets(ctx: CryptoContext, maxPayloadSize: Bignum, canAck: boolean, otherFrames: BaseFrame[], createPacket: (frames: BaseFrame[]) => BasePacket): BasePacket[] {
+        let cryptoStream = ctx.getCryptoStream();
+        let packets = new Array<BasePacket>();
+        let packetFrames = new Array<BaseFrame>();
+        let size = 0;
+
+        if( canAck ){
+            // if we're sending something at this level anyway, we include an ACK if there is anything new to ACK, even if the ACK policy says it's not urgent yet
+            let piggyback = cryptoStream.getOutgoingDataSize() > 0 || otherFrames.length > 0;
+            let ackFrame = ctx.getAckHandler().getAckFrame(this.connection, piggyback);
+            if( ackFrame !== undefined ){
+                packetFrames.push(ackFrame);
+                size += ackFrame.encodedLength();
+            }
         }
 
-        var bufferedFrame: BaseFrame | undefined = this.bufferedFrames.shift();
-        while (bufferedFrame !== undefined) {
-            var frameSize = bufferedFrame.toBuffer().byteLength;
-            if (size.add(frameSize).greaterThan(maxPayloadSize) && !size.equals(0)) {
-                packets.push(this.createNewPacket(packetFrames));
-                size = new Bignum(0);
+        // CRYPTO frames are sized to fill up the rest of the packet
+        let maxSize = maxPayloadSize.toNumber();
+        while( cryptoStream.getOutgoingDataSize() > 0 ){
+            let dataSize = maxSize - size - this.getCryptoFrameOverhead(cryptoStream, maxSize);
+            if( dataSize <= 0 ){
+                packets.push( createPacket(packetFrames) );
                 packetFrames = [];
+                size = 0;
+                continue;
             }
-            size = size.add(frameSize);
-            packetFrames.push(bufferedFrame);
-            bufferedFrame = this.bufferedFrames.shift();
+
+            let frame = this.createCryptoFrame(cryptoStream, dataSize);
+            packetFrames.push(frame);
+            size += frame.encodedLength();
         }
 
-        frames.streamFrames.forEach((frame: BaseFrame) => {
-            var frameSize = frame.toBuffer().byteLength;
+        return packets.concat( this.packFrames(packetFrames, otherFrames, maxPayloadSize, createPacket) );
+    }
+
+    // adds frames to the (partially filled) packetFrames, starting a new packet each time maxPayloadSize would be exceeded
+    private packFrames(packetFrames: BaseFrame[], frames: BaseFrame[], maxPayloadSize: Bignum, createPacket: (frames: BaseFrame[]) => BasePacket): BasePacket[] {
+        let packets = new Array<BasePacket>();
+        let size = new Bignum(0);
+        packetFrames.forEach((frame: BaseFrame) => {
+            size = size.add(frame.encodedLength());
+        });
+
+        frames.forEach((frame: BaseFrame) => {
+            var frameSize = frame.encodedLength();
             if (size.add(frameSize).greaterThan(maxPayloadSize) && !size.equals(0)) {
-                packets.push(this.createNewPacket(packetFrames));
+                packets.push(createPacket(packetFrames));
                 size = new Bignum(0);
                 packetFrames = [];
             }
@@ -230,7 +234,7 @@ export class FlowControl {
             packetFrames.push(frame);
         });
         if (packetFrames.length > 0) {
-            packets.push(this.createNewPacket(packetFrames));
+            packets.push(createPacket(packetFrames));
         }
 
         return packets;
@@ -239,6 +243,22 @@ export class FlowControl {
     private serverHasSentInitial:boolean = false;
 
     private createNewPacket(frames: BaseFrame[]) {
+        let packetType = this.getPacketType(frames);
+
+        switch( packetType ){
+            case PacketType.Protected0RTT:
+                return PacketFactory.createProtected0RTTPacket(this.connection, frames);
+            case PacketType.Initial:
+                this.serverHasSentInitial = true; // TODO: FIXME: this is dirty and should be corrected ASAP! 
+                return PacketFactory.createInitialPacket(this.connection, frames);
+            case PacketType.Handshake:
+                return PacketFactory.createHandshakePacket(this.connection, frames);
+            default:
+                return PacketFactory.createShortHeaderPacket(this.connection, frames);
+        }
+    }
+
+    private getPacketType(frames: BaseFrame[]): PacketType {
         var handshakeState = this.connection.getQuicTLS().getHandshakeState();
         
         var isServer = this.connection.getEndpointType() !== EndpointType.Client;
@@ -267,33 +287,31 @@ export class FlowControl {
                 // 3.2 step "3" in the handshake process: client is fully setup but haven't heard final from server yet : normal data from client -> server
             // 4. server -> client: handhsake packet in response to clientInitial 
             if (this.connection.getQuicTLS().isEarlyDataAllowed() && !isCryptoFrame && !isServer && streamData) {
-                return PacketFactory.createProtected0RTTPacket(this.connection, frames);
-            } //else if (this.connection.getStreamManager().getStream(new Bignum(0)).getLocalOffset().equals(0) && !isServer && isHandshake) {
-              //  return PacketFactory.createInitialPacket(this.connection, frames);
-            //} 
+                return PacketType.Protected0RTT;
+            } 
             else if(isServer && isCryptoFrame && !this.serverHasSentInitial){
-                this.serverHasSentInitial = true; // TODO: FIXME: this is dirty and should be corrected ASAP! 
-                return PacketFactory.createInitialPacket(this.connection, frames);
-                
+                return PacketType.Initial;
             }else if (!isCryptoFrame && ((this.connection.getQuicTLS().isEarlyDataAllowed() && this.connection.getQuicTLS().isSessionReused()) || (handshakeState >= HandshakeState.CLIENT_COMPLETED))) {
-                return PacketFactory.createShortHeaderPacket(this.connection, frames); 
+                return PacketType.Protected1RTT;
             } else {
-                return PacketFactory.createHandshakePacket(this.connection, frames);
+                return PacketType.Handshake;
             }
         } else {
-            return PacketFactory.createShortHeaderPacket(this.connection, frames);
+            return PacketType.Protected1RTT;
         }
     }
 
     // get frames that need to be SENT to our peer 
     // primarily: STREAM frames with data and flow control frames
     // ACK and CRYPTO etc. frames are done elsewhere 
-    public getFrames(maxPayloadSize: Bignum): FlowControlFrames {
+    // streamDataBudget limits the total size of the STREAM frames: whatever doesn't fit stays in the streams for the next call
+    public getFrames(maxPayloadSize: Bignum, streamDataBudget: number): FlowControlFrames {
         var streamFrames = new Array<StreamFrame>();
         var flowControlFrames = new Array<BaseFrame>();
         var handshakeFrames = new Array<CryptoFrame>(); // TODO: this cannot be returned from here, so don't indicate that it could 
         var uniAdded = false;
         var bidiAdded = false;
+        var budgetLeft = streamDataBudget;
 
         // 3 types of flow control:
         //   1. connection level DATA
@@ -308,16 +326,28 @@ export class FlowControl {
         }
 
         // per-stream
-        this.connection.getStreamManager().getStreams().forEach((stream: Stream) => {
-            let dataBlocked = connectionLevelBlocked;
+        // only streams with data waiting are looked at (see StreamManager:activateStream): 
+        // they are dropped from that set here once drained or blocked on their own flow control, and added back when that changes
+        let streamManager = this.connection.getStreamManager();
+        streamManager.getActiveStreams().forEach((stream: Stream) => {
+            if (stream.isReceiveOnly() || !stream.hasDataToSend()) {
+                streamManager.deactivateStream(stream);
+                return;
+            }
+
+            // a FIN without data doesn't use any credit, so it can always be sent
+            let hasData = stream.getOutgoingDataSize() > 0;
+            let dataBlocked = connectionLevelBlocked && hasData;
 
             // 2. 
             // TODO: check if we're allowed to send these messages if the conn-level flow control maximum is exceeded
-            if ( !stream.isReceiveOnly() && stream.ableToSend()) { 
+            if ( hasData && stream.ableToSend() ) { 
                 if( !stream.getBlockedSent() ){ // keep track of if we've already sent a STREAM_BLOCKED frame for this stream
                     flowControlFrames.push(FrameFactory.createStreamBlockedFrame(stream.getStreamID(), stream.getRemoteOffset()));
                     stream.setBlockedSent(true); // is un-set when we receive MAX_STREAM_DATA frame from peer 
                 }
+                // nothing will change for this stream until we get a MAX_STREAM_DATA frame (see FrameHandler:handleMaxStreamDataFrame)
+                streamManager.deactivateStream(stream);
                 dataBlocked = true;
             } 
 
@@ -341,8 +371,15 @@ export class FlowControl {
 
             if( !dataBlocked ){
                 // no type of flow control is stopping us from sending, so let's get the data frames! 
-                if (stream.getOutgoingDataSize() !== 0) {
-                    streamFrames = streamFrames.concat(this.getStreamFrames(stream, maxPayloadSize));
+                if (budgetLeft > 0) {
+                    let newFrames = this.getStreamFrames(stream, maxPayloadSize, budgetLeft);
+                    newFrames.forEach((frame: StreamFrame) => {
+                        budgetLeft -= frame.encodedLength();
+                    });
+                    streamFrames = streamFrames.concat(newFrames);
+                }
+                if (!stream.hasDataToSend()) {
+                    streamManager.deactivateStream(stream);
                 }
             }
         });
@@ -358,25 +395,31 @@ export class FlowControl {
         };
     }
 
-    private getCryptoStreamFrames( stream: CryptoStream, maxPayloadSize: Bignum ): Array<CryptoFrame>{
-        let output:Array<CryptoFrame> = new Array<CryptoFrame>();
+    // type byte + offset + length (we never put more than maxPayloadSize bytes in a single frame)
+    private getCryptoFrameOverhead( stream: CryptoStream, maxPayloadSize: number ): number {
+        return 1 + VLIE.getEncodedByteLength(stream.getRemoteOffset()) + VLIE.getEncodedByteLength(new Bignum(maxPayloadSize));
+    }
 
-        let streamDataSize = maxPayloadSize.lessThan(stream.getOutgoingDataSize()) ? maxPayloadSize : new Bignum(stream.getOutgoingDataSize());
+    private createCryptoFrame( stream: CryptoStream, maxDataSize: number ): CryptoFrame {
+        let streamDataSize = Math.min( maxDataSize, stream.getOutgoingDataSize() );
 
-        while( stream.getOutgoingDataSize() > 0 ){
-            let streamData = stream.popData( streamDataSize.toNumber() );
-            let frame = (FrameFactory.createCryptoFrame(streamData.slice(0, streamDataSize.toNumber()), stream.getRemoteOffset()));
-            frame.setCryptoLevel( stream.getCryptoLevel() );
-            output.push(frame);
+        let streamData = stream.popData( streamDataSize );
+        let frame = FrameFactory.createCryptoFrame(streamData, stream.getRemoteOffset());
+        frame.setCryptoLevel( stream.getCryptoLevel() );
 
-            stream.addRemoteOffset(streamDataSize);
-        }
+        stream.addRemoteOffset(streamDataSize);
         
-        return output;
+        return frame;
+    }
+
+    // type byte + stream ID + offset + length (we never put more than maxPayloadSize bytes in a single frame)
+    private getStreamFrameOverhead( stream: Stream, maxPayloadSize: Bignum ): number {
+        return 1 + VLIE.getEncodedByteLength(stream.getStreamID()) + VLIE.getEncodedByteLength(stream.getRemoteOffset()) + VLIE.getEncodedByteLength(maxPayloadSize);
     }
 
-    private getStreamFrames(stream: Stream, maxPayloadSize: Bignum): Array<StreamFrame> {
+    private getStreamFrames(stream: Stream, maxPayloadSize: Bignum, streamDataBudget: number): Array<StreamFrame> {
         let streamFrames = new Array<StreamFrame>();
+        let budgetLeft = streamDataBudget;
 
         // TODO: is this really needed every time? there shouldn't be anything in the data to begin with...
         //if (stream.isReceiveOnly()) {
@@ -384,82 +427,130 @@ export class FlowControl {
         //}
 
         while (stream.getOutgoingDataSize() > 0 && !stream.ableToSend() && !this.connection.ableToSend()) {
-            let streamDataSize = maxPayloadSize.lessThan(stream.getOutgoingDataSize()) ? maxPayloadSize : new Bignum(stream.getOutgoingDataSize());
+            // the frame (including its header) has to fit in both a single packet and what's left of the budget
+            let maxFrameDataSize = Math.min(maxPayloadSize.toNumber(), budgetLeft) - this.getStreamFrameOverhead(stream, maxPayloadSize);
+            if (maxFrameDataSize <= 0) {
+                break;
+            }
+            let streamDataSize = new Bignum( Math.min(maxFrameDataSize, stream.getOutgoingDataSize()) );
 
             // adhere to current connection-level and then stream-level flow control max-data limits
             streamDataSize = streamDataSize.greaterThan(this.connection.getSendAllowance().subtract(this.connection.getRemoteOffset())) ? this.connection.getSendAllowance().subtract(this.connection.getRemoteOffset()) : streamDataSize;
             streamDataSize = streamDataSize.greaterThan(stream.getSendAllowance().subtract(stream.getRemoteOffset())) ? stream.getSendAllowance().subtract(stream.getRemoteOffset()) : streamDataSize;
 
 
-            let streamData = stream.popData(streamDataSize.toNumber());
+            // slices of the application's buffers: the data is only copied when the packet is encoded
+            let streamData = stream.popDataSlices(streamDataSize.toNumber());
             let isFin = stream.getFinalSentOffset() !== undefined ? stream.getFinalSentOffset().equals(stream.getRemoteOffset().add(streamDataSize)) : false;
-            let frame = (FrameFactory.createStreamFrame(stream.getStreamID(), streamData.slice(0, streamDataSize.toNumber()), isFin, true, stream.getRemoteOffset()));
+            let frame = (FrameFactory.createStreamFrame(stream.getStreamID(), streamData, isFin, true, stream.getRemoteOffset()));
+            if (isFin) {
+                stream.setFinSent();
+            }
         
             streamFrames.push(frame);
+            budgetLeft -= frame.encodedLength();
 
             // update flow control limits 
             stream.addRemoteOffset(streamDataSize);
             this.connection.addRemoteOffset(streamDataSize);
         } 
 
+        if (stream.getOutgoingDataSize() === 0 && stream.isFinPending() && this.getStreamFrameOverhead(stream, maxPayloadSize) <= Math.min(maxPayloadSize.toNumber(), budgetLeft)) {
+            streamFrames.push( FrameFactory.createStreamFrame(stream.getStreamID(), Buffer.alloc(0), true, true, stream.getRemoteOffset()) );
+            stream.setFinSent();
+        }
+
         return streamFrames;
     }
 
     private getLocalFlowControlFrames(): BaseFrame[] {
-        if (this.connection.getQuicTLS().getHandshakeState() === HandshakeState.SERVER_HELLO) {
-            return [];
-        }
         var frames = new Array<BaseFrame>();
-        if (this.connection.isPeerAlmostBlocked() || this.connection.isPeerBlocked()) {
-            var newMaxData = this.connection.increaseReceiveAllowance();
-            frames.push(FrameFactory.createMaxDataFrame(newMaxData));
-            this.connection.setPeerBlocked(false);
+        // getPackets drops these frames until the handshake is done, but the streams leave the changed set and the allowances grow here:
+        // a frame that is dropped would never be generated again, so nothing changes until they can actually be sent
+        if (this.connection.getQuicTLS().getHandshakeState() < HandshakeState.CLIENT_COMPLETED) {
+            return frames;
         }
-
-        this.connection.getStreamManager().getStreams().forEach((stream: Stream) => {
+        // the windows are auto-tuned based on how fast the peer uses them up, relative to the RTT (see FlowControlledObject:autoTuneReceiveWindow)
+        var rttMeasurement = this.connection.getRTTMeasurement();
+        var smoothedRtt = (rttMeasurement !== undefined && rttMeasurement.hasRTTSample()) ? rttMeasurement.smoothedRtt : undefined;
+
+        // streams go first: if one of their windows grows, the connection's window might have to grow along with it
+        // only streams whose receive state changed since the last call are looked at (see StreamManager:markReceiveStateChanged)
+        // a stream that still needs an update after this (e.g., no buffer space until the application reads) is marked again when that changes
+        let changedStreams = this.connection.getStreamManager().getReceiveStateChangedStreams();
+        changedStreams.forEach((stream: Stream) => {
+            changedStreams.delete(stream);
             if (stream.isUniStream() === true && stream.isLocalStream() === true) {
                 return;
             }
             if (stream.isPeerAlmostBlocked() || stream.isPeerBlocked()) {
-                var newMaxStreamData = stream.increaseReceiveAllowance();
-                frames.push(FrameFactory.createMaxStreamDataFrame(stream.getStreamID(), newMaxStreamData));
-                stream.setPeerBlocked(false);
+                var oldMaxStreamData = stream.getReceiveAllowance();
+                var newMaxStreamData = stream.increaseReceiveAllowance(smoothedRtt);
+                if (newMaxStreamData.greaterThan(oldMaxStreamData) || stream.isPeerBlocked()) {
+                    frames.push(FrameFactory.createMaxStreamDataFrame(stream.getStreamID(), newMaxStreamData));
+                    stream.setPeerBlocked(false);
+                }
+                this.connection.ensureReceiveWindowSize( Math.ceil(stream.getReceiveWindowSize() * Constants.CONNECTION_TO_STREAM_WINDOW_RATIO) );
             }
         });
 
-        frames = frames.concat(this.checkLocalStreamId());
+        // the allowance only grows as far as there is buffer space: if the application isn't reading, there might not be anything new to announce
+        if (this.connection.isPeerAlmostBlocked() || this.connection.isPeerBlocked()) {
+            var oldMaxData = this.connection.getReceiveAllowance();
+            var newMaxData = this.connection.increaseReceiveAllowance(smoothedRtt);
+            if (newMaxData.greaterThan(oldMaxData) || this.connection.isPeerBlocked()) {
+                frames.push(FrameFactory.createMaxDataFrame(newMaxData));
+                this.connection.setPeerBlocked(false);
+            }
+        }
+
+        this.checkLocalStreamId();
         return frames;
     }
 
 
-    private checkLocalStreamId(): BaseFrame[] {
-        var frames = new Array<BaseFrame>();
-        this.connection.getStreamManager().getStreams().forEach((stream: Stream) => {
-            var streamId = stream.getStreamID();
-            if (this.isRemoteStreamId(streamId)) {
-                return;
-            }
-            var newStreamId = undefined;
-            let streamType:FrameType = FrameType.UNKNOWN;
-            if (Stream.isUniStreamId(streamId)) {
-                if (streamId.add(Constants.DEFAULT_MAX_STREAM_ID_BUFFER_SPACE).greaterThanOrEqual(this.connection.getLocalMaxStreamUni().multiply(4))) {
-                    newStreamId = this.connection.getLocalMaxStreamUni().add(Constants.DEFAULT_MAX_STREAM_ID_INCREMENT);
-                    this.connection.setLocalMaxStreamUni(newStreamId);
-                    streamType = FrameType.MAX_STREAMS_UNI;
-                }
-            } else {
-                if (streamId.add(Constants.DEFAULT_MAX_STREAM_ID_BUFFER_SPACE).greaterThanOrEqual(this.connection.getLocalMaxStreamBidi().multiply(4))) {
-                    newStreamId = this.connection.getLocalMaxStreamBidi().add(Constants.DEFAULT_MAX_STREAM_ID_INCREMENT);
-                    this.connection.setLocalMaxStreamBidi(newStreamId);
-                    streamType = FrameType.MAX_STREAMS_BIDI;
-                }
-            }
-            if (newStreamId !== undefined && streamType !== FrameType.UNKNOWN) {
-                frames.push(FrameFactory.createMaxStreamIdFrame(streamType, newStreamId));
-            }
-        });
+    // Stream count credit (MAX_STREAMS) is recycled: whenever streams the peer opened are retired (see StreamManager:retireStream), they can open new ones
+    // The peer can always have as many streams open at once as we allowed in our transport parameters (INITIAL_MAX_STREAMS_*): that's our concurrency target
+    // To prevent sending a frame for each single stream, we wait until a decent part of the target has become available again
+    // Our limit moves as soon as the frame is created, so it is queued as a 1-RTT control frame: the flow control frames of getFrames are
+    // dropped during the handshake (see getPackets), and a dropped MAX_STREAMS would never be generated again
+    private checkLocalStreamId(): void {
+        if (this.connection.getLocalTransportParameters() === undefined || this.connection.getLocalMaxStreamBidi() === undefined) {
+            return;
+        }
+        let isServer = this.connection.getEndpointType() === EndpointType.Server;
+        let streamManager = this.connection.getStreamManager();
+
+        let bidiTarget = this.connection.getLocalTransportParameter(TransportParameterId.INITIAL_MAX_STREAMS_BIDI);
+        let bidiRetired = streamManager.getRetiredStreamCount(isServer ? StreamType.ClientBidi : StreamType.ServerBidi);
+        let newMaxBidi = this.getNewMaxStreams(bidiTarget + bidiRetired, this.connection.getLocalMaxStreamBidi(), bidiTarget, this.connection.getLocalMaxStreamBidiBlocked());
+        if (newMaxBidi !== undefined) {
+            this.connection.setLocalMaxStreamBidi(newMaxBidi * 4);
+            this.connection.setLocalMaxStreamBidiBlocked(false);
+            this.queueControlFrame(FrameFactory.createMaxStreamIdFrame(FrameType.MAX_STREAMS_BIDI, new Bignum(newMaxBidi)));
+        }
 
-        return frames;
+        let uniTarget = this.connection.getLocalTransportParameter(TransportParameterId.INITIAL_MAX_STREAMS_UNI);
+        let uniRetired = streamManager.getRetiredStreamCount(isServer ? StreamType.ClientUni : StreamType.ServerUni);
+        let newMaxUni = this.getNewMaxStreams(uniTarget + uniRetired, this.connection.getLocalMaxStreamUni(), uniTarget, this.connection.getLocalMaxStreamUniBlocked());
+        if (newMaxUni !== undefined) {
+            this.connection.setLocalMaxStreamUni(newMaxUni * 4);
+            this.connection.setLocalMaxStreamUniBlocked(false);
+            this.queueControlFrame(FrameFactory.createMaxStreamIdFrame(FrameType.MAX_STREAMS_UNI, new Bignum(newMaxUni)));
+        }
+    }
+
+    // localMaxStreams is kept as a stream ID limit (count * 4, see Connection:setLocalTransportParameters), the MAX_STREAMS frame carries the count
+    private getNewMaxStreams(allowedCount: number, localMaxStreams: Bignum, concurrencyTarget: number, peerBlocked: boolean): number | undefined {
+        let currentCount = Math.floor(localMaxStreams.toNumber() / 4);
+        let increase = allowedCount - currentCount;
+        if (increase <= 0) {
+            return undefined;
+        }
+        if (!peerBlocked && increase < Math.max(1, Math.floor(concurrencyTarget * Constants.MAX_STREAMS_UPDATE_THRESHOLD))) {
+            return undefined;
+        }
+        return allowedCount;
     }
 
     private isRemoteStreamId(streamId: Bignum): boolean {
@@ -470,7 +561,7 @@ export class FlowControl {
     }
 
 
-    private isRemoteStreamIdBlocked(stream: Stream): boolean {
+    public isRemoteStreamIdBlocked(stream: Stream): boolean {
         if (!this.isRemoteStreamId(stream.getStreamID())) {
             return false;
         }
@@ -3,6 +3,10 @@ import {TransportParameterId} from '../crypto/transport.parameters';
 import {Bignum} from '../types/bignum';
 import { EventEmitter } from 'events';
 import { logMethod } from '../utilities/decorators/log.decorator';
+import { Constants } from '../utilities/constants';
+import { Time, TimeFormat } from '../types/time';
+import { ReceiveWindowBudget } from './receive.window.budget';
+import { VerboseLogging } from '../utilities/logging/verbose.logging';
 
 
 // REFACTOR TODO: use composition instead of inheritance for FlowControlledObject... 
@@ -15,14 +19,28 @@ export abstract class FlowControlledObject extends EventEmitter {
 	
 	private isRemoteBlocked: boolean; // our peer is blocked on this stream, expects a MAX_STREAM_DATA update from us (i.e., their sendAllowance is reached)
 	
-	private readonly MAX_BUFFER_SIZE: number;
+	private readonly MAX_BUFFER_SIZE: number; // upper bound for the receive window
 	private currentBufferSize: number;
 
-    public constructor(bufferSize: number) {
+	// Receive window auto-tuning, similar to what TCP stacks do
+	// The window starts small (initialWindowSize) and grows when the peer uses it up faster than it could be refreshed with a window update, 
+	// i.e., when flow control instead of the network is what's limiting the peer. See autoTuneReceiveWindow
+	private receiveWindowSize: number;
+	private windowEpochStart: Time; // start of the current measurement period, reset after each window update
+	private windowEpochOffset: Bignum; // localOffset at the start of the current measurement period
+	private windowBudget?: ReceiveWindowBudget; // if set, window growth has to be reserved here first (e.g., a memory budget shared by all connections)
+	private budgetReserved: number; // what we reserved in windowBudget so far, given back by releaseReceiveWindow
+
+    public constructor(bufferSize: number, initialWindowSize: number = bufferSize) {
 		super();
 		this.MAX_BUFFER_SIZE = bufferSize;
 		this.currentBufferSize = 0;
 		this.isRemoteBlocked = false;
+		this.budgetReserved = 0;
+
+		this.receiveWindowSize = Math.min(initialWindowSize, bufferSize);
+		this.windowEpochStart = Time.now();
+		this.windowEpochOffset = new Bignum(0);
 		
 		this.localOffset = new Bignum(0);
 		this.remoteOffset = new Bignum(0);
@@ -92,9 +110,11 @@ export abstract class FlowControlledObject extends EventEmitter {
 	}
 
 
+	// true once enough of the window is used up that we should send a window update
+	// this is well before the peer actually blocks, so it (ideally) never has to wait for the update to arrive
     public isPeerAlmostBlocked(added: any = new Bignum(0)): boolean {
-		var temp = this.localOffset.add(added).add(this.MAX_BUFFER_SIZE / 10);
-		return this.receiveAllowance.lessThan(temp);
+		var remaining = this.receiveAllowance.subtract(this.localOffset.add(added));
+		return remaining.lessThanOrEqual( Math.floor(this.receiveWindowSize * (1 - Constants.RECEIVE_WINDOW_UPDATE_THRESHOLD)) );
 	}
 
 	// when we receive a STREAM_BLOCKED frame from the peer
@@ -114,17 +134,104 @@ export abstract class FlowControlledObject extends EventEmitter {
 	}
 
 
-	public increaseReceiveAllowance(): Bignum {
+	/**
+	 * Moves the receive allowance to a full window past what we've received, minus what we still have buffered (e.g., data the application hasn't read yet)
+	 * @param smoothedRtt if given (in ms), the window size is auto-tuned first, based on how fast the peer used up the previous window
+	 */
+	public increaseReceiveAllowance(smoothedRtt?: number): Bignum {
+		if (smoothedRtt !== undefined) {
+			this.autoTuneReceiveWindow(smoothedRtt);
+		}
+
 		var updatedLocalMaxData = this.getLocalOffset().add(this.getBufferSpaceAvailable());
 		// If test should not be necessary, it is just a precaution to be sure that we do not make the max data smaller, which is not allowed by QUIC
 		if (updatedLocalMaxData.greaterThan(this.getReceiveAllowance())) {
 			this.setReceiveAllowance(updatedLocalMaxData);
+			this.startWindowEpoch();
 		}
 		return this.getReceiveAllowance();
 	}
 
 	public getBufferSpaceAvailable(): number {
-		return this.MAX_BUFFER_SIZE - this.currentBufferSize;
+		return Math.max(0, this.receiveWindowSize - this.currentBufferSize);
+	}
+
+	public getReceiveWindowSize(): number {
+		return this.receiveWindowSize;
+	}
+
+	/**
+	 * @param reserveInitialWindow false if the initial window is already accounted for elsewhere (e.g., streams: their initial windows are covered by the connection's),
+	 *  in which case only the growth beyond it is reserved
+	 */
+	public setReceiveWindowBudget(budget: ReceiveWindowBudget, reserveInitialWindow: boolean = true): void {
+		this.windowBudget = budget;
+		if (reserveInitialWindow) {
+			budget.reserve(this.receiveWindowSize, true); // the initial window has already been promised in our transport parameters
+			this.budgetReserved = this.receiveWindowSize;
+		}
+	}
+
+	// gives our share back to the budget, after which the window can no longer grow. Only to be used when we're done with this object
+	// safe to call more than once, so it can be called from every path that retires the object
+	public releaseReceiveWindow(): void {
+		if (this.windowBudget !== undefined) {
+			this.windowBudget.release(this.budgetReserved);
+			this.windowBudget = undefined;
+			this.budgetReserved = 0;
+		}
+	}
+
+	/**
+	 * Makes sure the window is at least the given size (as far as the maximum and the budget allow)
+	 * Used to keep the connection's window a bit larger than that of its streams: otherwise a single stream could be blocked on the connection window
+	 */
+	public ensureReceiveWindowSize(size: number): void {
+		if (size > this.receiveWindowSize) {
+			this.growReceiveWindow(size);
+		}
+	}
+
+	// The window should be large enough for the peer to keep sending for a full RTT while our window update is underway (i.e., at least the bandwidth-delay product)
+	// We measure how fast the previous window was used up: if that rate times the RTT (times 2, for some headroom) exceeds the window, the window is what's limiting the peer and we grow it
+	// The window at most doubles per update, to prevent overshooting on a single bursty measurement
+	private autoTuneReceiveWindow(smoothedRtt: number): void {
+		var consumed = this.localOffset.subtract(this.windowEpochOffset).toNumber();
+		// only draw conclusions when a decent part of the window was used during this period
+		if (smoothedRtt <= 0 || consumed < this.receiveWindowSize * Constants.RECEIVE_WINDOW_UPDATE_THRESHOLD) {
+			return;
+		}
+
+		var elapsed = Math.max(Time.now(this.windowEpochStart).format(TimeFormat.MilliSeconds), 1);
+		var rate = consumed / elapsed; // bytes per ms
+		var target = Math.ceil(2 * rate * smoothedRtt);
+
+		if (target > this.receiveWindowSize) {
+			this.growReceiveWindow( Math.min(target, 2 * this.receiveWindowSize) );
+		}
+	}
+
+	private growReceiveWindow(size: number): void {
+		var newSize = Math.min(size, this.MAX_BUFFER_SIZE);
+		var increase = newSize - this.receiveWindowSize;
+		if (increase <= 0) {
+			return;
+		}
+		if (this.windowBudget !== undefined) {
+			if (!this.windowBudget.reserve(increase)) {
+				VerboseLogging.debug("FlowControlledObject:growReceiveWindow : budget exhausted, keeping window at " + this.receiveWindowSize);
+				return;
+			}
+			this.budgetReserved += increase;
+		}
+
+		VerboseLogging.debug("FlowControlledObject:growReceiveWindow : receive window grows from " + this.receiveWindowSize + " to " + newSize);
+		this.receiveWindowSize = newSize;
+	}
+
+	private startWindowEpoch(): void {
+		this.windowEpochStart = Time.now();
+		this.windowEpochOffset = this.localOffset;
 	}
 
 	public getBufferSpaceUsed(): number {
@@ -0,0 +1,42 @@
+import { Constants } from '../utilities/constants';
+
+
+// Upper bound on the sum of receive windows handed out to our peers
+// Every byte of window we grant is a byte the peer is allowed to make us buffer, so auto-tuned windows (see FlowControlledObject) can only grow as long as there is room left here
+export class ReceiveWindowBudget {
+
+    // shared by all connections in this process
+    public static readonly GLOBAL: ReceiveWindowBudget = new ReceiveWindowBudget(Constants.GLOBAL_RECEIVE_WINDOW_BUDGET);
+
+    private limit: number;
+    private used: number;
+
+    public constructor(limit: number) {
+        this.limit = limit;
+        this.used = 0;
+    }
+
+    /**
+     * @param force reserve the bytes even if that goes over the limit (for windows we've already committed to)
+     * @returns false if there was not enough room left, in which case nothing was reserved
+     */
+    public reserve(bytes: number, force: boolean = false): boolean {
+        if (!force && this.used + bytes > this.limit) {
+            return false;
+        }
+        this.used += bytes;
+        return true;
+    }
+
+    public release(bytes: number): void {
+        this.used = Math.max(0, this.used - bytes);
+    }
+
+    public getUsed(): number {
+        return this.used;
+    }
+
+    public getLimit(): number {
+        return this.limit;
+    }
+}
@@ -0,0 +1,60 @@
+import {Bignum} from '../types/bignum';
+import {VLIE} from '../types/vlie';
+import {BaseFrame, FrameType} from './base.frame';
+
+
+/*
+ACK_FREQUENCY frame from the delayed ACK extension (draft-iyengar-quic-delayed-ack)
+Only sent to peers that advertised the min_ack_delay transport parameter
+Lets the sender of data tell the receiver how often it wants to see ACKs, e.g., fewer ACKs for bulk transfers
+*/
+export class AckFrequencyFrame extends BaseFrame {
+
+    // frames can be reordered, so only the one with the highest sequence number is applied
+    private sequenceNumber: Bignum;
+    // number of ack-eliciting packets the receiver may receive before it has to send an ACK
+    private packetTolerance: Bignum;
+    // new max_ack_delay the receiver should use, in MICROseconds (not lower than the receiver's min_ack_delay)
+    private updateMaxAckDelay: Bignum;
+    // if true, the receiver doesn't need to ACK immediately on reordering
+    private ignoreOrder: boolean;
+
+    public constructor(sequenceNumber: Bignum, packetTolerance: Bignum, updateMaxAckDelay: Bignum, ignoreOrder: boolean) {
+        super(FrameType.ACK_FREQUENCY, true);
+        this.sequenceNumber = sequenceNumber;
+        this.packetTolerance = packetTolerance;
+        this.updateMaxAckDelay = updateMaxAckDelay;
+        this.ignoreOrder = ignoreOrder;
+    }
+
+    public encodedLength(): number {
+        // frame type is a varint, which takes 2 bytes for this one. Last byte is ignoreOrder
+        return VLIE.getEncodedByteLength(this.getType()) + VLIE.getEncodedByteLength(this.sequenceNumber) + 
+               VLIE.getEncodedByteLength(this.packetTolerance) + VLIE.getEncodedByteLength(this.updateMaxAckDelay) + 1;
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        offset = VLIE.encodeInto(this.getType(), buffer, offset);
+        offset = VLIE.encodeInto(this.sequenceNumber, buffer, offset);
+        offset = VLIE.encodeInto(this.packetTolerance, buffer, offset);
+        offset = VLIE.encodeInto(this.updateMaxAckDelay, buffer, offset);
+        buffer.writeUInt8(this.ignoreOrder ? 1 : 0, offset++);
+        return offset;
+    }
+
+    public getSequenceNumber(): Bignum {
+        return this.sequenceNumber;
+    }
+
+    public getPacketTolerance(): Bignum {
+        return this.packetTolerance;
+    }
+
+    public getUpdateMaxAckDelay(): Bignum {
+        return this.updateMaxAckDelay;
+    }
+
+    public getIgnoreOrder(): boolean {
+        return this.ignoreOrder;
+    }
+}
@@ -81,65 +81,44 @@ export class AckFrame extends BaseFrame {
         return this.firstAckBlock;
     }
 
-    public toBuffer(): Buffer {
-        var offset = 1;
-        var laBuffer: Buffer = VLIE.encode(this.largestAcknowledged);
-        var ackDelayBuffer: Buffer = VLIE.encode(this.ackDelay);
-        var ackBlockCount: Buffer = VLIE.encode(this.ackBlockCount);
-        var firstAckBlockBuffer: Buffer = VLIE.encode(this.firstAckBlock);
-        var ackBlockBuffers: Buffer[] = [];
-        var ackBlockByteSize = 0;
-        this.ackBlocks.forEach((ackBlock: AckBlock) => {
-            var ackBlockBuffer: Buffer = ackBlock.toBuffer();
-            ackBlockByteSize += ackBlockBuffer.byteLength;
-            ackBlockBuffers.push(ackBlockBuffer);
-        });
-
-        let ECT0countBuffer: Buffer = VLIE.encode( this.ECT0count );
-        let ECT1countBuffer: Buffer = VLIE.encode( this.ECT1count );
-        let CEcountBuffer: Buffer   = VLIE.encode( this.CEcount );
-
+    public encodedLength(): number {
         var size = 1;
         size += VLIE.getEncodedByteLength(this.largestAcknowledged);
         size += VLIE.getEncodedByteLength(this.ackDelay);
         size += VLIE.getEncodedByteLength(this.ackBlockCount);
         size += VLIE.getEncodedByteLength(this.firstAckBlock);
-        size += ackBlockByteSize;
+        this.ackBlocks.forEach((ackBlock: AckBlock) => {
+            size += ackBlock.encodedLength();
+        });
         if( this.containsECN ){
             size += VLIE.getEncodedByteLength(this.ECT0count);
             size += VLIE.getEncodedByteLength(this.ECT1count);
             size += VLIE.getEncodedByteLength(this.CEcount);
         }
+        return size;
+    }
 
-        var returnBuffer: Buffer = Buffer.alloc(size);
+    public encodeInto(buffer: Buffer, offset: number): number {
         if( this.containsECN )
-            returnBuffer.writeUInt8(FrameType.ACK_ECN, 0);
+            buffer.writeUInt8(FrameType.ACK_ECN, offset++);
         else
-            returnBuffer.writeUInt8(FrameType.ACK, 0);
-
-        laBuffer.copy(returnBuffer, offset);
-        offset += laBuffer.byteLength;
-        ackDelayBuffer.copy(returnBuffer, offset);
-        offset += ackDelayBuffer.byteLength;
-        ackBlockCount.copy(returnBuffer, offset);
-        offset += ackBlockCount.byteLength;
-        firstAckBlockBuffer.copy(returnBuffer, offset);
-        offset += firstAckBlockBuffer.byteLength;
-        ackBlockBuffers.forEach((ackBlockBuffer: Buffer) => {
-            ackBlockBuffer.copy(returnBuffer, offset);
-            offset += ackBlockBuffer.byteLength;
+            buffer.writeUInt8(FrameType.ACK, offset++);
+
+        offset = VLIE.encodeInto(this.largestAcknowledged, buffer, offset);
+        offset = VLIE.encodeInto(this.ackDelay, buffer, offset);
+        offset = VLIE.encodeInto(this.ackBlockCount, buffer, offset);
+        offset = VLIE.encodeInto(this.firstAckBlock, buffer, offset);
+        this.ackBlocks.forEach((ackBlock: AckBlock) => {
+            offset = ackBlock.encodeInto(buffer, offset);
         });
 
         if( this.containsECN ){
-            ECT0countBuffer.copy( returnBuffer, offset );
-            offset += ECT0countBuffer.byteLength;
-            ECT1countBuffer.copy( returnBuffer, offset );
-            offset += ECT1countBuffer.byteLength;
-            CEcountBuffer.copy( returnBuffer, offset );
-            offset += CEcountBuffer.byteLength;
+            offset = VLIE.encodeInto(this.ECT0count, buffer, offset);
+            offset = VLIE.encodeInto(this.ECT1count, buffer, offset);
+            offset = VLIE.encodeInto(this.CEcount, buffer, offset);
         }
 
-        return returnBuffer;
+        return offset;
     }
 
 
@@ -196,14 +175,18 @@ export class AckBlock {
         return this.block;
     }
 
+    public encodedLength(): number {
+        return VLIE.getEncodedByteLength(this.gap) + VLIE.getEncodedByteLength(this.block);
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        offset = VLIE.encodeInto(this.gap, buffer, offset);
+        return VLIE.encodeInto(this.block, buffer, offset);
+    }
+
     public toBuffer(): Buffer {
-        var offset = 0;
-        var gapBuffer: Buffer = VLIE.encode(this.gap);
-        var blockBuffer: Buffer = VLIE.encode(this.block);
-        var returnBuffer: Buffer = Buffer.alloc(gapBuffer.byteLength + blockBuffer.byteLength);
-        gapBuffer.copy(returnBuffer, offset);
-        offset += VLIE.getEncodedByteLength(this.gap);
-        blockBuffer.copy(returnBuffer, offset);
+        var returnBuffer: Buffer = Buffer.alloc(this.encodedLength());
+        this.encodeInto(returnBuffer, 0);
         return returnBuffer;
     }
 }
\ No newline at end of file
@@ -9,7 +9,17 @@ export abstract class BaseFrame {
         this.retransmittable = retransmittable;
     }
 
-    abstract toBuffer(): Buffer;
+    // size of the frame on the wire, calculated without actually encoding the frame
+    abstract encodedLength(): number;
+    // writes the frame into buffer at offset (which needs to have at least encodedLength() bytes left), returns the offset right after the frame
+    abstract encodeInto(buffer: Buffer, offset: number): number;
+
+    // NOTE: when assembling packets, prefer encodedLength() and encodeInto() so each frame is only serialized once, straight into the packet buffer
+    public toBuffer(): Buffer {
+        let buffer = Buffer.alloc(this.encodedLength());
+        this.encodeInto(buffer, 0);
+        return buffer;
+    }
     
     public isRetransmittable(): boolean {
         return this.retransmittable;
@@ -57,5 +67,8 @@ export enum FrameType {
     CONNECTION_CLOSE        = 0x1c,
     APPLICATION_CLOSE       = 0x1d,
 
+    // extensions
+    ACK_FREQUENCY           = 0xaf, // draft-iyengar-quic-delayed-ack, encoded as a 2-byte varint on the wire
+
     UNKNOWN                 = 0xff
 }
\ No newline at end of file
@@ -12,12 +12,13 @@ export class BlockedFrame extends BaseFrame {
         this.blockedOffset = blockedOffset;
     }
     
-    public toBuffer(): Buffer {
-        var blockedBuffer: Buffer = VLIE.encode(this.blockedOffset);
-        var returnBuffer: Buffer = Buffer.alloc(blockedBuffer.byteLength + 1);
-        returnBuffer.writeUInt8(this.getType(), 0);
-        blockedBuffer.copy(returnBuffer, 1);
-        return returnBuffer;
+    public encodedLength(): number {
+        return 1 + VLIE.getEncodedByteLength(this.blockedOffset);
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.writeUInt8(this.getType(), offset++);
+        return VLIE.encodeInto(this.blockedOffset, buffer, offset);
     }
 
     public getBlockedOffset(): Bignum {
@@ -13,37 +13,28 @@ abstract class BaseCloseFrame extends BaseFrame {
         this.phrase = phrase;
     }
 
-    public toBuffer(): Buffer {
-        let phraseLengthBuffer: Buffer = VLIE.encode(this.phrase.length);
-        let phraseBuffer: Buffer = Buffer.from(this.phrase, 'utf8');
-        // TODO: Currently we don't log the responsible frame 
-        let frameType:Buffer;
-
-        let bufLength:number;
-        if( this.getType() === FrameType.CONNECTION_CLOSE ){
-            frameType = VLIE.encode(0); 
-            bufLength = 1 + 2 + frameType.byteLength + phraseLengthBuffer.byteLength + phraseBuffer.byteLength;
-        }
-        else
-            bufLength = 1 + 2 + phraseLengthBuffer.byteLength + phraseBuffer.byteLength;
-
-        let buf = Buffer.alloc(bufLength);
+    public encodedLength(): number {
+        // 8 bit type + 16 bit error code
+        let size = 3;
+        // TODO: Currently we don't log the responsible frame, so it's always 0 (1 byte)
+        if( this.getType() === FrameType.CONNECTION_CLOSE )
+            size += 1;
+        size += VLIE.getEncodedByteLength(this.phrase.length);
+        size += Buffer.byteLength(this.phrase, 'utf8');
+        return size;
+    }
 
-        let offset = 0;
-        buf.writeUInt8(this.getType(), offset++);
-        buf.writeUInt16BE(this.errorCode, offset);
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.writeUInt8(this.getType(), offset++);
+        buffer.writeUInt16BE(this.errorCode, offset);
         offset += 2;
 
+        if( this.getType() === FrameType.CONNECTION_CLOSE )
+            offset = VLIE.encodeInto(0, buffer, offset);
 
-        if( this.getType() === FrameType.CONNECTION_CLOSE ){
-            frameType!.copy(buf, offset);
-            offset += frameType!.byteLength;
-        }
-
-        phraseLengthBuffer.copy(buf, offset);
-        offset += phraseLengthBuffer.byteLength;
-        phraseBuffer.copy(buf, offset);
-        return buf;
+        offset = VLIE.encodeInto(this.phrase.length, buffer, offset);
+        offset += buffer.write(this.phrase, offset, Buffer.byteLength(this.phrase, 'utf8'), 'utf8');
+        return offset;
     }
 
     public getErrorCode(): number {
@@ -29,36 +29,16 @@ export class CryptoFrame extends BaseFrame {
         return this.cryptoLevel;
     }
 
-    public toBuffer(): Buffer {
-        let lengthBuffer = undefined;
-        let offsetBuffer = undefined;
-        let size = 0;
-
-        let type = this.getType();
-        size += 1;
-
-        lengthBuffer = VLIE.encode(this.length);
-        size += lengthBuffer.byteLength;
-
-        offsetBuffer = VLIE.encode(this.offset);
-        size += offsetBuffer.byteLength;
-
-
-        
-        var buffer = Buffer.alloc(size + this.data.byteLength);
-        var writeoffset = 0;
-
-        buffer.writeUInt8(type, writeoffset);
-        writeoffset += 1;
-
-        offsetBuffer.copy(buffer, writeoffset);
-        writeoffset += offsetBuffer.byteLength;
-
-        lengthBuffer.copy(buffer, writeoffset);
-        writeoffset += lengthBuffer.byteLength; 
+    public encodedLength(): number {
+        return 1 + VLIE.getEncodedByteLength(this.offset) + VLIE.getEncodedByteLength(this.length) + this.data.byteLength;
+    }
 
-        this.data.copy(buffer, writeoffset);
-        return buffer;
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.writeUInt8(this.getType(), offset++);
+        offset = VLIE.encodeInto(this.offset, buffer, offset);
+        offset = VLIE.encodeInto(this.length, buffer, offset);
+        offset += this.data.copy(buffer, offset);
+        return offset;
     }
 
     public getLength(): Bignum {
@@ -12,12 +12,13 @@ export class MaxDataFrame extends BaseFrame {
         this.maxData = maxData;
     }
 
-    public toBuffer(): Buffer {
-        var maxDataBuffer: Buffer = VLIE.encode(this.maxData);
-        var returnBuffer: Buffer = Buffer.alloc(maxDataBuffer.byteLength + 1);
-        returnBuffer.writeUInt8(this.getType(), 0);
-        maxDataBuffer.copy(returnBuffer, 1);
-        return returnBuffer;
+    public encodedLength(): number {
+        return 1 + VLIE.getEncodedByteLength(this.maxData);
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.writeUInt8(this.getType(), offset++);
+        return VLIE.encodeInto(this.maxData, buffer, offset);
     }
 
     public getMaxData(): Bignum {
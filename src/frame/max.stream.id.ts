@@ -11,12 +11,13 @@ export class MaxStreamIdFrame extends BaseFrame {
         this.maxStreamID = maxStreamID;
 	}
     
-    public toBuffer(): Buffer {
-        var maxStreamIDBuffer: Buffer = VLIE.encode(this.maxStreamID);
-        var returnBuffer: Buffer = Buffer.alloc(maxStreamIDBuffer.byteLength + 1);
-        returnBuffer.writeUInt8(this.getType(), 0);
-        maxStreamIDBuffer.copy(returnBuffer, 1);
-        return returnBuffer;
+    public encodedLength(): number {
+        return 1 + VLIE.getEncodedByteLength(this.maxStreamID);
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.writeUInt8(this.getType(), offset++);
+        return VLIE.encodeInto(this.maxStreamID, buffer, offset);
     }
 
     public getMaxStreamId(): Bignum {
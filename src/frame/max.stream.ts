@@ -13,16 +13,14 @@ export class MaxStreamFrame extends BaseFrame {
 		this.maxData = maxData;
     }
     
-    public toBuffer(): Buffer {
-        var offset = 0;
-        var streamIDBuffer: Buffer = VLIE.encode(this.streamID);
-        var maxDataBuffer: Buffer = VLIE.encode(this.maxData);
-        var returnBuffer: Buffer = Buffer.alloc(streamIDBuffer.byteLength + maxDataBuffer.byteLength + 1);
-        returnBuffer.writeUInt8(this.getType(), offset++);
-        streamIDBuffer.copy(returnBuffer, offset);
-        offset += streamIDBuffer.byteLength;
-        maxDataBuffer.copy(returnBuffer, offset);
-        return returnBuffer;
+    public encodedLength(): number {
+        return 1 + VLIE.getEncodedByteLength(this.streamID) + VLIE.getEncodedByteLength(this.maxData);
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.writeUInt8(this.getType(), offset++);
+        offset = VLIE.encodeInto(this.streamID, buffer, offset);
+        return VLIE.encodeInto(this.maxData, buffer, offset);
     }
 
     public getMaxData(): Bignum {
@@ -18,23 +18,18 @@ export class NewConnectionIdFrame extends BaseFrame {
 		this.statelessResetToken = statelessResetToken;
 	}
     
-    public toBuffer(): Buffer {
-        var sequenceBuffer = VLIE.encode(this.sequence);
-        var size = this.getSize(sequenceBuffer.byteLength);
-        var buffer = Buffer.alloc(size);
-        var offset = 0;
-        buffer.writeUInt8(this.getType(), offset++);
-        sequenceBuffer.copy(buffer, offset);
-        offset += sequenceBuffer.byteLength;
-        buffer.writeUInt8(this.connectionID.getByteLength(), offset++);
-        this.connectionID.toBuffer().copy(buffer, offset);
-        offset += this.connectionID.getByteLength();
-        this.statelessResetToken.copy(buffer, offset);
-        return buffer;
+    public encodedLength(): number {
+        // type + connection ID length
+        return 2 + VLIE.getEncodedByteLength(this.sequence) + this.connectionID.getByteLength() + this.statelessResetToken.byteLength;
     }
 
-    private getSize(sequenceSize: number): number {
-        return this.connectionID.getByteLength() + this.statelessResetToken.length + 2 + sequenceSize;
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.writeUInt8(this.getType(), offset++);
+        offset = VLIE.encodeInto(this.sequence, buffer, offset);
+        buffer.writeUInt8(this.connectionID.getByteLength(), offset++);
+        offset += this.connectionID.toBuffer().copy(buffer, offset);
+        offset += this.statelessResetToken.copy(buffer, offset);
+        return offset;
     }
 
     public getConnectionId(): ConnectionID {
@@ -8,11 +8,14 @@ export class PaddingFrame extends BaseFrame{
         this.paddingLength = paddingSize;
     }
 
-    public toBuffer(): Buffer {
-        var buffer = Buffer.alloc(this.paddingLength + 1);
-        buffer.fill(0);
-        buffer.writeUInt8(this.getType(), 0);
-        return buffer;
+    public encodedLength(): number {
+        return this.paddingLength + 1;
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        // the PADDING type is 0x00, so the whole frame is just zeroes
+        buffer.fill(0, offset, offset + this.encodedLength());
+        return offset + this.encodedLength();
     }
 
     public getLength(): number {
@@ -10,11 +10,15 @@ abstract class BasePathFrame extends BaseFrame {
         this.data = data;
     }
 
-    public toBuffer(): Buffer {
-        var buffer = Buffer.alloc(10);
-        buffer.writeUInt8(this.getType(), 0);
-        this.data.copy(buffer, 1);
-        return buffer;
+    public encodedLength(): number {
+        return 10;
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.fill(0, offset, offset + this.encodedLength());
+        buffer.writeUInt8(this.getType(), offset);
+        this.data.copy(buffer, offset + 1);
+        return offset + this.encodedLength();
     }
 
     public getData(): Buffer {
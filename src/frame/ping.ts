@@ -7,9 +7,14 @@ export class PingFrame extends BaseFrame {
         super(FrameType.PING, true);
     }
 
-    public toBuffer(): Buffer {
-        var buffer = Buffer.alloc(25);
-        buffer.writeUInt8(this.getType(), 0);
-        return buffer;
+    // the PING is followed by 24 bytes of PADDING
+    public encodedLength(): number {
+        return 25;
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.fill(0, offset, offset + this.encodedLength());
+        buffer.writeUInt8(this.getType(), offset);
+        return offset + this.encodedLength();
     }
 }
\ No newline at end of file
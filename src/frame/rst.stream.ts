@@ -16,20 +16,17 @@ export class RstStreamFrame extends BaseFrame {
         this.finalOffset = finalOffset;
     }
 
-    public toBuffer(): Buffer {
-        var eStreamId: Buffer = VLIE.encode(this.streamID);
-        var eFinalOffset: Buffer = VLIE.encode(this.finalOffset);
+    public encodedLength(): number {
         // 8 bit type + 16 bit applicationErrorCode
-        var bufLength: number = 3 + eStreamId.byteLength + eFinalOffset.byteLength;
-        var buffer = Buffer.alloc(bufLength);
-        var offset = 0;
+        return 3 + VLIE.getEncodedByteLength(this.streamID) + VLIE.getEncodedByteLength(this.finalOffset);
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
         buffer.writeUInt8(this.getType(), offset++);
-        eStreamId.copy(buffer, offset);
-        offset += eStreamId.byteLength;
+        offset = VLIE.encodeInto(this.streamID, buffer, offset);
         buffer.writeUInt16BE(this.applicationErrorCode, offset);
         offset += 2;
-        eFinalOffset.copy(buffer, offset);
-        return buffer;
+        return VLIE.encodeInto(this.finalOffset, buffer, offset);
     }
 
     public getStreamId(): Bignum {
@@ -14,17 +14,16 @@ export class StopSendingFrame extends BaseFrame {
         this.applicationErrorCode = applicationErrorCode;
     }
 
-    public toBuffer(): Buffer {
-        var eStreamId: Buffer = VLIE.encode(this.streamID);
+    public encodedLength(): number {
         // 8 bit type + 16 bit applicationErrorCode
-        var bufLength: number = 3 + eStreamId.byteLength;
-        var buffer = Buffer.alloc(bufLength);
-        var offset = 0;
+        return 3 + VLIE.getEncodedByteLength(this.streamID);
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
         buffer.writeUInt8(this.getType(), offset++);
-        eStreamId.copy(buffer, offset);
-        offset += eStreamId.byteLength;
+        offset = VLIE.encodeInto(this.streamID, buffer, offset);
         buffer.writeUInt16BE(this.applicationErrorCode, offset);
-        return buffer;
+        return offset + 2;
     }
 
     public getStreamId(): Bignum {
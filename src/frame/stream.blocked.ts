@@ -14,16 +14,14 @@ export class StreamBlockedFrame extends BaseFrame {
         this.blockedOffset = blockedOffset;
     }
     
-    public toBuffer(): Buffer {
-        var offset = 0;
-        var streamIDBuffer: Buffer = VLIE.encode(this.streamID);
-        var blockedOffsetBuffer: Buffer = VLIE.encode(this.blockedOffset);
-        var returnBuffer: Buffer = Buffer.alloc(streamIDBuffer.byteLength + blockedOffsetBuffer.byteLength + 1);
-        returnBuffer.writeUInt8(this.getType(), offset++);
-        streamIDBuffer.copy(returnBuffer, offset);
-        offset += streamIDBuffer.byteLength;
-        blockedOffsetBuffer.copy(returnBuffer, offset);
-        return returnBuffer;
+    public encodedLength(): number {
+        return 1 + VLIE.getEncodedByteLength(this.streamID) + VLIE.getEncodedByteLength(this.blockedOffset);
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.writeUInt8(this.getType(), offset++);
+        offset = VLIE.encodeInto(this.streamID, buffer, offset);
+        return VLIE.encodeInto(this.blockedOffset, buffer, offset);
     }
 
     public getStreamId(): Bignum {
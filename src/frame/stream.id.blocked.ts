@@ -11,13 +11,13 @@ export class StreamIdBlockedFrame extends BaseFrame {
         this.streamID = streamID;
     }
     
-    public toBuffer(): Buffer {
-        var offset = 0;
-        var streamIDBuffer: Buffer = VLIE.encode(this.streamID);
-        var returnBuffer: Buffer = Buffer.alloc(streamIDBuffer.byteLength + 1);
-        returnBuffer.writeUInt8(this.getType(), offset++);
-        streamIDBuffer.copy(returnBuffer, offset);
-        return returnBuffer;
+    public encodedLength(): number {
+        return 1 + VLIE.getEncodedByteLength(this.streamID);
+    }
+
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.writeUInt8(this.getType(), offset++);
+        return VLIE.encodeInto(this.streamID, buffer, offset);
     }
 
     public getStreamId(): Bignum {
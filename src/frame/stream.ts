@@ -13,12 +13,17 @@ export class StreamFrame extends BaseFrame {
     private length: Bignum;
     private offset: Bignum;
 
-    private data: Buffer;
+    // Scatter list: for outgoing frames, these are slices of the buffers the application handed to the stream (see Stream:popDataSlices)
+    // The bytes are only copied once, when the frame is encoded into its packet
+    private data: Buffer[];
+    private dataLength: number;
 
-    public constructor(streamID: Bignum, data: Buffer) {
+    public constructor(streamID: Bignum, data: Buffer | Buffer[]) {
         super(FrameType.STREAM, true);
         this.streamID = streamID;
-        this.data = data;
+        this.data = [];
+        this.dataLength = 0;
+        this.setData(data);
         this.fin =  false;
         this.len = false;
         this.off = false;
@@ -26,39 +31,30 @@ export class StreamFrame extends BaseFrame {
         this.offset = new Bignum(0);
     }
 
-    public toBuffer(): Buffer {
-        var type = this.getType();
-        var size = 1;
-        var streamIDBuffer = VLIE.encode(this.streamID);
-        size += streamIDBuffer.byteLength;
-        var lengthBuffer = undefined;
-        var offsetBuffer = undefined;
-
+    public encodedLength(): number {
+        let size = 1 + VLIE.getEncodedByteLength(this.streamID);
+        if (this.off) {
+            size += VLIE.getEncodedByteLength(this.offset);
+        }
         if (this.len) {
-            lengthBuffer = VLIE.encode(this.length)
-            size += lengthBuffer.byteLength;
+            size += VLIE.getEncodedByteLength(this.length);
         }
+        return size + this.dataLength;
+    }
 
+    public encodeInto(buffer: Buffer, offset: number): number {
+        buffer.writeUInt8(this.getType(), offset++);
+        offset = VLIE.encodeInto(this.streamID, buffer, offset);
         if (this.off) {
-            offsetBuffer = VLIE.encode(this.offset)
-            size += offsetBuffer.byteLength;
+            offset = VLIE.encodeInto(this.offset, buffer, offset);
         }
-
-        var buffer = Buffer.alloc(size + this.data.byteLength);
-        var offset = 0;
-        buffer.writeUInt8(type, offset++);
-        streamIDBuffer.copy(buffer, offset);
-        offset += streamIDBuffer.byteLength;
-        if (this.off && offsetBuffer !== undefined) {
-            offsetBuffer.copy(buffer, offset);
-            offset += offsetBuffer.byteLength;
+        if (this.len) {
+            offset = VLIE.encodeInto(this.length, buffer, offset);
         }
-        if (this.len && lengthBuffer !== undefined) {
-            lengthBuffer.copy(buffer, offset);
-            offset += lengthBuffer.byteLength;
+        for (let slice of this.data) {
+            offset += slice.copy(buffer, offset);
         }
-        this.data.copy(buffer, offset);
-        return buffer;
+        return offset;
     }
 
     public getType(): number {
@@ -130,12 +126,31 @@ export class StreamFrame extends BaseFrame {
         this.offset = value;
     }
 
+    // NOTE: for frames built from several slices, this copies them into a single Buffer (which is then kept). Use getDataSlices() where possible
     public getData(): Buffer {
+        if (this.data.length === 0) {
+            return Buffer.alloc(0);
+        }
+        if (this.data.length > 1) {
+            this.data = [Buffer.concat(this.data, this.dataLength)];
+        }
+        return this.data[0];
+    }
+
+    public getDataSlices(): Buffer[] {
         return this.data;
     }
 
-    public setData(buf: Buffer) {
-        this.data = buf;
+    public getDataLength(): number {
+        return this.dataLength;
+    }
+
+    public setData(data: Buffer | Buffer[]) {
+        this.data = (data instanceof Buffer) ? [data] : data;
+        this.dataLength = 0;
+        for (let slice of this.data) {
+            this.dataLength += slice.byteLength;
+        }
     }
 
     /**
@@ -4,7 +4,6 @@ import { Bignum } from "../../../types/bignum";
 import { Http3Message } from "../common/http3.message";
 import { Http3Header } from "../common/qpack/types/http3.header";
 import { VerboseLogging } from "../../../utilities/logging/verbose.logging";
-import { Http3ResourceParser, Http3ResourceParserEvent } from "./http3.resourceparser";
 import { Constants } from "../../../utilities/constants";
 import { readFileSync } from "fs";
 import { Http3RequestMetadata } from "./http3.requestmetadata";
@@ -37,14 +36,16 @@ let startedRequestCount:number = 0;
 let finishedRequestCount:number = 0;
 
 const client: Http3Client = new Http3Client(host, port);
+// the server can push the stylesheets and scripts of the page along with it: get() then uses those instead of requesting them
+client.allowPushes(32);
 
 client.on(Http3ClientEvent.CLIENT_CONNECTED, () => {
     // Default behaviour: 
     // Request file and scan for related resources if HTML or JS
     if (lookupTable === undefined) {
-        const resourceParser: Http3ResourceParser = new Http3ResourceParser();
-        resourceParser.on(Http3ResourceParserEvent.FILES_FOUND, (fileList: string[]) => {
-            VerboseLogging.info("HTTP/3 Resource parser found new resources");
+        // found while the HTML (or javascript) is still coming in: requested right away, like a browser does
+        client.on(Http3ClientEvent.RESOURCES_FOUND, (path: string, fileList: string[]) => {
+            VerboseLogging.info("HTTP/3 Resource parser found new resources in " + path);
             for (const file of fileList) {
                 VerboseLogging.info("Requesting newly found resource: " + file);
                 ++startedRequestCount;
@@ -62,10 +63,6 @@ client.on(Http3ClientEvent.CLIENT_CONNECTED, () => {
             console.info("HTTP3 response on path '" + path + "'\nHeaders: " + headerStrings + "\nContent:\n" + payload.toString("utf8"));
             VerboseLogging.info("HTTP3 response on path '" + path + "'\nHeaders: " + headerStrings + "\nContent:\n" + payload.toString("utf8"));
 
-            const mimeType: string | undefined = response.getHeaderFrame().getHeaderValue("Content-Type");
-            if (mimeType !== undefined) {
-                resourceParser.parseBuffer(payload, mimeType);
-            }
             ++finishedRequestCount;
 
             if( finishedRequestCount === startedRequestCount ){
@@ -1,5 +1,8 @@
 export enum Http3ClientEvent {
     CLIENT_CONNECTED = "connected",
-    RESPONSE_RECEIVED = "response_received",
+    RESPONSE_RECEIVED = "response_received", // (path, message, request stream ID). No stream ID for responses that were pushed
+    RESOURCES_FOUND = "resources_found", // (path of the response, paths of the resources), while the response is still coming in
+    PUSH_RECEIVED = "push_received", // (path, message) of a response the server pushed, RESPONSE_RECEIVED follows once get() is called for it
     ALL_REQUESTS_FINISHED = "all_requests_finished",
+    CONNECTION_CLOSED = "connection_closed", // the QUIC connection is gone (e.g., idle timeout or an error): pending requests won't be answered anymore
 }
\ No newline at end of file
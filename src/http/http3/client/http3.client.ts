@@ -13,25 +13,40 @@ import { Http3ReceivingControlStream as Http3ReceivingControlStream, Http3Endpoi
 import { Http3SendingControlStream } from "../common/http3.sendingcontrolstream";
 import { VerboseLogging } from "../../../utilities/logging/verbose.logging";
 import { EndpointType } from "../../../types/endpoint.type";
-import { Http3SettingsFrame, Http3PriorityFrame, Http3CancelPushFrame, Http3GoAwayFrame, Http3MaxPushIDFrame, PrioritizedElementType, ElementDependencyType } from "../common/frames";
+import { Http3SettingsFrame, Http3PriorityFrame, Http3CancelPushFrame, Http3GoAwayFrame, Http3MaxPushIDFrame, PrioritizedElementType, ElementDependencyType, Http3DataFrame, Http3HeaderFrame, Http3PushPromiseFrame } from "../common/frames";
 import { Http3QPackEncoder } from "../common/qpack/http3.qpackencoder";
 import { Http3QPackDecoder } from "../common/qpack/http3.qpackdecoder";
 import { Http3FrameParser } from "../common/parsers/http3.frame.parser";
 import { QlogWrapper } from "../../../utilities/logging/qlog.wrapper";
 import { Http3StreamState } from "../common/types/http3.streamstate";
 import { Http3DependencyTree } from "../common/prioritization/http3.deptree";
-import { Http3BaseFrame } from "../common/frames/http3.baseframe";
+import { Http3Scheduler } from "../common/prioritization/http3.scheduler";
+import { Http3BaseFrame, Http3FrameType } from "../common/frames/http3.baseframe";
 import { parseHttp3Message } from "../common/parsers/http3.message.parser";
+import { Http3StreamFrameParser } from "../common/parsers/http3.streamframe.parser";
 import { Http3Message } from "../common/http3.message";
 import { Http3PriorityScheme, Http3FIFOScheme, Http3RoundRobinScheme, Http3WeightedRoundRobinScheme, Http3FirefoxScheme } from "../common/prioritization/schemes/index"
 import { Http3RequestMetadata } from "./http3.requestmetadata";
+import { Http3ResourceParser, Http3ResourceParserEvent } from "../common/parsers/http3.resource.parser";
 import { Http3Response } from "../common/http3.response";
 import { Connection } from "../../../quicker/connection";
 
+// A response the server pushed, or promised to push. Kept until get() is called for its path
+interface Http3Push {
+    pushID: Bignum,
+    path?: string, // from the PUSH_PROMISE, which can arrive after the push stream has started
+    authority?: string, // of the get() that claimed it
+    weight?: number, // of the get() that claimed it, in case it has to be requested after all (see onPushCancelled)
+    metadata?: Http3RequestMetadata, // idem
+    frames: Http3BaseFrame[],
+    message?: Http3Message, // once the push stream has ended
+    claimed: boolean, // get() was called for its path
+}
+
 export class Http3Client extends EventEmitter {
     private quickerClient: Client;
     private prioritiser: Http3PriorityScheme;
-    private scheduleTimer?: NodeJS.Timer;
+    private scheduler?: Http3Scheduler;
     private sendingControlStream?: Http3SendingControlStream; // Client initiated
     private receivingControlStream?: Http3ReceivingControlStream; // Server initiated
 
@@ -46,6 +61,17 @@ export class Http3Client extends EventEmitter {
     private lastStreamID: Bignum = new Bignum(0);
 
     private pendingRequestStreams: QuicStream[] = [];
+    // bidirectional streams are only opened for requests, this is compared against the server's MAX_STREAMS
+    private openedRequestStreams: number = 0;
+    private connectionClosed: boolean = false;
+
+    // Server push: the server can't push anything until allowPushes() has sent MAX_PUSH_ID
+    private maxPushID?: Bignum;
+    private pushes: Map<string, Http3Push> = new Map<string, Http3Push>(); // by push ID
+    private pushIDsByPath: Map<string, string> = new Map<string, string>(); // promised pushes that haven't been claimed yet
+    private cancelledPushes: Set<string> = new Set<string>();
+    private requestedPaths: Set<string> = new Set<string>();
+    private pendingPushes: number = 0; // claimed by get(), but not completely received yet
 
     private http3FrameParser: Http3FrameParser;
 
@@ -83,6 +109,9 @@ export class Http3Client extends EventEmitter {
 
             // Send initial settings frame
             this.sendingControlStream.sendFrame(new Http3SettingsFrame([]));
+            if (this.maxPushID !== undefined) {
+                this.sendingControlStream.sendFrame(new Http3MaxPushIDFrame(this.maxPushID));
+            }
 
             // Frames needed for initial setup of the tree
             // E.g. moving or setting weights of placeholders
@@ -93,15 +122,23 @@ export class Http3Client extends EventEmitter {
 
             this.emit(Http3ClientEvent.CLIENT_CONNECTED);
 
-            // Schedule 1 chunk of 1000 bytes every 30ms
-            // TODO tweak numbers
-            // TODO Listen to congestion control events instead
-            this.scheduleTimer = setInterval(() => {
-                this.prioritiser.schedule();
-            }, 10);
+            // Request data is moved from the prioritiser to the streams whenever congestion control has room for it
+            this.scheduler = new Http3Scheduler(this.quickerClient.getConnection(), this.prioritiser);
         });
 
         this.quickerClient.on(QuickerEvent.NEW_STREAM, this.onNewStream);
+        this.quickerClient.on(QuickerEvent.CONNECTION_CLOSE, () => {
+            // can be reported more than once
+            if (this.connectionClosed) {
+                return;
+            }
+            this.connectionClosed = true;
+            this.isClosed = true;
+            if (this.scheduler !== undefined) {
+                this.scheduler.stop();
+            }
+            this.emit(Http3ClientEvent.CONNECTION_CLOSED);
+        });
     }
 
     private async onNewStream(quicStream: QuicStream) {
@@ -133,10 +170,8 @@ export class Http3Client extends EventEmitter {
                             this.setupControlStreamEvents(controlStream);
                         } else if (streamTypeBignum.equals(Http3UniStreamType.PUSH)) {
                             streamType = Http3UniStreamType.PUSH;
-                            // Server shouldn't receive push streams
-                            quicStream.end();
-                            quicStream.getConnection().sendPackets(); // we force trigger sending here because it's not yet done anywhere else. FIXME: This should be moved into stream prioritization scheduler later
-                            throw new Http3Error(Http3ErrorCode.HTTP_WRONG_STREAM_DIRECTION, "A push stream was initialized towards the server. This is not allowed");
+                            this.setupPushStream(quicStream, bufferedData);
+                            logger.onHTTPStreamStateChanged(quicStream.getStreamId(), Http3StreamState.REMOTELY_OPENED, "PUSH");
                         } else if (streamTypeBignum.equals(Http3UniStreamType.ENCODER)) {
                             streamType = Http3UniStreamType.ENCODER;
                             this.setupServerEncoderStream(quicStream, bufferedData);
@@ -175,14 +210,41 @@ export class Http3Client extends EventEmitter {
         }
     }
 
-    // Returns streamID of requeststream
-    public get(path: string, authority: string, weight: number = 16, metadata?: Http3RequestMetadata): Bignum {
+    // Returns streamID of requeststream, undefined if the server pushed (or promised to push) the response: no request is sent then
+    public get(path: string, authority: string, weight: number = 16, metadata?: Http3RequestMetadata): Bignum | undefined {
         if (this.isClosed === true) {
             throw new Http3Error(Http3ErrorCode.HTTP3_CLIENT_CLOSED, "Can not send new requests after client has been closed");
         }
         if (this.terminateConnection === true) {
             throw new Http3Error(Http3ErrorCode.HTTP3_SERVER_CLOSED, "Can not send request, server has requested that the connection be closed");
         }
+        if (this.claimPush(path, authority, weight, metadata)) {
+            return undefined;
+        }
+        return this.sendRequest(path, authority, weight, metadata);
+    }
+
+    /**
+     * Lets the server push up to maxPushes responses over this connection (MAX_PUSH_ID). The limit can only be raised
+     * Pushed responses are kept until get() is called for their path, which then uses the push instead of sending a request
+     * Pushes of paths that were already requested are cancelled
+     */
+    public allowPushes(maxPushes: number) {
+        if (maxPushes <= 0) {
+            return;
+        }
+        const maxPushID: Bignum = new Bignum(maxPushes - 1);
+        if (this.maxPushID !== undefined && maxPushID.lessThanOrEqual(this.maxPushID)) {
+            return;
+        }
+        this.maxPushID = maxPushID;
+        // before the connection is up, it's sent right after the SETTINGS
+        if (this.sendingControlStream !== undefined) {
+            this.sendingControlStream.sendFrame(new Http3MaxPushIDFrame(maxPushID));
+        }
+    }
+
+    private sendRequest(path: string, authority: string, weight: number, metadata?: Http3RequestMetadata): Bignum {
         if (this.clientQPackEncoder === undefined) {
             throw new Http3Error(Http3ErrorCode.HTTP3_UNINITIALISED_ENCODER);
         }
@@ -222,6 +284,8 @@ export class Http3Client extends EventEmitter {
 
         this.lastStreamID = stream.getStreamId();
         this.pendingRequestStreams.push(stream);
+        ++this.openedRequestStreams;
+        this.requestedPaths.add(path);
         VerboseLogging.info("Created new stream for HTTP/3 GET request. StreamID: " + stream.getStreamId());
 
         // TODO move logging to deptree because not all data will be sent instantly
@@ -253,10 +317,28 @@ export class Http3Client extends EventEmitter {
         this.prioritiser.addData(stream.getStreamId(), req.toBuffer());
         this.prioritiser.finishStream(stream.getStreamId());
 
-        let bufferedData: Buffer = new Buffer(0);
+        // frames are parsed as the response comes in, so the response is never re-concatenated or re-parsed as a whole
+        const frames: Http3BaseFrame[] = [];
+        let resourceParser: Http3ResourceParser | undefined = undefined;
+        const frameParser: Http3StreamFrameParser = new Http3StreamFrameParser(this.http3FrameParser, stream.getStreamId(), (frame: Http3BaseFrame) => {
+            if (frame.getFrameType() === Http3FrameType.PUSH_PROMISE) {
+                this.onPushPromise(frame as Http3PushPromiseFrame);
+                return;
+            }
+            if (frames.length === 0 && frame.getFrameType() === Http3FrameType.HEADERS) {
+                resourceParser = this.createResourceParser(path, frame as Http3HeaderFrame);
+            }
+            frames.push(frame);
+        }, (data: Buffer) => {
+            // DATA is handed over as it arrives, so subresources can be found (and requested) before the whole response is in
+            frames.push(new Http3DataFrame(data));
+            if (resourceParser !== undefined) {
+                resourceParser.parseChunk(data);
+            }
+        });
 
         stream.on(QuickerEvent.STREAM_DATA_AVAILABLE, (data: Buffer) => {
-            bufferedData = Buffer.concat([bufferedData, data]);
+            frameParser.parse(data);
             if (this.logger !== undefined) {
                 this.logger.onHTTPDataChunk(
                     stream.getStreamId(),
@@ -272,20 +354,21 @@ export class Http3Client extends EventEmitter {
 
             this.prioritiser.removeRequestStream(stream.getStreamId());
 
-            const [frames, newOffset]: [Http3BaseFrame[], number] = this.http3FrameParser.parse(bufferedData, stream.getStreamId());
+            frameParser.end();
+            if (resourceParser !== undefined) {
+                resourceParser.end();
+            }
             const message: Http3Message = parseHttp3Message(frames);
 
             // Send out event that the response has been received
-            this.emit(Http3ClientEvent.RESPONSE_RECEIVED, path, message)
+            this.emit(Http3ClientEvent.RESPONSE_RECEIVED, path, message, stream.getStreamId());
 
             // Mark request as completed
             this.pendingRequestStreams = this.pendingRequestStreams.filter((requestStream: QuicStream) => {
                 return requestStream.getStreamId() !== stream.getStreamId();
             });
 
-            if (this.pendingRequestStreams.length === 0) {
-                this.emit(Http3ClientEvent.ALL_REQUESTS_FINISHED);
-            }
+            this.checkAllRequestsFinished();
 
             stream.removeAllListeners();
         });
@@ -297,15 +380,43 @@ export class Http3Client extends EventEmitter {
         // Don't allow new requests to be made
         this.isClosed = true;
 
+        const closeConnection = () => {
+            if (this.scheduler !== undefined) {
+                this.scheduler.stop();
+            }
+
+            this.quickerClient.close();
+        };
+
         // Wait for outbound requests to complete
         // TODO This will give problems if server doesn't respond to all requests. Use a timeout as alternative
-        this.on(Http3ClientEvent.ALL_REQUESTS_FINISHED, () => {
-            if (this.scheduleTimer !== undefined) {
-                clearInterval(this.scheduleTimer);
+        if (this.getPendingRequestCount() === 0) {
+            if (!this.connectionClosed) {
+                closeConnection();
             }
+        } else {
+            this.on(Http3ClientEvent.ALL_REQUESTS_FINISHED, closeConnection);
+        }
+    }
 
-            this.quickerClient.close();
-        });
+    // Connected, and neither closed by us nor told to go away by the server
+    public canSendRequests(): boolean {
+        return this.sendingControlStream !== undefined && !this.isClosed && !this.terminateConnection;
+    }
+
+    // Requests that can still be sent before the server's MAX_STREAMS limit is reached (beyond it, QUIC holds them back until the server raises it)
+    public getRequestStreamCredit(): number {
+        if (this.sendingControlStream === undefined) {
+            return 0;
+        }
+        // the limit is kept as a stream ID: client bidirectional stream IDs are 0, 4, 8, ...
+        const maxStreams: number = Math.floor(this.quickerClient.getConnection().getRemoteMaxStreamBidi().toNumber() / 4);
+        return Math.max(0, maxStreams - this.openedRequestStreams);
+    }
+
+    // Requests (and claimed pushes) that haven't been answered yet
+    public getPendingRequestCount(): number {
+        return this.pendingRequestStreams.length + this.pendingPushes;
     }
 
     private setupControlStreamEvents(controlStream: Http3ReceivingControlStream) {
@@ -317,8 +428,8 @@ export class Http3Client extends EventEmitter {
             VerboseLogging.info("HTTP/3: priority frame received on client-sided control stream. ControlStreamID: " + controlStream.getStreamID().toDecimalString());
         });
         controlStream.on(Http3ControlStreamEvent.HTTP3_CANCEL_PUSH_FRAME, (frame: Http3CancelPushFrame) => {
-            // TODO
             VerboseLogging.info("HTTP/3: cancel push frame received on client-sided control stream. ControlStreamID: " + controlStream.getStreamID().toDecimalString() + " - Cancelled PushID: " + frame.getPushID().toDecimalString());
+            this.onPushCancelled(frame.getPushID());
         });
         controlStream.on(Http3ControlStreamEvent.HTTP3_SETTINGS_FRAME, (frame: Http3SettingsFrame) => {
             // TODO
@@ -361,6 +472,193 @@ export class Http3Client extends EventEmitter {
         this.clientQPackEncoder.setPeerDecoderStream(serverDecoderStream, bufferedStreamData.byteLength === 0 ? undefined : bufferedStreamData);
     }
 
+    private checkAllRequestsFinished() {
+        if (this.getPendingRequestCount() === 0) {
+            this.emit(Http3ClientEvent.ALL_REQUESTS_FINISHED);
+        }
+    }
+
+    // Returns the push with this ID (created if we haven't heard of it before), undefined if it was cancelled
+    private getPush(pushID: Bignum): Http3Push | undefined {
+        if (this.maxPushID === undefined || pushID.greaterThan(this.maxPushID)) {
+            throw new Http3Error(Http3ErrorCode.HTTP_ID_ERROR, "Server used push ID " + pushID.toDecimalString() + ", which is above the MAX_PUSH_ID we sent");
+        }
+        const key: string = pushID.toString();
+        if (this.cancelledPushes.has(key)) {
+            return undefined;
+        }
+        let push: Http3Push | undefined = this.pushes.get(key);
+        if (push === undefined) {
+            push = { pushID: pushID, frames: [], claimed: false };
+            this.pushes.set(key, push);
+        }
+        return push;
+    }
+
+    private onPushPromise(frame: Http3PushPromiseFrame) {
+        const push: Http3Push | undefined = this.getPush(frame.getPushID());
+        if (push === undefined || push.path !== undefined) {
+            // cancelled, or promised on another request stream before
+            return;
+        }
+        const path: string | undefined = frame.getHeaderValue(":path");
+        if (path === undefined || this.requestedPaths.has(path) || this.pushIDsByPath.has(path)) {
+            // we asked for it ourselves already (or it's being pushed twice)
+            this.cancelPush(push);
+            return;
+        }
+        push.path = path;
+        this.pushIDsByPath.set(path, push.pushID.toString());
+        VerboseLogging.info("Http3Client:onPushPromise : server promised to push " + path + ", push ID " + push.pushID.toDecimalString());
+        if (push.message !== undefined) {
+            // the push stream was faster than the promise
+            this.emit(Http3ClientEvent.PUSH_RECEIVED, path, push.message);
+        }
+    }
+
+    // The push ID comes first on a push stream, then the response, framed like on a request stream
+    private setupPushStream(pushStream: QuicStream, bufferedStreamData: Buffer) {
+        let bufferedData: Buffer = bufferedStreamData;
+        let push: Http3Push | undefined = undefined;
+        const frameParser: Http3StreamFrameParser = new Http3StreamFrameParser(this.http3FrameParser, pushStream.getStreamId(), (frame: Http3BaseFrame) => {
+            if (frame.getFrameType() === Http3FrameType.PUSH_PROMISE) {
+                throw new Http3Error(Http3ErrorCode.HTTP_UNEXPECTED_FRAME, "Received a PUSH_PROMISE frame on push stream " + pushStream.getStreamId().toDecimalString());
+            }
+            push!.frames.push(frame);
+        }, (data: Buffer) => {
+            push!.frames.push(new Http3DataFrame(data));
+        });
+        const isCancelled = (): boolean => {
+            return push === undefined || this.cancelledPushes.has(push.pushID.toString());
+        };
+
+        const onData = (data: Buffer) => {
+            if (push === undefined) {
+                bufferedData = Buffer.concat([bufferedData, data]);
+                let pushIDOffset: VLIEOffset;
+                try {
+                    pushIDOffset = VLIE.decode(bufferedData);
+                } catch (error) {
+                    if (error instanceof RangeError) {
+                        return; // push ID not completely in yet
+                    }
+                    throw error;
+                }
+                push = this.getPush(pushIDOffset.value);
+                if (push === undefined) {
+                    // cancelled: whatever the server still sends is ignored
+                    pushStream.removeAllListeners(QuickerEvent.STREAM_DATA_AVAILABLE);
+                    return;
+                }
+                data = bufferedData.slice(pushIDOffset.offset);
+                bufferedData = Buffer.alloc(0);
+            }
+            if (!isCancelled()) {
+                frameParser.parse(data);
+            }
+        };
+        pushStream.on(QuickerEvent.STREAM_DATA_AVAILABLE, onData);
+        if (bufferedData.byteLength > 0) {
+            const initialData: Buffer = bufferedData;
+            bufferedData = Buffer.alloc(0);
+            onData(initialData);
+        }
+
+        pushStream.on(QuickerEvent.STREAM_END, () => {
+            if (push === undefined || isCancelled()) {
+                return;
+            }
+            frameParser.end();
+            push.message = parseHttp3Message(push.frames);
+            push.frames = [];
+            if (push.path !== undefined) {
+                this.emit(Http3ClientEvent.PUSH_RECEIVED, push.path, push.message);
+            }
+            if (push.claimed) {
+                this.completeClaimedPush(push);
+            }
+        });
+    }
+
+    // get() for a path the server pushed or promised: the push is used instead of sending a request
+    private claimPush(path: string, authority: string, weight: number, metadata?: Http3RequestMetadata): boolean {
+        const key: string | undefined = this.pushIDsByPath.get(path);
+        if (key === undefined) {
+            return false;
+        }
+        const push: Http3Push = this.pushes.get(key)!;
+        this.pushIDsByPath.delete(path);
+        this.requestedPaths.add(path);
+        push.claimed = true;
+        push.authority = authority;
+        push.weight = weight;
+        push.metadata = metadata;
+        ++this.pendingPushes;
+        VerboseLogging.info("Http3Client:claimPush : " + path + " was pushed by the server, push ID " + push.pushID.toDecimalString());
+        if (push.message !== undefined) {
+            // already in: answer asynchronously, like a request would be
+            setImmediate(() => {
+                this.completeClaimedPush(push);
+            });
+        }
+        return true;
+    }
+
+    private completeClaimedPush(push: Http3Push) {
+        this.pushes.delete(push.pushID.toString());
+        --this.pendingPushes;
+        this.emit(Http3ClientEvent.RESPONSE_RECEIVED, push.path, push.message);
+        this.checkAllRequestsFinished();
+    }
+
+    // We don't want the push: tell the server to stop sending it
+    private cancelPush(push: Http3Push) {
+        const key: string = push.pushID.toString();
+        this.cancelledPushes.add(key);
+        this.pushes.delete(key);
+        if (this.sendingControlStream !== undefined) {
+            this.sendingControlStream.sendFrame(new Http3CancelPushFrame(push.pushID));
+        }
+        VerboseLogging.info("Http3Client:cancelPush : cancelled push ID " + push.pushID.toDecimalString() + (push.path !== undefined ? " (" + push.path + ")" : ""));
+    }
+
+    // The server won't push it after all: if get() was waiting for it, request it instead
+    private onPushCancelled(pushID: Bignum) {
+        const key: string = pushID.toString();
+        this.cancelledPushes.add(key);
+        const push: Http3Push | undefined = this.pushes.get(key);
+        if (push === undefined) {
+            return;
+        }
+        this.pushes.delete(key);
+        if (push.path === undefined) {
+            return;
+        }
+        if (this.pushIDsByPath.get(push.path) === key) {
+            this.pushIDsByPath.delete(push.path);
+        }
+        if (push.claimed && push.message === undefined) {
+            this.sendRequest(push.path, push.authority!, push.weight!, push.metadata);
+            --this.pendingPushes;
+        }
+    }
+
+    // Only if someone is listening for the resources, and the response is a document that can have any (see Http3ResourceParser)
+    private createResourceParser(path: string, headerFrame: Http3HeaderFrame): Http3ResourceParser | undefined {
+        if (this.listenerCount(Http3ClientEvent.RESOURCES_FOUND) === 0) {
+            return undefined;
+        }
+        const mimeType: string | undefined = headerFrame.getHeaderValue("content-type");
+        const resourceParser: Http3ResourceParser = new Http3ResourceParser();
+        if (mimeType === undefined || !resourceParser.startDocument(mimeType, path)) {
+            return undefined;
+        }
+        resourceParser.on(Http3ResourceParserEvent.FILES_FOUND, (files: string[]) => {
+            this.emit(Http3ClientEvent.RESOURCES_FOUND, path, files);
+        });
+        return resourceParser;
+    }
+
     public DEBUGgetQlogger():QlogWrapper|undefined {
         return this.logger;
     }
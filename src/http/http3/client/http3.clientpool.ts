@@ -0,0 +1,344 @@
+import { EventEmitter } from "events";
+import { Http3Client } from "./http3.client";
+import { Http3ClientEvent } from "./http3.client.events";
+import { Http3RequestMetadata } from "./http3.requestmetadata";
+import { Http3Message } from "../common/http3.message";
+import { Http3Error, Http3ErrorCode } from "../common/errors/http3.error";
+import { Bignum } from "../../../types/bignum";
+import { Constants } from "../../../utilities/constants";
+import { VerboseLogging } from "../../../utilities/logging/verbose.logging";
+
+export enum Http3ClientPoolEvent {
+    RESPONSE_RECEIVED = "response_received", // (request: Http3PoolRequest, response: Http3Message)
+    REQUEST_FAILED = "request_failed", // (request: Http3PoolRequest, reason: string)
+    ALL_REQUESTS_FINISHED = "all_requests_finished",
+}
+
+export interface Http3PoolRequest {
+    host: string,
+    port: number,
+    path: string,
+    metadata?: Http3RequestMetadata,
+    queuedTime: number, // ms (see Http3ClientPool:now), when it was handed to the pool
+    sentTime?: number, // ms, when it was (last) sent on a connection
+    attempts: number, // amount of connections it was sent on
+}
+
+// Creates the connections of the pool, can be replaced to test the pool without a network (see test.clientpool.ts)
+export type Http3ClientFactory = (host: string, port: number) => Http3Client;
+
+// A single connection of an origin
+class Http3PoolConnection {
+    public client: Http3Client;
+    public connected: boolean = false;
+    // requests in flight, by request stream ID
+    public requests: Map<string, Http3PoolRequest> = new Map<string, Http3PoolRequest>();
+
+    public constructor(client: Http3Client) {
+        this.client = client;
+    }
+}
+
+// The connections to a host:port, and the requests that are waiting for one of them
+class Http3PoolOrigin {
+    public host: string;
+    public port: number;
+    public authority: string;
+    public connections: Http3PoolConnection[] = [];
+    public queue: Http3PoolRequest[] = [];
+    // connections that were lost before they were established, since the last one that was
+    public failedAttempts: number = 0;
+    // connections that are waiting for their backoff to end (see Http3ClientPool:scheduleReconnect)
+    public reconnectTimers: NodeJS.Timer[] = [];
+
+    public constructor(host: string, port: number) {
+        this.host = host;
+        this.port = port;
+        this.authority = host + ":" + port;
+    }
+}
+
+/**
+ * Spreads requests over several HTTP/3 connections per origin, e.g., to generate load (see loadgenerator.ts)
+ * A request goes to the connection with the fewest requests in flight that still has stream credit (the server's MAX_STREAMS),
+ * if there is none it waits in a queue per origin until a response comes in
+ * Lost connections are replaced (with exponential backoff) and the requests they didn't answer are sent again on another one,
+ * up to HTTP3_POOL_MAX_ATTEMPTS times. Only GETs are sent, so that's always safe
+ */
+export class Http3ClientPool extends EventEmitter {
+    private connectionsPerOrigin: number;
+    private createClient: Http3ClientFactory;
+    private origins: Map<string, Http3PoolOrigin> = new Map<string, Http3PoolOrigin>();
+    private pendingRequests: number = 0; // queued or in flight
+    private isClosed: boolean = false;
+
+    public constructor(connectionsPerOrigin: number = Constants.HTTP3_POOL_CONNECTIONS_PER_ORIGIN,
+                       createClient: Http3ClientFactory = (host: string, port: number) => new Http3Client(host, port)) {
+        super();
+        if (!(connectionsPerOrigin >= 1)) {
+            throw new Error("Http3ClientPool: needs at least one connection per origin, got " + connectionsPerOrigin);
+        }
+        this.connectionsPerOrigin = connectionsPerOrigin;
+        this.createClient = createClient;
+    }
+
+    /**
+     * Sends a GET request on one of the connections to host:port, which are opened on first use
+     * The response is reported with RESPONSE_RECEIVED, or REQUEST_FAILED if it never came
+     */
+    public get(host: string, port: number, path: string, metadata?: Http3RequestMetadata): Http3PoolRequest {
+        if (this.isClosed) {
+            throw new Http3Error(Http3ErrorCode.HTTP3_CLIENT_CLOSED, "Can not send new requests after the pool has been closed");
+        }
+        const origin: Http3PoolOrigin = this.getOrigin(host, port);
+        const request: Http3PoolRequest = {
+            host: host,
+            port: port,
+            path: path,
+            metadata: metadata,
+            queuedTime: Http3ClientPool.now(),
+            attempts: 0,
+        };
+        origin.queue.push(request);
+        ++this.pendingRequests;
+        this.dispatch(origin);
+        return request;
+    }
+
+    public getPendingRequestCount(): number {
+        return this.pendingRequests;
+    }
+
+    public getConnectionCount(): number {
+        let count: number = 0;
+        this.origins.forEach((origin: Http3PoolOrigin) => {
+            count += origin.connections.length;
+        });
+        return count;
+    }
+
+    // Closes all connections once every request has been answered (or has failed)
+    public close() {
+        this.isClosed = true;
+        // no more reconnects: requests waiting for an origin without connections would wait forever
+        let failed: boolean = false;
+        for (const origin of this.origins.values()) {
+            for (const timer of origin.reconnectTimers) {
+                clearTimeout(timer);
+            }
+            origin.reconnectTimers = [];
+            failed = this.checkOriginDown(origin) || failed;
+        }
+        if (failed) {
+            this.checkAllRequestsFinished();
+        }
+        const closeConnections = () => {
+            this.origins.forEach((origin: Http3PoolOrigin) => {
+                for (const connection of origin.connections) {
+                    connection.client.close();
+                }
+            });
+        };
+        if (this.pendingRequests === 0) {
+            closeConnections();
+        } else {
+            this.once(Http3ClientPoolEvent.ALL_REQUESTS_FINISHED, closeConnections);
+        }
+    }
+
+    // in ms, with sub-millisecond precision
+    public static now(): number {
+        const time: [number, number] = process.hrtime();
+        return time[0] * 1000 + time[1] / 1000000;
+    }
+
+    private getOrigin(host: string, port: number): Http3PoolOrigin {
+        const key: string = host + ":" + port;
+        let origin: Http3PoolOrigin | undefined = this.origins.get(key);
+        if (origin === undefined) {
+            origin = new Http3PoolOrigin(host, port);
+            this.origins.set(key, origin);
+            for (let i = 0; i < this.connectionsPerOrigin; ++i) {
+                this.connect(origin);
+            }
+        }
+        return origin;
+    }
+
+    private connect(origin: Http3PoolOrigin) {
+        let client: Http3Client;
+        try {
+            client = this.createClient(origin.host, origin.port);
+        } catch (error) {
+            VerboseLogging.error("Http3ClientPool:connect : could not connect to " + origin.authority + " : " + error);
+            ++origin.failedAttempts;
+            if (!this.isClosed) {
+                this.scheduleReconnect(origin);
+            }
+            if (this.checkOriginDown(origin)) {
+                this.checkAllRequestsFinished();
+            }
+            return;
+        }
+
+        const connection: Http3PoolConnection = new Http3PoolConnection(client);
+        origin.connections.push(connection);
+
+        client.on(Http3ClientEvent.CLIENT_CONNECTED, () => {
+            connection.connected = true;
+            origin.failedAttempts = 0;
+            this.dispatch(origin);
+        });
+        client.on(Http3ClientEvent.RESPONSE_RECEIVED, (path: string, response: Http3Message, streamID?: Bignum) => {
+            // pool connections don't allow pushes, so every response has a request stream
+            const request: Http3PoolRequest | undefined = streamID === undefined ? undefined : connection.requests.get(streamID.toString());
+            if (request === undefined) {
+                return;
+            }
+            connection.requests.delete(streamID!.toString());
+            --this.pendingRequests;
+            this.emit(Http3ClientPoolEvent.RESPONSE_RECEIVED, request, response);
+            // a stream less in flight: room for the next one
+            this.dispatch(origin);
+            this.checkAllRequestsFinished();
+        });
+        client.on(Http3ClientEvent.CONNECTION_CLOSED, () => {
+            this.onConnectionLost(origin, connection);
+        });
+    }
+
+    private onConnectionLost(origin: Http3PoolOrigin, connection: Http3PoolConnection) {
+        const index: number = origin.connections.indexOf(connection);
+        if (index < 0) {
+            return;
+        }
+        origin.connections.splice(index, 1);
+        if (!connection.connected) {
+            ++origin.failedAttempts;
+        }
+        VerboseLogging.warn("Http3ClientPool:onConnectionLost : lost a connection to " + origin.authority + " with " + connection.requests.size + " requests in flight");
+
+        // unanswered requests go first in line for the other connections
+        const retries: Http3PoolRequest[] = [];
+        connection.requests.forEach((request: Http3PoolRequest) => {
+            if (request.attempts >= Constants.HTTP3_POOL_MAX_ATTEMPTS) {
+                this.fail(request, "connection lost " + request.attempts + " times");
+            } else {
+                retries.push(request);
+            }
+        });
+        connection.requests.clear();
+        origin.queue = retries.concat(origin.queue);
+
+        if (!this.isClosed) {
+            this.scheduleReconnect(origin);
+        }
+        this.checkOriginDown(origin);
+        this.dispatch(origin);
+        this.checkAllRequestsFinished();
+    }
+
+    private scheduleReconnect(origin: Http3PoolOrigin) {
+        const delay: number = Math.min(Constants.HTTP3_POOL_RECONNECT_DELAY * Math.pow(2, origin.failedAttempts), Constants.HTTP3_POOL_MAX_RECONNECT_DELAY);
+        const timer: NodeJS.Timer = setTimeout(() => {
+            origin.reconnectTimers.splice(origin.reconnectTimers.indexOf(timer), 1);
+            if (!this.isClosed) {
+                this.connect(origin);
+            }
+        }, delay);
+        origin.reconnectTimers.push(timer);
+    }
+
+    /**
+     * Fails the queued requests of an origin that seems to be down (too many connections in a row failed before they were established),
+     * or that has no connections left and none on the way (e.g., after close()): nothing would ever send them otherwise
+     * Returns true if requests were failed
+     */
+    private checkOriginDown(origin: Http3PoolOrigin): boolean {
+        if (origin.queue.length === 0) {
+            return false;
+        }
+        let reason: string;
+        if (origin.failedAttempts >= Constants.HTTP3_POOL_MAX_ATTEMPTS && !this.hasConnectedConnection(origin)) {
+            reason = "could not connect to " + origin.authority;
+        } else if (origin.connections.length === 0 && origin.reconnectTimers.length === 0) {
+            reason = "no connections left to " + origin.authority;
+        } else {
+            return false;
+        }
+        const queue: Http3PoolRequest[] = origin.queue;
+        origin.queue = [];
+        for (const request of queue) {
+            this.fail(request, reason);
+        }
+        return true;
+    }
+
+    /**
+     * Sends queued requests on the least loaded connections that have stream credit left
+     * A connection that is out of credit but has nothing in flight is still used: QUIC then holds the stream back and tells the server (STREAMS_BLOCKED),
+     * instead of us waiting for a MAX_STREAMS that might never come by itself
+     */
+    private dispatch(origin: Http3PoolOrigin) {
+        while (origin.queue.length > 0) {
+            const connection: Http3PoolConnection | undefined = this.getLeastLoadedConnection(origin);
+            if (connection === undefined) {
+                return;
+            }
+            this.send(origin, connection, origin.queue.shift()!);
+        }
+    }
+
+    private getLeastLoadedConnection(origin: Http3PoolOrigin): Http3PoolConnection | undefined {
+        let leastLoaded: Http3PoolConnection | undefined = undefined;
+        for (const connection of origin.connections) {
+            if (!connection.connected || !connection.client.canSendRequests()) {
+                continue;
+            }
+            const inFlight: number = connection.requests.size;
+            if (inFlight > 0 && connection.client.getRequestStreamCredit() === 0) {
+                continue;
+            }
+            if (leastLoaded === undefined || inFlight < leastLoaded.requests.size) {
+                leastLoaded = connection;
+            }
+        }
+        return leastLoaded;
+    }
+
+    private send(origin: Http3PoolOrigin, connection: Http3PoolConnection, request: Http3PoolRequest) {
+        ++request.attempts;
+        request.sentTime = Http3ClientPool.now();
+        let streamID: Bignum | undefined;
+        try {
+            streamID = connection.client.get(request.path, origin.authority, undefined, request.metadata);
+        } catch (error) {
+            // e.g., no mimetype can be derived from the path: sending it again won't help
+            this.fail(request, error.message);
+            this.checkAllRequestsFinished();
+            return;
+        }
+        connection.requests.set(streamID!.toString(), request);
+    }
+
+    private hasConnectedConnection(origin: Http3PoolOrigin): boolean {
+        for (const connection of origin.connections) {
+            if (connection.connected) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    private fail(request: Http3PoolRequest, reason: string) {
+        --this.pendingRequests;
+        VerboseLogging.error("Http3ClientPool : request for " + request.path + " on " + request.host + ":" + request.port + " failed : " + reason);
+        this.emit(Http3ClientPoolEvent.REQUEST_FAILED, request, reason);
+    }
+
+    private checkAllRequestsFinished() {
+        if (this.pendingRequests === 0) {
+            this.emit(Http3ClientPoolEvent.ALL_REQUESTS_FINISHED);
+        }
+    }
+}
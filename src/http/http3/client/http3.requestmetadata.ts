@@ -11,4 +11,6 @@ export interface Http3RequestMetadata {
     delayPriorityFrame?: number, // ms
     childrenStart?: string[], // List of file paths that are discovered during transmission of the parent
     childrenEnd?: string[], // List of files that are discovered after the parent is completed
+    priority?: string, // value of the priority request header (e.g., "u=1, i"), see Http3ExtensiblePrioritiesScheme
+    push?: string[], // Files the server pushes along with this one (if the client allows it), instead of waiting for the client to discover and request them
 }
\ No newline at end of file
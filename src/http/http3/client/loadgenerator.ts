@@ -0,0 +1,220 @@
+import { Http3ClientPool, Http3ClientPoolEvent, Http3PoolRequest } from "./http3.clientpool";
+import { Http3Message } from "../common/http3.message";
+import { Constants } from "../../../utilities/constants";
+import { writeFileSync } from "fs";
+
+// node loadgenerator.js host port [--connections=4] [--requests=10000] [--concurrency=1000] [--paths=/index.html,/QUIC.png] [--output=results.json]
+// Keeps <concurrency> GET requests in flight, spread over a pool of <connections> connections (see Http3ClientPool),
+// until <requests> have been answered. The paths are requested round robin
+// Afterwards, the latency percentiles and throughput are printed (and written to <output> as JSON)
+
+interface LoadGeneratorOptions {
+    host: string,
+    port: number,
+    connections: number,
+    requests: number,
+    concurrency: number,
+    paths: string[],
+    outputFile?: string,
+}
+
+interface LatencyPercentiles {
+    p50: number,
+    p90: number,
+    p99: number,
+    p999: number,
+    max: number,
+    mean: number,
+}
+
+interface LoadGeneratorResult {
+    options: LoadGeneratorOptions,
+    completed: number,
+    failed: number,
+    duration: number, // ms
+    requestsPerSecond: number,
+    bytes: number, // response payloads
+    megabitsPerSecond: number,
+    statusCodes: {[status: string]: number},
+    responseTime: LatencyPercentiles, // ms, from handing the request to the pool to the complete response: includes waiting for a connection or stream credit
+    serviceTime: LatencyPercentiles, // ms, from sending the request on its connection to the complete response
+}
+
+export class Http3LoadGenerator {
+    private options: LoadGeneratorOptions;
+    private pool: Http3ClientPool;
+
+    private started: number = 0;
+    private completed: number = 0;
+    private failed: number = 0;
+    private bytes: number = 0;
+    private statusCodes: {[status: string]: number} = {};
+    private responseTimes: number[] = [];
+    private serviceTimes: number[] = [];
+    private startTime: number = 0;
+    private isSending: boolean = false;
+
+    public constructor(options: LoadGeneratorOptions) {
+        this.options = options;
+        this.pool = new Http3ClientPool(options.connections);
+    }
+
+    public static parseArguments(args: string[]): LoadGeneratorOptions {
+        const options: LoadGeneratorOptions = {
+            host: args[0] || "127.0.0.1",
+            port: parseInt(args[1]) || 4433,
+            connections: Constants.HTTP3_POOL_CONNECTIONS_PER_ORIGIN,
+            requests: 10000,
+            concurrency: 1000,
+            paths: ["/index.html"],
+        };
+
+        for (const arg of args.slice(2)) {
+            const [option, value] = arg.split("=");
+            switch (option) {
+                case "--connections":
+                    options.connections = Number(value);
+                    break;
+                case "--requests":
+                    options.requests = Number(value);
+                    break;
+                case "--concurrency":
+                    options.concurrency = Number(value);
+                    break;
+                case "--paths":
+                    options.paths = value.split(",");
+                    break;
+                case "--output":
+                    options.outputFile = value;
+                    break;
+                default:
+                    throw new Error("Http3LoadGenerator: unknown option " + arg);
+            }
+        }
+        if (!(options.connections >= 1) || !(options.requests >= 1) || !(options.concurrency >= 1) || options.paths.length === 0) {
+            throw new Error("Http3LoadGenerator: invalid options " + JSON.stringify(options));
+        }
+        return options;
+    }
+
+    public run(): Promise<LoadGeneratorResult> {
+        return new Promise<LoadGeneratorResult>((resolve) => {
+            this.pool.on(Http3ClientPoolEvent.RESPONSE_RECEIVED, (request: Http3PoolRequest, response: Http3Message) => {
+                const now: number = Http3ClientPool.now();
+                ++this.completed;
+                this.bytes += response.getPayload().byteLength;
+                const status: string = response.getHeaderFrame().getHeaderValue(":status") || "none";
+                this.statusCodes[status] = (this.statusCodes[status] || 0) + 1;
+                this.responseTimes.push(now - request.queuedTime);
+                this.serviceTimes.push(now - request.sentTime!);
+                this.sendRequests();
+            });
+            this.pool.on(Http3ClientPoolEvent.REQUEST_FAILED, () => {
+                ++this.failed;
+                this.sendRequests();
+            });
+
+            let lastCompleted: number = 0;
+            const progress = setInterval(() => {
+                console.log("Http3LoadGenerator: " + this.completed + " completed (" + (this.completed - lastCompleted) + "/s), " + this.failed + " failed, " +
+                            this.pool.getPendingRequestCount() + " pending on " + this.pool.getConnectionCount() + " connections");
+                lastCompleted = this.completed;
+            }, 1000);
+
+            this.pool.on(Http3ClientPoolEvent.ALL_REQUESTS_FINISHED, () => {
+                if (this.started < this.options.requests) {
+                    return; // requests failed right away, while sendRequests() was still adding new ones
+                }
+                clearInterval(progress);
+                this.pool.close();
+                resolve(this.getResult());
+            });
+
+            this.startTime = Http3ClientPool.now();
+            this.sendRequests();
+        });
+    }
+
+    // tops the amount of requests in flight back up to the concurrency
+    private sendRequests() {
+        // requests can fail right away, which calls us again: the loop below already takes care of those
+        if (this.isSending) {
+            return;
+        }
+        this.isSending = true;
+        while (this.started < this.options.requests && this.pool.getPendingRequestCount() < this.options.concurrency) {
+            const path: string = this.options.paths[this.started % this.options.paths.length];
+            ++this.started;
+            this.pool.get(this.options.host, this.options.port, path);
+        }
+        this.isSending = false;
+    }
+
+    private getResult(): LoadGeneratorResult {
+        const duration: number = Http3ClientPool.now() - this.startTime;
+        return {
+            options: this.options,
+            completed: this.completed,
+            failed: this.failed,
+            duration: duration,
+            requestsPerSecond: this.completed / (duration / 1000),
+            bytes: this.bytes,
+            megabitsPerSecond: (this.bytes * 8 / 1000000) / (duration / 1000),
+            statusCodes: this.statusCodes,
+            responseTime: Http3LoadGenerator.getPercentiles(this.responseTimes),
+            serviceTime: Http3LoadGenerator.getPercentiles(this.serviceTimes),
+        };
+    }
+
+    // nearest rank
+    private static getPercentiles(values: number[]): LatencyPercentiles {
+        if (values.length === 0) {
+            return { p50: 0, p90: 0, p99: 0, p999: 0, max: 0, mean: 0 };
+        }
+        const sorted: number[] = values.slice().sort((a: number, b: number) => a - b);
+        const percentile = (p: number): number => {
+            return sorted[Math.min(sorted.length - 1, Math.ceil(p / 100 * sorted.length) - 1)];
+        };
+        let sum: number = 0;
+        for (const value of sorted) {
+            sum += value;
+        }
+        return {
+            p50: percentile(50),
+            p90: percentile(90),
+            p99: percentile(99),
+            p999: percentile(99.9),
+            max: sorted[sorted.length - 1],
+            mean: sum / sorted.length,
+        };
+    }
+
+    public static report(result: LoadGeneratorResult) {
+        const format = (latencies: LatencyPercentiles): string => {
+            return "p50 " + latencies.p50.toFixed(1) + ", p90 " + latencies.p90.toFixed(1) + ", p99 " + latencies.p99.toFixed(1) +
+                   ", p99.9 " + latencies.p999.toFixed(1) + ", max " + latencies.max.toFixed(1) + ", mean " + latencies.mean.toFixed(1) + " (ms)";
+        };
+        console.log("");
+        console.log("Http3LoadGenerator: " + result.completed + " requests completed, " + result.failed + " failed in " + (result.duration / 1000).toFixed(2) + " s");
+        console.log("  throughput    : " + result.requestsPerSecond.toFixed(1) + " requests/s, " + result.megabitsPerSecond.toFixed(2) + " Mbit/s");
+        console.log("  status codes  : " + JSON.stringify(result.statusCodes));
+        console.log("  response time : " + format(result.responseTime));
+        console.log("  service time  : " + format(result.serviceTime));
+    }
+}
+
+const loadGeneratorOptions: LoadGeneratorOptions = Http3LoadGenerator.parseArguments(process.argv.slice(2));
+console.log("Http3LoadGenerator: " + loadGeneratorOptions.requests + " requests to " + loadGeneratorOptions.host + ":" + loadGeneratorOptions.port + ", " +
+            loadGeneratorOptions.concurrency + " at a time over " + loadGeneratorOptions.connections + " connections");
+
+new Http3LoadGenerator(loadGeneratorOptions).run().then((result: LoadGeneratorResult) => {
+    Http3LoadGenerator.report(result);
+    if (loadGeneratorOptions.outputFile !== undefined) {
+        writeFileSync(loadGeneratorOptions.outputFile, JSON.stringify(result, null, 4));
+        console.log("Http3LoadGenerator: results written to " + loadGeneratorOptions.outputFile);
+    }
+    // give the connections a moment to close cleanly
+    setTimeout(() => {
+        process.exit(result.failed === 0 ? 0 : 1);
+    }, 500);
+});
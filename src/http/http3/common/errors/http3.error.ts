@@ -18,6 +18,7 @@ export enum Http3ErrorCode {
     // Errors mentioned in RFC
     HTTP_WRONG_STREAM_DIRECTION,
     HTTP_UNEXPECTED_FRAME,
+    HTTP_ID_ERROR,
 }
 
 /**
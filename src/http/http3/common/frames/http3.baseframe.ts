@@ -8,6 +8,7 @@ export enum Http3FrameType {
     GOAWAY = 0x7,
     MAX_PUSH_ID = 0xD,
     DUPLICATE_PUSH = 0xE,
+    PRIORITY_UPDATE = 0xF0700, // RFC 9218, for request streams
     RESERVED = 0x21, // All formats that match with "0x1f * N + 0x21"
 }
 
@@ -5,9 +5,13 @@ import { VLIE } from "../../../../types/vlie";
 export class Http3CancelPushFrame extends Http3BaseFrame {
     private pushID: Bignum;
 
-    public constructor(payload: Buffer) {
+    public constructor(pushID: Bignum) {
         super();
-        this.pushID = VLIE.decode(payload).value;
+        this.pushID = pushID;
+    }
+
+    public static fromPayload(payload: Buffer): Http3CancelPushFrame {
+        return new Http3CancelPushFrame(VLIE.decode(payload).value);
     }
 
     public toBuffer(): Buffer {
@@ -10,18 +10,20 @@ export class Http3DataFrame extends Http3BaseFrame {
         this.payload = payload;
     }
 
+    // NOTE: copies the payload. When sending, use toBuffers() instead
     public toBuffer(): Buffer {
-        const type: Buffer = VLIE.encode(this.getFrameType());
-        const encodedLength: Buffer = VLIE.encode(this.getEncodedLength());
-
-        let buffer: Buffer = Buffer.alloc(type.byteLength + encodedLength.byteLength + this.payload.byteLength);
-
-        // Copy contents to buffer
-        type.copy(buffer);
-        encodedLength.copy(buffer, type.byteLength);
-        this.payload.copy(buffer, type.byteLength + encodedLength.byteLength);
+        return Buffer.concat(this.toBuffers());
+    }
 
-        return buffer;
+    // The encoded frame as [frame header (type + length), payload], without copying the payload
+    // These can be passed down to QuicStream:write as they are: the payload is only copied once, into the packet that carries it
+    public toBuffers(): Buffer[] {
+        const header: Buffer = Buffer.alloc(VLIE.getEncodedByteLength(this.getFrameType()) + VLIE.getEncodedByteLength(this.payload.byteLength));
+        VLIE.encodeInto(this.payload.byteLength, header, VLIE.encodeInto(this.getFrameType(), header, 0));
+        if (this.payload.byteLength === 0) {
+            return [header];
+        }
+        return [header, this.payload];
     }
 
     public static fromPayload(payload: Buffer): Http3DataFrame {
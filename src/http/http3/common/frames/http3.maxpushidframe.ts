@@ -5,9 +5,13 @@ import { VLIE } from "../../../../types/vlie";
 export class Http3MaxPushIDFrame extends Http3BaseFrame {
     private maxPushID: Bignum;
 
-    public constructor(payload: Buffer) {
+    public constructor(maxPushID: Bignum) {
         super();
-        this.maxPushID = VLIE.decode(payload).value;
+        this.maxPushID = maxPushID;
+    }
+
+    public static fromPayload(payload: Buffer): Http3MaxPushIDFrame {
+        return new Http3MaxPushIDFrame(VLIE.decode(payload).value);
     }
 
     public toBuffer(): Buffer {
@@ -25,4 +29,8 @@ export class Http3MaxPushIDFrame extends Http3BaseFrame {
     public getFrameType(): Http3FrameType {
         return Http3FrameType.MAX_PUSH_ID;
     }
+
+    public getMaxPushID(): Bignum {
+        return this.maxPushID;
+    }
 }
@@ -0,0 +1,54 @@
+import { Http3BaseFrame, Http3FrameType } from "./http3.baseframe";
+import { Bignum } from "../../../../types/bignum";
+import { VLIE, VLIEOffset } from "../../../../types/vlie";
+import { Http3Error, Http3ErrorCode } from "../errors/http3.error";
+
+/**
+ * Changes the priority of a request after it has been sent, see "Extensible Prioritization Scheme for HTTP" (RFC 9218)
+ * Only sent by clients, on their control stream
+ * Payload:
+ *  Prioritized Element ID: VLIE, the request stream the update applies to
+ *  Priority Field Value: the rest of the frame, in the same (ASCII) format as the priority request header, e.g., "u=2, i"
+ */
+export class Http3PriorityUpdateFrame extends Http3BaseFrame {
+    private requestStreamID: Bignum;
+    private priorityFieldValue: string;
+
+    public constructor(requestStreamID: Bignum, priorityFieldValue: string) {
+        super();
+        this.requestStreamID = requestStreamID;
+        this.priorityFieldValue = priorityFieldValue;
+    }
+
+    public static fromPayload(payload: Buffer): Http3PriorityUpdateFrame {
+        if (payload.byteLength === 0) {
+            throw new Http3Error(Http3ErrorCode.HTTP3_MALFORMED_FRAME, "PRIORITY_UPDATE frame without prioritized element ID");
+        }
+        const requestStreamID: VLIEOffset = VLIE.decode(payload);
+        return new Http3PriorityUpdateFrame(requestStreamID.value, payload.toString("ascii", requestStreamID.offset));
+    }
+
+    public toBuffer(): Buffer {
+        const type: Buffer = VLIE.encode(this.getFrameType());
+        const encodedLength: Buffer = VLIE.encode(this.getEncodedLength());
+        const requestStreamID: Buffer = VLIE.encode(this.requestStreamID);
+
+        return Buffer.concat([type, encodedLength, requestStreamID, Buffer.from(this.priorityFieldValue, "ascii")]);
+    }
+
+    public getEncodedLength(): number {
+        return VLIE.getEncodedByteLength(this.requestStreamID) + Buffer.byteLength(this.priorityFieldValue, "ascii");
+    }
+
+    public getFrameType(): Http3FrameType {
+        return Http3FrameType.PRIORITY_UPDATE;
+    }
+
+    public getRequestStreamID(): Bignum {
+        return this.requestStreamID;
+    }
+
+    public getPriorityFieldValue(): string {
+        return this.priorityFieldValue;
+    }
+}
@@ -0,0 +1,80 @@
+import { Http3BaseFrame, Http3FrameType } from "./http3.baseframe";
+import { Bignum } from "../../../../types/bignum";
+import { VLIE, VLIEOffset } from "../../../../types/vlie";
+import { Http3Header } from "../qpack/types/http3.header";
+import { Http3QPackEncoder } from "../qpack/http3.qpackencoder";
+import { Http3QPackDecoder } from "../qpack/http3.qpackdecoder";
+import { Http3Error, Http3ErrorCode } from "../errors/http3.error";
+
+/**
+ * Announces a server push: the request the server will answer on a push stream, without the client having to send it
+ * Only sent by servers, on the request stream of the response the pushed resource belongs to
+ * Payload:
+ *  Push ID: VLIE, also sent at the start of the push stream that carries the response
+ *  Header Block: the QPACK encoded request headers, encoded like a HEADERS frame on the request stream
+ */
+export class Http3PushPromiseFrame extends Http3BaseFrame {
+    private pushID: Bignum;
+    private headers: Http3Header[];
+    private requestStreamID: Bignum;
+    private encoder: Http3QPackEncoder;
+
+    public constructor(pushID: Bignum, headers: Http3Header[], requestStreamID: Bignum, encoder: Http3QPackEncoder) {
+        super();
+        this.pushID = pushID;
+        this.headers = headers;
+        this.requestStreamID = requestStreamID;
+        this.encoder = encoder;
+    }
+
+    public static fromPayload(payload: Buffer, requestStreamID: Bignum, encoder: Http3QPackEncoder, decoder: Http3QPackDecoder): Http3PushPromiseFrame {
+        if (payload.byteLength === 0) {
+            throw new Http3Error(Http3ErrorCode.HTTP3_MALFORMED_FRAME, "PUSH_PROMISE frame without push ID");
+        }
+        const pushID: VLIEOffset = VLIE.decode(payload);
+        const headers: Http3Header[] = decoder.decodeHeaders(payload.slice(pushID.offset), requestStreamID);
+
+        return new Http3PushPromiseFrame(pushID.value, headers, requestStreamID, encoder);
+    }
+
+    public toBuffer(): Buffer {
+        const type: Buffer = VLIE.encode(this.getFrameType());
+        const pushID: Buffer = VLIE.encode(this.pushID);
+        const headerBlock: Buffer = this.encode();
+        const encodedLength: Buffer = VLIE.encode(pushID.byteLength + headerBlock.byteLength);
+
+        return Buffer.concat([type, encodedLength, pushID, headerBlock]);
+    }
+
+    public getEncodedLength(): number {
+        // Use dryrun so encoder doesn't automatically transmit updates to decoder
+        return VLIE.getEncodedByteLength(this.pushID) + this.encode(true).byteLength;
+    }
+
+    public getFrameType(): Http3FrameType {
+        return Http3FrameType.PUSH_PROMISE;
+    }
+
+    public getPushID(): Bignum {
+        return this.pushID;
+    }
+
+    public getHeaders(): Http3Header[] {
+        return this.headers;
+    }
+
+    public getHeaderValue(property: string): string | undefined {
+        const name: string = property.toLowerCase();
+        for (const header of this.headers) {
+            if (header.name.toLowerCase() === name) {
+                return header.value;
+            }
+        }
+        return undefined;
+    }
+
+    // Dryrun can be enabled so the encoder doesn't automatically send encoder stream data to the decoder
+    private encode(dryrun: boolean = false): Buffer {
+        return this.encoder.encodeHeaders(this.headers, this.requestStreamID, dryrun);
+    }
+}
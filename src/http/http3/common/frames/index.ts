@@ -6,6 +6,8 @@ import { Http3SettingsFrame } from "./http3.settingsframe";
 import { Http3GoAwayFrame } from "./http3.goawayframe";
 import { Http3MaxPushIDFrame } from "./http3.maxpushidframe";
 import { Http3DuplicatePushFrame } from "./http3.duplicatepushframe";
+import { Http3PriorityUpdateFrame } from "./http3.priorityupdateframe";
+import { Http3PushPromiseFrame } from "./http3.pushpromiseframe";
 
 export {
     ElementDependencyType,
@@ -17,5 +19,7 @@ export {
     Http3HeaderFrame,
     Http3MaxPushIDFrame,
     Http3PriorityFrame,
+    Http3PriorityUpdateFrame,
+    Http3PushPromiseFrame,
     PrioritizedElementType,
 };
\ No newline at end of file
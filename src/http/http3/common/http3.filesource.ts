@@ -0,0 +1,110 @@
+import { open, fstat, read, close, Stats } from "fs";
+import { Http3DataFrame } from "./frames/http3.dataframe";
+import { VerboseLogging } from "../../../utilities/logging/verbose.logging";
+import { Constants } from "../../../utilities/constants";
+
+// Response body that is read from disk piece by piece, as the prioritisation scheme gets around to sending it
+// Instead of reading the whole file up front (and keeping it in memory until it's sent), a node asks for the next chunk (requestData())
+// when it runs low on buffered data. Each chunk is read asynchronously and handed over as a separate DATA frame,
+// so a response never holds more than a couple of chunks in memory and the event loop is never blocked on disk I/O
+export class Http3FileSource {
+    private path: string;
+    private chunkSize: number;
+    private fd?: number;
+    private size: number = 0;
+    private position: number = 0;
+    private reading: boolean = false;
+    private closed: boolean = false;
+
+    private onData?: (frame: Buffer[]) => void;
+    private onEnd?: () => void;
+
+    public constructor(path: string, chunkSize: number = Constants.HTTP3_FILE_CHUNK_SIZE) {
+        this.path = path;
+        this.chunkSize = chunkSize;
+    }
+
+    // Opens the file and resolves with its size (needed for the content-length header, before any data is read)
+    public open(): Promise<number> {
+        return new Promise<number>((resolve, reject) => {
+            open(this.path, "r", (err: NodeJS.ErrnoException | null, fd: number) => {
+                if (err) {
+                    reject(err);
+                    return;
+                }
+                fstat(fd, (statErr: NodeJS.ErrnoException | null, stats: Stats) => {
+                    if (statErr || !stats.isFile()) {
+                        close(fd, () => {});
+                        reject(statErr ? statErr : new Error("Http3FileSource:open : not a regular file : " + this.path));
+                        return;
+                    }
+                    this.fd = fd;
+                    this.size = stats.size;
+                    resolve(this.size);
+                });
+            });
+        });
+    }
+
+    public getSize(): number {
+        return this.size;
+    }
+
+    // onData is called with each encoded DATA frame (as frame header + chunk, see Http3DataFrame:toBuffers), onEnd after the last one (or when reading fails: the stream is then ended early)
+    public attach(onData: (frame: Buffer[]) => void, onEnd: () => void) {
+        this.onData = onData;
+        this.onEnd = onEnd;
+    }
+
+    // Starts reading the next chunk if that isn't already happening. Calling this more often than needed is harmless
+    public requestData() {
+        if (this.reading || this.closed || this.fd === undefined || this.onData === undefined) {
+            return;
+        }
+        if (this.position >= this.size) {
+            this.finish();
+            return;
+        }
+
+        this.reading = true;
+        const length: number = Math.min(this.chunkSize, this.size - this.position);
+        const chunk: Buffer = Buffer.allocUnsafe(length);
+        read(this.fd, chunk, 0, length, this.position, (err: NodeJS.ErrnoException | null, bytesRead: number) => {
+            this.reading = false;
+            if (this.closed) {
+                return;
+            }
+            if (err || bytesRead === 0) {
+                // the file changed underneath us: we can't send anything sensible anymore, so end the response here
+                VerboseLogging.error("Http3FileSource:requestData : reading " + this.path + " failed at offset " + this.position + " : " + (err ? err.message : "unexpected end of file"));
+                this.finish();
+                return;
+            }
+
+            this.position += bytesRead;
+            this.onData!(new Http3DataFrame(chunk.slice(0, bytesRead)).toBuffers());
+            if (this.position >= this.size) {
+                this.finish();
+            }
+        });
+    }
+
+    // Stops reading and releases the file descriptor. Safe to call more than once
+    public close() {
+        if (this.closed) {
+            return;
+        }
+        this.closed = true;
+        if (this.fd !== undefined) {
+            close(this.fd, () => {});
+            this.fd = undefined;
+        }
+    }
+
+    private finish() {
+        this.close();
+        if (this.onEnd !== undefined) {
+            this.onEnd();
+        }
+    }
+}
@@ -3,8 +3,9 @@ import { Http3BaseFrame, Http3FrameType } from "./frames/http3.baseframe";
 import { Http3Error, Http3ErrorCode } from "./errors/http3.error";
 import { EventEmitter } from "events";
 import { Http3FrameParser } from "./parsers/http3.frame.parser";
+import { Http3StreamFrameParser } from "./parsers/http3.streamframe.parser";
 import { QuickerEvent } from "../../../quicker/quicker.event";
-import { Http3PriorityFrame, Http3SettingsFrame, Http3CancelPushFrame, Http3GoAwayFrame, Http3MaxPushIDFrame } from "./frames";
+import { Http3PriorityFrame, Http3SettingsFrame, Http3CancelPushFrame, Http3GoAwayFrame, Http3MaxPushIDFrame, Http3PriorityUpdateFrame } from "./frames";
 import { Bignum } from "../../../types/bignum";
 import { QlogWrapper } from "../../../utilities/logging/qlog.wrapper";
 
@@ -19,13 +20,13 @@ export enum Http3ControlStreamEvent {
     HTTP3_SETTINGS_FRAME = "settings",
     HTTP3_GOAWAY_FRAME = "goaway",
     HTTP3_MAX_PUSH_ID = "max push id",
+    HTTP3_PRIORITY_UPDATE_FRAME = "priority update",
 }
 
 export class Http3ReceivingControlStream extends EventEmitter {
     private quicControlStream: QuicStream;
     private endpointType: Http3EndpointType;
-    private frameParser: Http3FrameParser;
-    private bufferedData: Buffer;
+    private frameParser: Http3StreamFrameParser;
     private firstFrameHandled: boolean = false;
     private logger: QlogWrapper;
 
@@ -37,23 +38,20 @@ export class Http3ReceivingControlStream extends EventEmitter {
         }
         this.quicControlStream = quicControlStream;
         this.endpointType = endpointType;
-        this.frameParser = frameParser;
+        this.frameParser = new Http3StreamFrameParser(frameParser, quicControlStream.getStreamId(), (frame: Http3BaseFrame) => {
+            this.handleFrame(frame);
+        });
         this.logger = logger;
-        if (initialBuffer === undefined) {
-            this.bufferedData = Buffer.alloc(0);
-        } else {
-            this.bufferedData = initialBuffer;
-            this.parseCurrentBuffer();
+        if (initialBuffer !== undefined) {
+            this.frameParser.parse(initialBuffer);
         }
 
         quicControlStream.on(QuickerEvent.STREAM_DATA_AVAILABLE, (data: Buffer) => {
-            this.bufferedData = Buffer.concat([this.bufferedData, data]);
-            this.parseCurrentBuffer();
+            this.frameParser.parse(data);
         });
 
         quicControlStream.on(QuickerEvent.STREAM_END, () => {
-            this.parseCurrentBuffer();
-            // TODO check if unparsed data leftover before ending stream
+            this.frameParser.end();
             // quicControlStream.getConnection().sendPackets(); // TODO we force trigger sending here because it's not yet done anywhere else. FIXME: THIS SHOULDN'T BE NEEDED!
             quicControlStream.end();
         });
@@ -67,14 +65,6 @@ export class Http3ReceivingControlStream extends EventEmitter {
         return this.quicControlStream;
     }
 
-    private parseCurrentBuffer() {
-        const [frames, offset] = this.frameParser.parse(this.bufferedData, this.getStreamID());
-        for (let frame of frames) {
-            this.handleFrame(frame);
-        }
-        this.bufferedData = this.bufferedData.slice(offset);
-    }
-
     private handleFrame(frame: Http3BaseFrame) {
         if (this.firstFrameHandled === false && frame.getFrameType() !== Http3FrameType.SETTINGS) {
             throw new Http3Error(Http3ErrorCode.HTTP_UNEXPECTED_FRAME, "First frame received on HTTP/3 control stream was not a settings frame. This is not allowed. StreamID: " + this.quicControlStream.getStreamId().toDecimalString());
@@ -99,6 +89,12 @@ export class Http3ReceivingControlStream extends EventEmitter {
             case Http3FrameType.MAX_PUSH_ID:
                 this.emit(Http3ControlStreamEvent.HTTP3_MAX_PUSH_ID, frame as Http3MaxPushIDFrame);
                 break;
+            case Http3FrameType.PRIORITY_UPDATE:
+                if (this.endpointType === Http3EndpointType.CLIENT) {
+                    throw new Http3Error(Http3ErrorCode.HTTP_UNEXPECTED_FRAME, "Received a PRIORITY_UPDATE frame from the server. Only clients can send these.");
+                }
+                this.emit(Http3ControlStreamEvent.HTTP3_PRIORITY_UPDATE_FRAME, frame as Http3PriorityUpdateFrame);
+                break;
             default:
                 // Frametype not handled by control stream
                 throw new Http3Error(Http3ErrorCode.HTTP3_UNEXPECTED_FRAME)
@@ -4,8 +4,17 @@ import { Http3Header } from "./qpack/types/http3.header";
 import { Bignum } from "../../../types/bignum";
 
 export class Http3Request {    
-    private content: Buffer = new Buffer(0);
+    // kept as the pieces it arrived in, they're only concatenated once the content is read (see getContent)
+    private content: Buffer[] = [];
     private headerFrame: Http3HeaderFrame;
+    // filled in by the server's router, for routes with parameters (e.g., /users/:id)
+    private params: {[name: string]: string} = {};
+
+    // Request body, as it arrives. Until a handler calls onBody(), DATA is collected in content
+    // After that, it's passed on directly and not kept, so large uploads don't have to be buffered
+    private bodyListener?: (data: Buffer) => void;
+    private bodyEndListeners: Array<() => void> = [];
+    private bodyEnded: boolean = false;
     
     public constructor(requestStreamID: Bignum, encoder: Http3QPackEncoder, headers: Http3Header[] = []) {
         this.headerFrame = new Http3HeaderFrame(headers, requestStreamID, encoder);
@@ -13,7 +22,7 @@ export class Http3Request {
     
     public toBuffer(): Buffer {        
         let buffer: Buffer = this.headerFrame.toBuffer();
-        buffer = Buffer.concat([buffer, this.content]);
+        buffer = Buffer.concat([buffer, this.getContent()]);
 
         return buffer;
     }
@@ -27,7 +36,7 @@ export class Http3Request {
     }
     
     public getDataFrame(): Http3DataFrame {
-        return new Http3DataFrame(this.content);
+        return new Http3DataFrame(this.getContent());
     }
     
     public setHeader(property: string, value: string) {
@@ -39,10 +48,103 @@ export class Http3Request {
     }
     
     public appendContent(content: Buffer) {
-        this.content = Buffer.concat([this.content, content]);
+        if (content.byteLength > 0) {
+            this.content.push(content);
+        }
     }
     
     public setContent(content: Buffer) {
-        this.content = content;
+        this.content = [content];
+        this.bodyEnded = true;
+    }
+
+    public getContent(): Buffer {
+        if (this.content.length === 0) {
+            return new Buffer(0);
+        }
+        if (this.content.length > 1) {
+            this.content = [Buffer.concat(this.content)];
+        }
+        return this.content[0];
+    }
+
+    // path without query string
+    public getPath(): string | undefined {
+        const path: string | undefined = this.getHeaderValue(":path");
+        if (path === undefined) {
+            return undefined;
+        }
+        const queryStart: number = path.indexOf("?");
+        return queryStart < 0 ? path : path.substring(0, queryStart);
+    }
+
+    public getParam(name: string): string | undefined {
+        return this.params[name];
+    }
+
+    public getParams(): {[name: string]: string} {
+        return this.params;
+    }
+
+    public setParams(params: {[name: string]: string}) {
+        this.params = params;
+    }
+
+    /**
+     * Streams the request body to the handler: onData gets whatever was received so far right away, and all further DATA as it arrives
+     * onEnd is called once the whole body has been received (immediately if that's already the case)
+     */
+    public onBody(onData: (data: Buffer) => void, onEnd?: () => void) {
+        if (this.content.length > 0) {
+            const received: Buffer = this.getContent();
+            this.content = [];
+            onData(received);
+        }
+        this.bodyListener = onData;
+        if (onEnd !== undefined) {
+            if (this.bodyEnded) {
+                onEnd();
+            } else {
+                this.bodyEndListeners.push(onEnd);
+            }
+        }
+    }
+
+    // resolves with the complete body. Don't combine with onBody(), which hands out the data instead of keeping it
+    public getBody(): Promise<Buffer> {
+        if (this.bodyEnded) {
+            return Promise.resolve(this.getContent());
+        }
+        return new Promise<Buffer>((resolve) => {
+            this.bodyEndListeners.push(() => {
+                resolve(this.getContent());
+            });
+        });
+    }
+
+    public isBodyComplete(): boolean {
+        return this.bodyEnded;
+    }
+
+    // called by the server for every DATA frame received on the request stream
+    public addBodyData(data: Buffer) {
+        if (this.bodyListener !== undefined) {
+            this.bodyListener(data);
+        } else {
+            this.appendContent(data);
+        }
+    }
+
+    // called by the server when the request stream has ended
+    public endBody() {
+        if (this.bodyEnded) {
+            return;
+        }
+        this.bodyEnded = true;
+        const listeners: Array<() => void> = this.bodyEndListeners;
+        this.bodyEndListeners = [];
+        for (const listener of listeners) {
+            listener();
+        }
     }
 }
@@ -1,18 +1,31 @@
 import { Http3HeaderFrame, Http3DataFrame } from "./frames";
 import { resolve, extname } from "path";
-import { existsSync, readFileSync } from "fs";
 import { Http3QPackEncoder } from "./qpack/http3.qpackencoder";
 import { Http3QPackDecoder } from "./qpack/http3.qpackdecoder";
 import { Http3Header } from "./qpack/types/http3.header";
 import { Bignum } from "../../../types/bignum";
 import { VerboseLogging } from "../../../utilities/logging/verbose.logging";
 import { Constants } from "../../../utilities/constants";
+import { Http3FileSource } from "./http3.filesource";
+import { Http3StaticCache, Http3StaticCacheEntry } from "./http3.staticcache";
+import { Http3Request } from "./http3.request";
+
+export interface Http3ResponseFrames {
+    headers: Buffer, // encoded HEADERS frame
+    body?: Buffer[] | Http3FileSource, // encoded DATA frame (see Http3DataFrame:toBuffers), or a file that still has to be read. Not set for 304 responses
+    resources?: string[], // subresources of an HTML file, as found by the static cache. Only for 200 responses of files it keeps in memory
+}
 
 export class Http3Response {
     private ready: boolean = false;
     private content?: Buffer;
     private filePath?: string;
     private headerFrame: Http3HeaderFrame;
+    // Responses that are generated piece by piece (write()/end()) go straight to the stream's prioritiser through these (see attach())
+    private onStreamData?: (data: Buffer | Buffer[]) => void;
+    private onStreamEnd?: () => void;
+    private headersSent: boolean = false;
+    private ended: boolean = false;
     // -> Content-Type
     private publicDir: string;
 
@@ -28,73 +41,170 @@ export class Http3Response {
         }
     }
 
-    public toBuffer(): Buffer {
-        let dataFrame: Http3DataFrame | undefined;
-
+    /**
+     * Encodes the response. Files are looked up in the static cache: small ones are sent straight from memory,
+     * for larger ones the body is an Http3FileSource that has only been opened, not read:
+     * hand it to the prioritiser (Http3PriorityScheme:addDataSource) so it's read chunk by chunk as it's being sent
+     * If the request carries validators (If-None-Match, If-Modified-Since) that match the file, a 304 without body is returned instead
+     */
+    public async getFrames(staticCache: Http3StaticCache, request?: Http3Request): Promise<Http3ResponseFrames> {
         this.headerFrame.setHeaderValue("server", "quicker/h3-20");
 
         if (this.filePath !== undefined) {
-            // Trim everything after first '?'
-            let trimmedPath: string = this.filePath;
-            const matches: RegExpMatchArray | null = this.filePath.match(this.trimQueryParamsPattern);
-            if (matches !== null) {
-                trimmedPath = matches[1];
+            return this.getFileFrames(staticCache, request, true);
+        } 
+        else if (this.content !== undefined) {
+            return { headers: this.headerFrame.toBuffer(), body: new Http3DataFrame(this.content).toBuffers() };
+        }
+        else {
+            throw new Error("Tried sending a HTTP response without a payload.");
+        }
+    }
+
+    private async getFileFrames(staticCache: Http3StaticCache, request: Http3Request | undefined, retryIfChanged: boolean): Promise<Http3ResponseFrames> {
+        let absoluteFilePath: string = this.getAbsoluteFilePath();
+        let entry: Http3StaticCacheEntry;
+        try {
+            entry = await staticCache.get(absoluteFilePath);
+            this.setStatus(200);
+        }
+        catch (e) {
+            VerboseLogging.error("HTTP3Response:getFrames : file does not exist : " + absoluteFilePath);
+            entry = await staticCache.get(resolve(__dirname) + this.publicDir + "/notfound.html");
+            this.setStatus(404);
+        }
+
+        if (request !== undefined && this.headerFrame.getHeaderValue(":status") === "200" &&
+            Http3StaticCache.isNotModified(entry, request.getHeaderValue("if-none-match"), request.getHeaderValue("if-modified-since"))) {
+            VerboseLogging.info("Client copy of " + absoluteFilePath + " is still valid, sending 304");
+            this.setStatus(304);
+            this.setHeaderValue("etag", entry.etag);
+            this.setHeaderValue("last-modified", entry.lastModified);
+            return { headers: this.headerFrame.toBuffer() };
+        }
+
+        for (const header of entry.headers) {
+            // a user handler might have chosen a different content-type
+            if (header.name !== "content-type" || this.headerFrame.getHeaderValue(header.name) === undefined) {
+                this.setHeaderValue(header.name, header.value);
             }
+        }
 
-            trimmedPath = trimmedPath.replace( new RegExp("%20", "g"), " ");
+        if (entry.body !== undefined) {
+            VerboseLogging.info("Sending file: " + entry.path + " (" + entry.size + " bytes, cached)");
+            const resources: string[] | undefined = this.headerFrame.getHeaderValue(":status") === "200" ? entry.resources : undefined;
+            return { headers: this.headerFrame.toBuffer(), body: [entry.body], resources: resources };
+        }
 
-            let absoluteFilePath = this.parsePath(resolve(__dirname) + this.publicDir + trimmedPath);
-            if (!existsSync(absoluteFilePath)) {
-                VerboseLogging.error("HTTP3Response:sendFile : file does not exist : " + absoluteFilePath);
-                console.error("toBuffer:sendFile : file does not exist : " + absoluteFilePath);
-                absoluteFilePath = resolve(__dirname) + this.publicDir + "/notfound.html";
-                this.setStatus(404);
-            } else {
-                this.setStatus(200);
+        const source: Http3FileSource = new Http3FileSource(entry.path);
+        const size: number = await source.open();
+        if (size !== entry.size) {
+            // the file changed and the watcher hasn't told us yet: our headers are wrong, so look it up again
+            source.close();
+            staticCache.invalidate(entry.path);
+            if (retryIfChanged) {
+                return this.getFileFrames(staticCache, request, false);
             }
-            VerboseLogging.info("Reading file: " + absoluteFilePath);
+            throw new Error("HTTP3Response:getFrames : " + entry.path + " keeps changing while it's being sent");
+        }
+        VerboseLogging.info("Sending file: " + entry.path + " (" + size + " bytes)");
 
-            dataFrame = new Http3DataFrame(readFileSync(absoluteFilePath));
-            this.setHeaderValue("content-length", dataFrame.getEncodedLength().toString());
-            return Buffer.concat([this.headerFrame.toBuffer(), dataFrame.toBuffer()]);
+        return { headers: this.headerFrame.toBuffer(), body: source };
+    }
+
+    // Set up by the server before the request handler is called, so write() can hand out frames immediately
+    public attach(onData: (data: Buffer | Buffer[]) => void, onEnd: () => void) {
+        this.onStreamData = onData;
+        this.onStreamEnd = onEnd;
+    }
 
-        } else if (this.content !== undefined) {
-            dataFrame = new Http3DataFrame(this.content);
+    /**
+     * Sends part of the response body right away, instead of waiting for the handler to finish (e.g., for generated or proxied content)
+     * The headers are sent along with the first write, so set them (and the status) before calling this
+     * Can't be combined with sendFile() or sendBuffer()
+     */
+    public write(data: Buffer): boolean {
+        if (this.filePath !== undefined || this.content !== undefined || this.ended) {
+            return false;
+        }
+        if (this.onStreamData === undefined) {
+            throw new Error("HTTP3Response:write : response is not attached to a stream");
+        }
+        this.ready = true;
+        if (!this.headersSent) {
+            this.headerFrame.setHeaderValue("server", "quicker/h3-20");
+            if (this.headerFrame.getHeaderValue(":status") === undefined) {
+                this.setStatus(200);
+            }
+            this.headersSent = true;
+            this.onStreamData(this.headerFrame.toBuffer());
         }
+        if (data.byteLength > 0) {
+            this.onStreamData(new Http3DataFrame(data).toBuffers());
+        }
+        return true;
+    }
 
-        if (dataFrame !== undefined) {
-            return Buffer.concat([this.headerFrame.toBuffer(), dataFrame.toBuffer()]);
-        } else {
+    // Ends a response that was started with write(). Nothing can be sent after this
+    public end(data: Buffer = Buffer.alloc(0)): boolean {
+        if (!this.write(data)) {
+            return false;
+        }
+        this.ended = true;
+        this.onStreamEnd!();
+        return true;
+    }
+
+    // true once write() has been used: the response is then already (partly) sent and getFrames() can no longer be used
+    public isStreaming(): boolean {
+        return this.headersSent;
+    }
+
+    public isEnded(): boolean {
+        return this.ended;
+    }
+
+    // Only for responses with in-memory content (sendBuffer). Files are never read in one go, use getFrames() for those
+    public toBuffer(): Buffer {
+        if (this.filePath !== undefined) {
+            throw new Error("HTTP3Response:toBuffer : file responses are read asynchronously, use getFrames() instead");
+        }
+        if (this.content === undefined) {
             throw new Error("Tried sending a HTTP response without a payload.");
         }
+        this.headerFrame.setHeaderValue("server", "quicker/h3-20");
+        return Buffer.concat([this.headerFrame.toBuffer(), new Http3DataFrame(this.content).toBuffer()]);
+    }
+
+    private getAbsoluteFilePath(): string {
+        // Trim everything after first '?'
+        let trimmedPath: string = this.filePath!;
+        const matches: RegExpMatchArray | null = trimmedPath.match(this.trimQueryParamsPattern);
+        if (matches !== null) {
+            trimmedPath = matches[1];
+        }
+
+        trimmedPath = trimmedPath.replace( new RegExp("%20", "g"), " ");
+
+        return this.parsePath(resolve(__dirname) + this.publicDir + trimmedPath);
     }
 
     public sendFile(path: string): boolean {
         // Can only send something when no other content has been buffered
-        if (this.ready === true) {
+        if (this.ready === true || this.headersSent) {
             return false;
         }
         this.filePath = path;
         this.ready = true;
 
-        let mimeType: string;
-        try{
-            mimeType = Http3Response.extensionToMimetype(this.getFileExtension(), this.filePath);
-        }
-        catch(e){
-            VerboseLogging.error("HTTP3Response:sendFile : extension unknown, defaulting to unknown mimetype " + this.filePath);
-            console.error("HTTP3Response:sendFile : extension unknown, defaulting to unknown mimetype " + this.filePath);
-            mimeType = "unknown";
-        }
-
-        this.setHeaderValue("Content-Type", mimeType);
+        // Content-Type (and the other entity headers) come from the static cache, see getFrames()
 
         return true;
     }
 
     public sendBuffer(content: Buffer, mimeType?: string): boolean {
         // Can only send something when no other content has been buffered
-        if (this.content !== undefined || this.filePath != undefined) {
+        if (this.content !== undefined || this.filePath != undefined || this.headersSent) {
             return false;
         }
         this.content = content;
@@ -128,12 +238,9 @@ export class Http3Response {
         return this.filePath;
     }
 
+    // based on the requested path only, without touching the disk (if the file doesn't exist, getFrames() sends notfound.html with its own Content-Type)
     public getFileExtension(): string {
-        let absoluteFilePath = this.parsePath(resolve(__dirname) + this.publicDir + this.filePath);
-        if (!existsSync(absoluteFilePath)) {
-            absoluteFilePath = resolve(__dirname) + this.publicDir + "/notfound.html";
-        }
-        return extname(absoluteFilePath);
+        return extname(this.parsePath(resolve(__dirname) + this.publicDir + this.filePath));
     }
 
     public getHeaderFrame(): Http3HeaderFrame {
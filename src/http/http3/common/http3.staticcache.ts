@@ -0,0 +1,301 @@
+import { stat, readFile, watch, Stats, FSWatcher } from "fs";
+import { Http3DataFrame } from "./frames/http3.dataframe";
+import { Http3Header } from "./qpack/types/http3.header";
+import { VerboseLogging } from "../../../utilities/logging/verbose.logging";
+import { Constants } from "../../../utilities/constants";
+import { Http3ResourceParser, Http3ResourceParserEvent } from "./parsers/http3.resource.parser";
+
+export interface Http3StaticCacheEntry {
+    path: string, // absolute path on disk
+    size: number,
+    etag: string,
+    lastModified: string, // HTTP date
+    modifiedTime: number, // mtime in ms, rounded down to whole seconds (HTTP dates have no better precision)
+    headers: Http3Header[], // content-type, content-length, etag and last-modified for a 200 response
+    body?: Buffer, // the whole file as an encoded DATA frame, only for files up to HTTP3_STATIC_CACHE_MAX_FILE_SIZE
+    resources?: string[], // for HTML files with a body: the subresources they refer to (see Http3ResourceParser), candidates for server push
+                          // as written in the file: relative ones depend on the path the file is requested with (see Http3Server:getPushCandidates)
+}
+
+// A load from disk that's in progress. Concurrent requests for a file that isn't cached yet share it
+class Http3StaticCacheLoad {
+    public promise!: Promise<Http3StaticCacheEntry>;
+    // the file changed (or was invalidated) while we were loading it: what we read is served, but not cached
+    public stale: boolean = false;
+    // installed before we look at the file, so we can't miss a change that happens while we're reading it. Becomes the entry's watcher once it's cached
+    public watcher?: FSWatcher;
+}
+
+// LRU cache of static files served by Http3Response
+// For every file, this keeps what would otherwise be redone for each request: stat()ing the path, the mimetype lookup, the validators (ETag, Last-Modified)
+// and, for small files, the contents themselves, already framed as a single DATA frame that can be handed to every stream that asks for it
+// Entries are dropped as soon as fs.watch reports a change to the file, so we never serve stale content for long
+// NOTE: the headers can't be cached in their QPACK-encoded form: the encoder's dynamic table is per connection, so they're still encoded for every response
+export class Http3StaticCache {
+    // JS Maps keep insertion order: we re-insert entries when they're used, so the first entry is always the least recently used one
+    private entries: Map<string, Http3StaticCacheEntry> = new Map<string, Http3StaticCacheEntry>();
+    private watchers: Map<string, FSWatcher> = new Map<string, FSWatcher>();
+    private loading: Map<string, Http3StaticCacheLoad> = new Map<string, Http3StaticCacheLoad>();
+    private cachedBytes: number = 0;
+
+    // maps a file path to its mimetype (Http3Response:extensionToMimetype), throws if it's unknown
+    private mimeTypeResolver: (path: string) => string;
+    private maxBytes: number;
+    private maxFileSize: number;
+    private maxEntries: number;
+
+    public constructor(mimeTypeResolver: (path: string) => string, maxBytes: number = Constants.HTTP3_STATIC_CACHE_SIZE, maxFileSize: number = Constants.HTTP3_STATIC_CACHE_MAX_FILE_SIZE, maxEntries: number = Constants.HTTP3_STATIC_CACHE_MAX_ENTRIES) {
+        this.mimeTypeResolver = mimeTypeResolver;
+        this.maxBytes = maxBytes;
+        this.maxFileSize = Math.min(maxFileSize, maxBytes);
+        this.maxEntries = maxEntries;
+    }
+
+    /**
+     * Resolves with the cache entry for the file at the given absolute path, loading it from disk if needed
+     * Rejects if the file doesn't exist or isn't a regular file
+     */
+    public get(path: string): Promise<Http3StaticCacheEntry> {
+        const entry: Http3StaticCacheEntry | undefined = this.entries.get(path);
+        if (entry !== undefined) {
+            this.entries.delete(path);
+            this.entries.set(path, entry);
+            return Promise.resolve(entry);
+        }
+
+        let pending: Http3StaticCacheLoad | undefined = this.loading.get(path);
+        if (pending === undefined) {
+            const load: Http3StaticCacheLoad = new Http3StaticCacheLoad();
+            load.promise = this.load(path, load);
+            this.loading.set(path, load);
+            const done = () => {
+                if (this.loading.get(path) === load) {
+                    this.loading.delete(path);
+                }
+            };
+            load.promise.then(done, done);
+            pending = load;
+        }
+        return pending.promise;
+    }
+
+    // drops the entry for the given path (if any), the next request will load it from disk again
+    // a load of this path that's still in progress isn't cached when it's done. Loads of other paths aren't affected
+    public invalidate(path: string) {
+        const load: Http3StaticCacheLoad | undefined = this.loading.get(path);
+        if (load !== undefined) {
+            load.stale = true;
+            this.loading.delete(path);
+        }
+        this.remove(path);
+    }
+
+    public clear() {
+        this.loading.forEach((load: Http3StaticCacheLoad) => {
+            load.stale = true;
+        });
+        this.loading.clear();
+        for (const path of Array.from(this.entries.keys())) {
+            this.remove(path);
+        }
+    }
+
+    public getEntryCount(): number {
+        return this.entries.size;
+    }
+
+    public getCachedBytes(): number {
+        return this.cachedBytes;
+    }
+
+    /**
+     * Checks the conditional request headers against a cached entry
+     * @returns true if the client's copy is still valid and a 304 (Not Modified) can be sent instead of the file
+     */
+    public static isNotModified(entry: Http3StaticCacheEntry, ifNoneMatch?: string, ifModifiedSince?: string): boolean {
+        // RFC 7232 section 6: If-Modified-Since is ignored when If-None-Match is present
+        if (ifNoneMatch !== undefined) {
+            if (ifNoneMatch.trim() === "*") {
+                return true;
+            }
+            // weak comparison: W/"x" matches "x"
+            const ourTag: string = Http3StaticCache.stripWeakPrefix(entry.etag);
+            for (const tag of ifNoneMatch.split(",")) {
+                if (Http3StaticCache.stripWeakPrefix(tag.trim()) === ourTag) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (ifModifiedSince !== undefined) {
+            const since: number = Date.parse(ifModifiedSince);
+            return !isNaN(since) && entry.modifiedTime <= since;
+        }
+        return false;
+    }
+
+    private remove(path: string) {
+        const watcher: FSWatcher | undefined = this.watchers.get(path);
+        if (watcher !== undefined) {
+            watcher.close();
+            this.watchers.delete(path);
+        }
+        const entry: Http3StaticCacheEntry | undefined = this.entries.get(path);
+        if (entry !== undefined) {
+            this.entries.delete(path);
+            this.cachedBytes -= Http3StaticCache.getEntryBytes(entry);
+            VerboseLogging.debug("Http3StaticCache:remove : dropped " + path + ", " + this.entries.size + " entries (" + this.cachedBytes + " bytes) left");
+        }
+    }
+
+    private load(path: string, load: Http3StaticCacheLoad): Promise<Http3StaticCacheEntry> {
+        // the watcher goes first: a change that lands between our stat() and readFile() (or after them) is then always noticed, even if the size stays the same
+        try {
+            // persistent: false, so the watchers don't keep the process alive
+            const watcher: FSWatcher = watch(path, { persistent: false }, () => {
+                this.onFileChanged(path, load);
+            });
+            watcher.on("error", () => {
+                this.onFileChanged(path, load);
+            });
+            load.watcher = watcher;
+        }
+        catch (e) {
+            // without a watcher we wouldn't notice changes to the file, so don't cache it (if it doesn't exist, the stat below reports that)
+            VerboseLogging.warn("Http3StaticCache:load : could not watch " + path + ", not caching it : " + e);
+            load.stale = true;
+        }
+
+        return new Promise<Http3StaticCacheEntry>((resolve, reject) => {
+            stat(path, (statErr: NodeJS.ErrnoException | null, stats: Stats) => {
+                if (statErr || !stats.isFile()) {
+                    this.closeWatcher(load);
+                    reject(statErr ? statErr : new Error("Http3StaticCache:load : not a regular file : " + path));
+                    return;
+                }
+
+                const entry: Http3StaticCacheEntry = this.createEntry(path, stats);
+                if (stats.size > this.maxFileSize) {
+                    // too big to keep in memory: only the headers are cached, Http3Response streams the contents from disk
+                    this.insert(entry, load);
+                    resolve(entry);
+                    return;
+                }
+
+                readFile(path, (readErr: NodeJS.ErrnoException | null, data: Buffer) => {
+                    if (readErr) {
+                        this.closeWatcher(load);
+                        reject(readErr);
+                        return;
+                    }
+                    if (data.byteLength !== stats.size) {
+                        // file changed while we were reading it: serve what we read, but don't cache it
+                        VerboseLogging.warn("Http3StaticCache:load : " + path + " changed while it was being read, not caching it");
+                        const changedEntry: Http3StaticCacheEntry = this.createEntry(path, stats, data.byteLength);
+                        changedEntry.body = new Http3DataFrame(data).toBuffer();
+                        this.closeWatcher(load);
+                        resolve(changedEntry);
+                        return;
+                    }
+                    entry.body = new Http3DataFrame(data).toBuffer();
+                    entry.resources = Http3StaticCache.findResources(entry, data);
+                    this.insert(entry, load);
+                    resolve(entry);
+                });
+            });
+        });
+    }
+
+    private onFileChanged(path: string, load: Http3StaticCacheLoad) {
+        if (load.watcher !== undefined && this.watchers.get(path) === load.watcher) {
+            // the load is done and cached: drop the entry
+            this.invalidate(path);
+        }
+        else {
+            // still loading: whatever we read might be outdated already
+            load.stale = true;
+            if (this.loading.get(path) === load) {
+                this.loading.delete(path);
+            }
+        }
+    }
+
+    private closeWatcher(load: Http3StaticCacheLoad) {
+        if (load.watcher !== undefined) {
+            load.watcher.close();
+            load.watcher = undefined;
+        }
+    }
+
+    private insert(entry: Http3StaticCacheEntry, load: Http3StaticCacheLoad) {
+        if (load.stale || load.watcher === undefined) {
+            // the file changed while loading (or we can't watch it), the entry might already be outdated
+            this.closeWatcher(load);
+            return;
+        }
+
+        // never count the same path twice
+        this.remove(entry.path);
+        this.entries.set(entry.path, entry);
+        this.watchers.set(entry.path, load.watcher);
+        this.cachedBytes += Http3StaticCache.getEntryBytes(entry);
+
+        // evict least recently used entries until we're within budget again
+        const iterator = this.entries.keys();
+        while (this.cachedBytes > this.maxBytes || this.entries.size > this.maxEntries) {
+            this.remove(iterator.next().value);
+        }
+    }
+
+    private createEntry(path: string, stats: Stats, size: number = stats.size): Http3StaticCacheEntry {
+        const modifiedTime: number = Math.floor(stats.mtime.getTime() / 1000) * 1000;
+        const etag: string = "W/\"" + size.toString(16) + "-" + stats.mtime.getTime().toString(16) + "\"";
+        const lastModified: string = new Date(modifiedTime).toUTCString();
+
+        let mimeType: string;
+        try {
+            mimeType = this.mimeTypeResolver(path);
+        }
+        catch (e) {
+            VerboseLogging.error("Http3StaticCache:createEntry : extension unknown, defaulting to unknown mimetype " + path);
+            mimeType = "unknown";
+        }
+
+        return {
+            path: path,
+            size: size,
+            etag: etag,
+            lastModified: lastModified,
+            modifiedTime: modifiedTime,
+            headers: [
+                { name: "content-type", value: mimeType },
+                { name: "content-length", value: size.toString() },
+                { name: "etag", value: etag },
+                { name: "last-modified", value: lastModified },
+            ],
+        };
+    }
+
+    // parsed once when the file is loaded, instead of for every response it's pushed along with
+    private static findResources(entry: Http3StaticCacheEntry, data: Buffer): string[] | undefined {
+        const mimeType: string = entry.headers[0].value;
+        if (!mimeType.startsWith("text/html")) {
+            return undefined;
+        }
+        let resources: string[] = [];
+        const parser: Http3ResourceParser = new Http3ResourceParser();
+        parser.on(Http3ResourceParserEvent.FILES_FOUND, (files: string[]) => {
+            resources = resources.concat(files);
+        });
+        parser.parseBuffer(data, mimeType);
+        return resources;
+    }
+
+    private static getEntryBytes(entry: Http3StaticCacheEntry): number {
+        return entry.body === undefined ? 0 : entry.body.byteLength;
+    }
+
+    private static stripWeakPrefix(tag: string): string {
+        return tag.startsWith("W/") ? tag.substring(2) : tag;
+    }
+}
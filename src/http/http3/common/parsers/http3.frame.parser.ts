@@ -1,6 +1,6 @@
 import { VLIE, VLIEOffset } from "../../../../types/vlie";
 import { Bignum } from "../../../../types/bignum";
-import { Http3DataFrame, Http3CancelPushFrame, Http3GoAwayFrame, Http3MaxPushIDFrame, Http3DuplicatePushFrame, Http3SettingsFrame } from "../frames";
+import { Http3DataFrame, Http3CancelPushFrame, Http3GoAwayFrame, Http3MaxPushIDFrame, Http3DuplicatePushFrame, Http3SettingsFrame, Http3PriorityUpdateFrame, Http3PushPromiseFrame } from "../frames";
 import { Http3PriorityFrame } from "../frames/http3.priorityframe";
 import { Http3HeaderFrame } from "../frames/http3.headerframe";
 import { Http3Error, Http3ErrorCode } from "../errors/http3.error";
@@ -22,6 +22,8 @@ export class Http3FrameParser {
     
     /**
      * Parses a buffer and tries to extract all Http3Frames from it
+     * Parsing stops at the first frame that isn't completely in the buffer: the returned offset then points at its start, so it can be retried once more data is available
+     * For data that arrives in pieces on a stream, use an Http3StreamFrameParser instead, which doesn't need the caller to keep (and re-concat) the leftovers
      * @param buffer A buffer object containing the frame
      * @param streamID The ID of the stream that the frames were sent on
      * @param bufferOffset The offset within the buffer where the frame starts at
@@ -30,80 +32,112 @@ export class Http3FrameParser {
     public parse(buffer: Buffer, streamID: Bignum, bufferOffset: number = 0): [Http3BaseFrame[], number] {
         let frames: Http3BaseFrame[] = [];
         let offset: number = bufferOffset;
-        let parsedOffset = offset;
 
-        // TODO catch error out of range and return all completely parsed frames and parsedOffset
         while(offset < buffer.byteLength) {
-            // TODO Safety checks before parsing to make sure format is valid
+            const headerLength: number = Http3FrameParser.getFrameHeaderLength(buffer, offset);
+            if (headerLength < 0 || offset + headerLength > buffer.byteLength) {
+                break; // frame type and/or length not completely received yet
+            }
 
-            // let frameType: number = buffer.readUInt8(offset++);
             const frameTypeVlie: VLIEOffset = VLIE.decode(buffer, offset);
-            const frameType: Bignum = frameTypeVlie.value;
-            offset = frameTypeVlie.offset;
-            let frameTypeEnum: Http3FrameType | undefined = Http3FrameParser.toFrameType(frameType);
-            if (frameTypeEnum === undefined) {
-                throw new Http3Error(Http3ErrorCode.HTTP3_MALFORMED_FRAME);
+            const lengthVlie: VLIEOffset = VLIE.decode(buffer, frameTypeVlie.offset);
+            const frameType: Http3FrameType = this.decodeFrameType(frameTypeVlie.value);
+            // TODO length is bignum: risk downcast to number?
+            const length: number = lengthVlie.value.toNumber();
+            if (lengthVlie.offset + length > buffer.byteLength) {
+                break; // payload not completely received yet
             }
 
-            let lengthVlie: VLIEOffset = VLIE.decode(buffer, offset);
-            let length: Bignum = lengthVlie.value;
-            offset = lengthVlie.offset;
-
-            // TODO From offset to offset + length BUT length is bignum
-            // Risk downcast to number?
-            let payload: Buffer = buffer.slice(offset, offset + length.toNumber());
-            offset += length.toNumber();
+            const payload: Buffer = buffer.slice(lengthVlie.offset, lengthVlie.offset + length);
+            offset = lengthVlie.offset + length;
 
-            switch(frameTypeEnum) {
-                case Http3FrameType.DATA:
-                    const http3DataFrame: Http3DataFrame = Http3DataFrame.fromPayload(payload);
-                    frames.push(http3DataFrame);
-                    if (this.logger !== undefined) {
-                        this.logger.onHTTPFrame_Data(http3DataFrame, "RX");
-                    }
-                    break;
-                case Http3FrameType.HEADERS:
-                    if (this.encoder === undefined || this.decoder === undefined) {
-                        throw new Http3Error(Http3ErrorCode.HTTP3_UNINITIALISED_DECODER, "HTTP/3 Frame parser encountered a header frame before decoder was initialised!");
-                    }
-                    const headerFrame: Http3HeaderFrame = Http3HeaderFrame.fromPayload(payload, streamID, this.encoder, this.decoder);
-                    frames.push(headerFrame);
-                    if (this.logger !== undefined) {
-                        this.logger.onHTTPFrame_Headers(headerFrame, "RX");
-                    }
-                    break;
-                case Http3FrameType.PRIORITY:
-                    frames.push(Http3PriorityFrame.fromPayload(payload));
-                    break;
-                case Http3FrameType.CANCEL_PUSH:
-                    frames.push(new Http3CancelPushFrame(payload));
-                    break;
-                case Http3FrameType.SETTINGS:
-                    const settingsFrame: Http3SettingsFrame = Http3SettingsFrame.fromPayload(payload);
-                    frames.push(settingsFrame);
-                    if (this.logger !== undefined) {
-                        this.logger.onHTTPFrame_Settings(settingsFrame, "RX");
-                    }
-                    break;
-                case Http3FrameType.GOAWAY:
-                    const goAwayFrame: Http3GoAwayFrame = Http3GoAwayFrame.fromPayload(payload);
-                    frames.push(goAwayFrame);
-                    break;
-                case Http3FrameType.MAX_PUSH_ID:
-                    frames.push(new Http3MaxPushIDFrame(payload));
-                    break;
-                case Http3FrameType.DUPLICATE_PUSH:
-                    frames.push(new Http3DuplicatePushFrame(payload));
-                    break;
-                case Http3FrameType.RESERVED:
-                    break;
-                default:
-                    throw new Http3Error(Http3ErrorCode.HTTP3_UNKNOWN_FRAMETYPE, "Unknown frametype encountered while parsing http3 frames");
+            const frame: Http3BaseFrame | undefined = this.parsePayload(frameType, payload, streamID);
+            if (frame !== undefined) {
+                frames.push(frame);
             }
-            parsedOffset = offset;
         }
         
-        return [frames, parsedOffset];
+        return [frames, offset];
+    }
+
+    /**
+     * Creates the frame of the given type from its (complete) payload
+     * @returns undefined for reserved frame types, which are to be ignored
+     */
+    public parsePayload(frameType: Http3FrameType, payload: Buffer, streamID: Bignum): Http3BaseFrame | undefined {
+        switch(frameType) {
+            case Http3FrameType.DATA:
+                const http3DataFrame: Http3DataFrame = Http3DataFrame.fromPayload(payload);
+                if (this.logger !== undefined) {
+                    this.logger.onHTTPFrame_Data(http3DataFrame, "RX");
+                }
+                return http3DataFrame;
+            case Http3FrameType.HEADERS:
+                if (this.encoder === undefined || this.decoder === undefined) {
+                    throw new Http3Error(Http3ErrorCode.HTTP3_UNINITIALISED_DECODER, "HTTP/3 Frame parser encountered a header frame before decoder was initialised!");
+                }
+                const headerFrame: Http3HeaderFrame = Http3HeaderFrame.fromPayload(payload, streamID, this.encoder, this.decoder);
+                if (this.logger !== undefined) {
+                    this.logger.onHTTPFrame_Headers(headerFrame, "RX");
+                }
+                return headerFrame;
+            case Http3FrameType.PRIORITY:
+                return Http3PriorityFrame.fromPayload(payload);
+            case Http3FrameType.CANCEL_PUSH:
+                return Http3CancelPushFrame.fromPayload(payload);
+            case Http3FrameType.SETTINGS:
+                const settingsFrame: Http3SettingsFrame = Http3SettingsFrame.fromPayload(payload);
+                if (this.logger !== undefined) {
+                    this.logger.onHTTPFrame_Settings(settingsFrame, "RX");
+                }
+                return settingsFrame;
+            case Http3FrameType.PUSH_PROMISE:
+                if (this.encoder === undefined || this.decoder === undefined) {
+                    throw new Http3Error(Http3ErrorCode.HTTP3_UNINITIALISED_DECODER, "HTTP/3 Frame parser encountered a push promise frame before decoder was initialised!");
+                }
+                return Http3PushPromiseFrame.fromPayload(payload, streamID, this.encoder, this.decoder);
+            case Http3FrameType.GOAWAY:
+                return Http3GoAwayFrame.fromPayload(payload);
+            case Http3FrameType.MAX_PUSH_ID:
+                return Http3MaxPushIDFrame.fromPayload(payload);
+            case Http3FrameType.DUPLICATE_PUSH:
+                return new Http3DuplicatePushFrame(payload);
+            case Http3FrameType.PRIORITY_UPDATE:
+                return Http3PriorityUpdateFrame.fromPayload(payload);
+            case Http3FrameType.RESERVED:
+                return undefined;
+            default:
+                throw new Http3Error(Http3ErrorCode.HTTP3_UNKNOWN_FRAMETYPE, "Unknown frametype encountered while parsing http3 frames");
+        }
+    }
+
+    // Throws for frame types we don't know (reserved frame types are known, but should be ignored)
+    public decodeFrameType(frameType: Bignum): Http3FrameType {
+        const frameTypeEnum: Http3FrameType | undefined = Http3FrameParser.toFrameType(frameType);
+        if (frameTypeEnum === undefined) {
+            throw new Http3Error(Http3ErrorCode.HTTP3_MALFORMED_FRAME);
+        }
+        return frameTypeEnum;
+    }
+
+    public getLogger(): QlogWrapper | undefined {
+        return this.logger;
+    }
+
+    /**
+     * Size of the type and length fields of the frame starting at offset, which are two variable-length integers
+     * Their sizes are encoded in the first two bits of their first byte, so this only needs to look at (at most) two bytes
+     * @returns -1 if not even that much is available yet
+     */
+    public static getFrameHeaderLength(buffer: Buffer, offset: number = 0): number {
+        if (offset >= buffer.byteLength) {
+            return -1;
+        }
+        const typeLength: number = 1 << (buffer[offset] >> 6);
+        if (offset + typeLength >= buffer.byteLength) {
+            return -1;
+        }
+        return typeLength + (1 << (buffer[offset + typeLength] >> 6));
     }
     
     public setEncoder(encoder: Http3QPackEncoder) {
@@ -135,6 +169,7 @@ export class Http3FrameParser {
             case Http3FrameType.GOAWAY:
             case Http3FrameType.MAX_PUSH_ID:
             case Http3FrameType.DUPLICATE_PUSH:
+            case Http3FrameType.PRIORITY_UPDATE:
                 return ft as Http3FrameType;
             default:
                 return undefined;
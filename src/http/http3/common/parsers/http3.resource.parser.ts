@@ -0,0 +1,388 @@
+import { EventEmitter } from "events";
+import { posix } from "path";
+import { VerboseLogging } from "../../../../utilities/logging/verbose.logging";
+
+export enum Http3ResourceParserEvent {
+    FILES_FOUND = "files found",
+}
+
+// Where the tokenizer is in the document
+enum Http3ResourceParserState {
+    TEXT, // HTML content outside of tags
+    TAG_OPEN, // right after "<"
+    TAG_NAME,
+    END_TAG, // "</...", skipped until ">"
+    BEFORE_ATTRIBUTE_NAME,
+    ATTRIBUTE_NAME,
+    AFTER_ATTRIBUTE_NAME,
+    BEFORE_ATTRIBUTE_VALUE,
+    ATTRIBUTE_VALUE_QUOTED,
+    ATTRIBUTE_VALUE_UNQUOTED,
+    MARKUP_DECLARATION, // right after "<!": a comment if "--" follows
+    MARKUP, // comments, doctype, ... Skipped
+    RAW_TEXT, // content of <script> and <style>, can contain "<" that doesn't start a tag
+    SCRIPT, // a javascript file: only src="..." assignments are looked for
+}
+
+// Character codes the tokenizer looks at
+const enum Char {
+    TAB = 0x09, LINE_FEED = 0x0A, FORM_FEED = 0x0C, CARRIAGE_RETURN = 0x0D, SPACE = 0x20,
+    EXCLAMATION_MARK = 0x21, DOUBLE_QUOTE = 0x22, APOSTROPHE = 0x27, HYPHEN = 0x2D, SLASH = 0x2F,
+    LESS_THAN = 0x3C, EQUALS = 0x3D, GREATER_THAN = 0x3E,
+}
+
+/**
+ * Finds the subresources (src attributes, and href attributes of <link>s) of an HTML or javascript document while it comes in
+ * Chunks are tokenized byte by byte as they arrive and FILES_FOUND is emitted for every resource as soon as its attribute is complete,
+ * so it can be requested while the rest of the document is still underway, like a browser's preload scanner does.
+ * Nothing but the attribute being parsed is kept, never the document (or a string version of it)
+ * One parser handles one document at a time: startDocument, parseChunk for every chunk, end. parseBuffer does all of these for a complete document
+ * Relative paths are resolved against the directory of the document's path, if it's given (see resolvePath)
+ */
+export class Http3ResourceParser extends EventEmitter {
+    // tags whose content isn't HTML
+    private static readonly RAW_TEXT_TAGS: string[] = ["script", "style"];
+    // longest tag or attribute name we need to recognize: everything longer is never one of ours and isn't kept
+    private static readonly MAX_NAME_LENGTH: number = 8;
+    // URLs longer than this are dropped, so a broken document can't make us buffer without bounds
+    private static readonly MAX_VALUE_LENGTH: number = 2048;
+
+    private state: Http3ResourceParserState = Http3ResourceParserState.TEXT;
+    private parsing: boolean = false;
+    private isScript: boolean = false;
+    private tagName: string = "";
+    private attributeName: string = "";
+    private attributeValue: number[] = []; // raw bytes: values can be split over chunks in the middle of a UTF-8 character
+    private quote: number = 0;
+    // "-->" for comments, "</script" or "</style" for raw text: how many characters of it were matched so far
+    private closingSequence: string = "";
+    private closingSequenceMatched: number = 0;
+    private found: Set<string> = new Set<string>();
+    private documentPath?: string;
+
+    public constructor() {
+        super();
+    }
+
+    // Complete document in a single buffer
+    public parseBuffer(requestedFile: Buffer, mimeType: string, documentPath?: string): void {
+        if (this.startDocument(mimeType, documentPath)) {
+            this.parseChunk(requestedFile);
+        }
+        this.end();
+    }
+
+    // Resets the parser for a new document. Returns false if documents of this type can't contain resources, parseChunk then ignores everything
+    // documentPath is the path the document was requested with. Without it, relative paths are reported as they are written
+    public startDocument(mimeType: string, documentPath?: string): boolean {
+        this.reset();
+        this.documentPath = documentPath;
+        switch (this.parseMimeTypeForResources(mimeType)) {
+            case "text/html":
+                this.state = Http3ResourceParserState.TEXT;
+                this.parsing = true;
+                break;
+            case "application/javascript":
+                this.state = Http3ResourceParserState.SCRIPT;
+                this.parsing = true;
+                this.isScript = true;
+                break;
+            default:
+                this.parsing = false;
+        }
+        return this.parsing;
+    }
+
+    public parseChunk(chunk: Buffer): void {
+        if (this.parsing === false) {
+            return;
+        }
+        for (let i = 0; i < chunk.byteLength; ++i) {
+            this.parseByte(chunk[i]);
+        }
+    }
+
+    // Document is complete. An unquoted attribute value can run until the very end
+    public end(): void {
+        if (this.parsing === true && this.state === Http3ResourceParserState.ATTRIBUTE_VALUE_UNQUOTED) {
+            this.completeAttribute();
+        }
+        this.reset();
+    }
+
+    private reset() {
+        this.parsing = false;
+        this.isScript = false;
+        this.tagName = "";
+        this.attributeName = "";
+        this.attributeValue = [];
+        this.closingSequenceMatched = 0;
+        this.found.clear();
+    }
+
+    private parseByte(byte: number) {
+        switch (this.state) {
+            case Http3ResourceParserState.TEXT:
+                if (byte === Char.LESS_THAN) {
+                    this.state = Http3ResourceParserState.TAG_OPEN;
+                }
+                break;
+
+            case Http3ResourceParserState.TAG_OPEN:
+                if (Http3ResourceParser.isLetter(byte)) {
+                    this.tagName = String.fromCharCode(byte | 0x20); // lowercase
+                    this.state = Http3ResourceParserState.TAG_NAME;
+                } else if (byte === Char.SLASH) {
+                    this.state = Http3ResourceParserState.END_TAG;
+                } else if (byte === Char.EXCLAMATION_MARK) {
+                    this.closingSequenceMatched = 0; // counts the dashes of "<!--"
+                    this.state = Http3ResourceParserState.MARKUP_DECLARATION;
+                } else if (byte !== Char.LESS_THAN) {
+                    this.state = Http3ResourceParserState.TEXT; // e.g., "a < b"
+                }
+                break;
+
+            case Http3ResourceParserState.TAG_NAME:
+                if (Http3ResourceParser.isWhitespace(byte) || byte === Char.SLASH) {
+                    this.state = Http3ResourceParserState.BEFORE_ATTRIBUTE_NAME;
+                } else if (byte === Char.GREATER_THAN) {
+                    this.completeTag();
+                } else {
+                    this.tagName = this.appendToName(this.tagName, byte);
+                }
+                break;
+
+            case Http3ResourceParserState.END_TAG:
+                if (byte === Char.GREATER_THAN) {
+                    this.state = Http3ResourceParserState.TEXT;
+                }
+                break;
+
+            case Http3ResourceParserState.BEFORE_ATTRIBUTE_NAME:
+                if (byte === Char.GREATER_THAN) {
+                    this.completeTag();
+                } else if (!Http3ResourceParser.isWhitespace(byte) && byte !== Char.SLASH) {
+                    this.attributeName = this.appendToName("", byte);
+                    this.state = Http3ResourceParserState.ATTRIBUTE_NAME;
+                }
+                break;
+
+            case Http3ResourceParserState.ATTRIBUTE_NAME:
+                if (byte === Char.EQUALS) {
+                    this.state = Http3ResourceParserState.BEFORE_ATTRIBUTE_VALUE;
+                } else if (Http3ResourceParser.isWhitespace(byte)) {
+                    this.state = Http3ResourceParserState.AFTER_ATTRIBUTE_NAME;
+                } else if (byte === Char.SLASH) {
+                    this.state = Http3ResourceParserState.BEFORE_ATTRIBUTE_NAME;
+                } else if (byte === Char.GREATER_THAN) {
+                    this.completeTag();
+                } else {
+                    this.attributeName = this.appendToName(this.attributeName, byte);
+                }
+                break;
+
+            case Http3ResourceParserState.AFTER_ATTRIBUTE_NAME:
+                // attribute without a value, unless there's a "=" after all
+                if (byte === Char.EQUALS) {
+                    this.state = Http3ResourceParserState.BEFORE_ATTRIBUTE_VALUE;
+                } else if (byte === Char.GREATER_THAN) {
+                    this.completeTag();
+                } else if (byte === Char.SLASH) {
+                    this.state = Http3ResourceParserState.BEFORE_ATTRIBUTE_NAME;
+                } else if (!Http3ResourceParser.isWhitespace(byte)) {
+                    this.attributeName = this.appendToName("", byte);
+                    this.state = Http3ResourceParserState.ATTRIBUTE_NAME;
+                }
+                break;
+
+            case Http3ResourceParserState.BEFORE_ATTRIBUTE_VALUE:
+                if (byte === Char.DOUBLE_QUOTE || byte === Char.APOSTROPHE) {
+                    this.quote = byte;
+                    this.attributeValue = [];
+                    this.state = Http3ResourceParserState.ATTRIBUTE_VALUE_QUOTED;
+                } else if (byte === Char.GREATER_THAN) {
+                    this.completeTag();
+                } else if (!Http3ResourceParser.isWhitespace(byte)) {
+                    this.attributeValue = [byte];
+                    this.state = Http3ResourceParserState.ATTRIBUTE_VALUE_UNQUOTED;
+                }
+                break;
+
+            case Http3ResourceParserState.ATTRIBUTE_VALUE_QUOTED:
+                if (byte === this.quote) {
+                    this.completeAttribute();
+                    // javascript has no tags, it goes back to looking for the next src
+                    this.state = this.isScript ? Http3ResourceParserState.SCRIPT : Http3ResourceParserState.BEFORE_ATTRIBUTE_NAME;
+                } else {
+                    this.appendToValue(byte);
+                }
+                break;
+
+            case Http3ResourceParserState.ATTRIBUTE_VALUE_UNQUOTED:
+                if (Http3ResourceParser.isWhitespace(byte)) {
+                    this.completeAttribute();
+                    this.state = Http3ResourceParserState.BEFORE_ATTRIBUTE_NAME;
+                } else if (byte === Char.GREATER_THAN) {
+                    this.completeAttribute();
+                    this.completeTag();
+                } else {
+                    this.appendToValue(byte);
+                }
+                break;
+
+            case Http3ResourceParserState.MARKUP_DECLARATION:
+                if (byte === Char.HYPHEN && ++this.closingSequenceMatched === 2) {
+                    this.startClosingSequence("-->", Http3ResourceParserState.MARKUP);
+                } else if (byte === Char.GREATER_THAN) {
+                    this.state = Http3ResourceParserState.TEXT;
+                } else if (byte !== Char.HYPHEN) {
+                    // e.g., <!doctype html>
+                    this.startClosingSequence(">", Http3ResourceParserState.MARKUP);
+                }
+                break;
+
+            case Http3ResourceParserState.MARKUP:
+            case Http3ResourceParserState.RAW_TEXT:
+                this.matchClosingSequence(byte);
+                break;
+
+            case Http3ResourceParserState.SCRIPT:
+                // looks for src, optional whitespace, =, optional whitespace and a quoted value. Anything else starts over
+                if (this.attributeName === "src=") {
+                    if (byte === Char.DOUBLE_QUOTE || byte === Char.APOSTROPHE) {
+                        this.attributeName = "src";
+                        this.quote = byte;
+                        this.attributeValue = [];
+                        this.state = Http3ResourceParserState.ATTRIBUTE_VALUE_QUOTED;
+                    } else if (!Http3ResourceParser.isWhitespace(byte)) {
+                        this.attributeName = "";
+                    }
+                } else if (this.attributeName === "src" && (byte === Char.EQUALS || Http3ResourceParser.isWhitespace(byte))) {
+                    if (byte === Char.EQUALS) {
+                        this.attributeName = "src=";
+                    }
+                } else if (Http3ResourceParser.isNameCharacter(byte)) {
+                    this.attributeName = this.appendToName(this.attributeName, byte);
+                } else {
+                    this.attributeName = "";
+                }
+                break;
+        }
+    }
+
+    private completeTag() {
+        if (Http3ResourceParser.RAW_TEXT_TAGS.indexOf(this.tagName) >= 0) {
+            // <script src="..."> has its resource in an attribute, which we already have by now
+            this.startClosingSequence("</" + this.tagName, Http3ResourceParserState.RAW_TEXT);
+        } else {
+            this.state = Http3ResourceParserState.TEXT;
+        }
+    }
+
+    private completeAttribute() {
+        const name: string = this.attributeName;
+        const value: number[] = this.attributeValue;
+        this.attributeName = "";
+        this.attributeValue = [];
+
+        // browsers only fetch href for <link>s: those of <a> etc. are navigations
+        if (name !== "src" && (name !== "href" || this.tagName !== "link")) {
+            return;
+        }
+        if (value.length === 0 || value.length > Http3ResourceParser.MAX_VALUE_LENGTH) {
+            return;
+        }
+
+        let file: string = Buffer.from(value).toString("utf8").trim();
+        const fragmentIndex: number = file.indexOf("#");
+        if (fragmentIndex >= 0) {
+            file = file.substring(0, fragmentIndex);
+        }
+        // other origins (http://..., //host/...), data: and javascript: URLs etc. can't be requested on this connection
+        if (file === "" || file.indexOf(":") >= 0 || file.indexOf("//") === 0) {
+            return;
+        }
+        if (this.documentPath !== undefined) {
+            file = Http3ResourceParser.resolvePath(this.documentPath, file);
+        }
+        if (this.found.has(file)) {
+            return;
+        }
+        this.found.add(file);
+
+        VerboseLogging.debug("Http3ResourceParser:completeAttribute : found " + file);
+        this.emit(Http3ResourceParserEvent.FILES_FOUND, [file]);
+    }
+
+    /**
+     * Resolves a path found in a document against the directory of the document's path, like a browser does
+     * e.g., "img/a.png" in /docs/index.html is /docs/img/a.png, "../a.css" is /a.css. Absolute paths are only normalized
+     */
+    public static resolvePath(documentPath: string, file: string): string {
+        if (file[0] === "/") {
+            return posix.normalize(file);
+        }
+        const queryStart: number = documentPath.indexOf("?");
+        const documentFile: string = queryStart < 0 ? documentPath : documentPath.substring(0, queryStart);
+        const directory: string = documentFile.substring(0, documentFile.lastIndexOf("/") + 1);
+        // normalize can't go above the root of an absolute path, so neither can a relative path with too many ".."s
+        return posix.normalize((directory[0] === "/" ? "" : "/") + directory + file);
+    }
+
+    private startClosingSequence(sequence: string, state: Http3ResourceParserState) {
+        this.closingSequence = sequence;
+        this.closingSequenceMatched = 0;
+        this.state = state;
+    }
+
+    // case insensitive, "-->" and "</script" never need anything else
+    private matchClosingSequence(byte: number) {
+        const character: string = Http3ResourceParser.isLetter(byte) ? String.fromCharCode(byte | 0x20) : String.fromCharCode(byte);
+        if (character === this.closingSequence[this.closingSequenceMatched]) {
+            ++this.closingSequenceMatched;
+        } else {
+            // a run of the first character ("--->", "<</script") keeps what was matched, otherwise we start over
+            const restart: string = this.closingSequence[0];
+            const repeating: boolean = character === restart && this.closingSequenceMatched > 0 && this.closingSequence[this.closingSequenceMatched - 1] === restart;
+            if (!repeating) {
+                this.closingSequenceMatched = character === restart ? 1 : 0;
+            }
+        }
+        if (this.closingSequenceMatched === this.closingSequence.length) {
+            this.closingSequenceMatched = 0;
+            // the rest of "</script ...>" is an end tag, skipped like any other
+            this.state = this.state === Http3ResourceParserState.RAW_TEXT ? Http3ResourceParserState.END_TAG : Http3ResourceParserState.TEXT;
+            this.tagName = "";
+        }
+    }
+
+    private appendToName(name: string, byte: number): string {
+        if (name.length > Http3ResourceParser.MAX_NAME_LENGTH) {
+            return name; // no use keeping it, it's already too long to match anything
+        }
+        return name + (Http3ResourceParser.isLetter(byte) ? String.fromCharCode(byte | 0x20) : String.fromCharCode(byte));
+    }
+
+    private appendToValue(byte: number) {
+        if (this.attributeValue.length <= Http3ResourceParser.MAX_VALUE_LENGTH) {
+            this.attributeValue.push(byte);
+        }
+    }
+
+    private static isLetter(byte: number): boolean {
+        return (byte >= 0x41 && byte <= 0x5A) || (byte >= 0x61 && byte <= 0x7A);
+    }
+
+    private static isNameCharacter(byte: number): boolean {
+        return Http3ResourceParser.isLetter(byte) || (byte >= 0x30 && byte <= 0x39) || byte === 0x5F || byte === 0x24; // digits, _ and $
+    }
+
+    private static isWhitespace(byte: number): boolean {
+        return byte === Char.SPACE || byte === Char.TAB || byte === Char.LINE_FEED || byte === Char.CARRIAGE_RETURN || byte === Char.FORM_FEED;
+    }
+
+    // Content-Type can have parameters, e.g., "text/html; charset=utf-8"
+    private parseMimeTypeForResources(mimeType: string): string {
+        return mimeType.split(";")[0].trim().toLowerCase();
+    }
+}
@@ -0,0 +1,138 @@
+import { VLIE, VLIEOffset } from "../../../../types/vlie";
+import { Bignum } from "../../../../types/bignum";
+import { Http3BaseFrame, Http3FrameType } from "../frames/http3.baseframe";
+import { Http3FrameParser } from "./http3.frame.parser";
+import { Http3Error, Http3ErrorCode } from "../errors/http3.error";
+
+// Which part of a frame the parser is waiting for
+enum Http3StreamFrameParserState {
+    HEADER, // type and length
+    PAYLOAD,
+}
+
+/**
+ * Parses the frames on a single HTTP/3 stream, as the stream data arrives
+ * Unlike Http3FrameParser:parse, this keeps state across calls: a frame that's split over multiple chunks is picked up where it was left,
+ * so callers just pass every new chunk of stream data and don't have to keep (and re-concat and re-parse) what couldn't be parsed yet
+ * Frames are passed to onFrame once they're complete. If a DATA payload handler is set, DATA frame payloads are not buffered at all:
+ * every piece is passed on as soon as it arrives (as a slice of the received chunk, without copying)
+ * Both handlers are called in stream order, so e.g., a HEADERS frame is always handled before the DATA that follows it, even if they arrive in the same chunk
+ */
+export class Http3StreamFrameParser {
+    private frameParser: Http3FrameParser;
+    private streamID: Bignum;
+    private onFrame: (frame: Http3BaseFrame) => void;
+    private onDataPayload?: (data: Buffer) => void;
+
+    private state: Http3StreamFrameParserState = Http3StreamFrameParserState.HEADER;
+    // frame type and length bytes if they were split over chunks. At most 16 bytes (two 8-byte variable-length integers)
+    private partialHeader: Buffer = Buffer.alloc(0);
+    private frameType: Http3FrameType = Http3FrameType.DATA;
+    private payloadRemaining: number = 0;
+    // pieces of the payload of the current frame, for frames that are only handed out when complete
+    private payloadChunks: Buffer[] = [];
+
+    public constructor(frameParser: Http3FrameParser, streamID: Bignum, onFrame: (frame: Http3BaseFrame) => void, onDataPayload?: (data: Buffer) => void) {
+        this.frameParser = frameParser;
+        this.streamID = streamID;
+        this.onFrame = onFrame;
+        this.onDataPayload = onDataPayload;
+    }
+
+    /**
+     * @param data the next chunk of stream data
+     */
+    public parse(data: Buffer) {
+        let offset: number = 0;
+
+        while (offset < data.byteLength) {
+            if (this.state === Http3StreamFrameParserState.HEADER) {
+                offset = this.parseHeader(data, offset);
+                if (this.state === Http3StreamFrameParserState.HEADER) {
+                    break; // header still incomplete, rest of data was kept in partialHeader
+                }
+                if (this.payloadRemaining === 0) {
+                    this.completeFrame();
+                }
+            }
+            else {
+                const length: number = Math.min(this.payloadRemaining, data.byteLength - offset);
+                const piece: Buffer = data.slice(offset, offset + length);
+                offset += length;
+                this.payloadRemaining -= length;
+
+                if (this.frameType === Http3FrameType.DATA && this.onDataPayload !== undefined) {
+                    this.onDataPayload(piece);
+                } else {
+                    this.payloadChunks.push(piece);
+                }
+
+                if (this.payloadRemaining === 0) {
+                    this.completeFrame();
+                }
+            }
+        }
+    }
+
+    // true if the parser is in between frames: if the stream ends while this is false, its last frame was cut off
+    public isAtFrameBoundary(): boolean {
+        return this.state === Http3StreamFrameParserState.HEADER && this.partialHeader.byteLength === 0;
+    }
+
+    // Checks that the stream didn't end halfway a frame
+    public end() {
+        if (!this.isAtFrameBoundary()) {
+            throw new Http3Error(Http3ErrorCode.HTTP3_MALFORMED_FRAME, "Stream " + this.streamID.toDecimalString() + " ended in the middle of a frame");
+        }
+    }
+
+    // returns the offset in data right after the frame header, or data.byteLength if the header isn't complete yet
+    private parseHeader(data: Buffer, offset: number): number {
+        let header: Buffer = data;
+        let headerOffset: number = offset;
+        if (this.partialHeader.byteLength > 0) {
+            // the header never exceeds 16 bytes, so that's all we need to add to what we have
+            header = Buffer.concat([this.partialHeader, data.slice(offset, offset + 16)]);
+            headerOffset = 0;
+        }
+
+        const headerLength: number = Http3FrameParser.getFrameHeaderLength(header, headerOffset);
+        if (headerLength < 0 || headerOffset + headerLength > header.byteLength) {
+            this.partialHeader = Buffer.from(header.slice(headerOffset)); // copy: the chunk itself shouldn't be kept alive for a few bytes
+            return data.byteLength;
+        }
+
+        const frameTypeVlie: VLIEOffset = VLIE.decode(header, headerOffset);
+        const lengthVlie: VLIEOffset = VLIE.decode(header, frameTypeVlie.offset);
+        this.frameType = this.frameParser.decodeFrameType(frameTypeVlie.value);
+        // TODO length is bignum: risk downcast to number?
+        this.payloadRemaining = lengthVlie.value.toNumber();
+        this.state = Http3StreamFrameParserState.PAYLOAD;
+
+        const consumedFromData: number = headerLength - this.partialHeader.byteLength;
+        this.partialHeader = Buffer.alloc(0);
+
+        if (this.frameType === Http3FrameType.DATA && this.onDataPayload !== undefined) {
+            const logger = this.frameParser.getLogger();
+            if (logger !== undefined) {
+                logger.onHTTPFrame_DataLength(this.payloadRemaining, "RX");
+            }
+        }
+
+        return offset + consumedFromData;
+    }
+
+    private completeFrame() {
+        this.state = Http3StreamFrameParserState.HEADER;
+        if (this.frameType === Http3FrameType.DATA && this.onDataPayload !== undefined) {
+            return; // all of it has already been passed on
+        }
+
+        const payload: Buffer = this.payloadChunks.length === 1 ? this.payloadChunks[0] : Buffer.concat(this.payloadChunks);
+        this.payloadChunks = [];
+        const frame: Http3BaseFrame | undefined = this.frameParser.parsePayload(this.frameType, payload, this.streamID);
+        if (frame !== undefined) {
+            this.onFrame(frame);
+        }
+    }
+}
@@ -10,6 +10,7 @@ import { VerboseLogging } from "../../../../utilities/logging/verbose.logging";
 import { Http3NodeEvent } from "./http3.nodeevent";
 import { EventEmitter } from "events";
 import { QlogWrapper } from "../../../../utilities/logging/qlog.wrapper";
+import { Http3FileSource } from "../http3.filesource";
 
 export enum DependencyTreeNodeType {
     REQUEST = "Request",
@@ -469,13 +470,23 @@ export class Http3DependencyTree extends EventEmitter {
         }
     }
 
-    public addData(streamID: Bignum, buffer: Buffer) {
+    public addData(streamID: Bignum, buffer: Buffer | Buffer[]) {
         const node: Http3RequestNode | undefined = this.requestStreams.get(streamID.toString());
         if (node !== undefined) {
             node.addData(buffer);
         }
     }
 
+    public addDataSource(streamID: Bignum, source: Http3FileSource) {
+        const node: Http3RequestNode | undefined = this.requestStreams.get(streamID.toString());
+        if (node !== undefined) {
+            node.setDataSource(source);
+        }
+        else {
+            source.close();
+        }
+    }
+
     // Marks a stream as finished -> No new data can be added.
     // Currently buffered data will still be transmitted
     // Stream will be closed when all data has been consumed
@@ -488,8 +499,9 @@ export class Http3DependencyTree extends EventEmitter {
     }
 
     // Do one pass starting from root
-    public schedule() {
-        this.root.schedule();
+    // Returns the amount of bytes that were written to a stream, 0 if there was nothing to send
+    public schedule(): number {
+        return this.root.schedule();
     }
 
     public toJSON(): DependencyTree {
@@ -13,7 +13,7 @@ export class Http3DependencyTreeRoot extends Http3PrioritisedElementNode {
             type: DependencyTreeNodeType.ROOT,
             id: "ROOT",
             weight: this.weight,
-            children: this.children.map((child: Http3PrioritisedElementNode) => {
+            children: Array.from(this.children).map((child: Http3PrioritisedElementNode) => {
                 return child.toJSON();
             }),
         }
@@ -15,7 +15,7 @@ export class Http3PlaceholderNode extends Http3PrioritisedElementNode {
             type: DependencyTreeNodeType.PLACEHOLDER,
             id: this.placeholderID.toString(),
             weight: this.weight,
-            children: this.children.map((child: Http3PrioritisedElementNode) => {
+            children: Array.from(this.children).map((child: Http3PrioritisedElementNode) => {
                 return child.toJSON();
             }),
         }
@@ -7,7 +7,9 @@ export class Http3PrioritisedElementNode extends EventEmitter {
     public static readonly CHUNK_SIZE = 1400;
     private parent: Http3PrioritisedElementNode | null;
     protected activeChildrenPQueue: Http3DepNodePQueue = new Http3DepNodePQueue([]);
-    protected children: Http3PrioritisedElementNode[] = [];
+    protected children: Set<Http3PrioritisedElementNode> = new Set<Http3PrioritisedElementNode>();
+    // position in the parent's activeChildrenPQueue, -1 if not in there. Only to be touched by Http3DepNodePQueue
+    public heapIndex: number = -1;
     protected weight: number;
     protected pseudoTime: number = 0;
     protected lastPseudoTime: number = 0;
@@ -27,17 +29,23 @@ export class Http3PrioritisedElementNode extends EventEmitter {
     }
 
     // Do one (recursive) pass starting from this node
-    public schedule() {
-        const child: Http3PrioritisedElementNode | undefined = this.activeChildrenPQueue.pop();
+    // Returns the amount of bytes that were written to a stream, 0 if there was nothing to send
+    public schedule(): number {
+        // the child stays in the queue while it's being scheduled, so activateChild() can't add it a second time in the meantime
+        const child: Http3PrioritisedElementNode | undefined = this.activeChildrenPQueue.peek();
         if (child !== undefined) {
             this.lastPseudoTime = child.pseudoTime;
-            child.schedule();
+            const bytesScheduled: number = child.schedule();
             if (child.isActive()) {
                 // K = 256 -> constant to compensate the lost bits by integer division (e.g., 256).
                 child.pseudoTime = this.lastPseudoTime + child.getBytesSent() * 256 / child.weight;
-                this.activeChildrenPQueue.push(child);
+                this.activeChildrenPQueue.update(child);
+            } else {
+                this.activeChildrenPQueue.delete(child);
             }
+            return bytesScheduled;
         }
+        return 0;
     }
 
     public getBytesSent(): number {
@@ -51,16 +59,12 @@ export class Http3PrioritisedElementNode extends EventEmitter {
     }
 
     public hasChild(child: Http3PrioritisedElementNode): boolean {
-        // FIXME -> slow, swap out with specialised data structure
-        return this.children.indexOf(child) >= 0;
+        return this.children.has(child);
     }
 
     private removeChild(child: Http3PrioritisedElementNode) {
         this.activeChildrenPQueue.delete(child);
-        // FIXME -> slow, swap out with specialised data structure
-        this.children = this.children.filter((value) => {
-            return value !== child;
-        });
+        this.children.delete(child);
     }
 
     public activateChild(child: Http3PrioritisedElementNode) {
@@ -80,12 +84,13 @@ export class Http3PrioritisedElementNode extends EventEmitter {
     }
 
     public passChildren(targetNode: Http3PrioritisedElementNode) {
-        for (const child of this.children) {
+        // setParent() removes the child from this.children: iterate over a copy
+        for (const child of Array.from(this.children)) {
             if (child !== targetNode) {
                 child.setParent(targetNode);
             }
         }
-        this.children = [];
+        this.children.clear();
         this.activeChildrenPQueue.clear();
     }
 
@@ -135,7 +140,7 @@ export class Http3PrioritisedElementNode extends EventEmitter {
             this.parent.removeChild(this);
         }
         this.parent = parent;
-        this.parent.children.push(this);
+        this.parent.children.add(this);
         if (this.isActive() === true) {
             parent.activateChild(this);
         }
@@ -157,7 +162,7 @@ export class Http3PrioritisedElementNode extends EventEmitter {
         return {
             id: "-1",
             weight: -1,
-            children: this.children.map((child: Http3PrioritisedElementNode) => {
+            children: Array.from(this.children).map((child: Http3PrioritisedElementNode) => {
                 return child.toJSON();
             }),
         }
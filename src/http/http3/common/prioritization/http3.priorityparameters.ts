@@ -0,0 +1,43 @@
+// Priority of a response in the urgency/incremental model ("Extensible Prioritization Scheme for HTTP", RFC 9218)
+// Clients signal these in the priority request header, or later on in a PRIORITY_UPDATE frame (e.g., "u=1, i")
+export interface Http3PriorityParameters {
+    urgency: number, // 0 (most urgent) to 7 (least urgent)
+    incremental: boolean, // the client can use the response while it comes in, so it may share the bandwidth with other incremental responses
+}
+
+export const HTTP3_URGENCY_LEVELS: number = 8;
+export const HTTP3_DEFAULT_PRIORITY: Http3PriorityParameters = { urgency: 3, incremental: false };
+
+/**
+ * Parses a priority field value (the value of the priority header, or the payload of a PRIORITY_UPDATE frame)
+ * It's a structured field dictionary: members are comma separated, "u" holds the urgency, "i" (or "i=?1") marks the response as incremental
+ * Unknown members, parameters and invalid values are ignored, as the RFC requires
+ * Parameters that are missing (or invalid) get their default value. This also goes for PRIORITY_UPDATEs: they replace the stream's priority as a whole,
+ * so "u=2" after "u=5, i" means urgency 2, not incremental (RFC 9218 section 7)
+ */
+export function parsePriorityFieldValue(value: string): Http3PriorityParameters {
+    const parameters: Http3PriorityParameters = { urgency: HTTP3_DEFAULT_PRIORITY.urgency, incremental: HTTP3_DEFAULT_PRIORITY.incremental };
+
+    for (const member of value.split(",")) {
+        // drop the member's own parameters (";key=value"), we don't use any
+        const item: string = member.split(";")[0].trim();
+        const equalsIndex: number = item.indexOf("=");
+        const key: string = equalsIndex < 0 ? item : item.substring(0, equalsIndex).trim();
+        const itemValue: string | undefined = equalsIndex < 0 ? undefined : item.substring(equalsIndex + 1).trim();
+
+        if (key === "u") {
+            if (itemValue !== undefined && /^[0-9]$/.test(itemValue) && Number(itemValue) < HTTP3_URGENCY_LEVELS) {
+                parameters.urgency = Number(itemValue);
+            }
+        } else if (key === "i") {
+            // a key without value is a boolean true
+            if (itemValue === undefined || itemValue === "?1") {
+                parameters.incremental = true;
+            } else if (itemValue === "?0") {
+                parameters.incremental = false;
+            }
+        }
+    }
+
+    return parameters;
+}
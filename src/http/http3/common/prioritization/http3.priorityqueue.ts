@@ -1,5 +1,9 @@
 import { Http3PrioritisedElementNode } from "./http3.prioritisedelementnode";
 
+// Binary min-heap of nodes, ordered by pseudo time
+// Every node keeps its own position in the heap array (see Http3PrioritisedElementNode:heapIndex), so membership checks are O(1)
+// and deleting or re-sorting an arbitrary node is O(log n) instead of a linear search
+// NOTE: a node can only be in one queue at a time. That's always the case here: the only queue a node is in is its parent's activeChildrenPQueue
 export class Http3DepNodePQueue {
     private heap: Http3PrioritisedElementNode[] = [];
 
@@ -9,48 +13,60 @@ export class Http3DepNodePQueue {
         }
     }
 
+    // Adds the node to the queue. No-op if it's already in there
     public push(node: Http3PrioritisedElementNode) {
-        const newSize = this.heap.push(node);
-        this.siftUp(newSize - 1);
+        if (this.includes(node)) {
+            return;
+        }
+        node.heapIndex = this.heap.push(node) - 1;
+        this.siftUp(node.heapIndex);
     }
 
     public pop(): Http3PrioritisedElementNode | undefined {
-        if (this.heap.length > 0) {
-            const top: Http3PrioritisedElementNode = this.heap[0];
-            const bottom: Http3PrioritisedElementNode | undefined = this.heap.pop();
-            if (bottom !== undefined && this.heap.length > 0) {
-                this.heap[0] = bottom;
-                this.siftDown(0);
-            }
-
-            return top;
-        } else {
-            return undefined
+        const top: Http3PrioritisedElementNode | undefined = this.peek();
+        if (top !== undefined) {
+            this.delete(top);
         }
+        return top;
+    }
+
+    // Returns the node with the lowest pseudo time, without removing it
+    public peek(): Http3PrioritisedElementNode | undefined {
+        return this.heap.length > 0 ? this.heap[0] : undefined;
     }
 
     public clear() {
+        for (const node of this.heap) {
+            node.heapIndex = -1;
+        }
         this.heap = [];
     }
 
-    // TODO O(n) time complexity, preferably implement priority search queue
-    public includes(node: Http3PrioritisedElementNode) {
-        return this.heap.indexOf(node) !== -1;
+    public includes(node: Http3PrioritisedElementNode): boolean {
+        return node.heapIndex >= 0 && node.heapIndex < this.heap.length && this.heap[node.heapIndex] === node;
     }
 
-    // TODO O(n) time complexity, preferably implement priority search queue
-    // deletes first occurrence of the passed value, if it is in the heap
+    // Removes the node from the queue, if it is in there
     public delete(node: Http3PrioritisedElementNode) {
-        const index: number = this.heap.findIndex((val) => {
-            return val === node; // FIXME? Comparison between objects is probably slow?
-        });
-
-        if (index !== -1) {
-            // Swap with rightmost leaf
-            this.swap(index, this.heap.length-1);
-            this.heap.pop();
-            // Resift the heap
-            this.siftDown(index);
+        if (!this.includes(node)) {
+            return;
+        }
+
+        const index: number = node.heapIndex;
+        const bottom: Http3PrioritisedElementNode = this.heap.pop()!;
+        node.heapIndex = -1;
+        if (bottom !== node) {
+            // Rightmost leaf takes the deleted node's place and is sifted to where it belongs from there
+            this.heap[index] = bottom;
+            bottom.heapIndex = index;
+            this.restore(index);
+        }
+    }
+
+    // Call after changing the pseudo time of a node that's in the queue, to move it to its new place
+    public update(node: Http3PrioritisedElementNode) {
+        if (this.includes(node)) {
+            this.restore(node.heapIndex);
         }
     }
 
@@ -58,54 +74,58 @@ export class Http3DepNodePQueue {
         return this.heap.length;
     }
 
+    // The node at index can be out of place in either direction (e.g., after update), only one of these will actually move it
+    private restore(index: number) {
+        if (index > 0 && this.heap[index].getPseudoTime() < this.heap[this.parentIndex(index)].getPseudoTime()) {
+            this.siftUp(index);
+        } else {
+            this.siftDown(index);
+        }
+    }
+
+    private parentIndex(index: number): number {
+        return Math.floor((index-1)/2);
+    }
+
     // Sifts up from given index in the heap array
     private siftUp(index: number) {
-        if (index > 0) {
-            const parentIndex: number = Math.floor((index-1)/2);
-            if (this.heap[index].getPseudoTime() < this.heap[parentIndex].getPseudoTime()) {
-                // Swap parent and child and sift from there
-                this.swap(index, parentIndex);
-                this.siftUp(parentIndex);
+        while (index > 0) {
+            const parentIndex: number = this.parentIndex(index);
+            if (this.heap[index].getPseudoTime() >= this.heap[parentIndex].getPseudoTime()) {
+                return;
             }
+            // Swap parent and child and sift from there
+            this.swap(index, parentIndex);
+            index = parentIndex;
         }
     }
 
     private siftDown(index: number) {
-        const leftChildIndex: number = (2*index)+1;
-        const rightChildIndex: number = (2*index)+2;
-        // If leaf: stop
-        if (leftChildIndex >= this.heap.length) {
-            return;
-        }
-        // If only left child exists
-        else if (rightChildIndex === this.heap.length) {
-            const leftChild: number = this.heap[leftChildIndex].getPseudoTime();
-            if (this.heap[index].getPseudoTime() > leftChild) {
-                this.swap(index, leftChildIndex);
+        while (true) {
+            const leftChildIndex: number = (2*index)+1;
+            const rightChildIndex: number = (2*index)+2;
+            // If leaf: stop
+            if (leftChildIndex >= this.heap.length) {
+                return;
             }
-        // If both children exist, compare which one is the smaller and swap
-        } else {
-            const leftChild: number = this.heap[leftChildIndex].getPseudoTime();
-            const rightChild: number = this.heap[rightChildIndex].getPseudoTime();
-            if (leftChild < rightChild) {
-                if (leftChild < this.heap[index].getPseudoTime()) {
-                    this.swap(leftChildIndex, index);
-                    this.siftDown(leftChildIndex);
-                }
-            } else {
-                if (rightChild < this.heap[index].getPseudoTime()) {
-                    this.swap(rightChildIndex, index);
-                    this.siftDown(rightChildIndex);
-                }
+            // Smallest of both children (if there is a right one)
+            let smallestChildIndex: number = leftChildIndex;
+            if (rightChildIndex < this.heap.length && this.heap[rightChildIndex].getPseudoTime() < this.heap[leftChildIndex].getPseudoTime()) {
+                smallestChildIndex = rightChildIndex;
+            }
+            if (this.heap[smallestChildIndex].getPseudoTime() >= this.heap[index].getPseudoTime()) {
+                return;
             }
+            this.swap(smallestChildIndex, index);
+            index = smallestChildIndex;
         }
     }
 
     private swap(indexA: number, indexB: number) {
-        if (indexA < this.heap.length && indexB < this.heap.length) {
-            const a: Http3PrioritisedElementNode = this.heap[indexA];
-            this.heap[indexA] = this.heap[indexB];
-            this.heap[indexB] = a;
-        }
+        const a: Http3PrioritisedElementNode = this.heap[indexA];
+        this.heap[indexA] = this.heap[indexB];
+        this.heap[indexB] = a;
+        this.heap[indexA].heapIndex = indexA;
+        this.heap[indexB].heapIndex = indexB;
     }
 }
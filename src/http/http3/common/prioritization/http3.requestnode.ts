@@ -6,12 +6,16 @@ import { Http3StreamState } from "../types/http3.streamstate";
 import { Http3Error, Http3ErrorCode } from "../errors/http3.error";
 import { VerboseLogging } from "../../../../utilities/logging/verbose.logging";
 import { DependencyTree, DependencyTreeNodeType } from "./http3.deptree";
+import { BufferQueue } from "../../../../types/buffer.queue";
+import { Http3FileSource } from "../http3.filesource";
+import { Constants } from "../../../../utilities/constants";
 
 export class Http3RequestNode extends Http3PrioritisedElementNode {
-    private bufferedData: Buffer = Buffer.alloc(0);
+    private bufferedData: BufferQueue = new BufferQueue();
     private stream: QuicStream;
     private bytesSent: number = Http3PrioritisedElementNode.CHUNK_SIZE;
     private allDataBuffered: boolean = false; // Set to true if all data has been received and stream can be closed
+    private dataSource?: Http3FileSource; // if set, data is pulled from here as it's being sent, instead of being added up front
 
     // Parent should be root by default
     public constructor(stream: QuicStream, parent: Http3PrioritisedElementNode, weight: number = 16) {
@@ -20,30 +24,34 @@ export class Http3RequestNode extends Http3PrioritisedElementNode {
         this.setParent(parent);
     }
 
-    public schedule() {
+    public schedule(): number {
         // TODO possibly set a threshold minimum amount of data so that it doesn't send, for example, a single byte
         // But make sure all buffers are emptied eventually
-        if (this.bufferedData.byteLength > 0) {
-            const sendBuffer: Buffer = this.popData(Http3RequestNode.CHUNK_SIZE);
-            if (this.allDataBuffered === true && this.bufferedData.byteLength === 0) {
-                this.stream.end(sendBuffer);
+        if (this.bufferedData.getByteLength() > 0) {
+            const sendBuffers: Buffer[] = this.popData(Http3RequestNode.CHUNK_SIZE);
+            this.requestSourceData();
+            if (this.allDataBuffered === true && this.bufferedData.getByteLength() === 0) {
+                this.stream.end(sendBuffers);
             } else {
-                this.stream.write(sendBuffer);
+                this.stream.write(sendBuffers);
+            }
+            this.bytesSent = 0;
+            for (const buffer of sendBuffers) {
+                this.bytesSent += buffer.byteLength;
             }
-            this.stream.getConnection().sendPackets(); // Force sending packets
-            this.bytesSent = sendBuffer.byteLength;
             this.stream.getConnection().getQlogger().onHTTPDataChunk(this.stream.getStreamId(), this.bytesSent, this.weight, "TX");
             VerboseLogging.info("Scheduled " + this.bytesSent + " bytes to be sent on stream " + this.stream.getStreamId().toString());
-            if (this.allDataBuffered === true && this.bufferedData.byteLength === 0) {
+            if (this.allDataBuffered === true && this.bufferedData.getByteLength() === 0) {
                 this.stream.getConnection().getQlogger().onHTTPStreamStateChanged(this.stream.getStreamId(), Http3StreamState.MODIFIED, "HALF_CLOSED");
                 VerboseLogging.info("Closed stream " + this.stream.getStreamId().toString() + ", all data transmitted");
                 setTimeout(() => {
                     this.terminate(); // FIXME This pruning is way too aggressive and not spec compliant (should wait at least 2 RTT)
                 }, 500);
             }
+            return this.bytesSent;
         } else {
             // Schedule children
-            super.schedule();
+            return super.schedule();
         }
     }
 
@@ -52,18 +60,28 @@ export class Http3RequestNode extends Http3PrioritisedElementNode {
     }
 
     public hasData(): boolean {
-        return this.bufferedData.byteLength > 0;
+        return this.bufferedData.getByteLength() > 0;
     }
 
     // Set done to true if this was last data
     // Can only add data if stream has not yet been marked as finished
-    public addData(newData: Buffer, done: boolean = false) {
+    // A list of Buffers (e.g., from Http3DataFrame:toBuffers) is queued without concatenating it
+    public addData(newData: Buffer | Buffer[], done: boolean = false) {
         if (this.allDataBuffered === true) {
             // TODO implement appropriate error
             throw new Error("Can not add new data to request node if it has already been marked as finished");
         }
-        if (newData.byteLength > 0) {
-            this.bufferedData = Buffer.concat([this.bufferedData, newData]);
+        const byteLength: number = this.bufferedData.getByteLength();
+        if (newData instanceof Buffer) {
+            this.bufferedData.push(newData);
+        } else {
+            for (const buffer of newData) {
+                this.bufferedData.push(buffer);
+            }
+        }
+        if (this.bufferedData.getByteLength() > byteLength) {
+            // the data is written to the stream when the connection has room for it (see Http3Scheduler)
+            this.stream.getConnection().requestSendPackets();
             const parent: Http3PrioritisedElementNode | null = this.getParent();
             if (parent !== null) {
                 parent.activateChild(this);
@@ -72,15 +90,39 @@ export class Http3RequestNode extends Http3PrioritisedElementNode {
         this.allDataBuffered = done;
     }
 
+    // The source adds its data through addData() and finishes the node once it has nothing left
+    public setDataSource(source: Http3FileSource) {
+        this.dataSource = source;
+        source.attach((data: Buffer[]) => {
+            this.addData(data);
+        }, () => {
+            this.dataSource = undefined;
+            this.finish();
+        });
+        this.requestSourceData();
+    }
+
+    // keep (at most) about one file chunk buffered ahead of what's being sent
+    private requestSourceData() {
+        if (this.dataSource !== undefined && this.bufferedData.getByteLength() < Constants.HTTP3_FILE_CHUNK_SIZE) {
+            this.dataSource.requestData();
+        }
+    }
+
     // Blocks new data from being passed to the stream
     // When all currently buffered data has been transmitted, stream will be closed and
     // children of this node will be passed to this node's parent
     public finish() {
+        if (this.dataSource !== undefined) {
+            // whatever the source hasn't read yet won't be sent anymore
+            this.dataSource.close();
+            this.dataSource = undefined;
+        }
         this.allDataBuffered = true;
-        if (this.bufferedData.byteLength === 0) {
+        if (this.bufferedData.getByteLength() === 0) {
             this.stream.end();
             this.removeSelf();
-            this.stream.getConnection().sendPackets(); // Force sending packets FIXME QUICker cannot send empty frames yet
+            this.stream.getConnection().requestSendPackets(); // only the FIN is left to send
             this.stream.getConnection().getQlogger().onHTTPStreamStateChanged(this.stream.getStreamId(), Http3StreamState.MODIFIED, "HALF_CLOSED");
         }
     }
@@ -88,6 +130,10 @@ export class Http3RequestNode extends Http3PrioritisedElementNode {
     // Closes its stream and removes itself from the tree
     // CAUTION: untransmitted data will be lost!
     public terminate() {
+        if (this.dataSource !== undefined) {
+            this.dataSource.close();
+            this.dataSource = undefined;
+        }
         this.stream.end();
         this.removeSelf();
     }
@@ -98,18 +144,10 @@ export class Http3RequestNode extends Http3PrioritisedElementNode {
         return this.hasData() || super.isActive();
     }
 
-    // Consumes <bytecount> amount of data from the buffer and returns it
+    // Consumes <bytecount> amount of data from the buffer and returns it, as slices of the buffered data (nothing is copied)
     // If the bytecount is greater than the amount of bytes left in the buffer, the full buffer is consumed
-    public popData(bytecount: number): Buffer {
-        let popped: Buffer;
-        if (bytecount > this.bufferedData.byteLength) {
-            popped = this.bufferedData;
-            this.bufferedData = Buffer.alloc(0);
-        } else {
-            popped = this.bufferedData.slice(0, bytecount);
-            this.bufferedData = this.bufferedData.slice(bytecount);
-        }
-        return popped;
+    public popData(bytecount: number): Buffer[] {
+        return this.bufferedData.consume(bytecount);
     }
 
     public getStreamID(): Bignum {
@@ -121,7 +159,7 @@ export class Http3RequestNode extends Http3PrioritisedElementNode {
             type: DependencyTreeNodeType.REQUEST,
             id: this.stream.getStreamId().toDecimalString(),
             weight: this.weight,
-            children: this.children.map((child: Http3PrioritisedElementNode) => {
+            children: Array.from(this.children).map((child: Http3PrioritisedElementNode) => {
                 return child.toJSON();
             }),
         }
@@ -0,0 +1,46 @@
+import { Connection, ConnectionEvent } from "../../../../quicker/connection";
+import { Http3PriorityScheme } from "./schemes/http3.priorityscheme";
+import { VerboseLogging } from "../../../../utilities/logging/verbose.logging";
+
+/**
+ * Moves data from the prioritisation scheme to the QUIC streams whenever the connection can send it
+ * The scheme buffers everything the endpoint wants to send. Whenever congestion control has room for more STREAM data,
+ * the connection emits a send opportunity (see Connection:offerSendOpportunity) and we keep asking the scheme for its next chunk until that room is used up.
+ * The chunks are packetized right after, in the same sendPackets() call.
+ * There is no timer: new data only asks the connection to send (Connection:requestSendPackets), which then comes back to us here.
+ * An idle connection costs nothing, and a connection with a large window isn't limited to one chunk per timer tick
+ */
+export class Http3Scheduler {
+    private connection: Connection;
+    private prioritiser: Http3PriorityScheme;
+    private stopped: boolean = false;
+
+    public constructor(connection: Connection, prioritiser: Http3PriorityScheme) {
+        this.connection = connection;
+        this.prioritiser = prioritiser;
+        this.onSendOpportunity = this.onSendOpportunity.bind(this);
+        this.connection.on(ConnectionEvent.SEND_OPPORTUNITY, this.onSendOpportunity);
+    }
+
+    // No more data is moved to the streams after this. Whatever was already written to them is still sent by the connection
+    public stop() {
+        if (this.stopped === true) {
+            return;
+        }
+        this.stopped = true;
+        this.connection.removeListener(ConnectionEvent.SEND_OPPORTUNITY, this.onSendOpportunity);
+    }
+
+    private onSendOpportunity(budget: number) {
+        let bytesScheduled: number = 0;
+        // The last chunk can go a bit over budget (at most one chunk). That's fine: it simply waits in its stream for the next opportunity
+        while (bytesScheduled < budget) {
+            const chunkSize: number = this.prioritiser.schedule();
+            if (chunkSize === 0) {
+                break; // nothing left to send
+            }
+            bytesScheduled += chunkSize;
+        }
+        VerboseLogging.debug("Http3Scheduler:onSendOpportunity : scheduled " + bytesScheduled + " of " + budget + " bytes");
+    }
+}
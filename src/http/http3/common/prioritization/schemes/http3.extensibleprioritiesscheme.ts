@@ -0,0 +1,224 @@
+import { Http3PriorityScheme } from "./http3.priorityscheme";
+import { QlogWrapper } from "../../../../../utilities/logging/qlog.wrapper";
+import { QuicStream } from "../../../../../quicker/quic.stream";
+import { Bignum } from "../../../../../types/bignum";
+import { Http3PriorityFrame } from "../../frames";
+import { Http3PMeenanNode, Http3PMeenanNodeEvent } from "./http3.pmeenannode";
+import { VerboseLogging } from "../../../../../utilities/logging/verbose.logging";
+import { Http3RequestMetadata } from "../../../client/http3.requestmetadata";
+import { Http3FileSource } from "../../http3.filesource";
+import { Http3PriorityParameters, HTTP3_URGENCY_LEVELS, HTTP3_DEFAULT_PRIORITY, parsePriorityFieldValue } from "../http3.priorityparameters";
+
+interface Http3PrioritisedStream {
+    node: Http3PMeenanNode,
+    parameters: Http3PriorityParameters,
+}
+
+// Streams of a single urgency level that have data to send
+// JS Sets keep insertion order and have O(1) deletes, so they double as queues we can remove arbitrary streams from
+class Http3UrgencyBucket {
+    // non-incremental: sent one after the other, in the order they got data
+    public sequential: Set<Http3PMeenanNode> = new Set<Http3PMeenanNode>();
+    // incremental: round robin, one chunk each
+    public incremental: Set<Http3PMeenanNode> = new Set<Http3PMeenanNode>();
+
+    public isEmpty(): boolean {
+        return this.sequential.size === 0 && this.incremental.size === 0;
+    }
+}
+
+/**
+ * Urgency/incremental prioritisation ("Extensible Prioritization Scheme for HTTP", RFC 9218), instead of a dependency tree
+ * Every response has an urgency (0 to 7) and is either incremental or not, taken from the priority request header and
+ * changed by PRIORITY_UPDATE frames on the control stream. Requests without priority get the default (urgency 3, not incremental)
+ * Only the most urgent level that has data is served. Within a level, non-incremental responses go first, one at a time,
+ * then the incremental ones share what's left round robin
+ * Only streams that actually have data are queued and the first non-empty level is found with a bitmask, so schedule() is O(1)
+ */
+export class Http3ExtensiblePrioritiesScheme extends Http3PriorityScheme {
+    // PRIORITY_UPDATEs can arrive before the request stream they're about: we keep a limited amount of them around until it does
+    private static readonly MAX_PENDING_UPDATES: number = 256;
+
+    private buckets: Http3UrgencyBucket[] = [];
+    // bit u is set if bucket u has at least one stream with data. Lowest set bit = most urgent level with data
+    private activeBuckets: number = 0;
+
+    private unprioritisedStreams: Map<string, QuicStream> = new Map<string, QuicStream>();
+    private streams: Map<string, Http3PrioritisedStream> = new Map<string, Http3PrioritisedStream>();
+    private pendingUpdates: Map<string, string> = new Map<string, string>();
+
+    public constructor(logger?: QlogWrapper) {
+        super(0, logger);
+        for (let i = 0; i < HTTP3_URGENCY_LEVELS; ++i) {
+            this.buckets.push(new Http3UrgencyBucket());
+        }
+    }
+
+    public initialSetup(): Http3PriorityFrame[] {
+        return [];
+    }
+
+    public addStream(requestStream: QuicStream): void {
+        this.unprioritisedStreams.set(requestStream.getStreamId().toString(), requestStream);
+    }
+
+    // Priorities are signalled through the priority header and PRIORITY_UPDATE frames, never with PRIORITY frames: always returns null
+    public applyScheme(streamID: Bignum, metadata: Http3RequestMetadata): Http3PriorityFrame | null {
+        const key: string = streamID.toString();
+        const requestStream: QuicStream | undefined = this.unprioritisedStreams.get(key);
+        if (requestStream === undefined) {
+            throw new Error("Tried applying a scheme to a stream which was not in the data structure");
+        }
+        this.unprioritisedStreams.delete(key);
+
+        let parameters: Http3PriorityParameters = HTTP3_DEFAULT_PRIORITY;
+        if (metadata.priority !== undefined) {
+            parameters = parsePriorityFieldValue(metadata.priority);
+        }
+        // an update that was sent after the request, but arrived before it, replaces the header
+        const pendingUpdate: string | undefined = this.pendingUpdates.get(key);
+        if (pendingUpdate !== undefined) {
+            this.pendingUpdates.delete(key);
+            parameters = parsePriorityFieldValue(pendingUpdate);
+        }
+
+        const node: Http3PMeenanNode = new Http3PMeenanNode(requestStream, parameters.urgency, parameters.incremental ? 1 : 0);
+        node.on(Http3PMeenanNodeEvent.DATA_AVAILABLE, () => {
+            this.activateNode(key);
+        });
+        node.on(Http3PMeenanNodeEvent.NODE_FINISHED, () => {
+            this.removeRequestStream(streamID);
+        });
+        this.streams.set(key, { node: node, parameters: parameters });
+
+        VerboseLogging.info("Http3ExtensiblePrioritiesScheme:applyScheme : stream " + key + " has urgency " + parameters.urgency + (parameters.incremental ? ", incremental" : ""));
+        return null;
+    }
+
+    public handlePriorityFrame(priorityFrame: Http3PriorityFrame, currentStreamID: Bignum): void {
+        // Dependency tree priorities don't map onto urgencies: ignored
+        VerboseLogging.warn("Http3ExtensiblePrioritiesScheme:handlePriorityFrame : PRIORITY frames are not supported by this scheme, ignoring it");
+    }
+
+    public handlePriorityUpdate(requestStreamID: Bignum, priorityFieldValue: string): void {
+        const key: string = requestStreamID.toString();
+        const stream: Http3PrioritisedStream | undefined = this.streams.get(key);
+        if (stream === undefined) {
+            // request not in yet (or already done, in which case this is never used and dropped with the rest once there are too many)
+            if (this.pendingUpdates.size < Http3ExtensiblePrioritiesScheme.MAX_PENDING_UPDATES || this.pendingUpdates.has(key)) {
+                this.pendingUpdates.set(key, priorityFieldValue);
+            }
+            return;
+        }
+
+        this.deactivateNode(key);
+        // not merged with the current parameters: whatever the update leaves out goes back to its default
+        stream.parameters = parsePriorityFieldValue(priorityFieldValue);
+        stream.node.setPriority(stream.parameters.urgency);
+        stream.node.setConcurrency(stream.parameters.incremental ? 1 : 0);
+        this.activateNode(key);
+        VerboseLogging.info("Http3ExtensiblePrioritiesScheme:handlePriorityUpdate : stream " + key + " now has urgency " + stream.parameters.urgency + (stream.parameters.incremental ? ", incremental" : ""));
+    }
+
+    // undefined if the request hasn't come in yet (or is done already)
+    public getPriorityParameters(requestStreamID: Bignum): Http3PriorityParameters | undefined {
+        const stream: Http3PrioritisedStream | undefined = this.streams.get(requestStreamID.toString());
+        return stream === undefined ? undefined : stream.parameters;
+    }
+
+    public addData(requestStreamID: Bignum, buffer: Buffer | Buffer[]) {
+        this.getStream(requestStreamID, "adding data to").node.addData(buffer);
+    }
+
+    public addDataSource(requestStreamID: Bignum, source: Http3FileSource) {
+        this.getStream(requestStreamID, "adding a data source to").node.setDataSource(source);
+    }
+
+    public finishStream(requestStreamID: Bignum) {
+        this.getStream(requestStreamID, "finishing").node.finishStream();
+    }
+
+    public removeRequestStream(requestStreamID: Bignum) {
+        const key: string = requestStreamID.toString();
+        this.unprioritisedStreams.delete(key);
+        this.pendingUpdates.delete(key);
+        const stream: Http3PrioritisedStream | undefined = this.streams.get(key);
+        if (stream !== undefined) {
+            this.deactivateNode(key);
+            stream.node.removeAllListeners();
+            this.streams.delete(key);
+        }
+    }
+
+    public schedule(): number {
+        while (this.activeBuckets !== 0) {
+            // index of the lowest set bit
+            const urgency: number = 31 - Math.clz32(this.activeBuckets & -this.activeBuckets);
+            const bucket: Http3UrgencyBucket = this.buckets[urgency];
+
+            let node: Http3PMeenanNode;
+            let incremental: boolean;
+            if (bucket.sequential.size > 0) {
+                // stays first in line until it runs out of data or is finished
+                node = bucket.sequential.values().next().value;
+                incremental = false;
+            } else {
+                node = bucket.incremental.values().next().value;
+                bucket.incremental.delete(node);
+                incremental = true;
+            }
+
+            // can end up calling removeRequestStream (NODE_FINISHED)
+            const bytesScheduled: number = node.schedule();
+
+            const key: string = node.getStreamID().toString();
+            if (!node.hasData() || !this.streams.has(key)) {
+                this.deactivateNode(key);
+            } else if (incremental) {
+                bucket.incremental.add(node); // back of the line
+            }
+
+            if (bytesScheduled > 0) {
+                return bytesScheduled;
+            }
+        }
+        return 0;
+    }
+
+    private getStream(requestStreamID: Bignum, action: string): Http3PrioritisedStream {
+        const stream: Http3PrioritisedStream | undefined = this.streams.get(requestStreamID.toString());
+        if (stream === undefined) {
+            throw new Error("Tried " + action + " a stream which was not in the data structure");
+        }
+        return stream;
+    }
+
+    // queues the stream in the bucket of its urgency, if it has data
+    private activateNode(key: string) {
+        const stream: Http3PrioritisedStream | undefined = this.streams.get(key);
+        if (stream === undefined || !stream.node.hasData()) {
+            return;
+        }
+        const bucket: Http3UrgencyBucket = this.buckets[stream.parameters.urgency];
+        if (stream.parameters.incremental) {
+            bucket.incremental.add(stream.node);
+        } else {
+            bucket.sequential.add(stream.node);
+        }
+        this.activeBuckets |= (1 << stream.parameters.urgency);
+    }
+
+    private deactivateNode(key: string) {
+        const stream: Http3PrioritisedStream | undefined = this.streams.get(key);
+        if (stream === undefined) {
+            return;
+        }
+        const urgency: number = stream.parameters.urgency;
+        const bucket: Http3UrgencyBucket = this.buckets[urgency];
+        bucket.sequential.delete(stream.node);
+        bucket.incremental.delete(stream.node);
+        if (bucket.isEmpty()) {
+            this.activeBuckets &= ~(1 << urgency);
+        }
+    }
+}
@@ -2,6 +2,7 @@ import { QuicStream } from "../../../../../quicker/quic.stream";
 import { Http3PMeenanNode, Http3PMeenanNodeEvent } from "./http3.pmeenannode";
 import { EventEmitter } from "events";
 import { Bignum } from "../../../../../types/bignum";
+import { Http3FileSource } from "../../http3.filesource";
 
 export class Http3PMeenanBucket extends EventEmitter {
     private priority: number;
@@ -42,7 +43,7 @@ export class Http3PMeenanBucket extends EventEmitter {
         });
     }
 
-    public addData(requestStreamID: Bignum, data: Buffer) {
+    public addData(requestStreamID: Bignum, data: Buffer | Buffer[]) {
         const concurrency: number | undefined = this.streamIdToConcurrencyMap.get(requestStreamID.toString());
         switch(concurrency) {
             case 3:
@@ -73,6 +74,29 @@ export class Http3PMeenanBucket extends EventEmitter {
         }
     }
 
+    // the node then pulls its data from the source (see Http3FileSource)
+    public addDataSource(requestStreamID: Bignum, source: Http3FileSource) {
+        let bucket: Http3PMeenanNode[];
+        switch(this.streamIdToConcurrencyMap.get(requestStreamID.toString())) {
+            case 3:
+                bucket = this.exclusiveSequentialBucket;
+                break;
+            case 2:
+                bucket = this.sharedSequentialBucket;
+                break;
+            case 1:
+                bucket = this.sharedBucket;
+                break;
+            default:
+                throw new Error("Tried adding a data source to a stream which was not in the bucket");
+        }
+        for (const node of bucket) {
+            if (node.getStreamID().equals(requestStreamID)) {
+                node.setDataSource(source);
+            }
+        }
+    }
+
     public finishStream(streamID: Bignum) {
         const concurrency: number | undefined = this.streamIdToConcurrencyMap.get(streamID.toString());
         switch(concurrency) {
@@ -195,19 +219,20 @@ export class Http3PMeenanBucket extends EventEmitter {
         return this.exclusiveSequentialBucket.length === 0 && this.sharedSequentialBucket.length === 0 && this.sharedBucket.length === 0;
     }
 
-    // Returns false if the bucket is empty
-    public schedule(): boolean {
+    // Returns the amount of bytes that were scheduled, 0 if the bucket has nothing to send
+    public schedule(): number {
+        let bytesScheduled: number;
         for (const node of this.exclusiveSequentialBucket) {
-            if (node.schedule() === true) {
-                return true;
+            if ((bytesScheduled = node.schedule()) > 0) {
+                return bytesScheduled;
             }
         }
         // First check sharedSequential bucket before sharedbucket
         if (this.sharedFlipBit === false) {
             for (const node of this.sharedSequentialBucket) {
-                if (node.schedule() === true) {
+                if ((bytesScheduled = node.schedule()) > 0) {
                     this.sharedFlipBit = true;
-                    return true;
+                    return bytesScheduled;
                 }
             }
             if (this.sharedBucket.length > 0) {
@@ -216,10 +241,10 @@ export class Http3PMeenanBucket extends EventEmitter {
                 do {
                     // Wrap around index when reaching the end
                     index %= this.sharedBucket.length;
-                    if (this.sharedBucket[index].schedule() === true) {
+                    if ((bytesScheduled = this.sharedBucket[index].schedule()) > 0) {
                         ++(this.sharedBucketIndex);
                         this.sharedFlipBit = false
-                        return true;
+                        return bytesScheduled;
                     }
                     ++index;
                 } while (index !== this.sharedBucketIndex);
@@ -231,21 +256,21 @@ export class Http3PMeenanBucket extends EventEmitter {
                 do {
                     // Wrap around index when reaching the end
                     index %= this.sharedBucket.length;
-                    if (this.sharedBucket[index].schedule() === true) {
+                    if ((bytesScheduled = this.sharedBucket[index].schedule()) > 0) {
                         ++(this.sharedBucketIndex);
                         this.sharedFlipBit = false
-                        return true;
+                        return bytesScheduled;
                     }
                     ++index;
                 } while (index !== this.sharedBucketIndex);
             }
             for (const node of this.sharedSequentialBucket) {
-                if (node.schedule() === true) {
+                if ((bytesScheduled = node.schedule()) > 0) {
                     this.sharedFlipBit = true;
-                    return true;
+                    return bytesScheduled;
                 }
             }
         }
-        return false;
+        return 0;
     }
 }
\ No newline at end of file
@@ -3,19 +3,24 @@ import { VerboseLogging } from "../../../../../utilities/logging/verbose.logging
 import { Http3StreamState } from "../../types/http3.streamstate";
 import { EventEmitter } from "events";
 import { Bignum } from "../../../../../types/bignum";
+import { BufferQueue } from "../../../../../types/buffer.queue";
+import { Http3FileSource } from "../../http3.filesource";
+import { Constants } from "../../../../../utilities/constants";
 
 export enum Http3PMeenanNodeEvent {
     NODE_FINISHED = "node finished",
+    DATA_AVAILABLE = "node data available", // the node had nothing buffered, but now it does
 }
 
 export class Http3PMeenanNode extends EventEmitter {
     private static readonly CHUNK_SIZE: number = 1400;
 
-    private bufferedData: Buffer = Buffer.alloc(0);
+    private bufferedData: BufferQueue = new BufferQueue();
     private requestStream: QuicStream;
     private priority: number;
     private concurrency: number;
     private allDataBuffered: boolean = false; // Set to true if all data has been received and stream can be closed
+    private dataSource?: Http3FileSource; // if set, data is pulled from here as it's being sent, instead of being added up front
 
     public constructor(requestStream: QuicStream, priority: number, concurrency: number) {
         super();
@@ -24,9 +29,45 @@ export class Http3PMeenanNode extends EventEmitter {
         this.concurrency = concurrency;
     }
 
-    public addData(buffer: Buffer) {
+    // A list of Buffers (e.g., from Http3DataFrame:toBuffers) is queued without concatenating it
+    public addData(data: Buffer | Buffer[]) {
         if (this.allDataBuffered === false) {
-            this.bufferedData = Buffer.concat([this.bufferedData, buffer]);
+            const wasEmpty: boolean = this.bufferedData.getByteLength() === 0;
+            if (data instanceof Buffer) {
+                this.bufferedData.push(data);
+            } else {
+                for (const buffer of data) {
+                    this.bufferedData.push(buffer);
+                }
+            }
+            // the data is written to the stream when the connection has room for it (see Http3Scheduler)
+            this.requestStream.getConnection().requestSendPackets();
+            if (wasEmpty && this.bufferedData.getByteLength() > 0) {
+                this.emit(Http3PMeenanNodeEvent.DATA_AVAILABLE, this);
+            }
+        }
+    }
+
+    public hasData(): boolean {
+        return this.bufferedData.getByteLength() > 0;
+    }
+
+    // The source adds its data through addData() and finishes the stream once it has nothing left
+    public setDataSource(source: Http3FileSource) {
+        this.dataSource = source;
+        source.attach((data: Buffer[]) => {
+            this.addData(data);
+        }, () => {
+            this.dataSource = undefined;
+            this.finishStream();
+        });
+        this.requestSourceData();
+    }
+
+    // keep (at most) about one file chunk buffered ahead of what's being sent
+    private requestSourceData() {
+        if (this.dataSource !== undefined && this.bufferedData.getByteLength() < Constants.HTTP3_FILE_CHUNK_SIZE) {
+            this.dataSource.requestData();
         }
     }
 
@@ -47,10 +88,15 @@ export class Http3PMeenanNode extends EventEmitter {
     }
 
     public finishStream() {
+        if (this.dataSource !== undefined) {
+            // whatever the source hasn't read yet won't be sent anymore
+            this.dataSource.close();
+            this.dataSource = undefined;
+        }
         this.allDataBuffered = true;
-        if (this.bufferedData.byteLength === 0) {
+        if (this.bufferedData.getByteLength() === 0) {
             this.requestStream.end();
-            this.requestStream.getConnection().sendPackets(); // Force sending packets FIXME QUICker cannot send empty frames yet
+            this.requestStream.getConnection().requestSendPackets(); // only the FIN is left to send
             this.requestStream.getConnection().getQlogger().onHTTPStreamStateChanged(this.requestStream.getStreamId(), Http3StreamState.MODIFIED, "HALF_CLOSED");
             this.emit(Http3PMeenanNodeEvent.NODE_FINISHED, this, this.priority, this.concurrency);
         }
@@ -60,45 +106,41 @@ export class Http3PMeenanNode extends EventEmitter {
         return this.requestStream.getStreamId();
     }
 
-    // Returns true if it successfully scheduled a chunk, false otherwise
-    public schedule(): boolean {
+    // Returns the amount of bytes it scheduled, 0 if it had nothing to send
+    public schedule(): number {
         // TODO possibly set a threshold minimum amount of data so that it doesn't send, for example, a single byte
         // But make sure all buffers are emptied eventually
-        if (this.bufferedData.byteLength > 0) {
-            const sendBuffer: Buffer = this.popData(Http3PMeenanNode.CHUNK_SIZE);
-            if (this.allDataBuffered === true && this.bufferedData.byteLength === 0) {
-                this.requestStream.end(sendBuffer);
+        if (this.bufferedData.getByteLength() > 0) {
+            const sendBuffers: Buffer[] = this.popData(Http3PMeenanNode.CHUNK_SIZE);
+            let byteLength: number = 0;
+            for (const buffer of sendBuffers) {
+                byteLength += buffer.byteLength;
+            }
+            this.requestSourceData();
+            if (this.allDataBuffered === true && this.bufferedData.getByteLength() === 0) {
+                this.requestStream.end(sendBuffers);
             } else {
-                this.requestStream.write(sendBuffer);
+                this.requestStream.write(sendBuffers);
             }
-            this.requestStream.getConnection().sendPackets(); // Force sending packets
             // 6 bits for priority, 2 bits for concurrency
             const weight: number = (this.priority << 2) | this.concurrency;
             // Weight is not traditional h3 weight
-            this.requestStream.getConnection().getQlogger().onHTTPDataChunk(this.requestStream.getStreamId(), sendBuffer.byteLength, weight, "TX");
-            VerboseLogging.info("Scheduled " + sendBuffer.byteLength + " bytes to be sent on stream " + this.requestStream.getStreamId().toString());
-            if (this.allDataBuffered === true && this.bufferedData.byteLength === 0) {
+            this.requestStream.getConnection().getQlogger().onHTTPDataChunk(this.requestStream.getStreamId(), byteLength, weight, "TX");
+            VerboseLogging.info("Scheduled " + byteLength + " bytes to be sent on stream " + this.requestStream.getStreamId().toString());
+            if (this.allDataBuffered === true && this.bufferedData.getByteLength() === 0) {
                 this.requestStream.getConnection().getQlogger().onHTTPStreamStateChanged(this.requestStream.getStreamId(), Http3StreamState.MODIFIED, "HALF_CLOSED");
                 VerboseLogging.info("Closed stream " + this.requestStream.getStreamId().toString() + ", all data transmitted");
                 this.emit(Http3PMeenanNodeEvent.NODE_FINISHED, this, this.priority, this.concurrency);
             }
-            return true;
+            return byteLength;
         } else {
-            return false;
+            return 0;
         }
     }
 
-    // Consumes <bytecount> amount of data from the buffer and returns it
+    // Consumes <bytecount> amount of data from the buffer and returns it, as slices of the buffered data (nothing is copied)
     // If the bytecount is greater than the amount of bytes left in the buffer, the full buffer is consumed
-    private popData(bytecount: number): Buffer {
-        let popped: Buffer;
-        if (bytecount > this.bufferedData.byteLength) {
-            popped = this.bufferedData;
-            this.bufferedData = Buffer.alloc(0);
-        } else {
-            popped = this.bufferedData.slice(0, bytecount);
-            this.bufferedData = this.bufferedData.slice(bytecount);
-        }
-        return popped;
+    private popData(bytecount: number): Buffer[] {
+        return this.bufferedData.consume(bytecount);
     }
 }
\ No newline at end of file
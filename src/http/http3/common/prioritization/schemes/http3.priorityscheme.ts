@@ -4,6 +4,7 @@ import { Bignum } from "../../../../../types/bignum";
 import { Http3PriorityFrame } from "../../frames";
 import { QlogWrapper } from "../../../../../utilities/logging/qlog.wrapper";
 import { Http3RequestMetadata } from "../../../client/http3.requestmetadata";
+import { Http3FileSource } from "../../http3.filesource";
 
 export abstract class Http3PriorityScheme {
     protected dependencyTree: Http3DependencyTree;
@@ -30,12 +31,25 @@ export abstract class Http3PriorityScheme {
 
     public abstract handlePriorityFrame(priorityFrame: Http3PriorityFrame, currentStreamID: Bignum): void;
 
-    public addData(streamID: Bignum, buffer: Buffer) {
+    // PRIORITY_UPDATE frame (see Http3PriorityUpdateFrame) for the given request stream
+    public handlePriorityUpdate(requestStreamID: Bignum, priorityFieldValue: string): void {
+        // Only the urgency/incremental based schemes use these, the dependency tree based ones ignore them
+    }
+
+    public addData(streamID: Bignum, buffer: Buffer | Buffer[]) {
         this.dependencyTree.addData(streamID, buffer);
     }
 
-    public schedule() {
-        this.dependencyTree.schedule();
+    // Like addData, but the data is pulled from the source while the stream is being scheduled, instead of all being buffered here first
+    // The stream is finished automatically once the source is exhausted (so don't call finishStream for it)
+    public addDataSource(streamID: Bignum, source: Http3FileSource) {
+        this.dependencyTree.addDataSource(streamID, source);
+    }
+
+    // Writes the next chunk (of the stream that's next in line according to the scheme) to its QUIC stream
+    // Returns the amount of bytes that were written, 0 if there was nothing to send
+    public schedule(): number {
+        return this.dependencyTree.schedule();
     }
 
     public finishStream(requestStreamID: Bignum) {
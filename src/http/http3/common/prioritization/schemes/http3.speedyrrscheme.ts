@@ -7,6 +7,7 @@ import { Http3PriorityFrame, PrioritizedElementType, ElementDependencyType } fro
 import { Http3PMeenanNode, Http3PMeenanNodeEvent } from "./http3.pmeenannode";
 import { VerboseLogging } from "../../../../../utilities/logging/verbose.logging";
 import { Http3RequestMetadata } from "../../../client/http3.requestmetadata";
+import { Http3FileSource } from "../../http3.filesource";
 
 enum PriorityGroup {
     HIGHEST = 4,
@@ -105,7 +106,7 @@ export class Http3SpeedyRRScheme extends Http3PriorityScheme {
         // }
     }
 
-    public addData(requestStreamID: Bignum, buffer: Buffer) {
+    public addData(requestStreamID: Bignum, buffer: Buffer | Buffer[]) {
         const priority: number | undefined = this.streamIdToBucketMap.get(requestStreamID.toString());
         if (priority !== undefined) {
             this.buckets[priority].addData(requestStreamID, buffer);
@@ -114,6 +115,15 @@ export class Http3SpeedyRRScheme extends Http3PriorityScheme {
         }
     }
 
+    public addDataSource(requestStreamID: Bignum, source: Http3FileSource) {
+        const priority: number | undefined = this.streamIdToBucketMap.get(requestStreamID.toString());
+        if (priority !== undefined) {
+            this.buckets[priority].addDataSource(requestStreamID, source);
+        } else {
+            throw new Error("Tried adding a data source to stream which was not in the data structure");
+        }
+    }
+
     public finishStream(requestStreamID: Bignum) {
         const priority: number | undefined = this.streamIdToBucketMap.get(requestStreamID.toString());
         if (priority !== undefined) {
@@ -138,11 +148,15 @@ export class Http3SpeedyRRScheme extends Http3PriorityScheme {
         }
     }
 
-    public schedule() {
-        let iter: number = 0;
-        while(iter < this.activeBuckets.length && this.buckets[this.activeBuckets[iter]].schedule() === false) {
-            ++iter;
+    public schedule(): number {
+        // highest priority bucket that has something to send
+        for (const bucket of this.activeBuckets) {
+            const bytesScheduled: number = this.buckets[bucket].schedule();
+            if (bytesScheduled > 0) {
+                return bytesScheduled;
+            }
         }
+        return 0;
     }
 
     private metadataToBucket(metadata: Http3RequestMetadata): [number, number] {
@@ -10,6 +10,7 @@ import { Http3ClientSidedScheme } from "./http3.clientsidedscheme";
 import { Http3PMeenanScheme } from "./http3.pmeenanscheme";
 import { Http3PmeenanHtmlScheme } from "./http3.pmeenanhtmlscheme";
 import { Http3SpeedyRRScheme } from "./http3.speedyrrscheme";
+import { Http3ExtensiblePrioritiesScheme } from "./http3.extensibleprioritiesscheme";
 
 export {
     Http3DynamicFifoScheme,
@@ -24,4 +25,5 @@ export {
     Http3PMeenanScheme,
     Http3PmeenanHtmlScheme,
     Http3SpeedyRRScheme,
+    Http3ExtensiblePrioritiesScheme,
 }
\ No newline at end of file
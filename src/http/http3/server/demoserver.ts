@@ -38,6 +38,7 @@ Constants.LOG_FILE_NAME = "server.log";
 VerboseLogging.info("Running QUICker server at " + host + ":" + port + ", with certs: " + key + ", " + cert);
 
 let server: Http3Server = new Http3Server(resolve(__dirname + key), resolve(__dirname + cert), "rr", resourceList);
+server.setPushEnabled(true);
 server.listen(port, host);
 
 console.log("HTTP/3 server listening on port "+ host +":"+ port +", log level " + Constants.LOG_LEVEL);
@@ -0,0 +1,221 @@
+import { Http3Request } from "../common/http3.request";
+import { Http3Response } from "../common/http3.response";
+
+export type Http3RequestHandler = (req: Http3Request, res: Http3Response) => Promise<void>;
+
+export interface Http3RouteMatch {
+    handler?: Http3RequestHandler, // undefined if the path is known, but not for this method (-> 405, see allowedMethods)
+    params: {[name: string]: string},
+    allowedMethods: string[],
+}
+
+// Methods registered as ALL_METHODS match any method that has no specific handler of its own
+export const ALL_METHODS: string = "*";
+
+class Http3RouteNode {
+    // static part of the path this node matches (edge label of the radix tree). Empty for parameter and wildcard nodes
+    public prefix: string;
+    // static children, by the first character of their prefix: no two children share a first character (they would have been merged)
+    public staticChildren: Map<string, Http3RouteNode> = new Map<string, Http3RouteNode>();
+    // ":name" : matches a single path segment (up to the next '/')
+    public paramChild?: Http3RouteNode;
+    public paramName?: string;
+    // "*name" : matches the rest of the path, can only be the last part of a route
+    public wildcardChild?: Http3RouteNode;
+    public wildcardName?: string;
+
+    public handlers?: Map<string, Http3RequestHandler>;
+
+    public constructor(prefix: string = "") {
+        this.prefix = prefix;
+    }
+}
+
+/**
+ * Radix tree that maps (method, path) to request handlers
+ * Routes are paths with optional parameters, e.g., "/users/:id/posts" or "/files/*path"
+ * Lookups are proportional to the length of the path, not the amount of routes: shared prefixes are only compared once
+ * If multiple routes match, static parts win over parameters, which win over wildcards
+ */
+export class Http3Router {
+    private root: Http3RouteNode = new Http3RouteNode();
+
+    public add(method: string, route: string, handler: Http3RequestHandler) {
+        if (route.length === 0 || route[0] !== "/") {
+            throw new Error("Http3Router:add : routes need to start with a '/' : " + route);
+        }
+
+        let node: Http3RouteNode = this.root;
+        let position: number = 0;
+        while (position < route.length) {
+            const character: string = route[position];
+            if (character === ":" || character === "*") {
+                let end: number = route.indexOf("/", position);
+                if (end < 0) {
+                    end = route.length;
+                }
+                const name: string = route.substring(position + 1, end);
+                if (name.length === 0) {
+                    throw new Error("Http3Router:add : unnamed parameter in route " + route);
+                }
+
+                if (character === ":") {
+                    if (node.paramChild === undefined) {
+                        node.paramChild = new Http3RouteNode();
+                        node.paramName = name;
+                    }
+                    else if (node.paramName !== name) {
+                        throw new Error("Http3Router:add : parameter :" + name + " in route " + route + " conflicts with existing parameter :" + node.paramName);
+                    }
+                    node = node.paramChild;
+                }
+                else {
+                    if (end !== route.length) {
+                        throw new Error("Http3Router:add : wildcards can only be used at the end of a route : " + route);
+                    }
+                    if (node.wildcardChild === undefined) {
+                        node.wildcardChild = new Http3RouteNode();
+                        node.wildcardName = name;
+                    }
+                    else if (node.wildcardName !== name) {
+                        throw new Error("Http3Router:add : wildcard *" + name + " in route " + route + " conflicts with existing wildcard *" + node.wildcardName);
+                    }
+                    node = node.wildcardChild;
+                }
+                position = end;
+            }
+            else {
+                let end: number = position;
+                while (end < route.length && route[end] !== ":" && route[end] !== "*") {
+                    end++;
+                }
+                node = Http3Router.insertStatic(node, route.substring(position, end));
+                position = end;
+            }
+        }
+
+        if (node.handlers === undefined) {
+            node.handlers = new Map<string, Http3RequestHandler>();
+        }
+        node.handlers.set(method.toUpperCase(), handler);
+    }
+
+    /**
+     * @param path request path, without query string
+     * @returns undefined if no route matches the path at all
+     */
+    public find(method: string, path: string): Http3RouteMatch | undefined {
+        const names: string[] = [];
+        const values: string[] = [];
+        const node: Http3RouteNode | undefined = Http3Router.match(this.root, path, 0, names, values);
+        if (node === undefined || node.handlers === undefined) {
+            return undefined;
+        }
+
+        const params: {[name: string]: string} = {};
+        for (let i = 0; i < names.length; i++) {
+            params[names[i]] = Http3Router.decode(values[i]);
+        }
+
+        let handler: Http3RequestHandler | undefined = node.handlers.get(method.toUpperCase());
+        if (handler === undefined) {
+            handler = node.handlers.get(ALL_METHODS);
+        }
+
+        return {
+            handler: handler,
+            params: params,
+            allowedMethods: Array.from(node.handlers.keys()),
+        };
+    }
+
+    // follows (and, where needed, splits) the static edges for the given string, returns the node it ends in
+    private static insertStatic(node: Http3RouteNode, path: string): Http3RouteNode {
+        while (path.length > 0) {
+            let child: Http3RouteNode | undefined = node.staticChildren.get(path[0]);
+            if (child === undefined) {
+                child = new Http3RouteNode(path);
+                node.staticChildren.set(path[0], child);
+                return child;
+            }
+
+            let common: number = 0;
+            const max: number = Math.min(child.prefix.length, path.length);
+            while (common < max && child.prefix[common] === path[common]) {
+                common++;
+            }
+
+            if (common < child.prefix.length) {
+                // path diverges halfway the edge: split it
+                const split: Http3RouteNode = new Http3RouteNode(child.prefix.substring(0, common));
+                child.prefix = child.prefix.substring(common);
+                split.staticChildren.set(child.prefix[0], child);
+                node.staticChildren.set(path[0], split);
+                child = split;
+            }
+
+            node = child;
+            path = path.substring(common);
+        }
+        return node;
+    }
+
+    // depth-first, trying static edges first, then parameters, then wildcards. Only backtracks if a more specific branch turns out to be a dead end
+    private static match(node: Http3RouteNode, path: string, position: number, names: string[], values: string[]): Http3RouteNode | undefined {
+        if (position === path.length) {
+            if (node.handlers !== undefined) {
+                return node;
+            }
+            // "/files/*path" also matches "/files/"
+            if (node.wildcardChild !== undefined && node.wildcardChild.handlers !== undefined) {
+                names.push(node.wildcardName!);
+                values.push("");
+                return node.wildcardChild;
+            }
+            return undefined;
+        }
+
+        const child: Http3RouteNode | undefined = node.staticChildren.get(path[position]);
+        if (child !== undefined && path.startsWith(child.prefix, position)) {
+            const result: Http3RouteNode | undefined = Http3Router.match(child, path, position + child.prefix.length, names, values);
+            if (result !== undefined) {
+                return result;
+            }
+        }
+
+        if (node.paramChild !== undefined) {
+            let end: number = path.indexOf("/", position);
+            if (end < 0) {
+                end = path.length;
+            }
+            if (end > position) {
+                names.push(node.paramName!);
+                values.push(path.substring(position, end));
+                const result: Http3RouteNode | undefined = Http3Router.match(node.paramChild, path, end, names, values);
+                if (result !== undefined) {
+                    return result;
+                }
+                names.pop();
+                values.pop();
+            }
+        }
+
+        if (node.wildcardChild !== undefined && node.wildcardChild.handlers !== undefined) {
+            names.push(node.wildcardName!);
+            values.push(path.substring(position));
+            return node.wildcardChild;
+        }
+
+        return undefined;
+    }
+
+    private static decode(value: string): string {
+        try {
+            return decodeURIComponent(value);
+        }
+        catch (e) {
+            // malformed escape sequence: hand it over as-is
+            return value;
+        }
+    }
+}
@@ -1,4 +1,7 @@
-import { Http3Response } from "../common/http3.response";
+import { Http3Response, Http3ResponseFrames } from "../common/http3.response";
+import { Http3FileSource } from "../common/http3.filesource";
+import { Http3StaticCache } from "../common/http3.staticcache";
+import { Http3Router, Http3RouteMatch, Http3RequestHandler, ALL_METHODS } from "./http3.router";
 import { Http3Request } from "../common/http3.request";
 import { Server as QuicServer } from "../../../quicker/server";
 import { QuickerEvent } from "../../../quicker/quicker.event";
@@ -6,7 +9,7 @@ import { Connection } from "../../../quicker/connection";
 import { QuicStream } from "../../../quicker/quic.stream";
 import { VerboseLogging } from "../../../utilities/logging/verbose.logging";
 import { readFileSync } from "fs";
-import { parseHttp3Message } from "../common/parsers/http3.message.parser";
+import { extname } from "path";
 import { StreamType } from "../../../quicker/stream";
 import { Http3UniStreamType } from "../common/frames/streamtypes/http3.unistreamtypeframe";
 import { Http3ReceivingControlStream, Http3EndpointType, Http3ControlStreamEvent } from "../common/http3.receivingcontrolstream";
@@ -16,14 +19,19 @@ import { Bignum } from "../../../types/bignum";
 import { Http3Error, Http3ErrorCode } from "../common/errors/http3.error";
 import { EndpointType } from "../../../types/endpoint.type";
 import { Http3FrameParser } from "../common/parsers/http3.frame.parser";
+import { Http3StreamFrameParser } from "../common/parsers/http3.streamframe.parser";
+import { Http3ResourceParser } from "../common/parsers/http3.resource.parser";
 import { Http3QPackEncoder } from "../common/qpack/http3.qpackencoder";
 import { Http3QPackDecoder } from "../common/qpack/http3.qpackdecoder";
 import { QlogWrapper } from "../../../utilities/logging/qlog.wrapper";
 import { Http3StreamState } from "../common/types/http3.streamstate";
 import { Http3DependencyTree } from "../common/prioritization/http3.deptree";
+import { Http3Scheduler } from "../common/prioritization/http3.scheduler";
 import { Http3BaseFrame, Http3FrameType } from "../common/frames/http3.baseframe";
-import { Http3PriorityFrame, Http3SettingsFrame } from "../common/frames";
-import { Http3PriorityScheme, Http3DynamicFifoScheme, Http3FIFOScheme, Http3RoundRobinScheme, Http3WeightedRoundRobinScheme, Http3ParallelPlusScheme, Http3SerialPlusScheme, Http3FirefoxScheme, Http3ClientSidedScheme, Http3PMeenanScheme, Http3PmeenanHtmlScheme, Http3SpeedyRRScheme } from "../common/prioritization/schemes/index"
+import { Http3PriorityFrame, Http3SettingsFrame, Http3HeaderFrame, Http3PriorityUpdateFrame, Http3PushPromiseFrame, Http3CancelPushFrame, Http3MaxPushIDFrame } from "../common/frames";
+import { Http3PushStreamTypeFrame } from "../common/frames/streamtypes/http3.pushstreamtypeframe";
+import { Http3Header } from "../common/qpack/types/http3.header";
+import { Http3PriorityScheme, Http3DynamicFifoScheme, Http3FIFOScheme, Http3RoundRobinScheme, Http3WeightedRoundRobinScheme, Http3ParallelPlusScheme, Http3SerialPlusScheme, Http3FirefoxScheme, Http3ClientSidedScheme, Http3PMeenanScheme, Http3PmeenanHtmlScheme, Http3SpeedyRRScheme, Http3ExtensiblePrioritiesScheme } from "../common/prioritization/schemes/index"
 import { Http3Setting } from "../common/frames/http3.settingsframe";
 import { Http3RequestMetadata } from "../client/http3.requestmetadata";
 import { Constants } from "../../../utilities/constants";
@@ -31,10 +39,17 @@ import { HttpHelper } from "../../http0.9/http.helper";
 import { QuicError } from "../../../utilities/errors/connection.error";
 import { ConnectionErrorCodes } from "../../../utilities/errors/quic.codes";
 
+// Indicates next expected frametype on a request stream (parseHttp3Message does the same for complete messages)
+enum Http3RequestStreamState {
+    HEADERS,
+    BODY_OR_TRAILERS,
+    ENDED,
+}
+
 class ClientState {
     private logger: QlogWrapper;
     private prioritiser: Http3PriorityScheme;
-    private scheduleTimer: NodeJS.Timer;
+    private scheduler: Http3Scheduler;
     private sendingControlStream: Http3SendingControlStream;
     private receivingControlStream?: Http3ReceivingControlStream;
     private lastUsedStreamID: Bignum;
@@ -42,7 +57,14 @@ class ClientState {
     private qpackDecoder: Http3QPackDecoder;
     private frameParser: Http3FrameParser;
 
-    public constructor(logger: QlogWrapper, sendingControlStream: Http3SendingControlStream, lastUsedStreamID: Bignum, qpackEncoder: Http3QPackEncoder, qpackDecoder: Http3QPackDecoder, frameParser: Http3FrameParser, receivingControlStream?: Http3ReceivingControlStream, scheme: string = "client") {
+    // Server push: nothing is pushed until the client allows it with MAX_PUSH_ID
+    private maxPushID?: Bignum;
+    private nextPushID: Bignum = new Bignum(0);
+    private pushStreams: Map<string, QuicStream> = new Map<string, QuicStream>(); // by push ID, until they're cancelled
+    // paths the client has requested or that have been pushed to it: these are never pushed (again)
+    private sentPaths: Set<string> = new Set<string>();
+
+    public constructor(connection: Connection, logger: QlogWrapper, sendingControlStream: Http3SendingControlStream, lastUsedStreamID: Bignum, qpackEncoder: Http3QPackEncoder, qpackDecoder: Http3QPackDecoder, frameParser: Http3FrameParser, receivingControlStream?: Http3ReceivingControlStream, scheme: string = "client") {
         // TODO make scheme easily swappable without changing actual server code
         this.logger = logger;
         this.prioritiser = this.stringToScheme(scheme, logger);
@@ -58,12 +80,8 @@ class ClientState {
         // Returns frames which are not needed for server-sided prioritization
         this.prioritiser.initialSetup();
 
-        // Schedule 1 chunk of 1000 bytes every 30ms
-        // TODO tweak numbers
-        // TODO Listen to congestion control events instead
-        this.scheduleTimer = setInterval(() => {
-            this.prioritiser.schedule();
-        }, 10);
+        // Response data is moved from the prioritiser to the streams whenever congestion control has room for it
+        this.scheduler = new Http3Scheduler(connection, this.prioritiser);
     }
 
     public getLogger(): QlogWrapper {
@@ -75,7 +93,7 @@ class ClientState {
     }
 
     public stopScheduler() {
-        clearInterval(this.scheduleTimer);
+        this.scheduler.stop();
     }
 
     public setReceivingControlStream(receivingControlStream: Http3ReceivingControlStream) {
@@ -110,6 +128,47 @@ class ClientState {
         return this.frameParser;
     }
 
+    public setMaxPushID(maxPushID: Bignum) {
+        if (this.maxPushID !== undefined && maxPushID.lessThan(this.maxPushID)) {
+            throw new Http3Error(Http3ErrorCode.HTTP_ID_ERROR, "Client lowered its MAX_PUSH_ID from " + this.maxPushID.toDecimalString() + " to " + maxPushID.toDecimalString());
+        }
+        this.maxPushID = maxPushID;
+    }
+
+    public canPush(): boolean {
+        return this.maxPushID !== undefined && this.nextPushID.lessThanOrEqual(this.maxPushID);
+    }
+
+    public reservePushID(): Bignum {
+        const pushID: Bignum = this.nextPushID;
+        this.nextPushID = this.nextPushID.add(1);
+        return pushID;
+    }
+
+    public isPushIDUsed(pushID: Bignum): boolean {
+        return pushID.lessThan(this.nextPushID);
+    }
+
+    public addPushStream(pushID: Bignum, pushStream: QuicStream) {
+        this.pushStreams.set(pushID.toString(), pushStream);
+    }
+
+    // Returns the stream of the push, undefined if it was cancelled before
+    public removePushStream(pushID: Bignum): QuicStream | undefined {
+        const pushStream: QuicStream | undefined = this.pushStreams.get(pushID.toString());
+        this.pushStreams.delete(pushID.toString());
+        return pushStream;
+    }
+
+    // Returns false if the path was already requested by or pushed to the client
+    public markPathSent(path: string): boolean {
+        if (this.sentPaths.has(path)) {
+            return false;
+        }
+        this.sentPaths.add(path);
+        return true;
+    }
+
     private stringToScheme(schemename: string, logger?: QlogWrapper): Http3PriorityScheme {
         switch(schemename) {
             case "rr":
@@ -132,6 +191,8 @@ class ClientState {
                 return new Http3PmeenanHtmlScheme(logger);
             case "spdyrr":
                 return new Http3SpeedyRRScheme(logger);
+            case "urgency":
+                return new Http3ExtensiblePrioritiesScheme(logger);
             case "client":
                 return new Http3ClientSidedScheme(logger);
             default:
@@ -163,14 +224,19 @@ export class Http3Server {
     private readonly quickerServer: QuicServer;
     private prioritizationSchemeName?: string;
 
-    // GET Paths that have a user function mapped to them
-    private handledGetPaths: { [path: string]: (req: Http3Request, res: Http3Response) => Promise<void>; } = {};
+    // Paths that have a user function mapped to them
+    private router: Http3Router = new Http3Router();
     // private staticDirs: string[] = [];
 
     private connectionStates: Map<string, ClientState|ClientState09> = new Map<string, ClientState|ClientState09>();
 
     private resourceList?: {[path: string]: Http3RequestMetadata};
 
+    private pushEnabled: boolean = false;
+
+    // shared by all connections: the same static files are typically requested over and over
+    private staticCache: Http3StaticCache;
+
     // Separate from connectionState as they are kept for 0RTT connections
     // private connectionSettings: Map<string, Http3Setting[]> = new Map<string, Http3Setting[]>();
     // Tracks for each connection if the 
@@ -192,6 +258,7 @@ export class Http3Server {
         }
         this.prioritizationSchemeName = prioritizationSchemeName;
         this.resourceList = resourceList;
+        this.staticCache = new Http3StaticCache((path: string) => Http3Response.extensionToMimetype(extname(path), path));
 
         this.quickerServer.on(QuickerEvent.NEW_STREAM, this.onNewStream);
         this.quickerServer.on(QuickerEvent.CONNECTION_CLOSE, this.closeConnection);
@@ -218,15 +285,48 @@ export class Http3Server {
     /**
      * Hooks up a user function that handles a given path for the GET method based on an Http3Request
      * The user's function fills the Http3Response which will be sent to clients requesting the given path
-     * @param path The url where the function will be available via the GET method
+     * GET requests for paths without a handler are answered with the matching file from the public dir
+     * @param path The url where the function will be available via the GET method. Can contain parameters, e.g., /users/:id or /files/*path (see Http3Router)
      * @param callback
      */
-    public get(path: string, callback: (req: Http3Request, res: Http3Response) => Promise<void>) {
-        this.handledGetPaths[path] = callback;
+    public get(path: string, callback: Http3RequestHandler) {
+        this.route("GET", path, callback);
+    }
+
+    public post(path: string, callback: Http3RequestHandler) {
+        this.route("POST", path, callback);
     }
 
-    // TODO Add post/put/delete
-    // TODO Method for server pushes
+    public put(path: string, callback: Http3RequestHandler) {
+        this.route("PUT", path, callback);
+    }
+
+    public delete(path: string, callback: Http3RequestHandler) {
+        this.route("DELETE", path, callback);
+    }
+
+    // handles every method for which no specific handler was added on this path
+    public all(path: string, callback: Http3RequestHandler) {
+        this.route(ALL_METHODS, path, callback);
+    }
+
+    /**
+     * Hooks up a user function for the given method and path
+     * The request body can be read with Http3Request:getBody() or streamed with Http3Request:onBody()
+     * The response can be filled in and sent when the handler's promise resolves (sendFile/sendBuffer), or streamed while the handler runs (write/end)
+     */
+    public route(method: string, path: string, callback: Http3RequestHandler) {
+        this.router.add(method, path, callback);
+    }
+
+    /**
+     * Pushes the critical subresources of the responses this server sends, to clients that allow it (MAX_PUSH_ID)
+     * With a resource list, the paths listed under push are pushed, or else its critical childrenStart resources
+     * Without one, the stylesheets and scripts an HTML file refers to are pushed along with it (only for files the static cache keeps in memory)
+     */
+    public setPushEnabled(enabled: boolean) {
+        this.pushEnabled = enabled;
+    }
 
     private async onNewConnection(connection: Connection) {
 
@@ -247,6 +347,7 @@ export class Http3Server {
             connection.getQlogger().onHTTPStreamStateChanged(qpackDecoderStream.getStreamId(), Http3StreamState.LOCALLY_OPENED, "QPACK_DECODE");
 
             this.connectionStates.set(connection.getSrcConnectionID().toString(), new ClientState(
+                connection,
                 connection.getQlogger(),
                 controlHttp3Stream,
                 controlQuicStream.getStreamId(),
@@ -312,6 +413,21 @@ export class Http3Server {
             h3State.getPrioritiser().handlePriorityFrame(frame, controlStream.getStreamID());
             VerboseLogging.info("HTTP/3: priority frame received on client-sided control stream. ControlStreamID: " + controlStream.getStreamID().toDecimalString());
         });
+
+        controlStream.on(Http3ControlStreamEvent.HTTP3_PRIORITY_UPDATE_FRAME, (frame: Http3PriorityUpdateFrame) => {
+            h3State.getPrioritiser().handlePriorityUpdate(frame.getRequestStreamID(), frame.getPriorityFieldValue());
+            VerboseLogging.info("HTTP/3: priority update \"" + frame.getPriorityFieldValue() + "\" received for request stream " + frame.getRequestStreamID().toDecimalString());
+        });
+
+        controlStream.on(Http3ControlStreamEvent.HTTP3_MAX_PUSH_ID, (frame: Http3MaxPushIDFrame) => {
+            h3State.setMaxPushID(frame.getMaxPushID());
+            VerboseLogging.info("HTTP/3: client allows pushes up to push ID " + frame.getMaxPushID().toDecimalString());
+        });
+
+        controlStream.on(Http3ControlStreamEvent.HTTP3_CANCEL_PUSH_FRAME, (frame: Http3CancelPushFrame) => {
+            this.cancelPush(h3State, frame.getPushID());
+            VerboseLogging.info("HTTP/3: client cancelled push " + frame.getPushID().toDecimalString());
+        });
     }
 
     private onNewStream(quicStream: QuicStream) {
@@ -337,30 +453,54 @@ export class Http3Server {
             //  Bidi -> Request stream
             //  Uni -> Control or push stream based on first frame
 
-            // TODO HTTP request data should be handled from the moment enough has been received, not just on stream end
             if (quicStream.isBidiStream()) {
                 // Handle as a request stream
-                let bufferedData: Buffer = Buffer.alloc(0);
-                let bufferedFrames: Http3BaseFrame[] = [];
+                // The request is dispatched as soon as its HEADERS frame is in, the body is passed on to the handler while it's still arriving (see Http3Request:onBody)
+                let requestState: Http3RequestStreamState = Http3RequestStreamState.HEADERS;
+                let req: Http3Request | undefined = undefined;
 
                 state.getPrioritiser().addStream(quicStream);
 
-                quicStream.on(QuickerEvent.STREAM_DATA_AVAILABLE, (data: Buffer) => {
-                    bufferedData = Buffer.concat([bufferedData, data]);
-                    const [frames, offset]: [Http3BaseFrame[], number] = state.getFrameParser().parse(bufferedData, quicStream.getStreamId());
-                    // TODO priority frame should only be used if no other priority frames have arrived on the control stream for this request stream
-                    if (frames.length > 0 && frames[0].getFrameType() === Http3FrameType.PRIORITY) {
-                        state.getPrioritiser().handlePriorityFrame(frames[0] as Http3PriorityFrame, quicStream.getStreamId());
-                        quicStream.getConnection().getQlogger().onHTTPFrame_Priority(frames[0] as Http3PriorityFrame, "RX");
-                        frames.splice(0, 1);
+                // request body data is handed to the request as it arrives, without waiting for (or buffering) complete DATA frames
+                const frameParser: Http3StreamFrameParser = new Http3StreamFrameParser(state.getFrameParser(), quicStream.getStreamId(), (frame: Http3BaseFrame) => {
+                    if (requestState === Http3RequestStreamState.HEADERS && frame.getFrameType() === Http3FrameType.PRIORITY) {
+                        // TODO priority frame should only be used if no other priority frames have arrived on the control stream for this request stream
+                        state.getPrioritiser().handlePriorityFrame(frame as Http3PriorityFrame, quicStream.getStreamId());
+                        quicStream.getConnection().getQlogger().onHTTPFrame_Priority(frame as Http3PriorityFrame, "RX");
+                    } else if (requestState === Http3RequestStreamState.HEADERS && frame.getFrameType() === Http3FrameType.HEADERS) {
+                        req = new Http3Request(quicStream.getStreamId(), state.getQPackEncoder(), (frame as Http3HeaderFrame).getHeaders());
+                        requestState = Http3RequestStreamState.BODY_OR_TRAILERS;
+                        this.handleRequest(quicStream, req);
+                    } else if (requestState === Http3RequestStreamState.BODY_OR_TRAILERS && frame.getFrameType() === Http3FrameType.HEADERS) {
+                        // (Optional) trailing headers. The handler is already running, so it only sees these if it looks after the body has ended
+                        for (const header of (frame as Http3HeaderFrame).getHeaders()) {
+                            req!.setHeader(header.name, header.value);
+                        }
+                        requestState = Http3RequestStreamState.ENDED;
+                    } else {
+                        throw new Http3Error(Http3ErrorCode.HTTP3_UNEXPECTED_FRAME, "Encountered invalid frame on request stream " + quicStream.getStreamId().toDecimalString() + ". Frame was of type: " + frame.getFrameType());
+                    }
+                }, (data: Buffer) => {
+                    if (requestState !== Http3RequestStreamState.BODY_OR_TRAILERS) {
+                        throw new Http3Error(Http3ErrorCode.HTTP3_UNEXPECTED_FRAME, "Encountered DATA outside of the request body on request stream " + quicStream.getStreamId().toDecimalString());
                     }
-                    bufferedFrames = bufferedFrames.concat(frames);
-                    bufferedData = bufferedData.slice(offset);
+                    req!.addBodyData(data);
+                });
+
+                quicStream.on(QuickerEvent.STREAM_DATA_AVAILABLE, (data: Buffer) => {
+                    frameParser.parse(data);
                 });
 
                 quicStream.on(QuickerEvent.STREAM_END, () => {
-                    this.handleRequest(quicStream, bufferedFrames);
                     quicStream.removeAllListeners();
+                    frameParser.end();
+                    if (req === undefined) {
+                        VerboseLogging.info("Request stream " + quicStream.getStreamId().toDecimalString() + " ended before a HEADERS frame was received");
+                        state.getPrioritiser().finishStream(quicStream.getStreamId());
+                        return;
+                    }
+                    requestState = Http3RequestStreamState.ENDED;
+                    req.endBody();
                 });
             } else if (quicStream.isUniStream()) {
                 let streamType: Http3UniStreamType | undefined = undefined;
@@ -440,10 +580,10 @@ export class Http3Server {
     /**
      * Handles http requests
      * @param quicStream The stream on which to send a response
-     * @param bufferedFrames a buffer containing a full HTTP/3 message
-     * An Http/3 request is derived from this buffer and will be passed to user functions for the path specified in the request
+     * @param req The request, as soon as its headers are known. The body might still be arriving (see Http3Request:isBodyComplete)
+     * The request is passed to the user function for the path specified in the request
      */
-    private handleRequest(quicStream: QuicStream, bufferedFrames: Http3BaseFrame[]) {
+    private handleRequest(quicStream: QuicStream, req: Http3Request) {
         const connectionID: string = quicStream.getConnection().getSrcConnectionID().toString();
         let state: ClientState | ClientState09 | undefined = this.connectionStates.get(connectionID);
         const logger: QlogWrapper = quicStream.getConnection().getQlogger();
@@ -457,49 +597,245 @@ export class Http3Server {
         const encoder: Http3QPackEncoder = state.getQPackEncoder();
         const decoder: Http3QPackDecoder = state.getQPackDecoder();
 
-        let req: Http3Request = parseHttp3Message(bufferedFrames).toRequest(quicStream.getStreamId(), encoder);
         let res: Http3Response = new Http3Response([], quicStream.getStreamId(), encoder, decoder);
         const requestPath: string | undefined = req.getHeaderValue(":path");
+        const path: string | undefined = req.getPath();
         const method: string | undefined = req.getHeaderValue(":method");
 
         if (requestPath !== undefined && method !== undefined && method === "GET") {
             logger.onHTTPGet(requestPath, quicStream.getStreamId(), "RX");
         }
 
-        if (requestPath === undefined || method === undefined) {
+        if (requestPath === undefined || path === undefined || method === undefined) {
             VerboseLogging.info("Received HTTP/3 request with no path and/or method");
             state.getPrioritiser().finishStream(quicStream.getStreamId());
+            return;
+        }
+
+        const prioritiser: Http3PriorityScheme = state.getPrioritiser();
+        const streamID: Bignum = quicStream.getStreamId();
+        const h3State: ClientState = state;
+        h3State.markPathSent(requestPath);
+        let metadata: Http3RequestMetadata = this.resourceList === undefined ? {mimeType: this.getMimeType(res, requestPath)} : this.resourceList[requestPath];
+        const priority: string | undefined = req.getHeaderValue("priority");
+        if (priority !== undefined) {
+            // copy: resource list entries are shared by all connections
+            metadata = {...metadata, priority: priority};
+        }
+        prioritiser.applyScheme(streamID, metadata);
+
+        // anything the handler write()s goes to the prioritiser immediately, it's sent along with the other streams' data as the scheme sees fit
+        res.attach((data: Buffer | Buffer[]) => {
+            prioritiser.addData(streamID, data);
+        }, () => {
+            prioritiser.finishStream(streamID);
+        });
+
+        let handled: Promise<void>;
+        const route: Http3RouteMatch | undefined = this.router.find(method, path);
+        if (route !== undefined && route.handler !== undefined) {
+            req.setParams(route.params);
+            VerboseLogging.info("Request " + method + " " + path + " was handled by the server. Responding to HTTP/3 Request.");
+            // handlers are async: the (possibly long) wait for one of them never holds up any other stream
+            try {
+                handled = route.handler(req, res);
+            } catch (error) {
+                handled = Promise.reject(error);
+            }
+        } else if (route !== undefined) {
+            VerboseLogging.info("Requested path '" + path + "' has no handler for method " + method + ", allowed: " + route.allowedMethods.join(", "));
+            res.setStatus(405);
+            res.setHeaderValue("allow", route.allowedMethods.join(", "));
+            res.end();
+            handled = Promise.resolve();
+        } else if (method === "GET") {
+            VerboseLogging.info("Requested path '" + requestPath + "' has no specific handler. Trying to respond with requested file...");
+            res.sendFile(requestPath);
+            handled = Promise.resolve();
         } else {
-            let methodHandled: boolean = false;
-            // TODO implement other methods
-            switch(method) {
-                case "GET":
-                    methodHandled = true;
-                    if (this.handledGetPaths[requestPath] !== undefined) {
-                        // Call user function to fill response
-                        this.handledGetPaths[requestPath](req, res);
-                        VerboseLogging.info("Request was handled by the server. Responding to HTTP/3 Request.");
-                    } else {
-                        VerboseLogging.info("Requested path '" + requestPath + "' has no specific handler. Trying to respond with requested file...");
-                        res.sendFile(requestPath);
-                    }
-                    break;
-                default:
-                    break;
+            VerboseLogging.warn("Received HTTP/3 request with method " + method + " for " + path + ". There is no handler for this.");
+            res.setStatus(404);
+            res.end();
+            handled = Promise.resolve();
+        }
+
+        // files are opened asynchronously and then read while they're being sent, so the event loop never blocks on them
+        let body: Buffer[] | Http3FileSource | undefined = undefined;
+        handled.then(() => {
+            if (res.isStreaming()) {
+                // handler used write(): everything has been sent already
+                if (!res.isEnded()) {
+                    res.end();
+                }
+                return;
+            }
+            if (!res.isReady()) {
+                // handler only set a status and/or headers (e.g., 204)
+                res.end();
+                return;
             }
+            return res.getFrames(this.staticCache, req).then((frames: Http3ResponseFrames) => {
+                body = frames.body;
+                const pushPromises: Buffer[] = frames.body === undefined ? [] : this.pushResources(h3State, quicStream, req, requestPath, frames.resources);
+                this.queueResponse(prioritiser, streamID, frames, pushPromises);
+            });
+        }).catch((error: Error) => {
+            // e.g., the handler failed, or the connection was closed in the meantime and the stream is no longer in the prioritiser
+            VerboseLogging.error("Http3Server:handleRequest : could not respond on stream " + streamID.toDecimalString() + " : " + error.message);
+            if (body instanceof Http3FileSource) {
+                body.close();
+            }
+            try {
+                // if nothing has been sent yet (and the handler didn't pick a file or buffer), the client at least gets to know what happened
+                let ended: boolean = false;
+                if (!res.isStreaming() && body === undefined) {
+                    res.setStatus(500);
+                    ended = res.end();
+                }
+                if (!ended) {
+                    prioritiser.finishStream(streamID);
+                }
+            } catch (finishError) {
+                // nothing left to finish
+            }
+        });
+    }
 
-            if (methodHandled) {
-                // Respond and close stream
-                const metadata: Http3RequestMetadata = this.resourceList === undefined ? {mimeType: res.getMimeType(requestPath)} : this.resourceList[requestPath];
-                state.getPrioritiser().applyScheme(quicStream.getStreamId(), metadata);
-                state.getPrioritiser().addData(quicStream.getStreamId(), res.toBuffer());
-                state.getPrioritiser().finishStream(quicStream.getStreamId());
+    /**
+     * Hands a response to the prioritiser, which sends it on the stream as it sees fit
+     * @param pushPromises encoded PUSH_PROMISE frames, sent between the headers and the body
+     */
+    private queueResponse(prioritiser: Http3PriorityScheme, streamID: Bignum, frames: Http3ResponseFrames, pushPromises: Buffer[] = []) {
+        prioritiser.addData(streamID, frames.headers);
+        if (pushPromises.length > 0) {
+            prioritiser.addData(streamID, pushPromises);
+        }
+        if (frames.body === undefined) {
+            prioritiser.finishStream(streamID); // 304 Not Modified
+        } else if (frames.body instanceof Http3FileSource) {
+            prioritiser.addDataSource(streamID, frames.body); // finishes the stream when the whole file has been read
+        } else {
+            prioritiser.addData(streamID, frames.body);
+            prioritiser.finishStream(streamID);
+        }
+    }
+
+    /**
+     * Promises the subresources of a response that the client doesn't have yet, and starts pushing them (see setPushEnabled)
+     * @param resources the subresources of the response, as found by the static cache
+     * @returns the encoded PUSH_PROMISE frames, which have to go out on the request stream before the body: the client has to know about them before it finds the resources itself
+     */
+    private pushResources(state: ClientState, requestStream: QuicStream, req: Http3Request, requestPath: string, resources?: string[]): Buffer[] {
+        const pushPromises: Buffer[] = [];
+        const authority: string | undefined = req.getHeaderValue(":authority");
+        if (!this.pushEnabled || authority === undefined) {
+            return pushPromises;
+        }
+
+        for (const path of this.getPushCandidates(requestPath, resources)) {
+            if (!state.canPush() || pushPromises.length >= Constants.HTTP3_MAX_PUSHES_PER_RESPONSE) {
+                break;
+            }
+            if (!state.markPathSent(path)) {
+                continue;
             }
-            else {
-                // Close stream
-                VerboseLogging.warn("Received HTTP/3 request with method " + method + ". This method is currently not handled.");
-                state.getPrioritiser().finishStream(quicStream.getStreamId());
+            const pushID: Bignum = state.reservePushID();
+            const headers: Http3Header[] = [
+                { name: ":method", value: "GET" },
+                { name: ":scheme", value: "https" },
+                { name: ":authority", value: authority },
+                { name: ":path", value: path },
+            ];
+            pushPromises.push(new Http3PushPromiseFrame(pushID, headers, requestStream.getStreamId(), state.getQPackEncoder()).toBuffer());
+            this.push(state, requestStream.getConnection(), pushID, path);
+            VerboseLogging.info("Http3Server:pushResources : pushing " + path + " along with " + requestPath + ", push ID " + pushID.toDecimalString());
+        }
+        return pushPromises;
+    }
+
+    private getPushCandidates(requestPath: string, resources?: string[]): string[] {
+        if (this.resourceList !== undefined) {
+            const resourceList: {[path: string]: Http3RequestMetadata} = this.resourceList;
+            const metadata: Http3RequestMetadata | undefined = resourceList[requestPath];
+            if (metadata === undefined) {
+                return [];
             }
+            if (metadata.push !== undefined) {
+                return metadata.push;
+            }
+            // critical resources the client would discover while this one is still coming in
+            return (metadata.childrenStart || []).filter((child: string) => {
+                return resourceList[child] !== undefined && resourceList[child].isCritical === true;
+            });
+        }
+        if (resources === undefined) {
+            return [];
+        }
+        // stylesheets and scripts block rendering: those are worth the bandwidth, images are left to the client
+        return resources.map((resource: string) => Http3ResourceParser.resolvePath(requestPath, resource)).filter((resource: string) => {
+            try {
+                const mimeType: string = Http3Response.extensionToMimetype(extname(resource), resource);
+                return mimeType === "text/css" || mimeType === "application/javascript";
+            } catch (e) {
+                return false;
+            }
+        });
+    }
+
+    // Opens a push stream and sends the file on it like any other response: the prioritiser schedules it along with the request streams
+    private push(state: ClientState, connection: Connection, pushID: Bignum, path: string) {
+        const pushStream: QuicStream = this.quickerServer.createStream(connection, StreamType.ServerUni);
+        const streamID: Bignum = pushStream.getStreamId();
+        const prioritiser: Http3PriorityScheme = state.getPrioritiser();
+        connection.getQlogger().onHTTPStreamStateChanged(streamID, Http3StreamState.LOCALLY_OPENED, "PUSH");
+        state.addPushStream(pushID, pushStream);
+
+        const res: Http3Response = new Http3Response([], streamID, state.getQPackEncoder(), state.getQPackDecoder());
+        res.sendFile(path);
+        const metadata: Http3RequestMetadata | undefined = this.resourceList === undefined ? undefined : this.resourceList[path];
+        prioritiser.addStream(pushStream);
+        prioritiser.applyScheme(streamID, metadata !== undefined ? metadata : {mimeType: this.getMimeType(res, path)});
+        prioritiser.addData(streamID, new Http3PushStreamTypeFrame(pushID).toBuffer());
+
+        let body: Buffer[] | Http3FileSource | undefined = undefined;
+        res.getFrames(this.staticCache).then((frames: Http3ResponseFrames) => {
+            body = frames.body;
+            this.queueResponse(prioritiser, streamID, frames);
+        }).catch((error: Error) => {
+            // e.g., the push was cancelled or the connection was closed in the meantime, so the stream is no longer in the prioritiser
+            VerboseLogging.error("Http3Server:push : could not push " + path + " on stream " + streamID.toDecimalString() + " : " + error.message);
+            if (body instanceof Http3FileSource) {
+                body.close();
+            }
+            try {
+                prioritiser.finishStream(streamID);
+            } catch (finishError) {
+                // nothing left to finish
+            }
+        });
+    }
+
+    // The client doesn't want the pushed response (e.g., it has it cached already): stop sending it
+    // QuicStream has no way to reset a stream, so the push stream is ended early instead and the client ignores what it got of it
+    private cancelPush(state: ClientState, pushID: Bignum) {
+        if (!state.isPushIDUsed(pushID)) {
+            throw new Http3Error(Http3ErrorCode.HTTP_ID_ERROR, "Client cancelled push " + pushID.toDecimalString() + ", which was never promised");
+        }
+        const pushStream: QuicStream | undefined = state.removePushStream(pushID);
+        if (pushStream === undefined) {
+            return;
+        }
+        state.getPrioritiser().removeRequestStream(pushStream.getStreamId());
+        pushStream.end();
+        pushStream.getConnection().requestSendPackets();
+    }
+
+    // only used as a hint for the prioritisation scheme, so paths we can't derive a type from (e.g., routes with parameters) just get "unknown"
+    private getMimeType(res: Http3Response, requestPath: string): string {
+        try {
+            return res.getMimeType(requestPath);
+        } catch (e) {
+            return "unknown";
         }
     }
 
@@ -0,0 +1,71 @@
+import { Http3ExtensiblePrioritiesScheme } from "../common/prioritization/schemes/http3.extensibleprioritiesscheme";
+import { Http3PriorityParameters, parsePriorityFieldValue } from "../common/prioritization/http3.priorityparameters";
+import { QuicStream } from "../../../quicker/quic.stream";
+import { Bignum } from "../../../types/bignum";
+
+export class TestHttp3ExtensiblePriorities {
+    public static execute(): boolean {
+        let testCount = 0;
+
+        const tests: Array<[string, () => boolean]> = [
+            ["priority field values", () => this.testFieldValues()],
+            ["PRIORITY_UPDATE resets missing parameters", () => this.testUpdateDefaults()],
+        ];
+
+        for (const [name, test] of tests) {
+            if (test() === true) {
+                console.info("HTTP/3 extensible priorities test (" + name + ") succeeded");
+            } else {
+                console.error("HTTP/3 extensible priorities test (" + name + ") failed");
+                console.error("Failed after " + testCount + " tests");
+                return false;
+            }
+            ++testCount;
+        }
+
+        console.info("All " + testCount + " HTTP/3 extensible priorities tests succeeded");
+
+        return true;
+    }
+
+    private static equals(parameters: Http3PriorityParameters | undefined, urgency: number, incremental: boolean): boolean {
+        return parameters !== undefined && parameters.urgency === urgency && parameters.incremental === incremental;
+    }
+
+    private static testFieldValues(): boolean {
+        return this.equals(parsePriorityFieldValue(""), 3, false) &&
+               this.equals(parsePriorityFieldValue("u=5, i"), 5, true) &&
+               this.equals(parsePriorityFieldValue("i=?1;x=y, u=0"), 0, true) &&
+               this.equals(parsePriorityFieldValue("u=1, i=?0"), 1, false) &&
+               // invalid values and unknown members are ignored
+               this.equals(parsePriorityFieldValue("u=8, i=1, foo=bar"), 3, false);
+    }
+
+    // the scheme only asks the stream for its connection once data is added, which doesn't happen here
+    private static createStream(streamID: number): QuicStream {
+        return <QuicStream><any>{ getStreamId: () => new Bignum(streamID) };
+    }
+
+    private static testUpdateDefaults(): boolean {
+        const scheme: Http3ExtensiblePrioritiesScheme = new Http3ExtensiblePrioritiesScheme();
+
+        // update for a request that's already in
+        const streamID: Bignum = new Bignum(0);
+        scheme.addStream(this.createStream(0));
+        scheme.applyScheme(streamID, { mimeType: "text/html", priority: "u=5, i" });
+        const initial: boolean = this.equals(scheme.getPriorityParameters(streamID), 5, true);
+        scheme.handlePriorityUpdate(streamID, "u=2");
+        const updated: boolean = this.equals(scheme.getPriorityParameters(streamID), 2, false);
+        scheme.handlePriorityUpdate(streamID, "i");
+        const incremental: boolean = this.equals(scheme.getPriorityParameters(streamID), 3, true);
+
+        // update that arrives before its request: replaces the header instead of being merged with it
+        const earlyID: Bignum = new Bignum(4);
+        scheme.handlePriorityUpdate(earlyID, "u=1");
+        scheme.addStream(this.createStream(4));
+        scheme.applyScheme(earlyID, { mimeType: "text/html", priority: "u=6, i" });
+        const early: boolean = this.equals(scheme.getPriorityParameters(earlyID), 1, false);
+
+        return initial && updated && incremental && early;
+    }
+}
@@ -0,0 +1,143 @@
+import { Http3Router, Http3RouteMatch, Http3RequestHandler, ALL_METHODS } from "../server/http3.router";
+import { Http3Request } from "../common/http3.request";
+import { Http3Response } from "../common/http3.response";
+
+export class TestHttp3Router {
+    public static execute(): boolean {
+        let testCount = 0;
+
+        const tests: Array<[string, () => boolean]> = [
+            ["static vs parameter vs wildcard precedence", () => this.testPrecedence()],
+            ["shared prefixes", () => this.testSharedPrefixes()],
+            ["trailing slashes", () => this.testTrailingSlashes()],
+            ["method mismatch", () => this.testMethodMismatch()],
+        ];
+
+        for (const [name, test] of tests) {
+            if (test() === true) {
+                console.info("HTTP/3 router test (" + name + ") succeeded");
+            } else {
+                console.error("HTTP/3 router test (" + name + ") failed");
+                console.error("Failed after " + testCount + " tests");
+                return false;
+            }
+            ++testCount;
+        }
+
+        console.info("All " + testCount + " HTTP/3 router tests succeeded");
+
+        return true;
+    }
+
+    // every handler is a different function, so a match can be checked on identity
+    private static createHandler(): Http3RequestHandler {
+        return (req: Http3Request, res: Http3Response) => Promise.resolve();
+    }
+
+    private static matches(router: Http3Router, method: string, path: string, handler: Http3RequestHandler, params: {[name: string]: string} = {}): boolean {
+        const match: Http3RouteMatch | undefined = router.find(method, path);
+        if (match === undefined || match.handler !== handler) {
+            console.error("TestHttp3Router : " + method + " " + path + " did not match the expected route");
+            return false;
+        }
+        if (JSON.stringify(match.params) !== JSON.stringify(params)) {
+            console.error("TestHttp3Router : " + method + " " + path + " has parameters " + JSON.stringify(match.params) + ", expected " + JSON.stringify(params));
+            return false;
+        }
+        return true;
+    }
+
+    private static testPrecedence(): boolean {
+        const router: Http3Router = new Http3Router();
+        const me: Http3RequestHandler = this.createHandler();
+        const user: Http3RequestHandler = this.createHandler();
+        const settings: Http3RequestHandler = this.createHandler();
+        const rest: Http3RequestHandler = this.createHandler();
+        // registered least specific first: the order of registration shouldn't matter
+        router.add("GET", "/users/*rest", rest);
+        router.add("GET", "/users/:id", user);
+        router.add("GET", "/users/:id/settings", settings);
+        router.add("GET", "/users/me", me);
+
+        return this.matches(router, "GET", "/users/me", me) &&
+               this.matches(router, "GET", "/users/42", user, { id: "42" }) &&
+               // the static "me" branch has no "/settings": backtracks to the parameter
+               this.matches(router, "GET", "/users/me/settings", settings, { id: "me" }) &&
+               // nothing more specific matches
+               this.matches(router, "GET", "/users/42/posts/7", rest, { rest: "42/posts/7" }) &&
+               // parameters are URL decoded
+               this.matches(router, "GET", "/users/j%C3%A9r%C3%B4me", user, { id: "jérôme" });
+    }
+
+    private static testSharedPrefixes(): boolean {
+        const router: Http3Router = new Http3Router();
+        const css: Http3RequestHandler = this.createHandler();
+        const cat: Http3RequestHandler = this.createHandler();
+        const stat: Http3RequestHandler = this.createHandler();
+        const file: Http3RequestHandler = this.createHandler();
+        // every route splits the edge created by the previous ones
+        router.add("GET", "/static/css", css);
+        router.add("GET", "/static/cat", cat);
+        router.add("GET", "/stat", stat);
+        router.add("GET", "/static/:file", file);
+
+        return this.matches(router, "GET", "/static/css", css) &&
+               this.matches(router, "GET", "/static/cat", cat) &&
+               this.matches(router, "GET", "/stat", stat) &&
+               this.matches(router, "GET", "/static/c", file, { file: "c" }) &&
+               this.matches(router, "GET", "/static/cats", file, { file: "cats" }) &&
+               // halfway an edge, or at a split node without handlers of its own
+               router.find("GET", "/sta") === undefined &&
+               router.find("GET", "/static") === undefined &&
+               router.find("GET", "/static/") === undefined;
+    }
+
+    private static testTrailingSlashes(): boolean {
+        const router: Http3Router = new Http3Router();
+        const docs: Http3RequestHandler = this.createHandler();
+        const docsIndex: Http3RequestHandler = this.createHandler();
+        const files: Http3RequestHandler = this.createHandler();
+        const item: Http3RequestHandler = this.createHandler();
+        router.add("GET", "/docs", docs);
+        router.add("GET", "/docs/", docsIndex);
+        router.add("GET", "/files/*path", files);
+        router.add("GET", "/items/:id", item);
+
+        // a trailing slash is a different route, not normalized away
+        return this.matches(router, "GET", "/docs", docs) &&
+               this.matches(router, "GET", "/docs/", docsIndex) &&
+               // a wildcard also matches an empty rest
+               this.matches(router, "GET", "/files/", files, { path: "" }) &&
+               this.matches(router, "GET", "/files/a/b/", files, { path: "a/b/" }) &&
+               router.find("GET", "/files") === undefined &&
+               // a parameter never matches an empty segment, and it stops at a slash
+               router.find("GET", "/items/") === undefined &&
+               router.find("GET", "/items/5/") === undefined;
+    }
+
+    // Http3Server answers 405 with an allow header when the path is known but the method isn't (match without handler)
+    private static testMethodMismatch(): boolean {
+        const router: Http3Router = new Http3Router();
+        const get: Http3RequestHandler = this.createHandler();
+        const post: Http3RequestHandler = this.createHandler();
+        const any: Http3RequestHandler = this.createHandler();
+        router.add("GET", "/items", get);
+        router.add("post", "/items", post);
+        router.add(ALL_METHODS, "/echo", any);
+
+        const mismatch: Http3RouteMatch | undefined = router.find("DELETE", "/items");
+        const mismatchOk: boolean = mismatch !== undefined && mismatch.handler === undefined &&
+                                    JSON.stringify(mismatch.allowedMethods.sort()) === JSON.stringify(["GET", "POST"]);
+        if (!mismatchOk) {
+            console.error("TestHttp3Router : DELETE /items should be a match without handler, allowing GET and POST : " + JSON.stringify(mismatch));
+        }
+
+        return mismatchOk &&
+               // methods are case insensitive
+               this.matches(router, "get", "/items", get) &&
+               this.matches(router, "POST", "/items", post) &&
+               this.matches(router, "PUT", "/echo", any) &&
+               // unknown paths are no match at all (-> the server tries to serve a file or answers 404)
+               router.find("GET", "/unknown") === undefined;
+    }
+}
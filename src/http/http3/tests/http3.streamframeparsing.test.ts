@@ -0,0 +1,98 @@
+import { Http3BaseFrame, Http3FrameType } from "../common/frames/http3.baseframe";
+import { Http3FrameParser } from "../common/parsers/http3.frame.parser";
+import { Http3StreamFrameParser } from "../common/parsers/http3.streamframe.parser";
+import { Http3DataFrame, Http3CancelPushFrame } from "../common/frames";
+import { VLIE } from "../../../types/vlie";
+import { Bignum } from "../../../types/bignum";
+
+export class TestHttp3StreamFrameparser {
+    public static execute(): boolean {
+        let testCount = 0;
+
+        // Frames split at every possible position (including inside the type and length fields)
+        if (this.testSplitFrames() === true) {
+            console.info("HTTP/3 stream frame parsing test (split frames) succeeded")
+        } else {
+            console.error("HTTP/3 stream frame parsing test (split frames) failed");
+            console.error("Failed after " + testCount + " tests");
+            return false;
+        }
+        ++testCount;
+
+        // DATA payloads are handed out as they arrive, in order with the other frames
+        if (this.testDataPayloadHandler() === true) {
+            console.info("HTTP/3 stream frame parsing test (DATA payload handler) succeeded")
+        } else {
+            console.error("HTTP/3 stream frame parsing test (DATA payload handler) failed");
+            console.error("Failed after " + testCount + " tests");
+            return false;
+        }
+        ++testCount;
+
+        console.info("All " + testCount + " HTTP/3 stream frame parsing tests succeeded");
+
+        return true;
+    }
+
+    // DATA (with a payload that needs a 2 byte length), CANCEL_PUSH and an empty DATA frame
+    private static createStream(): Buffer {
+        const data: Buffer = Buffer.alloc(300, 0xab);
+        const cancelPush: Buffer = VLIE.encode(3503);
+        return Buffer.concat([
+            new Http3DataFrame(data).toBuffer(),
+            VLIE.encode(Http3FrameType.CANCEL_PUSH), VLIE.encode(cancelPush.byteLength), cancelPush,
+            new Http3DataFrame(Buffer.alloc(0)).toBuffer(),
+        ]);
+    }
+
+    private static testSplitFrames(): boolean {
+        const stream: Buffer = this.createStream();
+
+        for (let chunkSize = 1; chunkSize <= stream.byteLength; chunkSize++) {
+            const frames: Http3BaseFrame[] = [];
+            const parser: Http3StreamFrameParser = new Http3StreamFrameParser(new Http3FrameParser(), new Bignum(0), (frame: Http3BaseFrame) => {
+                frames.push(frame);
+            });
+            for (let offset = 0; offset < stream.byteLength; offset += chunkSize) {
+                parser.parse(stream.slice(offset, offset + chunkSize));
+            }
+
+            if (frames.length !== 3 || !parser.isAtFrameBoundary()) {
+                return false;
+            }
+            if (Buffer.concat(frames.map((frame) => frame.toBuffer())).compare(stream) !== 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    private static testDataPayloadHandler(): boolean {
+        const stream: Buffer = this.createStream();
+        const events: string[] = [];
+        const pieces: Buffer[] = [];
+        const parser: Http3StreamFrameParser = new Http3StreamFrameParser(new Http3FrameParser(), new Bignum(0), (frame: Http3BaseFrame) => {
+            events.push("frame " + frame.getFrameType());
+        }, (data: Buffer) => {
+            events.push("data");
+            pieces.push(data);
+        });
+
+        // first chunk ends halfway the DATA payload
+        parser.parse(stream.slice(0, 100));
+        if (pieces.length !== 1 || pieces[0].byteLength !== 97 || parser.isAtFrameBoundary()) {
+            return false;
+        }
+        parser.parse(stream.slice(100));
+
+        if (Buffer.concat(pieces).compare(Buffer.alloc(300, 0xab)) !== 0) {
+            return false;
+        }
+        // the DATA payload comes before the CANCEL_PUSH frame that follows it
+        if (events.join(",") !== "data,data,frame " + Http3FrameType.CANCEL_PUSH) {
+            return false;
+        }
+        return parser.isAtFrameBoundary();
+    }
+}
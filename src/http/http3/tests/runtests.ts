@@ -1,9 +1,30 @@
 import { TestHttp3Frameparser } from "./http3.frameparsing.test";
+import { TestHttp3StreamFrameparser } from "./http3.streamframeparsing.test";
 import { Http3StreamPriorityTester } from "./http3.streampriorities.test";
+import { TestHttp3Router } from "./http3.router.test";
+import { TestHttp3ExtensiblePriorities } from "./http3.extensiblepriorities.test";
 import { AssertionError } from "assert";
 
 let testCount = 0;
 
+if (TestHttp3StreamFrameparser.execute() === false) {
+    throw new AssertionError({
+        message: "HTTP/3 stream frame parser test failed"
+    });
+}
+++testCount;
+if (TestHttp3Router.execute() === false) {
+    throw new AssertionError({
+        message: "HTTP/3 router test failed"
+    });
+}
+++testCount;
+if (TestHttp3ExtensiblePriorities.execute() === false) {
+    throw new AssertionError({
+        message: "HTTP/3 extensible priorities test failed"
+    });
+}
+++testCount;
 if (TestHttp3Frameparser.execute() === false) {
     throw new AssertionError({
         message: "HTTP/3 frame parser test failed"
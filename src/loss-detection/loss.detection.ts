@@ -1,9 +1,10 @@
 import { BasePacket } from '../packet/base.packet';
 import { Bignum } from '../types/bignum';
 import { Alarm, AlarmEvent } from '../types/alarm';
+import { Time, TimeFormat } from '../types/time';
 import { AckFrame } from '../frame/ack';
 import { EventEmitter } from 'events';
-import { Connection, ConnectionEvent } from '../quicker/connection';
+import { Connection } from '../quicker/connection';
 import { VerboseLogging } from '../utilities/logging/verbose.logging';
 import { RTTMeasurement } from './rtt.measurement';
 
@@ -17,13 +18,19 @@ type SentPackets = { [key: string]: SentPacket };
 export interface SentPacket {
     // An object of type BasePacket
     packet: BasePacket,
-    // Milliseconds sinds epoch
+    // Milliseconds, from a monotonic clock (see LossDetection.now()), NOT since epoch
     time: number, // time at which this packet is sent locally, used to calculate RTT
-    // Does the packet contain frames that are retransmittable
+    // Does the packet contain frames that are retransmittable (= ack-eliciting)
     isRetransmittable: boolean
 };
 
 
+// Loss detection for a single packet number space, following the recovery draft:
+//  - a packet is lost if a packet sent PACKET_THRESHOLD packets later was acked (packet threshold)
+//  - or if it was sent TIME_THRESHOLD RTTs before a packet that was acked (time threshold)
+//  - if nothing is acked for a while, a Probe Timeout (PTO) fires, which sends probes but does NOT declare anything lost
+// There is a single timer per packet number space, used for both the time threshold and the PTO.
+// The PTO backs off exponentially (ptoCount) until an ACK is received.
 export class LossDetection extends EventEmitter {
 
     public DEBUGname = "";
@@ -32,157 +39,100 @@ export class LossDetection extends EventEmitter {
     // Constants of interest
     ///////////////////////////
 
-    // Maximum number of tail loss probes before an RTO fires.
-    private static readonly MAX_TLP: number = 2;
-    // Maximum reordering in packet number space before FACK style loss detection considers a packet lost.
-    private static readonly REORDERING_TRESHOLD: number = 2;
-    // Maximum reordering in time space before time based loss detection considers a packet lost. In fraction of an RTT.
-    private static readonly TIME_REORDERING_FRACTION: number = 1 / 8.0;
-    // Whether time based loss detection is in use. If false, uses FACK style loss detection.
-    private static readonly USING_TIME_LOSS_DETECTION: boolean = false;
-    // Minimum time in the future a tail loss probe alarm may be set for.
-    private static readonly MIN_TLP_TIMEOUT: number = 10;
-    // Minimum time in the future an RTO alarm may be set for.
-    private static readonly MIN_RTO_TIMEOUT: number = 200;
-    // The length of the peer’s delayed ack timer.
-    private static readonly DELAYED_ACK_TIMEOUT: number = 25;
-    // The default RTT used before an RTT sample is taken.
-    private static readonly DEFAULT_INITIAL_RTT: number = 100;
+    // Maximum reordering in packets before packet threshold loss detection considers a packet lost.
+    private static readonly PACKET_THRESHOLD: number = 3;
+    // Maximum reordering in time before time threshold loss detection considers a packet lost. Specified as an RTT multiplier.
+    private static readonly TIME_THRESHOLD: number = 9 / 8;
+    // Amount of packets we (re)send when the PTO fires, so a single loss of the probe doesn't cause another PTO
+    private static readonly MAX_PTO_PROBES: number = 2;
+    // Number of consecutive PTOs that need to pass without an ACK before we declare persistent congestion.
+    private static readonly PERSISTENT_CONGESTION_THRESHOLD: number = 3;
 
     ///////////////////////////
     // Variables of interest
     ///////////////////////////
 
-    // Multi-modal alarm used for loss detection.
+    // Alarm used for both time threshold loss detection and the probe timeout.
     private lossDetectionAlarm!: Alarm;
-    // The number of times the handshake packets have been retransmitted without receiving an ack.
-    private handshakeCount!: number;
-    // The number of times a tail loss probe has been sent without receiving an ack.
-    private tlpCount: number;
-    // The number of times an rto has been sent without receiving an ack.
-    private rtoCount: number;
-    // The last packet number sent prior to the first retransmission timeout.
-    private largestSentBeforeRto: Bignum;
-    // The time the most recent retransmittable packet was sent.
-    private timeOfLastSentRetransmittablePacket: number;
-    // The time the most recent packet containing handshake data was sent.
-    private timeOfLastSentHandshakePacket: number
-    // The packet number of the most recently sent packet.
-    private largestSentPacket: Bignum;
-    // The largest packet number acknowledged in an ACK frame.
-    private largestAckedPacket: Bignum;
-    // The largest packet number gap between the
-    // largest acked retransmittable packet and an unacknowledged
-    // retransmittable packet before it is declared lost.
-    private reorderingTreshold: Bignum;
-    // The reordering window as a fraction of max(smoothed_rtt, latest_rtt).
-    private timeReorderingTreshold: Bignum;
-    // The time at which the next packet will be considered lost based on early transmit or 
-    // exceeding the reordering window in time.
+    // The number of times a PTO has been sent without receiving an ack.
+    private ptoCount: number;
+    // The time the most recent ack-eliciting packet was sent.
+    private timeOfLastSentAckElicitingPacket: number;
+    // The largest packet number acknowledged in this packet number space so far.
+    private largestAckedPacket?: Bignum;
+    // The time at which the next packet will be considered lost based on exceeding the reordering window in time. 0 if not set.
     private lossTime: number;
-    // An association of packet numbers to information about them, including a number field indicating the packet number, 
-    // a time field indicating the time a packet was sent, a boolean indicating whether the packet is ack only, 
-    // and a bytes field indicating the packet’s size. sent_packets is ordered by packet number, 
+    // An association of packet numbers to information about them, including a number field indicating the packet number,
+    // a time field indicating the time a packet was sent, a boolean indicating whether the packet is ack only,
+    // and a bytes field indicating the packet’s size. sent_packets is ordered by packet number,
     // and packets remain in sent_packets until acknowledged or lost.
     private sentPackets: SentPackets;
 
-    private retransmittablePacketsOutstanding: number;
-    private handshakeOutstanding: number;
+    private ackElicitingPacketsOutstanding: number;
+    // The earliest lost ack-eliciting packet of the current loss period (see inPersistentCongestion). Kept across calls of detectLostPackets,
+    // since a loss period can span several rounds of the loss detection timer. Cleared when a packet sent after it is acked
+    private lossPeriodStart?: { time: number, packetNumber: Bignum };
 
     private rttMeasurer: RTTMeasurement;
+    // Only the 0/1-RTT space uses ack delays: Initial and Handshake packets are acked immediately by the peer
+    private isApplicationSpace: boolean;
 
-    public constructor(rttMeasurer: RTTMeasurement, connection: Connection) {
+    public constructor(rttMeasurer: RTTMeasurement, connection: Connection, isApplicationSpace: boolean = false) {
         super();
         this.rttMeasurer = rttMeasurer;
-        this.lossDetectionAlarm = new Alarm();
-        this.tlpCount = 0;
-        this.rtoCount = 0;
-        if (LossDetection.USING_TIME_LOSS_DETECTION) {
-            this.reorderingTreshold = Bignum.infinity();
-            this.timeReorderingTreshold = new Bignum(LossDetection.TIME_REORDERING_FRACTION);
-        } else {
-            this.reorderingTreshold = new Bignum(LossDetection.REORDERING_TRESHOLD);
-            this.timeReorderingTreshold = Bignum.infinity();
-        }
+        this.isApplicationSpace = isApplicationSpace;
+        this.lossDetectionAlarm = new Alarm(connection.getTimerWheel());
+        this.lossDetectionAlarm.on(AlarmEvent.TIMEOUT, (timePassed:number) => {
+            VerboseLogging.debug(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>////////////////////////////// LossDetection: alarm fired  //////////////////////////////// ");
+            VerboseLogging.info(this.DEBUGname + " LossDetection:setLossDetectionAlarm timeout alarm fired after " + timePassed + "ms");
+            this.onLossDetectionAlarm();
+            VerboseLogging.debug("<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<////////////////////////////// LossDetection: done handling alarm //////////////////////////////// ");
+        });
+
+        this.ptoCount = 0;
         this.lossTime = 0;
-        this.largestSentBeforeRto = new Bignum(0);
-        this.timeOfLastSentRetransmittablePacket = 0;
-        this.timeOfLastSentHandshakePacket = 0;
-        this.largestSentPacket = new Bignum(0);
-
-        this.largestAckedPacket = new Bignum(0);
-        this.retransmittablePacketsOutstanding = 0;
-        this.handshakeOutstanding = 0;
-        this.handshakeCount = 0;
+        this.timeOfLastSentAckElicitingPacket = 0;
+        this.largestAckedPacket = undefined;
+        this.ackElicitingPacketsOutstanding = 0;
         this.sentPackets = {};
-
-        //this.hookEvents(connection);
     }
 
-    /*
-    private hookEvents(connection: Connection) {
-        connection.on(ConnectionEvent.PACKET_SENT, (packet: BasePacket) => {
-            ROBIN: TODO: begin hier
-            // need to filter on crypto context here (or maybe in connection? but then we can't use events anymore?) FUCK ME FREDDY
-            this.onPacketSent(packet);
-        });
+    // sent times only need to be comparable to each other, so use a monotonic clock instead of the wall clock
+    private now(): number {
+        return Time.now().format(TimeFormat.MilliSeconds);
     }
-    */
 
     /**
      * After any packet is sent, be it a new transmission or a rebundled transmission, the following OnPacketSent function is called
      * @param basePacket The packet that is being sent. From this packet, the packetnumber and the number of bytes sent can be derived.
      */
     public onPacketSent(basePacket: BasePacket): void {
-        var currentTime = (new Date()).getTime();
-        var packetNumber = basePacket.getHeader().getPacketNumber()!.getValue();
-        this.largestSentPacket = packetNumber;
-
-        var sentPacket: SentPacket = {
-            packet: basePacket,
-            time: currentTime,
-            isRetransmittable: basePacket.isRetransmittable()
-        };
-        if (basePacket.isRetransmittable()) {
-            this.retransmittablePacketsOutstanding++;
-            this.timeOfLastSentRetransmittablePacket = currentTime;
-            if (basePacket.isHandshake()) {
-                this.handshakeOutstanding++;
-                this.timeOfLastSentHandshakePacket = currentTime;
-            }
-            // this.congestionControl.onPacketSent(basePacket.toBuffer().byteLength);
-            this.setLossDetectionAlarm();
-        }
+        let currentTime = this.now();
+        let packetNumber = basePacket.getHeader().getPacketNumber()!.getValue();
 
         let packet = this.sentPackets[packetNumber.toString('hex', 8)];
         if( packet !== undefined ){
             VerboseLogging.error(this.DEBUGname + " xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
             VerboseLogging.error(this.DEBUGname + " Packet was already in sentPackets buffer! cannot add twice, error!" + packetNumber.toNumber() + " -> packet type=" + packet.packet.getHeader().getPacketType());
             VerboseLogging.error(this.DEBUGname + " xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+            return;
         }
-        else{
-            VerboseLogging.debug(this.DEBUGname + " loss:onPacketSent : adding packet " +  packetNumber.toNumber() + ", is retransmittable=" + basePacket.isRetransmittable() );
 
-            this.sentPackets[packetNumber.toString('hex', 8)] = sentPacket;
-        }
-    }
+        VerboseLogging.debug(this.DEBUGname + " loss:onPacketSent : adding packet " +  packetNumber.toNumber() + ", is retransmittable=" + basePacket.isRetransmittable() );
 
-    private updateRtt(ackFrame: AckFrame) {
-
-        let largestAcknowledgedPacket = this.sentPackets[ackFrame.getLargestAcknowledged().toString('hex', 8)];
+        this.sentPackets[packetNumber.toString('hex', 8)] = {
+            packet: basePacket,
+            time: currentTime,
+            isRetransmittable: basePacket.isRetransmittable()
+        };
 
-         // check if we have not yet received an ACK for the largest acknowledge packet (then it would have been removed from this.sentPackets)
-         // we could receive a duplicate ACK here, for which we don't want to update our RTT estimates
-        if( largestAcknowledgedPacket !== undefined ){
-            this.rttMeasurer.updateRTT(ackFrame, largestAcknowledgedPacket);
+        if (basePacket.isRetransmittable()) {
+            this.ackElicitingPacketsOutstanding++;
+            this.timeOfLastSentAckElicitingPacket = currentTime;
+            this.setLossDetectionAlarm();
         }
-        else
-            VerboseLogging.info(this.DEBUGname + " LossDetection:updateRtt : not actually updating RTT because largestAcknowledgedPacket was previously acknowledged in a different ACK frame or it was an ACK-only frame");
-
     }
 
-
-
     /**
      * When an ack is received, it may acknowledge 0 or more packets.
      * @param ackFrame The ack frame that is received by this endpoint
@@ -190,74 +140,76 @@ export class LossDetection extends EventEmitter {
     public onAckReceived(ackFrame: AckFrame): void {
 
         VerboseLogging.info(this.DEBUGname + " Loss:onAckReceived AckFrame is acking " + ackFrame.determineAckedPacketNumbers().map((val, idx, arr) => val.toNumber()).join(","));
-        this.largestAckedPacket = ackFrame.getLargestAcknowledged();
-        /*
-        if (this.sentPackets[ackFrame.getLargestAcknowledged().toString('hex', 8)] !== undefined) {
-            this.latestRtt = new Bignum(new Date().getTime()).subtract(this.sentPackets[ackFrame.getLargestAcknowledged().toString('hex', 8)].time);
-            this.updateRtt(ackFrame);
+
+        let largestAcknowledged = ackFrame.getLargestAcknowledged();
+        if( this.largestAckedPacket === undefined || largestAcknowledged.greaterThan(this.largestAckedPacket) )
+            this.largestAckedPacket = largestAcknowledged;
+
+        let newlyAcked = this.determineNewlyAckedPackets(ackFrame);
+        if( newlyAcked.length === 0 ){
+            // duplicate or reordered ACK: nothing new learned, don't touch RTT, PTO backoff or loss state
+            VerboseLogging.info(this.DEBUGname + " LossDetection:onAckReceived : ACK frame did not acknowledge anything new, ignoring");
+            return;
         }
-        */
 
-        this.updateRtt(ackFrame);
+        // we only take an RTT sample if the largest acknowledged is newly acked (otherwise the delay the peer reports doesn't belong to it)
+        // and if at least one ack-eliciting packet was newly acked (the peer doesn't delay acks for ack-only packets in a predictable way)
+        let largestAcknowledgedPacket = this.sentPackets[largestAcknowledged.toString('hex', 8)];
+        let includesAckEliciting = newlyAcked.some( (sentPacket:SentPacket) => sentPacket.isRetransmittable );
+        if( largestAcknowledgedPacket !== undefined && includesAckEliciting ){
+            this.rttMeasurer.updateRTT(ackFrame, largestAcknowledgedPacket, this.now(), !this.isApplicationSpace);
+        }
+        else
+            VerboseLogging.info(this.DEBUGname + " LossDetection:onAckReceived : not updating RTT: largest acknowledged was acked before or nothing ack-eliciting was newly acked");
 
-        this.determineNewlyAckedPackets(ackFrame).forEach((sentPacket: BasePacket) => {
+        newlyAcked.forEach((sentPacket: SentPacket) => {
             this.onSentPacketAcked(sentPacket);
         });
-        this.detectLostPackets(ackFrame.getLargestAcknowledged());
+
+        this.detectLostPackets();
+
+        // the peer is clearly alive, so the next PTO starts from scratch
+        this.ptoCount = 0;
         this.setLossDetectionAlarm();
     }
 
     // reads the packet numbers from a received ack frame
     // those packet numbers correspond to packets we have sent, that are (probably) in this.sentPackets (could have been removed by receiving a previous ACK)
-    // this method transforms the packet numbers to actual packet object references of sent packets so they can be removed from the list
-    private determineNewlyAckedPackets(receivedAckFrame: AckFrame): BasePacket[] {
-        var ackedPackets: BasePacket[] = [];
-        var ackedPacketnumbers = receivedAckFrame.determineAckedPacketNumbers();
+    // this method transforms the packet numbers to actual references of sent packets so they can be removed from the list
+    private determineNewlyAckedPackets(receivedAckFrame: AckFrame): SentPacket[] {
+        let ackedPackets: SentPacket[] = [];
+        let ackedPacketnumbers = receivedAckFrame.determineAckedPacketNumbers();
 
         ackedPacketnumbers.forEach((packetnumber: Bignum) => {
-            //console.log("Loss:determineNewlyAckedPackets : looking for sent packet " + packetnumber.toNumber());
             let foundPacket = this.sentPackets[packetnumber.toString('hex', 8)];
             if (foundPacket !== undefined) {
-                //console.log("Loss:determineNewlyAckedPackets : Was found " + packetnumber.toNumber());
-                ackedPackets.push( foundPacket.packet );
+                ackedPackets.push( foundPacket );
             }
-            //else{
-                //console.log("Loss:determineNewlyAckedPackets : COULD NOT FIND, WAS ACKED EARLIER? " + packetnumber.toNumber() + " // " + Object.keys(this.sentPackets).length);
-                //console.log(this.sentPackets);
-            //}
-
         });
 
         return ackedPackets;
     }
 
     /**
-     * When a sent packet is ACKed by the receiver for the first time, onSentPacketAcked is called. 
-     * Note that a single received ACK frame may newly acknowledge several sent packets. 
-     * onSentPacketAcked must be called once for each of these newly acked packets. 
-     * OnPacketAcked takes one parameter, acked_packet_number returns a list of packet numbers that are detected as lost.
-     * If this is the first acknowledgement following RTO, check if the smallest newly acknowledged packet is one sent by the RTO,
-     * and if so, inform congestion control of a verified RTO, similar to F-RTO [RFC5682]
+     * When a sent packet is ACKed by the receiver for the first time, onSentPacketAcked is called.
+     * Note that a single received ACK frame may newly acknowledge several sent packets.
+     * onSentPacketAcked must be called once for each of these newly acked packets.
      * @param sentPacket A reference to one of the sentPackets that is being acked in a received ACK frame
      */
-    private onSentPacketAcked(sentPacket: BasePacket): void {
+    private onSentPacketAcked(sentPacket: SentPacket): void {
 
-        let ackedPacketNumber: Bignum = sentPacket.getHeader().getPacketNumber()!.getValue();
-        VerboseLogging.info(this.DEBUGname + " loss:onSentPacketAcked called for nr " + ackedPacketNumber.toNumber() + ", is retransmittable=" + this.sentPackets[ackedPacketNumber.toString('hex', 8)].packet.isRetransmittable());
+        let ackedPacketNumber: Bignum = sentPacket.packet.getHeader().getPacketNumber()!.getValue();
+        VerboseLogging.info(this.DEBUGname + " loss:onSentPacketAcked called for nr " + ackedPacketNumber.toNumber() + ", is retransmittable=" + sentPacket.isRetransmittable);
 
-        // TODO: move this to the end of this function? 
-        // inform ack handler so it can update internal state, congestion control so it can update bytes-in-flight etc.
-        // TODO: call ackhandler and congestion control directly instead of using events? makes code flow clearer 
-        this.emit(LossDetectionEvents.PACKET_ACKED, sentPacket);
-
-        if (this.rtoCount > 0 && ackedPacketNumber.greaterThan(this.largestSentBeforeRto)) {
-            this.emit(LossDetectionEvents.RETRANSMISSION_TIMEOUT_VERIFIED);
-        }
-        this.handshakeCount = 0;
-        this.tlpCount = 0;
-        this.rtoCount = 0;
-        
         this.removeFromSentPackets( ackedPacketNumber );
+
+        // something got through after the loss period started: the losses that follow are not part of the same period
+        if (this.lossPeriodStart !== undefined && ackedPacketNumber.greaterThan(this.lossPeriodStart.packetNumber))
+            this.lossPeriodStart = undefined;
+
+        // inform ack handler so it can update internal state, congestion control so it can update bytes-in-flight etc.
+        // TODO: call ackhandler and congestion control directly instead of using events? makes code flow clearer
+        this.emit(LossDetectionEvents.PACKET_ACKED, sentPacket.packet);
     }
 
     private removeFromSentPackets( packetNumber:Bignum ){
@@ -268,240 +220,197 @@ export class LossDetection extends EventEmitter {
             return;
         }
 
-        if (this.sentPackets[packetNumber.toString('hex', 8)].packet.isRetransmittable()) {
-            this.retransmittablePacketsOutstanding--;
-        }
-        if (this.sentPackets[packetNumber.toString('hex', 8)].packet.isHandshake()) {
-            this.handshakeOutstanding--;
+        if (packet.isRetransmittable) {
+            this.ackElicitingPacketsOutstanding--;
         }
         delete this.sentPackets[packetNumber.toString('hex', 8)];
     }
 
     public setLossDetectionAlarm(): void {
-        // Don't arm the alarm if there are no packets with retransmittable data in flight.
-        // TODO: replace retransmittablePacketsOutstanding by bytesInFlight
-        if (this.retransmittablePacketsOutstanding === 0) {
-            this.lossDetectionAlarm.reset();
-            VerboseLogging.info(this.DEBUGname + " LossDetection:setLossDetectionAlarm : no outstanding retransmittable packets, disabling loss alarm for now");
+        let now = this.now();
+
+        if (this.lossTime != 0) {
+            // Time threshold loss detection: some packet will be considered lost at lossTime
+            let alarmDuration = Math.max( 0, this.lossTime - now );
+            VerboseLogging.debug(this.DEBUGname + " LossDetection:alarm: time threshold " + alarmDuration);
+            this.lossDetectionAlarm.start(alarmDuration);
             return;
         }
-        else
-            VerboseLogging.debug(this.DEBUGname + " LossDetection:setLossDetectionAlarm : " + this.retransmittablePacketsOutstanding + " outstanding retransmittable packets" );
-        
-        var alarmDuration: number;
-        var time: number = this.timeOfLastSentRetransmittablePacket;
-        if (this.handshakeOutstanding !== 0) {
-            // Handshake retransmission alarm.
-            if (this.rttMeasurer.smoothedRtt == 0) {
-                alarmDuration = LossDetection.DEFAULT_INITIAL_RTT * 2;
-            } else {
-                alarmDuration = this.rttMeasurer.smoothedRtt * 2;
-            }
-            //alarmDuration = Bignum.max(alarmDuration.add(this.rttMeasurer.maxAckDelay), LossDetection.MIN_TLP_TIMEOUT);
-            alarmDuration = Math.max( alarmDuration + this.rttMeasurer.maxAckDelay, LossDetection.MIN_TLP_TIMEOUT);
-            var pw = Math.pow(2, this.handshakeCount);
-            alarmDuration = alarmDuration * pw;
-            time = this.timeOfLastSentHandshakePacket;
-            VerboseLogging.debug(this.DEBUGname + " LossDetection:alarm: handshake mode " + alarmDuration );
-        } else if (this.lossTime != 0) {
-            // Early retansmit timer or time loss detection
-            alarmDuration = this.lossTime - this.timeOfLastSentRetransmittablePacket;
-            VerboseLogging.debug(this.DEBUGname + " LossDetection:alarm: early retransmit " + alarmDuration);
-        } else {
-            // RTO or TLP alarm
-            //Calculate RTO duration
-            /*
-            alarmDuration = this.rttMeasurer.smoothedRtt.add(this.rttMeasurer.rttVar.multiply(4)).add(this.rttMeasurer.maxAckDelay);
-            alarmDuration = Bignum.max(alarmDuration, LossDetection.MIN_RTO_TIMEOUT);
-            alarmDuration = alarmDuration.multiply(Math.pow(2, this.rtoCount));
-            */
-           alarmDuration = this.rttMeasurer.smoothedRtt + this.rttMeasurer.rttVar * 4 + this.rttMeasurer.maxAckDelay;
-           alarmDuration = Math.max(alarmDuration, LossDetection.MIN_RTO_TIMEOUT);
-           alarmDuration = alarmDuration * Math.pow(2, this.rtoCount);
-
-            if (this.tlpCount < LossDetection.MAX_TLP) {
-                // Tail Loss Probe
-                /*
-                var tlpAlarmDuration = Bignum.max(this.rttMeasurer.maxAckDelay.add(this.rttMeasurer.smoothedRtt.multiply(1.5)), LossDetection.MIN_TLP_TIMEOUT);
-                alarmDuration = Bignum.min(tlpAlarmDuration, alarmDuration);
-                */
-                let tlpDuration = Math.max( this.rttMeasurer.maxAckDelay + this.rttMeasurer.smoothedRtt * 1.5, LossDetection.MIN_TLP_TIMEOUT);
-                alarmDuration = Math.min( tlpDuration, alarmDuration );
-                VerboseLogging.debug(this.DEBUGname + " LossDetection:alarm: TLP " + alarmDuration);
-            }
-            else
-                VerboseLogging.debug(this.DEBUGname + " LossDetection:alarm: RTO " + alarmDuration);
-        }
 
-        if (!this.lossDetectionAlarm.isRunning()) {
-            this.lossDetectionAlarm.on(AlarmEvent.TIMEOUT, (timePassed:number) => {
-                VerboseLogging.debug(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>////////////////////////////// LossDetection: alarm fired  //////////////////////////////// ");
-                VerboseLogging.info(this.DEBUGname + " LossDetection:setLossDetectionAlarm timeout alarm fired after " + timePassed + "ms");
-                this.lossDetectionAlarm.reset();
-                this.onLossDetectionAlarm();
-                VerboseLogging.debug("<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<////////////////////////////// LossDetection: done handling alarm //////////////////////////////// ");
-            });
-            this.lossDetectionAlarm.start(alarmDuration);
+        // Don't arm the alarm if there are no packets with ack-eliciting data in flight.
+        if (this.ackElicitingPacketsOutstanding === 0) {
+            this.lossDetectionAlarm.reset();
+            VerboseLogging.info(this.DEBUGname + " LossDetection:setLossDetectionAlarm : no outstanding ack-eliciting packets, disabling loss alarm for now");
+            return;
         }
+
+        // PTO, with exponential backoff
+        let ptoDuration = this.rttMeasurer.getProbeTimeout( this.isApplicationSpace ) * Math.pow(2, this.ptoCount);
+        let alarmDuration = Math.max( 0, this.timeOfLastSentAckElicitingPacket + ptoDuration - now );
+        VerboseLogging.debug(this.DEBUGname + " LossDetection:alarm: PTO " + alarmDuration + " (pto count " + this.ptoCount + ", " + this.ackElicitingPacketsOutstanding + " outstanding ack-eliciting packets)");
+
+        // always re-arm: an ACK or a new ack-eliciting packet moves the deadline (re-arming is O(1) on the timer wheel)
+        this.lossDetectionAlarm.start(alarmDuration);
     }
 
     /**
-     * QUIC uses one loss recovery alarm, which when set, can be in one of several modes. 
-     * When the alarm fires, the mode determines the action to be performed.
+     * QUIC uses one loss recovery alarm per packet number space, which is either a time threshold alarm or a PTO.
      */
     public onLossDetectionAlarm(): void {
-        if (this.handshakeOutstanding > 0) {
-            VerboseLogging.info(this.DEBUGname + " LossDetection:onLossDetectionAlarm Handshake");
-            // Handshake retransmission alarm.
-            this.retransmitAllUnackedHandshakeData();
-            this.handshakeCount++;
-        } else if (this.lossTime != 0) {
-            // Early retransmit or Time Loss Detection
-            VerboseLogging.info(this.DEBUGname + " LossDetection:onLossDetectionAlarm Early Retransmit or time-based");
-            this.detectLostPackets(this.largestAckedPacket);
-        } else if (this.tlpCount < LossDetection.MAX_TLP) {
-            // Tail Loss Probe.
-            VerboseLogging.info(this.DEBUGname + " LossDetection:onLossDetectionAlarm TLP, sendOne");
-            this.sendOnePacket();
-            this.tlpCount++;
-        } else {
-            // RTO
-            VerboseLogging.info(this.DEBUGname + " LossDetection:onLossDetectionAlarm RTO, sendTwo");
-            if (this.rtoCount === 0) {
-                this.largestSentBeforeRto = this.largestSentPacket;
-            }
-            this.sendTwoPackets();
-            this.rtoCount++;
+        if (this.lossTime != 0) {
+            // Time threshold loss detection
+            VerboseLogging.info(this.DEBUGname + " LossDetection:onLossDetectionAlarm time threshold");
+            this.detectLostPackets();
+        }
+        else {
+            // PTO: the peer hasn't acked anything in a while: send probes to elicit an ACK
+            // Nothing is declared lost here: that only happens when an ACK arrives, so a spurious PTO doesn't collapse the congestion window
+            VerboseLogging.info(this.DEBUGname + " LossDetection:onLossDetectionAlarm PTO " + this.ptoCount);
+            this.sendProbePackets(LossDetection.MAX_PTO_PROBES);
+            this.ptoCount++;
         }
         this.setLossDetectionAlarm();
     }
 
-    private detectLostPackets(largestAcked: Bignum): void {
+    private detectLostPackets(): void {
         this.lossTime = 0;
-        var lostPackets: BasePacket[] = [];
-        let delayUntilLost:number = Number.MAX_VALUE;
-
-        if (LossDetection.USING_TIME_LOSS_DETECTION) {
-            //delayUntilLost = this.timeReorderingTreshold.add(1).multiply(Bignum.max(this.rttMeasurer.latestRtt, this.rttMeasurer.smoothedRtt));
-            delayUntilLost = (this.timeReorderingTreshold.toNumber() + 1) * Math.max(this.rttMeasurer.latestRtt, this.rttMeasurer.smoothedRtt);
-        } 
-        else if (largestAcked.equals(this.largestSentPacket)) {
-            // Early retransmit alarm
-            //delayUntilLost = Bignum.max(this.rttMeasurer.latestRtt, this.rttMeasurer.smoothedRtt).multiply(5 / 4);
-            delayUntilLost = Math.max( this.rttMeasurer.latestRtt, this.rttMeasurer.smoothedRtt ) * 1.25;
-        }
 
-        var lostPackets: BasePacket[] = this.determineLostPackets(delayUntilLost);
-        // Inform the congestion controller of lost packets and
-        // let it decide whether to retransmit immediately.
-        if (lostPackets.length > 0) {
-            this.emit(LossDetectionEvents.PACKETS_LOST, lostPackets);
-            lostPackets.forEach((packet: BasePacket) => {
-                var sentPacket = this.sentPackets[packet.getHeader().getPacketNumber()!.getValue().toString('hex', 8)];
-                if (sentPacket !== undefined && sentPacket.packet.isHandshake()) {
-                    this.handshakeOutstanding--;
-                }
-
-                this.retransmitPacket(packet); // TODO: maybe this should be handled in the CC, like it says before, but it wasn't being done, and other retransmit logic is on Connection, so do that for this case too
-            });
-        }
-    }
+        if( this.largestAckedPacket === undefined )
+            return;
 
-    private determineLostPackets(delayUntilLost: number): BasePacket[] {
-        var lostPackets: BasePacket[] = [];
+        let largestAcked:Bignum = this.largestAckedPacket;
+        let lostPackets: SentPacket[] = [];
+
+        // at least GRANULARITY, so we don't declare packets lost on sub-timer-resolution reordering
+        let lossDelay = Math.max( LossDetection.TIME_THRESHOLD * Math.max(this.rttMeasurer.latestRtt, this.rttMeasurer.smoothedRtt), RTTMeasurement.GRANULARITY );
+        let now = this.now();
+        // packets sent before this time are deemed lost
+        let lostSendTime = now - lossDelay;
 
         Object.keys(this.sentPackets).forEach((key: string) => {
-            var unackedPacketNumber = new Bignum(Buffer.from(key, 'hex'));
-            if (unackedPacketNumber.lessThan(this.largestAckedPacket)) {
-                var unacked = this.sentPackets[key];
-                let timeSinceSent:number = (new Date()).getTime() - unacked.time;
-                
-                var delta = this.largestAckedPacket.subtract(unackedPacketNumber);
-                if (timeSinceSent > delayUntilLost || delta.greaterThan(this.reorderingTreshold)) {
-                    //delete this.sentPackets[unacked.packet.getHeader().getPacketNumber().getValue().toString('hex', 8)];
-                    this.removeFromSentPackets(unacked.packet.getHeader().getPacketNumber()!.getValue());
-                    if (unacked.packet.isRetransmittable()) {
-                        lostPackets.push(unacked.packet);
-                    }
-                } else if (delta.greaterThan(this.reorderingTreshold)) {
-                    // TODO: FIXME: added this because we will retransmit this packet in detectLostPackets, but that's probably not the best thing! 
-                    this.removeFromSentPackets(unacked.packet.getHeader().getPacketNumber()!.getValue());
-                    lostPackets.push(unacked.packet);
-                } else if (this.lossTime == 0 && delayUntilLost != Number.MAX_VALUE) {
-                    //this.lossTime = (new Bignum((new Date()).getTime())).add(delayUntilLost).subtract(timeSinceSent);
-                    this.lossTime = (new Date()).getTime() + delayUntilLost - timeSinceSent;
-                }
+            let unacked = this.sentPackets[key];
+            let unackedPacketNumber = unacked.packet.getHeader().getPacketNumber()!.getValue();
+
+            if (unackedPacketNumber.greaterThan(largestAcked))
+                return;
+
+            if (unacked.time <= lostSendTime || largestAcked.subtract(unackedPacketNumber).greaterThanOrEqual(LossDetection.PACKET_THRESHOLD)) {
+                lostPackets.push(unacked);
+            }
+            else {
+                let packetLossTime = unacked.time + lossDelay;
+                if (this.lossTime == 0 || packetLossTime < this.lossTime)
+                    this.lossTime = packetLossTime;
             }
         });
 
-        return lostPackets;
-    }
+        if (lostPackets.length === 0)
+            return;
 
-    private sendOnePacket(): void {
-        this.sendPackets(1);
-    }
+        // remove first, because retransmitPacket can change the PacketNumber, and we wouldn't find it in our sentPackets array anymore
+        lostPackets.forEach((lost: SentPacket) => {
+            this.removeFromSentPackets(lost.packet.getHeader().getPacketNumber()!.getValue());
+        });
+
+        // Inform the congestion controller of lost packets (it ignores ack-only packets)
+        this.emit(LossDetectionEvents.PACKETS_LOST, lostPackets.map( (lost:SentPacket) => lost.packet ));
+
+        if (this.inPersistentCongestion(lostPackets)) {
+            VerboseLogging.warn(this.DEBUGname + " LossDetection:detectLostPackets : persistent congestion detected");
+            this.emit(LossDetectionEvents.PERSISTENT_CONGESTION);
+        }
 
-    private sendTwoPackets(): void {
-        this.sendPackets(2);
+        lostPackets.forEach((lost: SentPacket) => {
+            this.retransmitPacket(lost); // TODO: maybe this should be handled in the CC, but other retransmit logic is on Connection, so do that for this case too
+        });
     }
 
-    private sendPackets(amount: number) {
-        var sendCount = 0;
-        var i = 0;
-        var keys = Object.keys(this.sentPackets);
-        while (keys.length > i) {
-            if (this.sentPackets[keys[i]].packet.isRetransmittable()) {
-                
-                // remove first, because retransmitPacket can change the PacketNumber, and we wouldn't find it in our sentPackets array anymore
-                let packet = this.sentPackets[keys[i]];
-                this.removeFromSentPackets( this.sentPackets[keys[i]].packet.getHeader().getPacketNumber()!.getValue() );
-                this.retransmitPacket(packet);
-                //delete this.sentPackets[keys[i]];
-                
-                sendCount++;
-                if (sendCount === amount) {
-                    break;
-                }
-            }
-            i++;
+    // Persistent congestion: a contiguous range of ack-eliciting packets was lost, spanning more than a few PTOs
+    // This is what the old RTO did, but now only when we're sure, instead of whenever a timer fires
+    // lostPackets is in packet number order (sentPackets is, since packet numbers only go up and we insert in order)
+    // The range can start in an earlier call (lossPeriodStart): the losses of a single period are often found over several timer rounds
+    private inPersistentCongestion(lostPackets: SentPacket[]): boolean {
+        // before the first RTT sample, our PTO is just a guess: don't take drastic measures based on it
+        if (!this.rttMeasurer.hasRTTSample())
+            return false;
+
+        let persistentCongestionDuration = this.rttMeasurer.getProbeTimeout( true ) * LossDetection.PERSISTENT_CONGESTION_THRESHOLD;
+
+        let first: { time: number, packetNumber: Bignum } | undefined = this.lossPeriodStart;
+        let previousNumber: Bignum | undefined = undefined;
+        let congested = false;
+        for (let lost of lostPackets) {
+            let packetNumber = lost.packet.getHeader().getPacketNumber()!.getValue();
+
+            // a gap in packet numbers means something in between was acked (or is still in flight): start a new range
+            // (between calls, anything acked after the start has already cleared lossPeriodStart, see onSentPacketAcked)
+            if (previousNumber !== undefined && !packetNumber.equals(previousNumber.add(1)))
+                first = undefined;
+            previousNumber = packetNumber;
+
+            if (!lost.isRetransmittable)
+                continue;
+
+            if (first === undefined)
+                first = { time: lost.time, packetNumber: packetNumber };
+            else if (lost.time - first.time > persistentCongestionDuration)
+                congested = true;
         }
+
+        // the range that's still open at the end can be continued by the next call. Once declared, a period doesn't count again
+        this.lossPeriodStart = congested ? undefined : first;
+        return congested;
     }
 
-    private retransmitAllUnackedHandshakeData(): void {
-        Object.keys(this.sentPackets).forEach((key: string) => {
-            if (this.sentPackets[key].packet.isHandshake()) {
-                //delete this.sentPackets[key];
-                // remove first, because retransmitPacket can change the PacketNumber, and we wouldn't find it in our sentPackets array anymore
-                let packet = this.sentPackets[key];
-                this.removeFromSentPackets( this.sentPackets[key].packet.getHeader().getPacketNumber()!.getValue() );
-                this.retransmitPacket(packet);
+    // PTO probes: re-send the oldest outstanding ack-eliciting data
+    // The original packets are not considered lost: they just aren't tracked anymore, since we re-use the packet object with a new packet number
+    private sendProbePackets(amount: number) {
+        let probes: SentPacket[] = [];
+
+        let keys = Object.keys(this.sentPackets);
+        for (let i = 0; i < keys.length && probes.length < amount; ++i) {
+            if (this.sentPackets[keys[i]].isRetransmittable) {
+                probes.push( this.sentPackets[keys[i]] );
             }
+        }
+
+        if (probes.length === 0)
+            return;
+
+        // remove first, because retransmitPacket can change the PacketNumber, and we wouldn't find it in our sentPackets array anymore
+        probes.forEach((probe: SentPacket) => {
+            this.removeFromSentPackets( probe.packet.getHeader().getPacketNumber()!.getValue() );
         });
-    }
 
-    private retransmitPacket(packet: SentPacket):void;
-    private retransmitPacket(packet: BasePacket):void;
-    private retransmitPacket(packet:any):void {
-        let p:BasePacket;
-        if( packet instanceof BasePacket )
-            p = packet;
-        else
-            p = packet.packet;
+        // congestion control needs to stop counting the old incarnations as in flight, without treating them as a loss
+        this.emit(LossDetectionEvents.PACKETS_RETIRED, probes.map( (probe:SentPacket) => probe.packet ));
 
-        if (p.isRetransmittable()) {
-            this.emit(LossDetectionEvents.RETRANSMIT_PACKET, p);
+        probes.forEach((probe: SentPacket) => {
+            this.retransmitPacket(probe);
+        });
+    }
+
+    private retransmitPacket(packet: SentPacket):void {
+        if (packet.isRetransmittable) {
+            this.emit(LossDetectionEvents.RETRANSMIT_PACKET, packet.packet);
         }
     }
 
     public reset() {
         this.lossDetectionAlarm.reset();
         this.sentPackets = {};
+        this.ackElicitingPacketsOutstanding = 0;
+        this.largestAckedPacket = undefined;
+        this.lossTime = 0;
+        this.ptoCount = 0;
+        this.lossPeriodStart = undefined;
     }
 }
 
 export enum LossDetectionEvents {
-    RETRANSMISSION_TIMEOUT_VERIFIED = "ld-retransmission-timeout-verified",
+    PERSISTENT_CONGESTION = "ld-persistent-congestion",
     PACKETS_LOST = "ld-packets-lost",
+    PACKETS_RETIRED = "ld-packets-retired",
     PACKET_ACKED = "ld-packet-acked",
     RETRANSMIT_PACKET = "ld-retransmit-packet"
 }
@@ -75,7 +75,7 @@ export abstract class BaseEncryptedPacket extends BasePacket {
     public getFrameSizes(): number {
         var size  = 0;
         this.frames.forEach((frame: BaseFrame) => {
-            size += frame.toBuffer().byteLength;
+            size += frame.encodedLength();
         });
         return size;
     }
@@ -86,17 +86,22 @@ export abstract class BaseEncryptedPacket extends BasePacket {
 
     protected getFramesBuffer(connection: Connection, header: BaseHeader): Buffer {
         var frameSizes = this.getFrameSizes();
+        // header protection samples the payload starting 4 bytes after the packet number, so tiny payloads need some padding
+        var padding: PaddingFrame|undefined = undefined;
+        if (frameSizes < 4) {
+            VerboseLogging.error("Added padding to frame at offset: " + frameSizes);
+            padding = FrameFactory.createPaddingFrame(20);
+            frameSizes += padding.encodedLength();
+        }
+
+        // every frame is encoded exactly once, directly into the payload buffer
         var dataBuffer = Buffer.alloc(frameSizes);
         var offset = 0;
         this.frames.forEach((frame: BaseFrame) => {
-            frame.toBuffer().copy(dataBuffer, offset);
-            offset += frame.toBuffer().byteLength;
+            offset = frame.encodeInto(dataBuffer, offset);
         });
-        if (offset < 4) {
-            VerboseLogging.error("Added padding to frame at offset: " + offset);
-            let padding = FrameFactory.createPaddingFrame(20);
-            dataBuffer = Buffer.concat([dataBuffer, padding.toBuffer()]);
-            offset += padding.toBuffer().byteLength;
+        if (padding !== undefined) {
+            offset = padding.encodeInto(dataBuffer, offset);
             VerboseLogging.error("Bufferlength after padding: " + dataBuffer.byteLength + "\toffset: " + offset);
         }
         dataBuffer = this.getEncryptedData(connection, header, dataBuffer);
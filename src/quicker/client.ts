@@ -59,7 +59,7 @@ export class Client extends Endpoint {
                 family: family
             };
     
-            this.connection = new Connection(remoteInfo, EndpointType.Client, socket, ConnectionID.randomConnectionID(), this.options);
+            this.connection = new Connection(remoteInfo, EndpointType.Client, socket, ConnectionID.randomConnectionID(), this.timerWheel, this.options);
             this.connection.setSrcConnectionID(ConnectionID.randomConnectionID());
             this.setupConnectionEvents();
     
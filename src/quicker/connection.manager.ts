@@ -10,22 +10,25 @@ import { LongHeader, LongHeaderType } from '../packet/header/long.header';
 import { QuickerError } from '../utilities/errors/quicker.error';
 import { QuickerErrorCodes } from '../utilities/errors/quicker.codes';
 import { VerboseLogging } from '../utilities/logging/verbose.logging';
+import { TimerWheel } from '../types/timer.wheel';
 
 // only used at the server-side, since that manages multiple connections
 // at client-side, we expect the higher-level client to create and manage its connection(s) directly 
 export class ConnectionManager extends EventEmitter{
     private secureContext: SecureContext;
     private serverSockets: { [key: string]: Socket; } = {};
+    private timerWheel: TimerWheel;
     private options: any;
 
     private connections: { [key: string]: Connection; } = {};
     private mappedConnections: { [key: string]: string; } = {};
     private omittedConnections: { [key: string]: Connection; } = {};
 
-    public constructor(secureContext: SecureContext, serverSockets: { [key: string]: Socket; }, options: any) {
+    public constructor(secureContext: SecureContext, serverSockets: { [key: string]: Socket; }, timerWheel: TimerWheel, options: any) {
         super();
         this.secureContext = secureContext;
         this.serverSockets = serverSockets;
+        this.timerWheel = timerWheel;
         this.options = options;
     }
     
@@ -93,7 +96,7 @@ export class ConnectionManager extends EventEmitter{
         let peerSrcConnectionID = longHeader.getSrcConnectionID();
         let peerDestConnectionID = longHeader.getDestConnectionID();
 
-        let connection = new Connection(remoteInfo, EndpointType.Server, this.serverSockets[rinfo.family], peerDestConnectionID, this.options);
+        let connection = new Connection(remoteInfo, EndpointType.Server, this.serverSockets[rinfo.family], peerDestConnectionID, this.timerWheel, this.options);
 
         // src is from the viewpoint of the server here. We choose our own, so it is random
         // the client chooses a temporary src for us (Which is called "initialDestConnectionID"), which we ourselves overwrite here
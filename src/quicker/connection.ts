@@ -1,4 +1,5 @@
 import { Alarm, AlarmEvent } from '../types/alarm';
+import { TimerWheel } from '../types/timer.wheel';
 import { TransportParameterId } from '../crypto/transport.parameters';
 import { AEAD } from '../crypto/aead';
 import { QTLS, HandshakeState, QuicTLSEvents } from '../crypto/qtls';
@@ -37,6 +38,7 @@ import { RTTMeasurement } from '../loss-detection/rtt.measurement';
 import { QlogWrapper } from '../utilities/logging/qlog.wrapper';
 import { BaseHeader, HeaderType } from '../packet/header/base.header';
 import { LongHeaderType, LongHeader } from '../packet/header/long.header';
+import { ReceiveWindowBudget } from '../flow-control/receive.window.budget';
 
 export class Connection extends FlowControlledObject {
 
@@ -69,11 +71,14 @@ export class Connection extends FlowControlledObject {
     private localMaxStreamUniBlocked: boolean;
     private localMaxStreamBidiBlocked: boolean;
 
+    private timerWheel: TimerWheel;
     private idleTimeoutAlarm: Alarm;
     private transmissionAlarm: Alarm;
     private closePacket!: BaseEncryptedPacket;
     private closeSentCount: number;
     private retrySent: boolean;
+    private sendPacketsRequested: boolean = false; // a sendPackets() is scheduled for the next event loop iteration (see requestSendPackets)
+    private ackFrequencySequenceNumber: number = 0; // the peer ignores ACK_FREQUENCY frames with a sequence number it has already seen
 
     private qtls: QTLS;
     private aead: AEAD;
@@ -83,6 +88,7 @@ export class Connection extends FlowControlledObject {
     private contextHandshake!: CryptoContext;
     private context1RTT!:CryptoContext;
 
+    private rttMeasurement!: RTTMeasurement; // shared by the loss detection of all packet number spaces
     private congestionControl!: CongestionControl;
     private flowControl!: FlowControl;
     private streamManager!: StreamManager;
@@ -90,13 +96,16 @@ export class Connection extends FlowControlledObject {
 
     private qlogger!:QlogWrapper;
 
-    public constructor(remoteInfo: RemoteInformation, endpointType: EndpointType, socket: Socket, initialDestConnectionID: ConnectionID, options?: any, bufferSize: number = Constants.DEFAULT_MAX_DATA) {
-        super(bufferSize);
+    public constructor(remoteInfo: RemoteInformation, endpointType: EndpointType, socket: Socket, initialDestConnectionID: ConnectionID, timerWheel: TimerWheel, options?: any, bufferSize: number = Constants.MAX_CONNECTION_RECEIVE_WINDOW) {
+        super(bufferSize, Constants.DEFAULT_MAX_DATA);
+        this.setReceiveWindowBudget(ReceiveWindowBudget.GLOBAL);
         this.remoteInfo = remoteInfo;
         this.socket = socket;
         this.endpointType = endpointType;
-        this.idleTimeoutAlarm = new Alarm();
-        this.transmissionAlarm = new Alarm();
+        this.timerWheel = timerWheel;
+        this.idleTimeoutAlarm = new Alarm(timerWheel);
+        this.transmissionAlarm = new Alarm(timerWheel);
+        this.hookAlarmEvents();
         this.localMaxStreamUniBlocked = false;
         this.localMaxStreamBidiBlocked = false;
         this.closeSentCount = 0;
@@ -146,15 +155,16 @@ export class Connection extends FlowControlledObject {
     private initializeCryptoContexts(){
 
         let rttMeasurer = new RTTMeasurement(this);
+        this.rttMeasurement = rttMeasurer;
         let lossInit = new LossDetection(rttMeasurer, this);
         lossInit.DEBUGname = "Initial";
         let lossHandshake = new LossDetection(rttMeasurer, this);
         lossHandshake.DEBUGname = "Handshake";
-        let lossData = new LossDetection(rttMeasurer, this);
+        let lossData = new LossDetection(rttMeasurer, this, true); // only 0/1RTT ACKs can be delayed by the peer
         lossData.DEBUGname = "0/1RTT";
 
         let pnsData      = new PacketNumberSpace(); // 0-RTT and 1-RTT have different encryption levels, but they share a PNS
-        let ackData      = new AckHandler(this); // TODO: AckHandler should be coupled to PNSpace directly? make this more clear by adding it to that class instead maybe?
+        let ackData      = new AckHandler(this, true); // TODO: AckHandler should be coupled to PNSpace directly? make this more clear by adding it to that class instead maybe?
         this.contextInitial     = new CryptoContext( EncryptionLevel.INITIAL,   new PacketNumberSpace(), new AckHandler(this), lossInit );
         this.context0RTT        = new CryptoContext( EncryptionLevel.ZERO_RTT,  pnsData,                 ackData,              lossData );
         this.contextHandshake   = new CryptoContext( EncryptionLevel.HANDSHAKE, new PacketNumberSpace(), new AckHandler(this), lossHandshake );
@@ -169,7 +179,7 @@ export class Connection extends FlowControlledObject {
         this.handshakeHandler = new HandshakeHandler(this.qtls, this.aead, this.endpointType === EndpointType.Server);
         this.streamManager = new StreamManager(this.endpointType);
         this.flowControl = new FlowControl(this);
-        this.congestionControl = new CongestionControl(this, [this.contextInitial.getLossDetection(), this.contextHandshake.getLossDetection(), this.context1RTT.getLossDetection()] ); // 1RTT and 0RTT share loss detection, don't add twice!
+        this.congestionControl = new CongestionControl(this, this.flowControl, [this.contextInitial.getLossDetection(), this.contextHandshake.getLossDetection(), this.context1RTT.getLossDetection()] ); // 1RTT and 0RTT share loss detection, don't add twice!
 
         this.hookStreamManagerEvents();
         this.hookLossDetectionEvents();
@@ -182,6 +192,18 @@ export class Connection extends FlowControlledObject {
         this.handshakeHandler.registerCryptoStream( this.context1RTT.getCryptoStream() );
     }
 
+    // alarms keep their listeners across resets, so these only need to be attached once
+    private hookAlarmEvents() {
+        this.transmissionAlarm.on(AlarmEvent.TIMEOUT, () => {
+            this.sendPackets();
+        });
+        this.idleTimeoutAlarm.on(AlarmEvent.TIMEOUT, () => {
+            this.setState(ConnectionState.Draining);
+            this.closeRequested();
+            this.emit(ConnectionEvent.DRAINING);
+        });
+    }
+
     private hookHandshakeHandlerEvents() {
         this.handshakeHandler.on(HandshakeHandlerEvents.ClientHandshakeDone, () => {
             this.emit(ConnectionEvent.HANDSHAKE_DONE);
@@ -254,6 +276,9 @@ export class Connection extends FlowControlledObject {
                 //ctx.getAckHandler().onPacketAcked(basePacket);
                 
                 context.getAckHandler().onPacketAcked(basePacket); 
+                if (context === this.context1RTT) { // STREAM frames are only sent in 0-RTT and 1-RTT packets
+                    this.streamManager.onPacketAcked(<BaseEncryptedPacket>basePacket);
+                }
             });
         }
     }
@@ -265,10 +290,32 @@ export class Connection extends FlowControlledObject {
         this.qtls.on(QuicTLSEvents.REMOTE_TRANSPORTPARAM_AVAILABLE, (transportParams: TransportParameters) => {
             this.setRemoteTransportParameters(transportParams);
         });
+        this.qtls.on(QuicTLSEvents.HANDSHAKE_DONE, () => {
+            this.requestAckFrequency();
+        });
+    }
+
+    // delayed ACK extension: if the peer supports it, ask it to ACK less often than every 2 packets, which saves both sides a lot of small packets for bulk transfers
+    // we keep the peer's own max_ack_delay, so our PTO calculations stay valid
+    private requestAckFrequency() {
+        if (!Constants.ACK_FREQUENCY_ENABLED || !this.getRemoteTransportParameter(TransportParameterId.MIN_ACK_DELAY)) {
+            return;
+        }
+
+        let maxAckDelay = this.getRemoteTransportParameter(TransportParameterId.MAX_ACK_DELAY) * 1000; // frame uses MICROseconds
+        maxAckDelay = Math.max(maxAckDelay, this.getRemoteTransportParameter(TransportParameterId.MIN_ACK_DELAY));
+
+        VerboseLogging.info("Connection:requestAckFrequency : peer supports ACK_FREQUENCY, asking for an ACK every " + Constants.ACK_FREQUENCY_PACKET_TOLERANCE + " packets");
+        let frame = FrameFactory.createAckFrequencyFrame(new Bignum(this.ackFrequencySequenceNumber++), new Bignum(Constants.ACK_FREQUENCY_PACKET_TOLERANCE), new Bignum(maxAckDelay), false);
+        this.flowControl.queueControlFrame(frame);
+        this.requestSendPackets();
     }
 
     private hookStreamManagerEvents() {
         this.streamManager.on(StreamManagerEvents.INITIALIZED_STREAM, (stream: Stream) => {
+            // stream windows start out within the connection's window, only their growth takes up extra budget (released in StreamManager:deleteStream)
+            stream.setReceiveWindowBudget(ReceiveWindowBudget.GLOBAL, false);
+
             // for external users of the quicker library
             if (stream.isRemoteStream()) {
                 // Only emits the event if the stream was initiated by the peer
@@ -287,6 +334,8 @@ export class Connection extends FlowControlledObject {
             });
             stream.on(FlowControlledObjectEvents.DECREMENT_BUFFER_DATA_USED, (dataLength: number) => {
                 this.decrementBufferSizeUsed(dataLength);
+                // the window can only grow as far as there is buffer space, so this might allow a window update that was held back
+                this.streamManager.markReceiveStateChanged(stream);
             });
         });
     }
@@ -332,11 +381,23 @@ export class Connection extends FlowControlledObject {
     public setState(connectionState: ConnectionState) {
         this.state = connectionState;
 
+        // whatever way we're going down (local error, peer's CONNECTION_CLOSE, idle timeout), the peer can't make us buffer anything anymore
+        if( connectionState === ConnectionState.Closing || connectionState === ConnectionState.Draining || connectionState === ConnectionState.Closed ){
+            this.releaseReceiveWindows();
+        }
         if( connectionState == ConnectionState.Closed ){
             this.qlogger.close();
         }
     }
 
+    // gives the receive windows of the connection and all of its streams back to the global budget
+    private releaseReceiveWindows(): void {
+        this.streamManager.getStreams().forEach((stream: Stream) => {
+            stream.releaseReceiveWindow();
+        });
+        this.releaseReceiveWindow();
+    }
+
     public getEndpointType(): EndpointType {
         return this.endpointType;
     }
@@ -357,6 +418,14 @@ export class Connection extends FlowControlledObject {
         return this.streamManager;
     }
 
+    public getRTTMeasurement(): RTTMeasurement {
+        return this.rttMeasurement;
+    }
+
+    public getTimerWheel(): TimerWheel {
+        return this.timerWheel;
+    }
+
     public getLocalTransportParameter(type: TransportParameterId): any {
         return this.localTransportParameters.getTransportParameter(type);
     }
@@ -783,15 +852,58 @@ export class Connection extends FlowControlledObject {
 
 
         this.transmissionAlarm.reset();
-        var packets: BasePacket[] = this.flowControl.getPackets();
-        VerboseLogging.info("Connection:sendPackets : queueing " + packets.length + " packets on congestionControl");
-        this.congestionControl.queuePackets(packets);
+        // CongestionControl pulls the packets from FlowControl itself, as far as the congestion window allows
+        this.congestionControl.sendPackets();
     }
 
-    private startTransmissionAlarm(): void {
-        this.transmissionAlarm.on(AlarmEvent.TIMEOUT, () => {
+    /**
+     * For applications that write a lot of small pieces: instead of calling sendPackets() after every write, call this.
+     * All calls made during the current event loop iteration are coalesced into a single sendPackets() right after it.
+     */
+    public requestSendPackets(): void {
+        if (this.sendPacketsRequested) {
+            return;
+        }
+        this.sendPacketsRequested = true;
+        setImmediate(() => {
+            this.sendPacketsRequested = false;
             this.sendPackets();
         });
+    }
+
+    /**
+     * Called by CongestionControl right before it packetizes STREAM data, with the amount of bytes the congestion window has room for.
+     * Applications that keep their own send queue instead of writing everything to the streams up front (e.g., HTTP/3 prioritisation)
+     * listen for ConnectionEvent.SEND_OPPORTUNITY and write (about) the given amount of bytes in response, which are then sent right away.
+     */
+    public offerSendOpportunity(streamDataBudget: number): void {
+        // no more than the connection's flow control allows, and what's already waiting in the streams (and can be sent) goes first
+        let connectionCredit = Math.max(0, this.getSendAllowance().subtract(this.getRemoteOffset()).toNumber());
+        let room = Math.min(streamDataBudget, connectionCredit);
+        let bytes = room - this.getSendableDataSize(room);
+        if (bytes > 0) {
+            this.emit(ConnectionEvent.SEND_OPPORTUNITY, bytes);
+        }
+    }
+
+    // Buffered STREAM data that could be put in packets right now as far as the streams' flow control allows, counted up to the given limit
+    // Data that is held back by flow control doesn't count: otherwise a single blocked stream with a big buffer would hide the room the others have
+    // Only the active streams have something to send, and we stop counting at the limit, so this doesn't visit every stream on the connection
+    private getSendableDataSize(limit: number): number {
+        let size = 0;
+        for (let stream of this.streamManager.getActiveStreams()) {
+            if (size >= limit) {
+                break;
+            }
+            if (stream.isReceiveOnly() || this.flowControl.isRemoteStreamIdBlocked(stream)) {
+                continue;
+            }
+            size += stream.getSendableDataSize();
+        }
+        return Math.min(size, limit);
+    }
+
+    private startTransmissionAlarm(): void {
         this.transmissionAlarm.start(40);
     }
 
@@ -835,11 +947,12 @@ export class Connection extends FlowControlledObject {
     }
 
     public closeRequested() {
-        var alarm = new Alarm();
-        alarm.start(Constants.TEMPORARY_DRAINING_TIME);
+        var alarm = new Alarm(this.timerWheel);
         alarm.on(AlarmEvent.TIMEOUT, () => {
+            this.releaseReceiveWindows();
             this.emit(ConnectionEvent.CLOSE);
         });
+        alarm.start(Constants.TEMPORARY_DRAINING_TIME);
     }
 
     public checkConnectionState(): void {
@@ -889,11 +1002,6 @@ export class Connection extends FlowControlledObject {
 
     public startIdleAlarm(): void {
         var time = this.localTransportParameters === undefined ? Constants.DEFAULT_IDLE_TIMEOUT : this.getLocalTransportParameter(TransportParameterId.IDLE_TIMEOUT);
-        this.idleTimeoutAlarm.on(AlarmEvent.TIMEOUT, () => {
-            this.state = ConnectionState.Draining;
-            this.closeRequested();
-            this.emit(ConnectionEvent.DRAINING);
-        })
         this.idleTimeoutAlarm.start(time * 1000);
     }
 }
@@ -918,6 +1026,7 @@ export enum ConnectionEvent {
     DRAINING = "con-draining",
     CLOSE = "con-close",
     PACKET_SENT = "con-packet-sent",
+    SEND_OPPORTUNITY = "con-send-opportunity", // the congestion window has room for more STREAM data than is buffered, see offerSendOpportunity
 
     BufferedPacketReadyForDecryption = "buffered-packet-ready-for-decryption"
 }
@@ -13,6 +13,7 @@ import { EventEmitter } from "events";
 import { PacketParser } from '../utilities/parsers/packet.parser';
 import { PacketHandler } from '../utilities/handlers/packet.handler';
 import { VerboseLogging } from '../utilities/logging/verbose.logging';
+import { TimerWheel } from '../types/timer.wheel';
 
 
 export abstract class Endpoint extends EventEmitter {
@@ -25,8 +26,12 @@ export abstract class Endpoint extends EventEmitter {
     protected headerHandler: HeaderHandler;
     protected packetHandler: PacketHandler;
 
+    // all timers of all connections of this endpoint are driven by this single wheel (and thus a single NodeJS timer)
+    protected timerWheel: TimerWheel;
+
     protected constructor() {
         super();
+        this.timerWheel = new TimerWheel();
         this.headerParser = new HeaderParser();
         this.headerHandler = new HeaderHandler();
         this.packetParser = new PacketParser();
@@ -41,6 +46,10 @@ export abstract class Endpoint extends EventEmitter {
         return this.hostname;
     }
 
+    public getTimerWheel(): TimerWheel {
+        return this.timerWheel;
+    }
+
     protected handleError(connection: Connection, error: any): any {
         VerboseLogging.error("Endpoint:handleError : " + error.message + " -- " + JSON.stringify(error));
         VerboseLogging.error("Endpoint:handleError : " + JSON.stringify(error.stack.toString()));
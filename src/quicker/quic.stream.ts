@@ -4,6 +4,8 @@ import { Bignum } from "../types/bignum";
 import { Stream, StreamEvent, StreamType } from "./stream";
 import { FrameFactory } from '../utilities/factories/frame.factory';
 import { QuickerEvent } from './quicker.event';
+import { BufferQueue } from '../types/buffer.queue';
+import { Constants } from '../utilities/constants';
 
 export class QuicStream extends EventEmitter{
     
@@ -11,40 +13,215 @@ export class QuicStream extends EventEmitter{
     private stream: Stream;
     private connection: Connection;
 
-    public constructor(connection: Connection, stream: Stream) {
+    // Reading works like NodeJS readable streams:
+    // - by default (flowing), every chunk is emitted as a STREAM_DATA_AVAILABLE event as soon as it arrives in order
+    // - when paused, or once someone listens for STREAM_READABLE, data is kept here instead, until the application pulls it out with read() or resume()s
+    // Data that is kept here counts against the stream's receive window (see Stream:addUnconsumedData), so the peer can't make us buffer more than that
+    private flowing: boolean;
+    private readMode: boolean;
+    private readableData: BufferQueue;
+    private receiveEnded: boolean;
+    private endEmitted: boolean;
+    private windowUpdateScheduled: boolean;
+
+    // Writing works like NodeJS writable streams: write() returns false once highWaterMark bytes are waiting to be sent
+    // the application should then wait for STREAM_DRAIN before writing more
+    private highWaterMark: number;
+    private needDrain: boolean;
+    private drainScheduled: boolean;
+
+    public constructor(connection: Connection, stream: Stream, highWaterMark: number = Constants.DEFAULT_STREAM_HIGH_WATER_MARK) {
         super();
         this.stream = stream;
         this.connection = connection;
+        this.flowing = true;
+        this.readMode = false;
+        this.readableData = new BufferQueue();
+        this.receiveEnded = false;
+        this.endEmitted = false;
+        this.windowUpdateScheduled = false;
+        this.highWaterMark = highWaterMark;
+        this.needDrain = false;
+        this.drainScheduled = false;
         this.setupEvents(stream);
     }
 
     private setupEvents(stream: Stream): void {
+        this.on("newListener", (event: string) => {
+            if (event === QuickerEvent.STREAM_READABLE) {
+                this.readMode = true;
+                this.flowing = false;
+            }
+        });
+
         stream.on(StreamEvent.DATA, (data: Buffer) => {
-            if (this.encoding !== undefined) {
-                this.emit(QuickerEvent.STREAM_DATA_AVAILABLE, data.toString(this.encoding))
-            } else {
-                this.emit(QuickerEvent.STREAM_DATA_AVAILABLE, data);
+            if (this.flowing) {
+                this.emitData(data);
+                return;
+            }
+
+            let wasEmpty = this.readableData.isEmpty();
+            this.readableData.push(data);
+            this.stream.addUnconsumedData(data.byteLength);
+            // only signal when going from empty to non-empty: the application is expected to read() until it gets nothing back
+            if (this.readMode && wasEmpty) {
+                this.emit(QuickerEvent.STREAM_READABLE);
             }
         });
         stream.on(StreamEvent.END, () => {
-            this.emit(QuickerEvent.STREAM_END);
+            this.receiveEnded = true;
+            // when not flowing, the end is only signaled after the application has read everything
+            if (this.readableData.isEmpty()) {
+                this.emitEnd();
+            }
+        });
+        stream.on(StreamEvent.DATA_SENT, () => {
+            this.checkDrain();
         });
     }
+
+    /**
+     * Returns (at most) size bytes of the received data, or undefined if there is nothing to read right now
+     * Only useful when not flowing (i.e., when listening for QuickerEvent.STREAM_READABLE, or after pause()): otherwise data is handed out through STREAM_DATA_AVAILABLE events
+     */
+    public read(size?: number): Buffer | undefined {
+        if (this.readableData.isEmpty()) {
+            return undefined;
+        }
+
+        let data = this.readableData.consumeBuffer(size);
+        this.onDataConsumed(data.byteLength);
+
+        if (this.readableData.isEmpty() && this.receiveEnded) {
+            // don't emit from within read() itself, the caller is probably still processing what we just returned
+            setImmediate(() => {
+                this.emitEnd();
+            });
+        }
+        return data;
+    }
+
+    // amount of received bytes waiting to be read()
+    public getReadableLength(): number {
+        return this.readableData.getByteLength();
+    }
+
+    // stop emitting STREAM_DATA_AVAILABLE events: received data is kept until resume()
+    public pause(): void {
+        this.flowing = false;
+    }
+
+    public resume(): void {
+        if (this.readMode) {
+            // NodeJS also ignores this if there's a readable listener: data is only handed out through read()
+            return;
+        }
+        this.flowing = true;
+
+        // the application might pause() again from within a data handler
+        while (this.flowing && !this.readableData.isEmpty()) {
+            let data = this.readableData.consumeBuffer();
+            this.onDataConsumed(data.byteLength);
+            this.emitData(data);
+        }
+        if (this.flowing && this.receiveEnded) {
+            this.emitEnd();
+        }
+    }
+
+    public isPaused(): boolean {
+        return !this.flowing;
+    }
+
+    private emitData(data: Buffer): void {
+        if (this.encoding !== undefined) {
+            this.emit(QuickerEvent.STREAM_DATA_AVAILABLE, data.toString(this.encoding))
+        } else {
+            this.emit(QuickerEvent.STREAM_DATA_AVAILABLE, data);
+        }
+    }
+
+    private emitEnd(): void {
+        if (this.endEmitted) {
+            return;
+        }
+        this.endEmitted = true;
+        this.emit(QuickerEvent.STREAM_END);
+    }
+
+    private onDataConsumed(dataLength: number): void {
+        this.stream.consumeData(dataLength);
+
+        // the peer might have been waiting for us to read: let it know as soon as there's room again
+        // this is done asynchronously, so reading a lot of small chunks in a row only triggers a single send
+        if (!this.windowUpdateScheduled && this.stream.isPeerAlmostBlocked()) {
+            this.windowUpdateScheduled = true;
+            setImmediate(() => {
+                this.windowUpdateScheduled = false;
+                this.connection.sendPackets();
+            });
+        }
+    }
     
     public getStreamId():Bignum {
         return this.stream.getStreamID();
     }
 
-    public write(data: Buffer): void {
-        this.stream.addData(data);
+    /**
+     * Queues data for sending. This never drops data, but returns false if the amount of data waiting to be sent is above the high water mark. 
+     * The application should then stop writing until QuickerEvent.STREAM_DRAIN is emitted
+     */
+    // A list of Buffers is queued as-is (without concatenating them), e.g., an HTTP/3 frame header followed by its payload
+    // As with a single Buffer, they should not be modified afterwards: they're only copied when they're put in a packet
+    public write(data: Buffer | Buffer[]): boolean {
+        if (data instanceof Buffer) {
+            this.stream.addData(data);
+        } else {
+            for (let buffer of data) {
+                this.stream.addData(buffer);
+            }
+        }
+        return this.checkWritable();
     }
 
-    public end(data?: Buffer): void {
-        if (data !== undefined) {
-            this.stream.addData(data, true);
-        } else {
-            this.stream.setFinalSentOffset(this.stream.getRemoteOffset());
+    public end(data?: Buffer | Buffer[]): void {
+        // data that's still buffered will be sent before the FIN
+        if (data instanceof Array) {
+            for (let i = 0; i < data.length - 1; ++i) {
+                this.stream.addData(data[i]);
+            }
+            data = data.length > 0 ? data[data.length - 1] : undefined;
+        }
+        this.stream.addData(data !== undefined ? data : Buffer.alloc(0), true);
+    }
+
+    // amount of bytes waiting to be sent
+    public getWritableLength(): number {
+        return this.stream.getOutgoingDataSize();
+    }
+
+    private checkWritable(): boolean {
+        let writable = this.stream.getOutgoingDataSize() < this.highWaterMark;
+        if (!writable) {
+            this.needDrain = true;
         }
+        return writable;
+    }
+
+    private checkDrain(): void {
+        if (!this.needDrain || this.drainScheduled || this.stream.getOutgoingDataSize() >= this.highWaterMark) {
+            return;
+        }
+
+        // this is called while FlowControl is building packets: the application shouldn't start writing (and sending) from within that
+        this.drainScheduled = true;
+        setImmediate(() => {
+            this.drainScheduled = false;
+            if (this.needDrain && this.stream.getOutgoingDataSize() < this.highWaterMark) {
+                this.needDrain = false;
+                this.emit(QuickerEvent.STREAM_DRAIN);
+            }
+        });
     }
 
     // TODO: refactor this. Is needed now so we can access the connection from a stream handler (see main.ts) but that's dirty
@@ -11,4 +11,6 @@ export enum QuickerEvent {
     NEW_MESSAGE = "message",
     STREAM_DATA_AVAILABLE = "data",
     STREAM_END = "end",
+    STREAM_READABLE = "readable", // listening to this switches the QuicStream from emitting "data" events to read() mode
+    STREAM_DRAIN = "drain", // after QuicStream.write() returned false, the send buffer has gone below the high water mark again
 }
\ No newline at end of file
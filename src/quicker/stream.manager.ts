@@ -1,9 +1,12 @@
-import { Stream, StreamType } from "./stream";
+import { Stream, StreamType, StreamEvent } from "./stream";
 import { TransportParameters, TransportParameterId } from "../crypto/transport.parameters";
 import { Bignum } from "../types/bignum";
 import { EndpointType } from "../types/endpoint.type";
 import { EventEmitter } from "events";
 import { VerboseLogging } from "../utilities/logging/verbose.logging";
+import { BaseEncryptedPacket } from "../packet/base.encrypted.packet";
+import { BaseFrame, FrameType } from "../frame/base.frame";
+import { StreamFrame } from "../frame/stream";
 
 export class StreamFlowControlParameters {
     // Transport parameters control initial flow control settings per-stream type
@@ -40,23 +43,73 @@ export class StreamFlowControlParameters {
 
 export class StreamManager extends EventEmitter {
 
-    private streams: Stream[];
+    // keyed on stream ID (see getStreamKey). Maps keep insertion order, so iterating still goes over the streams in the order they were opened
+    // streams are added and removed a lot on busy connections (see retireStream), which is O(1) here
+    private streams: Map<string, Stream>;
     private endpointType: EndpointType;
 
+    // Streams that (might) have something to send, in the order they should get a turn
+    // Streams are added when data is queued on them or they get new flow control credit, and removed when FlowControl finds them drained or blocked
+    // This way, a send pass only has to look at the streams that are actually sending, instead of at every (mostly idle) stream on the connection
+    private activeStreams: Set<Stream>;
+
+    // Same idea for the receive side: streams whose receive window might need an update (MAX_STREAM_DATA), because the peer sent data or told us it's blocked,
+    // or the application read some data. FlowControl only looks at these instead of at every stream, and clears the set when it has (see FlowControl:getLocalFlowControlFrames)
+    private receiveStateChangedStreams: Set<Stream>;
+
+    // Streams are forgotten once they're done in both directions (see retireStream), so long-lived connections don't keep every stream they ever had
+    // We still need to know which IDs were used, so a late (retransmitted) frame for such a stream doesn't open it again
+    // Per stream type (index = StreamType): every ID below retiredBelow is retired. IDs retired out of order are kept in retiredIds until the gap before them closes
+    private retiredBelow: number[];
+    private retiredIds: Set<number>;
+    private retiredCount: number[];
+
     public flowControl!: StreamFlowControlParameters;
 
     public constructor(endpointType: EndpointType) {
         super();
         this.endpointType = endpointType;
-        this.streams = [];
+        this.streams = new Map<string, Stream>();
+        this.activeStreams = new Set<Stream>();
+        this.receiveStateChangedStreams = new Set<Stream>();
+        this.retiredBelow = [StreamType.ClientBidi, StreamType.ServerBidi, StreamType.ClientUni, StreamType.ServerUni];
+        this.retiredIds = new Set<number>();
+        this.retiredCount = [0, 0, 0, 0];
         
         this.flowControl = new StreamFlowControlParameters();
     }
     
-    public getStreams(): Stream[] {
+    public getStreams(): Map<string, Stream> {
         return this.streams;
     }
 
+    // JS Sets keep insertion order and allow deleting entries while iterating: FlowControl uses this to walk the streams and drop the ones that are done
+    public getActiveStreams(): Set<Stream> {
+        return this.activeStreams;
+    }
+
+    // no-op if there is nothing to send, so this can be called whenever something changed that might allow the stream to send again (e.g., new flow control credit)
+    public activateStream(stream: Stream): void {
+        if (stream.hasDataToSend()) {
+            this.activeStreams.add(stream);
+        }
+    }
+
+    public deactivateStream(stream: Stream): void {
+        this.activeStreams.delete(stream);
+    }
+
+    public getReceiveStateChangedStreams(): Set<Stream> {
+        return this.receiveStateChangedStreams;
+    }
+
+    // ignored for streams that were already retired: those don't need window updates anymore
+    public markReceiveStateChanged(stream: Stream): void {
+        if (this._getStream(stream.getStreamID()) === stream) {
+            this.receiveStateChangedStreams.add(stream);
+        }
+    }
+
     // flow control parameter changes are applied automatically for NEW streams only
     // if you want to change existing streams, do that manually by calling applyDefaultFlowControlLimits()
     public getFlowControlParameters():StreamFlowControlParameters { return this.flowControl; } 
@@ -69,6 +122,7 @@ export class StreamManager extends EventEmitter {
         return stream !== undefined;
     }
 
+    // NOTE: this opens the stream if we don't have it. Check isRetiredStream() first if the ID comes from the peer
     //public getStream(streamId: number): Stream;
     public getStream(streamId: Bignum): Stream;
     public getStream(streamId: any): Stream {
@@ -121,26 +175,88 @@ export class StreamManager extends EventEmitter {
                 stream.setSendAllowance( 0 ); // cannot send anything on a uni-stream the peer opened
             }
         }
+
+        // the stream might have been waiting for these limits to be able to send
+        this.activateStream(stream);
     }
 
     private _getStream(streamId: number): Stream | undefined;
     private _getStream(streamId: Bignum): Stream | undefined;
     private _getStream(streamId: any): Stream | undefined {
-        var res = undefined;
-        this.streams.forEach((stream: Stream) => {
-            if (stream.getStreamID().equals(streamId)) {
-                res = stream;
-            }
-        });
-        return res;
+        return this.streams.get( StreamManager.getStreamKey(streamId) );
+    }
+
+    private static getStreamKey(streamId: number): string;
+    private static getStreamKey(streamId: Bignum): string;
+    private static getStreamKey(streamId: any): string {
+        if (streamId instanceof Bignum) {
+            return streamId.toDecimalString();
+        }
+        return "" + streamId;
     }
 
     public addStream(stream: Stream): void {
         if (this._getStream(stream.getStreamID()) === undefined) {
-            this.streams.push(stream);
+            this.streams.set( StreamManager.getStreamKey(stream.getStreamID()), stream );
+
+            stream.on(StreamEvent.DATA_QUEUED, () => {
+                this.activateStream(stream);
+            });
+            stream.on(StreamEvent.CLOSED, () => {
+                this.retireStream(stream);
+            });
+            this.activateStream(stream);
         }
     }
 
+    // streams that finished sending can only be retired once the peer has seen our FIN (see Stream:onFinAcked)
+    public onPacketAcked(packet: BaseEncryptedPacket): void {
+        packet.getFrames().forEach((frame: BaseFrame) => {
+            if (frame.getType() < FrameType.STREAM || frame.getType() > FrameType.STREAM_MAX_NR) {
+                return;
+            }
+            let streamFrame = <StreamFrame>frame;
+            if (streamFrame.getFin()) {
+                let stream = this._getStream(streamFrame.getStreamID());
+                if (stream !== undefined) {
+                    stream.onFinAcked();
+                }
+            }
+        });
+    }
+
+    // removes a stream that is done in both directions, releasing its buffers
+    // for streams the peer opened, this frees up room for them to open a new one (see FlowControl:checkLocalStreamId)
+    public retireStream(stream: Stream): void {
+        this.deleteStream(stream);
+
+        let id = stream.getStreamID().toNumber();
+        let type = id % 4;
+        this.retiredCount[type]++;
+        if (id === this.retiredBelow[type]) {
+            this.retiredBelow[type] += 4;
+            while (this.retiredIds.delete(this.retiredBelow[type])) {
+                this.retiredBelow[type] += 4;
+            }
+        }
+        else {
+            this.retiredIds.add(id);
+        }
+
+        VerboseLogging.debug("StreamManager:retireStream : retired stream " + id + ", " + this.streams.size + " streams left" );
+        this.emit(StreamManagerEvents.RETIRED_STREAM, stream);
+    }
+
+    public isRetiredStream(streamId: Bignum): boolean {
+        let id = streamId.toNumber();
+        return id < this.retiredBelow[id % 4] || this.retiredIds.has(id);
+    }
+
+    // amount of streams of the given type that have been retired during the lifetime of the connection
+    public getRetiredStreamCount(streamType: StreamType): number {
+        return this.retiredCount[streamType];
+    }
+
     public deleteStream(streamId: Bignum): void;
     public deleteStream(stream: Stream): void;
     public deleteStream(obj: any): void {
@@ -153,23 +269,26 @@ export class StreamManager extends EventEmitter {
         if (stream === undefined) {
             return;
         }
-        var index = this.streams.indexOf(stream);
-        if (index > -1) {
-            this.streams.splice(index, 1);
+        if (this.streams.delete( StreamManager.getStreamKey(stream.getStreamID()) )) {
+            this.activeStreams.delete(stream);
+            this.receiveStateChangedStreams.delete(stream);
+            stream.releaseReceiveWindow();
+            stream.removeAllListeners(StreamEvent.DATA_QUEUED);
+            stream.removeAllListeners(StreamEvent.CLOSED);
         }
     }
 
     public getNextStream(streamType: StreamType): Stream {
-        var next = new Bignum(streamType);
-        var stream = this._getStream(next);
-        while (stream != undefined) {
+        // IDs of retired streams can't be reused, skip over those as well
+        var next = new Bignum(this.retiredBelow[streamType]);
+        while (this._getStream(next) !== undefined || this.isRetiredStream(next)) {
             next = next.add(4);
-            stream = this._getStream(next);
         }
         return this.getStream(next);
     }
 }
 
 export enum StreamManagerEvents {
-    INITIALIZED_STREAM = "str-man-initialized-stream"
+    INITIALIZED_STREAM = "str-man-initialized-stream",
+    RETIRED_STREAM = "str-man-retired-stream"
 }
\ No newline at end of file
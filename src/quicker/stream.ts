@@ -7,12 +7,8 @@ import { QuicError } from '../utilities/errors/connection.error';
 import { ConnectionErrorCodes } from '../utilities/errors/quic.codes';
 import { Constants } from '../utilities/constants';
 import { VerboseLogging } from '../utilities/logging/verbose.logging';
-
-interface BufferedData {
-    data: Buffer,
-    offset:Bignum,
-	isFin: boolean
-};
+import { BufferQueue } from '../types/buffer.queue';
+import { ReassemblyBuffer } from '../types/reassembly.buffer';
 
 export class Stream extends FlowControlledObject {
 	
@@ -22,13 +18,18 @@ export class Stream extends FlowControlledObject {
 	private streamState: StreamState;
 	private finalReceivedOffset!: Bignum;
 	private finalSentOffset!: Bignum;
-	private data!: Buffer;
-    private bufferedData!:Array<BufferedData>;
-    private bufferedDataIsSorted!:boolean;
+	// outgoing data that hasn't been put in a STREAM frame yet. Queue of the application's buffers, so writes don't copy everything that's still pending
+	private data!: BufferQueue;
+    // received data that's not yet contiguous with what we've delivered (out-of-order arrivals)
+    private receiveBuffer!: ReassemblyBuffer;
+    private receiveEnded!: boolean; // StreamEvent.END has been emitted
+    private finSent!: boolean; // a STREAM frame with the FIN bit has been created
+    private finAcked!: boolean; // the peer has acknowledged the packet with our FIN, so we will never have to send anything on this stream again
+    private closedEmitted!: boolean;
 
 	
-    public constructor(endpointType: EndpointType, streamID: Bignum, bufferSize: number = Constants.DEFAULT_MAX_STREAM_DATA) {
-		super(bufferSize);
+    public constructor(endpointType: EndpointType, streamID: Bignum, bufferSize: number = Constants.MAX_STREAM_RECEIVE_WINDOW, initialWindowSize: number = Constants.DEFAULT_MAX_STREAM_DATA) {
+		super(bufferSize, initialWindowSize);
 		this.endpointType = endpointType;
 		this.streamID = streamID;
         this.streamState = StreamState.Open;
@@ -38,9 +39,12 @@ export class Stream extends FlowControlledObject {
 	public reset(): void {
 		this.blockedSent = false;
 		this.resetOffsets();
-		this.data = Buffer.alloc(0);
-        this.bufferedData = new Array<BufferedData>();
-        this.bufferedDataIsSorted = false;
+		this.data = new BufferQueue();
+        this.receiveBuffer = new ReassemblyBuffer();
+        this.receiveEnded = false;
+        this.finSent = false;
+        this.finAcked = false;
+        this.closedEmitted = false;
 	}
 
 	public getStreamID(): Bignum {
@@ -85,26 +89,63 @@ export class Stream extends FlowControlledObject {
     }
 
 	public addData(newData: Buffer, isFin = false): void {
-		if (this.blockedSent) {
-			throw new Error("stream:addData: send was blocked");
-        }
-        
-        this.data = Buffer.concat([this.data, newData]);
+        // being blocked by the peer's flow control (blockedSent) is no reason to refuse data: it simply stays buffered until we get more credit
+        // it's up to the application to stop writing when QuicStream.write() returns false
+        this.data.push(newData);
         
 		if (isFin) {
-            // FIXME: this is not correct: if we do popData anywhere in between these addData's, the remoteOffset will be erroneous! 
-			this.finalSentOffset = this.getCurrentSentOffset().add(this.data.byteLength);
+            // the remote offset is advanced for every popData (see FlowControl:getStreamFrames), so what's sent + what's still buffered is the final size
+			this.finalSentOffset = this.getCurrentSentOffset().add(this.data.getByteLength());
+		}
+
+		if (newData.byteLength > 0 || isFin) {
+			this.emit(StreamEvent.DATA_QUEUED);
 		}
     }
 
-	public popData(size: number = this.data.byteLength): Buffer {
-		var buf = this.data.slice(0, size);
-		this.data = this.data.slice(size);
-		return buf;
+	// only copies if the requested data spans multiple addData() calls
+	public popData(size: number = this.data.getByteLength()): Buffer {
+		let data = this.data.consumeBuffer(size);
+		if (data.byteLength > 0) {
+			this.emit(StreamEvent.DATA_SENT, data.byteLength);
+		}
+		return data;
+	}
+
+	// zero-copy version of popData(): the data is returned as slices of the Buffers that were passed to addData()
+	public popDataSlices(size: number = this.data.getByteLength()): Buffer[] {
+		let slices = this.data.consume(size);
+		let length = 0;
+		for (let slice of slices) {
+			length += slice.byteLength;
+		}
+		if (length > 0) {
+			this.emit(StreamEvent.DATA_SENT, length);
+		}
+		return slices;
 	}
 
 	public getOutgoingDataSize(): number {
-		return this.data.byteLength;
+		return this.data.getByteLength();
+	}
+
+	// the part of the outgoing data the peer's flow control allows us to send right now (not taking the connection's flow control into account)
+	public getSendableDataSize(): number {
+		let credit = this.getSendAllowance().subtract(this.getRemoteOffset()).toNumber();
+		return Math.max(0, Math.min(this.getOutgoingDataSize(), credit));
+	}
+
+	// the FIN can be the only thing left to send (e.g., QuicStream.end() without data), which has to go out in its own (empty) STREAM frame
+	public isFinPending(): boolean {
+		return this.finalSentOffset !== undefined && !this.finSent;
+	}
+
+	public setFinSent(): void {
+		this.finSent = true;
+	}
+
+	public hasDataToSend(): boolean {
+		return this.getOutgoingDataSize() > 0 || this.isFinPending();
 	}
 
     public isSendOnly(): boolean {
@@ -135,143 +176,144 @@ export class Stream extends FlowControlledObject {
 	}
 
 	public receiveData(data: Buffer, offset: Bignum, isFin: boolean): void {
+		let endOffset = offset.add(data.byteLength);
+
+		if (this.finalReceivedOffset !== undefined && endOffset.greaterThan(this.finalReceivedOffset)) {
+			throw new QuicError(ConnectionErrorCodes.FINAL_OFFSET_ERROR, "Stream:receiveData: receiving data past the end of the FIN'ed stream : " + endOffset.toDecimalString() + " > " + this.finalReceivedOffset.toDecimalString() + " in stream " + this.streamID.toDecimalString() );
+        }
 
-		if (this.finalReceivedOffset !== undefined && offset.add(data.byteLength).greaterThan(this.finalReceivedOffset)) {
-			throw new QuicError(ConnectionErrorCodes.FINAL_OFFSET_ERROR, "Stream:receiveData: receiving data past the end of the FIN'ed stream : " + offset.add(data.byteLength).toDecimalString() + " > " + this.finalReceivedOffset.toDecimalString() + " in stream " + this.streamID.toDecimalString() );
+        if (isFin) {
+            // the final size is known as soon as the FIN arrives, even if there are still gaps before it
+            if (this.finalReceivedOffset !== undefined && !this.finalReceivedOffset.equals(endOffset)) {
+                throw new QuicError(ConnectionErrorCodes.FINAL_OFFSET_ERROR, "Stream:receiveData: final offset changed : " + endOffset.toDecimalString() + " != " + this.finalReceivedOffset.toDecimalString() + " in stream " + this.streamID.toDecimalString() );
+            }
+            if (endOffset.lessThan(this.getCurrentReceivedOffset()) || endOffset.lessThan(this.receiveBuffer.getEndOffset())) {
+                throw new QuicError(ConnectionErrorCodes.FINAL_OFFSET_ERROR, "Stream:receiveData: FIN below data we already received : " + endOffset.toDecimalString() + " in stream " + this.streamID.toDecimalString() );
+            }
+            this.finalReceivedOffset = endOffset;
         }
 
         // Want to deal with out-of-order data AND overlapping data 
-        // to do this, we keep a list of buffered data, SORTED on offset
-        // when data comes in, we process this buffered list in offset order
-        
-        // 1. offset is exactly one more than current: which *should* always happen without loss/reordering
-		if ( offset.equals(this.getCurrentReceivedOffset()) ){
-            VerboseLogging.trace("Stream:receiveData : 1 : data exactly as expected : " + offset.toDecimalString() );
-            this.bubbleUpReceivedData(data, isFin);
-            if( !isFin )
-                this.checkBufferedData();
-            else{
-                VerboseLogging.debug("Stream:receiveData : stream delivered in-full : emptying buffered data : " + this.bufferedData.length );
-                for( let item of this.bufferedData ){
-                    VerboseLogging.debug("Stream:receiveData : stream delivered in-full : emptying buffered data : [" + item.offset.toDecimalString() + ", " + item.offset.add(item.data.byteLength).toDecimalString() + "]");
-                }
-                
-                this.bufferedData = new Array<BufferedData>();
+        // Data that is not contiguous with what we've already delivered is kept in a ReassemblyBuffer, which trims overlaps on insert
+        // Whenever the gap at the front is filled, everything that has become contiguous is delivered in one go
+        let readOffset = this.getCurrentReceivedOffset().toNumber();
+        let dataOffset = offset.toNumber();
+
+        if (dataOffset + data.byteLength <= readOffset) {
+            // already delivered to the application (e.g., a retransmit of data that wasn't lost after all): ignore
+            VerboseLogging.debug("Stream:receiveData : data was completely below current received offset, ignoring. " + readOffset + " >= " + (dataOffset + data.byteLength) );
+        }
+        else if (dataOffset <= readOffset) {
+            // (the new part of) this data is directly usable
+            this.bubbleUpReceivedData( data.slice(readOffset - dataOffset) );
+
+            if (!this.receiveBuffer.isEmpty()) {
+                this.deliverBufferedData();
             }
-        } 
-        // 2. offset is "in the future" : just buffer until further notice
-        else if (offset.greaterThan(this.getCurrentReceivedOffset())) {
-            VerboseLogging.trace("Stream:receiveData : 2 : data too far ahead, buffering : " + offset.toDecimalString() );
-            this.addBufferedData(data, offset, isFin);
-            // No need to call checkBuffered here: we didn't add anything to the buffer that could trigger a proper call to this function
-        } 
-        // 3. here, it's implied that offset is < currentReceivedOffset
-        // two cases remain: either it's completely below and we discard it (3.), or it's partially below and we split the data (4.)
-        else if( offset.add(data.byteLength).lessThanOrEqual(this.getCurrentReceivedOffset()) ){
-			// Offset is smaller than local offset
-            // --> data is already received by the application, thus ignore data.
-            VerboseLogging.debug("Stream:receiveData : 3 : data was completely below current received offset, ignoring. " + this.getCurrentReceivedOffset().toDecimalString() + " > " + offset.toDecimalString() + " and >= " + offset.add(data.byteLength).toDecimalString() );
         }
-        //4. partial overlap, this is where it gets nasty
         else {
-            VerboseLogging.debug("Stream:receiveData : 4 : data partially overlaps, adjusting and redoing : " + this.getCurrentReceivedOffset().toDecimalString() + " between " + offset.toDecimalString() + " and " + offset.add(data.byteLength).toDecimalString() );
-            // representation of situation: 
-            // .....................|  < current offset
-            //             |..................| < incoming data
-            // we can safely process this data first, before looking at the buffers, since this one will always contain SOME directly usable data
-            // it could be stuff that was already buffered (partially) overlaps this of course, but then it will be discardeed in 3. or processed in 4.
-
-            // example: current offset is at 15
-            //     ...........14|15
-            // incoming offset is 13
-            //     .......|13 14|15
-            // 15 - 13 = 2. Data index 2 = 15 (0 = 13, 1 = 14), so 2 is our direct index into the data buffer
-            let firstNewOffset:number = this.getCurrentReceivedOffset().subtract( offset ).toNumber();
-            let nonOverlappingData:Buffer = data.slice(firstNewOffset);
-            this.receiveData( nonOverlappingData, this.getCurrentReceivedOffset(), isFin);
-            // No need to call checkBuffered here : this *should* immediately execute 1., which processed any buffered data 
-		}
+            // "in the future" : buffer until the gap before it is filled
+            VerboseLogging.trace("Stream:receiveData : data too far ahead, buffering : " + dataOffset + " > " + readOffset );
+            let added = this.receiveBuffer.insert(dataOffset, data);
+            if (added > 0) {
+                this.incrementBufferSizeUsed(added);
+            }
+        }
+
+        this.checkReceiveEnded();
 	}
 
-	private bubbleUpReceivedData(data: Buffer, isFin: boolean): void {
+	private deliverBufferedData(): void {
+        let bufferedBefore = this.receiveBuffer.getByteLength();
+        let contiguous = this.receiveBuffer.popContiguous( this.getCurrentReceivedOffset().toNumber() );
+        this.decrementBufferSizeUsed(bufferedBefore - this.receiveBuffer.getByteLength());
+
+        if (contiguous.length > 0) {
+            VerboseLogging.debug("Stream:deliverBufferedData : delivering " + contiguous.length + " buffered chunks, " + this.receiveBuffer.getSegmentCount() + " segments left in the buffer" );
+        }
+        for (let chunk of contiguous) {
+            this.bubbleUpReceivedData(chunk);
+        }
+    }
+
+	private bubbleUpReceivedData(data: Buffer): void {
 		this.emit(StreamEvent.DATA, data);
         this.addLocalOffset(data.byteLength); // addCurrentReceivedOffset
 
         VerboseLogging.debug("Stream:bubbleUpReceivedData : new current received offset is at " + this.getCurrentReceivedOffset().toDecimalString() );
-        
-        if (isFin) {
-            this.finalReceivedOffset = this.getCurrentReceivedOffset();
-
-            if (this.getStreamState() === StreamState.Open) {
-                this.setStreamState(StreamState.LocalClosed);
-            } 
-            else if (this.getStreamState() === StreamState.RemoteClosed) {
-                this.setStreamState(StreamState.Closed);
-            }
-
-            this.emit(StreamEvent.END);
-        }
 	}
 
+	// Data that was delivered upwards (StreamEvent.DATA), but that the application hasn't consumed yet (e.g., a paused QuicStream)
+	// This is counted against our receive buffer, so the peer's allowance only grows as fast as the application actually reads
+	public addUnconsumedData(dataLength: number): void {
+		this.incrementBufferSizeUsed(dataLength);
+	}
 
-	private checkBufferedData(): void {
-        // TODO: potentially best to use insertion-sort here, but since that leads to re-allocation in JS anyway, it probably doesn't matter
-        // TODO: still... test and make sure this is better optimized
-        // TODO: now, this function is also called EVERY TIME for each new buffer check, even if we know things are sorted! 
+	public consumeData(dataLength: number): void {
+		this.decrementBufferSizeUsed(dataLength);
+	}
 
-        if( this.bufferedData.length === 0 )
+	private checkReceiveEnded(): void {
+        if (this.receiveEnded || this.finalReceivedOffset === undefined || !this.getCurrentReceivedOffset().equals(this.finalReceivedOffset)) {
             return;
-
-        // logic is that we sort based on the offset, as we can only process things in-order either way
-        if( !this.bufferedDataIsSorted ){
-            // sort is in-place
-            this.bufferedData.sort( (a:BufferedData, b:BufferedData):number => {
-                return a.offset.compare( b.offset );
-            });
         }
 
-        let firstUp = this.bufferedData[0];
-        VerboseLogging.debug("Stream:checkBufferedData : Checking candidate data " + firstUp.offset.toDecimalString() + ", length " + firstUp.data.byteLength + ". " + (this.bufferedData.length - 1) + " items left in the buffer" );
+        this.receiveEnded = true;
+        this.receiveBuffer.clear(); // should be empty already, nothing can be buffered beyond the final offset
 
-        // we are fully sorted. If this offset is > what we expect, nothing behind us is going to be ready for use, so we can stop
-        // this is one of our "recursion" stop conditions
-        if( firstUp.offset.greaterThan(this.getCurrentReceivedOffset()) ){
-            VerboseLogging.debug("Stream:checkBufferedData : first candidate's offset was too large");
-            return;
+        if (this.getStreamState() === StreamState.Open) {
+            this.setStreamState(StreamState.LocalClosed);
+        } 
+        else if (this.getStreamState() === StreamState.RemoteClosed) {
+            this.setStreamState(StreamState.Closed);
         }
 
+        this.emit(StreamEvent.END);
+        this.checkClosed();
+	}
 
-        // right here, we're sure this can be processed, 
-        // either in full (receiveData:1) or partially (receiveData:4) or discarded (receiveData:3) but never put back into the buffer (receiveData:2)
-        // that's why we have the greaterThan(this.getCurrentReceivedOffset()) above 
-        firstUp = this.bufferedData.shift()!;
-        this.receiveData( firstUp.data, firstUp.offset, firstUp.isFin );
+	// the peer abandoned its sending side (RESET_STREAM): nothing more will be delivered, so whatever is still buffered and our share of the receive budget can go
+	public onResetReceived(): void {
+		if (this.receiveEnded) {
+			return;
+		}
+		this.receiveEnded = true;
+		let buffered = this.receiveBuffer.getByteLength();
+		this.receiveBuffer.clear();
+		if (buffered > 0) {
+			this.decrementBufferSizeUsed(buffered);
+		}
+		this.releaseReceiveWindow();
+		this.checkClosed();
 	}
 
-    /*
-    private popBufferedData(localOffset: Bignum): BufferedData | undefined {
-		var offsetString: string = localOffset.toDecimalString();
-        if (this.bufferedData[offsetString] !== undefined) {
-			var bufferedData = this.bufferedData[offsetString];
-			delete this.bufferedData[offsetString];
-			this.decrementBufferSizeUsed(bufferedData.data.byteLength);
-            return bufferedData;
-        }
-        return undefined;
-    }
-    */
+	// called when a packet containing the STREAM frame with our FIN was acknowledged
+	// retransmits re-send the whole packet (see Connection:retransmitPacket), so from then on, we don't need our send state for this stream anymore
+	public onFinAcked(): void {
+		this.finAcked = true;
+		this.checkClosed();
+	}
 
-    private addBufferedData(data: Buffer, offset: Bignum, isFin: boolean): void {
-        
-        this.bufferedData.push( {
-            data: data,
-            offset: offset,
-            isFin: isFin
-        });
+	public isSendSideFinished(): boolean {
+		return this.isReceiveOnly() || this.finAcked;
+	}
 
-        this.bufferedDataIsSorted = false;
+	public isReceiveSideFinished(): boolean {
+		return this.isSendOnly() || this.receiveEnded;
+	}
 
-		this.incrementBufferSizeUsed(data.byteLength);
+	// nothing left to do in either direction: the stream can be forgotten (see StreamManager:retireStream)
+	public isClosed(): boolean {
+		return this.isSendSideFinished() && this.isReceiveSideFinished();
+	}
+
+	private checkClosed(): void {
+		if (this.closedEmitted || !this.isClosed()) {
+			return;
+		}
+		this.closedEmitted = true;
+		this.setStreamState(StreamState.Closed);
+		this.emit(StreamEvent.CLOSED);
 	}
 
 	public static isLocalStream(endpointType: EndpointType, streamID: Bignum): boolean {
@@ -329,4 +371,7 @@ export enum StreamType {
 export enum StreamEvent {
 	DATA = "stream-data",
 	END = "stream-end",
+	DATA_SENT = "stream-data-sent", // data was taken from the send buffer to be put in STREAM frames
+	DATA_QUEUED = "stream-data-queued", // new data was added to the send buffer (see StreamManager:activateStream)
+	CLOSED = "stream-closed", // both directions are finished (see Stream:isClosed)
 }
\ No newline at end of file
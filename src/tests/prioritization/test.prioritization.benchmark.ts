@@ -0,0 +1,665 @@
+import { QuicStream } from '../../quicker/quic.stream';
+import { Bignum } from '../../types/bignum';
+import { Constants } from '../../utilities/constants';
+import { Http3RequestMetadata } from '../../http/http3/client/http3.requestmetadata';
+import { VerboseLogging } from '../../utilities/logging/verbose.logging';
+import { Http3PriorityScheme, Http3DynamicFifoScheme, Http3FIFOScheme, Http3RoundRobinScheme, Http3WeightedRoundRobinScheme, Http3ParallelPlusScheme, Http3SerialPlusScheme, Http3FirefoxScheme, Http3PMeenanScheme, Http3PmeenanHtmlScheme, Http3SpeedyRRScheme, Http3ExtensiblePrioritiesScheme } from '../../http/http3/common/prioritization/schemes/index';
+import { existsSync, readFileSync, statSync, writeFileSync } from 'fs';
+import { join, basename } from 'path';
+
+// Offline counterpart of test.prioritization.testcases.ts: instead of running the demoserver and democlient over a real QUIC connection,
+// the server side prioritisation schemes are driven directly over a simulated link (bandwidth, RTT, random loss), in virtual time.
+// Runs are fast, deterministic and independent of the machine's load, so schemes can be compared over many pages and network conditions.
+//
+// run directly in quicker main directory as
+//   LOG_LEVEL=warn node ./out/tests/prioritization/test.prioritization.benchmark.js [options] [testcase directories]
+// options: --bandwidth=<Mbit/s> (default 10) --rtt=<ms> (default 50) --loss=<fraction of packets> (default 0) --seed=<number> (default 1)
+//          --schemes=<comma separated, names as for the demoserver> --verbose (results per resource) --output=<file to write all results to as JSON>
+// a testcase directory is laid out like public/prioritization_testcases/<testcase>: the resource files + prioritization_resource_lists/resource_list.json
+// without testcase directories, the page in public/index_with_subresources.html is used
+//
+// The model is kept simple on purpose, it only has to show how the schemes differ:
+//  - requests are tiny: they take RTT/2 to reach the server and never compete for bandwidth
+//  - the server sends whenever it has data and the link is free, as if the congestion window is never the bottleneck
+//  - like Http3Scheduler, the scheme is asked for data whenever the next packet can't be filled with what was already written to the streams
+//  - a lost packet is detected one RTT after it was sent and its data is retransmitted before any new data
+//  - the client requests resources like the democlient: childrenStart deltaStartTime ms after their parent was requested, childrenEnd deltaStartTime ms after their parent completed
+// NOTE: some nodes prune themselves on a (real) timer after they finish. Runs don't take real time, so that never happens during a run
+
+interface BenchmarkResource extends Http3RequestMetadata {
+    size?: number, // bytes, taken from the resource file if it's not in the resource list
+}
+
+interface BenchmarkTestcase {
+    name: string,
+    resources: {[path: string]: BenchmarkResource}, // first one is the page itself
+}
+
+interface NetworkConditions {
+    bandwidth: number, // Mbit/s
+    rtt: number, // ms
+    loss: number, // fraction of packets that is lost, 0 to 1
+    seed: number,
+}
+
+interface ResourceResult {
+    path: string,
+    size: number,
+    requestTime: number, // ms since the start of the page load
+    firstByteTime: number, // ms, -1 if nothing arrived
+    completionTime: number, // ms, -1 if the resource never completed
+}
+
+interface BenchmarkResult {
+    testcase: string,
+    scheme: string,
+    pageLoadTime: number, // ms, all resources complete (-1 if some never did)
+    aboveTheFoldTime: number, // ms, page + all critical and above the fold resources complete (-1 if some never did)
+    meanCompletionTime: number, // ms, average time between request and completion of a resource
+    fairness: number, // Jain's fairness index of the throughputs of the resources: 1 if they all got the same, 1/n if a single one got everything
+    cpuNanosecondsPerByte: number, // time spent in the scheme per byte it scheduled
+    packetsSent: number,
+    packetsLost: number,
+    resources: ResourceResult[],
+}
+
+// Bytes the scheme wrote to a stream, waiting to be put in a packet
+interface StreamChunk {
+    stream: BenchmarkStream,
+    length: number,
+    fin: boolean,
+}
+
+enum SimulationEventType {
+    REQUEST_SENT,
+    REQUEST_ARRIVED,
+    PACKET_ARRIVED,
+    PACKET_LOST, // the sender found out, retransmits now
+    LINK_FREE,
+}
+
+interface SimulationEvent {
+    time: number, // ms
+    order: number, // events at the same time are handled in the order they were added
+    type: SimulationEventType,
+    path?: string,
+    stream?: BenchmarkStream,
+    packet?: StreamChunk[],
+}
+
+// Only what the schemes use of a QuicStream. Written data is queued on the simulated sender instead of being packetized
+class BenchmarkStream {
+    public readonly path: string;
+    public readonly size: number;
+    public bytesReceived: number = 0;
+    public finReceived: boolean = false;
+    public requestTime: number = -1;
+    public firstByteTime: number = -1;
+    public completionTime: number = -1;
+
+    private streamID: Bignum;
+    private simulation: BenchmarkSimulation;
+
+    public constructor(streamID: Bignum, path: string, size: number, simulation: BenchmarkSimulation) {
+        this.streamID = streamID;
+        this.path = path;
+        this.size = size;
+        this.simulation = simulation;
+    }
+
+    public getStreamId(): Bignum {
+        return this.streamID;
+    }
+
+    // the simulation stands in for the Connection
+    public getConnection(): BenchmarkSimulation {
+        return this.simulation;
+    }
+
+    public write(data: Buffer | Buffer[]) {
+        this.simulation.queueChunk(this, data, false);
+    }
+
+    public end(data?: Buffer | Buffer[]) {
+        this.simulation.queueChunk(this, data === undefined ? [] : data, true);
+    }
+
+    public isComplete(): boolean {
+        return this.finReceived && this.bytesReceived >= this.size;
+    }
+}
+
+// mulberry32: Math.random can't be seeded, and every scheme should see exactly the same losses
+class SeededRandom {
+    private state: number;
+
+    public constructor(seed: number) {
+        this.state = seed >>> 0;
+    }
+
+    // in [0, 1)
+    public next(): number {
+        this.state = (this.state + 0x6D2B79F5) >>> 0;
+        let t: number = this.state;
+        t = Math.imul(t ^ (t >>> 15), t | 1);
+        t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+        return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    }
+}
+
+// Binary min-heap of events, ordered by time and then by order of addition
+class SimulationEventQueue {
+    private heap: SimulationEvent[] = [];
+
+    public push(event: SimulationEvent) {
+        this.heap.push(event);
+        let index: number = this.heap.length - 1;
+        while (index > 0) {
+            const parentIndex: number = Math.floor((index - 1) / 2);
+            if (!this.before(this.heap[index], this.heap[parentIndex])) {
+                break;
+            }
+            this.swap(index, parentIndex);
+            index = parentIndex;
+        }
+    }
+
+    public pop(): SimulationEvent | undefined {
+        if (this.heap.length === 0) {
+            return undefined;
+        }
+        const top: SimulationEvent = this.heap[0];
+        const bottom: SimulationEvent = this.heap.pop()!;
+        if (this.heap.length > 0) {
+            this.heap[0] = bottom;
+            let index: number = 0;
+            while (true) {
+                const leftChildIndex: number = (2 * index) + 1;
+                const rightChildIndex: number = (2 * index) + 2;
+                let smallestIndex: number = index;
+                if (leftChildIndex < this.heap.length && this.before(this.heap[leftChildIndex], this.heap[smallestIndex])) {
+                    smallestIndex = leftChildIndex;
+                }
+                if (rightChildIndex < this.heap.length && this.before(this.heap[rightChildIndex], this.heap[smallestIndex])) {
+                    smallestIndex = rightChildIndex;
+                }
+                if (smallestIndex === index) {
+                    break;
+                }
+                this.swap(index, smallestIndex);
+                index = smallestIndex;
+            }
+        }
+        return top;
+    }
+
+    private before(a: SimulationEvent, b: SimulationEvent): boolean {
+        return a.time < b.time || (a.time === b.time && a.order < b.order);
+    }
+
+    private swap(indexA: number, indexB: number) {
+        const a: SimulationEvent = this.heap[indexA];
+        this.heap[indexA] = this.heap[indexB];
+        this.heap[indexB] = a;
+    }
+}
+
+// A single page load with a single scheme
+class BenchmarkSimulation {
+    // the schemes never look at the contents of the responses: they're all slices of this one
+    private static payload: Buffer = Buffer.alloc(0);
+
+    private testcase: BenchmarkTestcase;
+    private conditions: NetworkConditions;
+    private scheme: Http3PriorityScheme;
+    private random: SeededRandom;
+
+    private now: number = 0;
+    private events: SimulationEventQueue = new SimulationEventQueue();
+    private eventCount: number = 0;
+
+    private streams: BenchmarkStream[] = [];
+    private nextStreamID: number = 0;
+    private pendingChunks: StreamChunk[] = [];
+    private pendingBytes: number = 0;
+    private retransmissions: StreamChunk[][] = [];
+    private linkBusy: boolean = false;
+
+    private schedulerTime: number = 0; // ns
+    private bytesScheduled: number = 0;
+    private packetsSent: number = 0;
+    private packetsLost: number = 0;
+
+    public constructor(testcase: BenchmarkTestcase, conditions: NetworkConditions, scheme: Http3PriorityScheme) {
+        this.testcase = testcase;
+        this.conditions = conditions;
+        this.scheme = scheme;
+        this.random = new SeededRandom(conditions.seed);
+
+        for (const path of Object.keys(testcase.resources)) {
+            if (BenchmarkSimulation.payload.byteLength < testcase.resources[path].size!) {
+                BenchmarkSimulation.payload = Buffer.alloc(testcase.resources[path].size!);
+            }
+        }
+    }
+
+    public run(schemeName: string): BenchmarkResult {
+        this.measure(() => {
+            this.scheme.initialSetup();
+        });
+
+        const page: string = Object.keys(this.testcase.resources)[0];
+        this.addEvent(0, SimulationEventType.REQUEST_SENT, { path: page });
+        this.requestChildren(page, this.testcase.resources[page].childrenStart, 0);
+
+        let event: SimulationEvent | undefined = this.events.pop();
+        while (event !== undefined) {
+            this.now = event.time;
+            switch (event.type) {
+                case SimulationEventType.REQUEST_SENT:
+                    this.onRequestSent(event.path!);
+                    break;
+                case SimulationEventType.REQUEST_ARRIVED:
+                    this.onRequestArrived(event.stream!);
+                    break;
+                case SimulationEventType.PACKET_ARRIVED:
+                    this.onPacketArrived(event.packet!);
+                    break;
+                case SimulationEventType.PACKET_LOST:
+                    this.retransmissions.push(event.packet!);
+                    this.requestSendPackets();
+                    break;
+                case SimulationEventType.LINK_FREE:
+                    this.linkBusy = false;
+                    this.sendPacket();
+                    break;
+            }
+            event = this.events.pop();
+        }
+
+        return this.getResult(schemeName);
+    }
+
+    // Connection:requestSendPackets. Wakes up the link if it was idle, after that it asks for data by itself as long as there is some
+    public requestSendPackets() {
+        if (!this.linkBusy) {
+            this.linkBusy = true;
+            this.addEvent(this.now, SimulationEventType.LINK_FREE);
+        }
+    }
+
+    // Connection:getQlogger. The schemes log every chunk and stream state change, we don't need those
+    public getQlogger(): any {
+        return {
+            onHTTPDataChunk: () => {},
+            onHTTPStreamStateChanged: () => {},
+        };
+    }
+
+    public queueChunk(stream: BenchmarkStream, data: Buffer | Buffer[], fin: boolean) {
+        let length: number = 0;
+        for (const buffer of (data instanceof Buffer ? [data] : data)) {
+            length += buffer.byteLength;
+        }
+        this.pendingChunks.push({ stream: stream, length: length, fin: fin });
+        this.pendingBytes += length;
+    }
+
+    private onRequestSent(path: string) {
+        const stream: BenchmarkStream = new BenchmarkStream(new Bignum(this.nextStreamID), path, this.testcase.resources[path].size!, this);
+        this.nextStreamID += 4; // client initiated bidirectional
+        stream.requestTime = this.now;
+        this.streams.push(stream);
+        this.addEvent(this.now + this.conditions.rtt / 2, SimulationEventType.REQUEST_ARRIVED, { stream: stream });
+    }
+
+    // Same calls as Http3Server:handleRequest, with the whole response available right away
+    private onRequestArrived(stream: BenchmarkStream) {
+        const streamID: Bignum = stream.getStreamId();
+        let metadata: Http3RequestMetadata = this.testcase.resources[stream.path];
+        if (metadata.priority === undefined) {
+            metadata = {...metadata, priority: BenchmarkSimulation.derivePriority(metadata)};
+        }
+        this.measure(() => {
+            this.scheme.addStream(stream as any as QuicStream);
+            this.scheme.applyScheme(streamID, metadata);
+            this.scheme.addData(streamID, BenchmarkSimulation.payload.slice(0, stream.size));
+            this.scheme.finishStream(streamID);
+        });
+    }
+
+    private onPacketArrived(packet: StreamChunk[]) {
+        for (const chunk of packet) {
+            const stream: BenchmarkStream = chunk.stream;
+            if (stream.firstByteTime < 0 && chunk.length > 0) {
+                stream.firstByteTime = this.now;
+            }
+            stream.bytesReceived += chunk.length;
+            stream.finReceived = stream.finReceived || chunk.fin;
+            if (stream.completionTime < 0 && stream.isComplete()) {
+                stream.completionTime = this.now;
+                this.requestChildren(stream.path, this.testcase.resources[stream.path].childrenEnd, this.now);
+            }
+        }
+    }
+
+    private requestChildren(parent: string, children: string[] | undefined, from: number) {
+        if (children === undefined) {
+            return;
+        }
+        for (const child of children) {
+            const metadata: BenchmarkResource | undefined = this.testcase.resources[child];
+            if (metadata === undefined) {
+                VerboseLogging.warn("PrioritizationBenchmark : " + this.testcase.name + " : " + parent + " has unknown child " + child + ", ignoring it");
+                continue;
+            }
+            this.addEvent(from + (metadata.deltaStartTime !== undefined ? metadata.deltaStartTime : 0), SimulationEventType.REQUEST_SENT, { path: child });
+        }
+    }
+
+    private sendPacket() {
+        let packet: StreamChunk[] | undefined = this.retransmissions.shift();
+        if (packet === undefined) {
+            packet = this.createPacket();
+            if (packet.length === 0) {
+                return; // idle until the next requestSendPackets
+            }
+        }
+
+        let packetSize: number = 0;
+        for (const chunk of packet) {
+            packetSize += chunk.length;
+        }
+        // Mbit/s = 1000 bits/ms. A packet with only a FIN still takes a bit of time
+        const transmissionTime: number = (Math.max(packetSize, 1) * 8) / (this.conditions.bandwidth * 1000);
+        this.linkBusy = true;
+        this.addEvent(this.now + transmissionTime, SimulationEventType.LINK_FREE);
+
+        ++this.packetsSent;
+        if (this.random.next() < this.conditions.loss) {
+            ++this.packetsLost;
+            this.addEvent(this.now + transmissionTime + this.conditions.rtt, SimulationEventType.PACKET_LOST, { packet: packet });
+        } else {
+            this.addEvent(this.now + transmissionTime + this.conditions.rtt / 2, SimulationEventType.PACKET_ARRIVED, { packet: packet });
+        }
+    }
+
+    // Fills a packet with the data that was written to the streams, in the order it was written
+    private createPacket(): StreamChunk[] {
+        const maxPacketSize: number = Constants.DEFAULT_MAX_PACKET_SIZE;
+
+        // see Http3Scheduler:onSendOpportunity
+        if (this.pendingBytes < maxPacketSize) {
+            this.measure(() => {
+                let scheduled: number = 0;
+                const budget: number = maxPacketSize - this.pendingBytes;
+                while (scheduled < budget) {
+                    const chunkSize: number = this.scheme.schedule();
+                    if (chunkSize === 0) {
+                        break;
+                    }
+                    scheduled += chunkSize;
+                }
+                this.bytesScheduled += scheduled;
+            });
+        }
+
+        const packet: StreamChunk[] = [];
+        let packetSize: number = 0;
+        while (this.pendingChunks.length > 0 && packetSize < maxPacketSize) {
+            const chunk: StreamChunk = this.pendingChunks[0];
+            const length: number = Math.min(chunk.length, maxPacketSize - packetSize);
+            if (length === chunk.length) {
+                this.pendingChunks.shift();
+                packet.push(chunk);
+            } else {
+                // the rest (and the FIN) goes in the next packet
+                chunk.length -= length;
+                packet.push({ stream: chunk.stream, length: length, fin: false });
+            }
+            packetSize += length;
+            this.pendingBytes -= length;
+        }
+        return packet;
+    }
+
+    private addEvent(time: number, type: SimulationEventType, data: {path?: string, stream?: BenchmarkStream, packet?: StreamChunk[]} = {}) {
+        this.events.push({ time: time, order: this.eventCount++, type: type, path: data.path, stream: data.stream, packet: data.packet });
+    }
+
+    private measure(action: () => void) {
+        const start: [number, number] = process.hrtime();
+        action();
+        const elapsed: [number, number] = process.hrtime(start);
+        this.schedulerTime += elapsed[0] * 1e9 + elapsed[1];
+    }
+
+    private getResult(schemeName: string): BenchmarkResult {
+        const resources: ResourceResult[] = [];
+        let complete: boolean = true;
+        let pageLoadTime: number = 0;
+        let aboveTheFoldTime: number = 0;
+        let completionTimeSum: number = 0;
+        const throughputs: number[] = [];
+
+        for (const stream of this.streams) {
+            resources.push({ path: stream.path, size: stream.size, requestTime: stream.requestTime, firstByteTime: stream.firstByteTime, completionTime: stream.completionTime });
+            if (stream.completionTime < 0) {
+                complete = false;
+                continue;
+            }
+            const metadata: BenchmarkResource = this.testcase.resources[stream.path];
+            const duration: number = stream.completionTime - stream.requestTime;
+            pageLoadTime = Math.max(pageLoadTime, stream.completionTime);
+            if (stream === this.streams[0] || metadata.isCritical === true || metadata.isAboveTheFold === true) {
+                aboveTheFoldTime = Math.max(aboveTheFoldTime, stream.completionTime);
+            }
+            completionTimeSum += duration;
+            if (stream.size > 0 && duration > 0) {
+                throughputs.push(stream.size / duration);
+            }
+        }
+
+        // Jain's index: (sum x)^2 / (n * sum x^2)
+        let sum: number = 0;
+        let sumOfSquares: number = 0;
+        for (const throughput of throughputs) {
+            sum += throughput;
+            sumOfSquares += throughput * throughput;
+        }
+
+        const completed: number = resources.filter((resource: ResourceResult) => resource.completionTime >= 0).length;
+        return {
+            testcase: this.testcase.name,
+            scheme: schemeName,
+            pageLoadTime: complete ? pageLoadTime : -1,
+            aboveTheFoldTime: complete ? aboveTheFoldTime : -1,
+            meanCompletionTime: completed > 0 ? completionTimeSum / completed : -1,
+            fairness: sumOfSquares > 0 ? (sum * sum) / (throughputs.length * sumOfSquares) : 1,
+            cpuNanosecondsPerByte: this.bytesScheduled > 0 ? this.schedulerTime / this.bytesScheduled : 0,
+            packetsSent: this.packetsSent,
+            packetsLost: this.packetsLost,
+            resources: resources,
+        };
+    }
+
+    // What a browser would put in the priority header (roughly what Chrome does), used when the resource list doesn't have one
+    // Only the urgency scheme looks at it
+    private static derivePriority(metadata: Http3RequestMetadata): string {
+        const mimeType: string = metadata.mimeType;
+        if (mimeType.indexOf("html") >= 0) {
+            return "u=0, i";
+        } else if (mimeType.indexOf("css") >= 0 || mimeType.indexOf("font") >= 0) {
+            return "u=0";
+        } else if (mimeType.indexOf("javascript") >= 0) {
+            if (metadata.isAsync === true || metadata.isDefer === true) {
+                return "u=3";
+            }
+            return (metadata.inHead === true || metadata.isCritical === true) ? "u=1" : "u=2";
+        } else if (mimeType.indexOf("image") >= 0) {
+            return metadata.isAboveTheFold === true ? "u=2, i" : "u=4, i";
+        }
+        return "u=4";
+    }
+}
+
+export class PrioritizationBenchmark {
+
+    // the demoserver's schemes, except "client": that one only does something with PRIORITY frames from a client
+    private static readonly SCHEMES: string[] = ["fifo", "rr", "wrr", "dfifo", "firefox", "p+", "s+", "pmeenan", "pmeenanhtml", "spdyrr", "urgency"];
+
+    public static execute(args: string[]): boolean {
+        const conditions: NetworkConditions = { bandwidth: 10, rtt: 50, loss: 0, seed: 1 };
+        let schemes: string[] = PrioritizationBenchmark.SCHEMES;
+        let verbose: boolean = false;
+        let outputFile: string | undefined = undefined;
+        const testcases: BenchmarkTestcase[] = [];
+
+        for (const arg of args) {
+            const [option, value] = arg.split("=");
+            switch (option) {
+                case "--bandwidth":
+                    conditions.bandwidth = Number(value);
+                    break;
+                case "--rtt":
+                    conditions.rtt = Number(value);
+                    break;
+                case "--loss":
+                    conditions.loss = Number(value);
+                    break;
+                case "--seed":
+                    conditions.seed = Number(value);
+                    break;
+                case "--schemes":
+                    schemes = value.split(",");
+                    break;
+                case "--verbose":
+                    verbose = true;
+                    break;
+                case "--output":
+                    outputFile = value;
+                    break;
+                default:
+                    testcases.push(PrioritizationBenchmark.loadTestcase(arg));
+            }
+        }
+        if (!(conditions.bandwidth > 0) || !(conditions.rtt >= 0) || !(conditions.loss >= 0 && conditions.loss < 1)) {
+            throw new Error("PrioritizationBenchmark: invalid network conditions " + JSON.stringify(conditions));
+        }
+        if (testcases.length === 0) {
+            testcases.push(PrioritizationBenchmark.getDefaultTestcase());
+        }
+
+        console.log(`PrioritizationBenchmark: ${testcases.length} testcases, ${schemes.length} schemes, ${conditions.bandwidth} Mbit/s, RTT ${conditions.rtt} ms, loss ${conditions.loss * 100}%`);
+
+        const results: BenchmarkResult[] = [];
+        let result: boolean = true;
+        for (const testcase of testcases) {
+            console.log("");
+            console.log(`${testcase.name} (${Object.keys(testcase.resources).length} resources)`);
+            console.log(["scheme", "load (ms)", "ATF (ms)", "mean (ms)", "fairness", "cpu (ns/B)"].map(PrioritizationBenchmark.toColumn).join(""));
+
+            for (const schemeName of schemes) {
+                const simulation: BenchmarkSimulation = new BenchmarkSimulation(testcase, conditions, PrioritizationBenchmark.stringToScheme(schemeName));
+                const schemeResult: BenchmarkResult = simulation.run(schemeName);
+                results.push(schemeResult);
+
+                // everything should arrive eventually, whatever the scheme
+                if (schemeResult.pageLoadTime < 0) {
+                    result = false;
+                    VerboseLogging.error(`PrioritizationBenchmark: ${testcase.name} with ${schemeName} : not all resources were completed!`);
+                }
+
+                console.log([schemeName, schemeResult.pageLoadTime.toFixed(1), schemeResult.aboveTheFoldTime.toFixed(1), schemeResult.meanCompletionTime.toFixed(1),
+                             schemeResult.fairness.toFixed(3), schemeResult.cpuNanosecondsPerByte.toFixed(2)].map(PrioritizationBenchmark.toColumn).join(""));
+                if (verbose) {
+                    for (const resource of schemeResult.resources) {
+                        console.log(`    ${resource.path} : ${resource.size} bytes, requested ${resource.requestTime.toFixed(1)}, first byte ${resource.firstByteTime.toFixed(1)}, complete ${resource.completionTime.toFixed(1)}`);
+                    }
+                }
+            }
+        }
+
+        if (outputFile !== undefined) {
+            writeFileSync(outputFile, JSON.stringify({ conditions: conditions, results: results }, null, 4));
+            console.log("PrioritizationBenchmark: results written to " + outputFile);
+        }
+
+        return result;
+    }
+
+    private static toColumn(value: string): string {
+        return value.length >= 12 ? value + " " : value + " ".repeat(12 - value.length);
+    }
+
+    // Same layout as the testcases of test.prioritization.testcases.ts
+    private static loadTestcase(directory: string): BenchmarkTestcase {
+        const resourceList: {resources: {[path: string]: BenchmarkResource}} = JSON.parse(readFileSync(join(directory, "prioritization_resource_lists", "resource_list.json"), "utf8"));
+        const testcase: BenchmarkTestcase = { name: basename(directory), resources: resourceList.resources };
+        PrioritizationBenchmark.addSizes(testcase, directory);
+        return testcase;
+    }
+
+    private static addSizes(testcase: BenchmarkTestcase, directory: string) {
+        for (const path of Object.keys(testcase.resources)) {
+            const resource: BenchmarkResource = testcase.resources[path];
+            if (resource.size === undefined) {
+                const filename: string = join(directory, path);
+                if (!existsSync(filename)) {
+                    throw new Error("PrioritizationBenchmark: no size for " + path + " in testcase " + testcase.name + " and " + filename + " doesn't exist");
+                }
+                resource.size = statSync(filename).size;
+            }
+        }
+    }
+
+    // public/index_with_subresources.html and what it loads
+    private static getDefaultTestcase(): BenchmarkTestcase {
+        const testcase: BenchmarkTestcase = {
+            name: "index_with_subresources",
+            resources: {
+                "/index_with_subresources.html": { mimeType: "text/html", isCritical: true, childrenStart: ["/QUIC_lowres.png", "/QUIC.png", "/footer.html"] },
+                "/QUIC_lowres.png": { mimeType: "image/png", isAboveTheFold: true, deltaStartTime: 5 },
+                "/QUIC.png": { mimeType: "image/png", isAboveTheFold: true, isAfterFirstImage: true, deltaStartTime: 5 },
+                "/footer.html": { mimeType: "text/html", deltaStartTime: 10, childrenEnd: ["/footer_script.js"] },
+                "/footer_script.js": { mimeType: "application/javascript", deltaStartTime: 1, childrenEnd: ["/footer_img.gif"] },
+                "/footer_img.gif": { mimeType: "image/gif", deltaStartTime: 1 },
+            },
+        };
+        PrioritizationBenchmark.addSizes(testcase, "public");
+        return testcase;
+    }
+
+    // see Http3Server:stringToScheme
+    private static stringToScheme(schemename: string): Http3PriorityScheme {
+        switch (schemename) {
+            case "rr":
+                return new Http3RoundRobinScheme();
+            case "wrr":
+                return new Http3WeightedRoundRobinScheme();
+            case "fifo":
+                return new Http3FIFOScheme();
+            case "dfifo":
+                return new Http3DynamicFifoScheme();
+            case "firefox":
+                return new Http3FirefoxScheme();
+            case "p+":
+                return new Http3ParallelPlusScheme();
+            case "s+":
+                return new Http3SerialPlusScheme();
+            case "pmeenan":
+                return new Http3PMeenanScheme();
+            case "pmeenanhtml":
+                return new Http3PmeenanHtmlScheme();
+            case "spdyrr":
+                return new Http3SpeedyRRScheme();
+            case "urgency":
+                return new Http3ExtensiblePrioritiesScheme();
+            default:
+                throw new Error("PrioritizationBenchmark: unknown scheme " + schemename);
+        }
+    }
+}
+
+const benchmarkSucceeded: boolean = PrioritizationBenchmark.execute(process.argv.slice(2));
+console.log("All prioritization benchmark runs completed? " + benchmarkSucceeded);
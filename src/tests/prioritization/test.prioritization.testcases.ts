@@ -45,7 +45,7 @@ export class TestPrioritization {
         // in the final results, we did not re-run the "demorgen" testcases due to lack of time                                                                                                                
 
         // the "zeroweightsimple" scheme is in a separate branch : http3-20_0-weight, since it changes http/3's default behaviour, which conflicts with all the rest
-        let schemes:Array<string> = ["fifo", "rr", "wrr", "dfifo", "firefox", "p+", "s+", "pmeenan", "pmeenanhtml", "spdyrr"/*, "zeroweightsimple"*/];
+        let schemes:Array<string> = ["fifo", "rr", "wrr", "dfifo", "firefox", "p+", "s+", "pmeenan", "pmeenanhtml", "spdyrr", "urgency"/*, "zeroweightsimple"*/];
         //bufferSize = "280k"; // define buffer size in democlient.ts with the sendbuffer.patch file applied // 2000 is 280k, 7200 is 1000k
 
 
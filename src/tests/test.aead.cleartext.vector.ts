@@ -5,6 +5,7 @@ import { Connection } from '../quicker/connection';
 import { EndpointType } from '../types/endpoint.type';
 import { Socket, createSocket, SocketType } from 'dgram';
 import { Version, ConnectionID } from '../packet/header/header.properties';
+import { TimerWheel } from '../types/timer.wheel';
 
 // This is an async test, so run directly from commandline : 
 // ../../nodejs/trunk/out/Release/node ./out/tests/test.aead.cleartext.vector.js 127.0.0.1 4433
@@ -44,7 +45,7 @@ export class TestAeaedCleartextVector  {
 
         setTimeout( () => {
 
-            let qtls:QTLS = new QTLS(true, {}, new Connection({address: "127.0.0.1", port: 1234, family: ""}, EndpointType.Server, socket, connectionID ));
+            let qtls:QTLS = new QTLS(true, {}, new Connection({address: "127.0.0.1", port: 1234, family: ""}, EndpointType.Server, socket, connectionID, new TimerWheel() ));
             let aead:AEAD = new AEAD(qtls);
 
             aead.generateClearTextSecrets( connectionID, qtls, new Version( Buffer.from("ff000014", "hex")) ); 
@@ -0,0 +1,81 @@
+import { BufferQueue } from "../types/buffer.queue";
+import { Stream } from "../quicker/stream";
+import { EndpointType } from "../types/endpoint.type";
+import { Bignum } from "../types/bignum";
+import { VerboseLogging } from "../utilities/logging/verbose.logging";
+
+
+export class TestBufferQueue {
+
+    private static check(nr: number, description: string, result: boolean): boolean {
+        if (result)
+            VerboseLogging.info("TestBufferQueue : testcase " + nr + " : " + description + " : OK");
+        else
+            VerboseLogging.error("TestBufferQueue : testcase " + nr + " : " + description + " : FAILED");
+        return result;
+    }
+
+    public static execute(): boolean {
+        let results = new Array<boolean>();
+
+        let first = Buffer.from("abcd");
+        let second = Buffer.from("efgh");
+        let third = Buffer.from("ijklmnop");
+
+        // 1. pushes are not copied, empty buffers are ignored
+        let queue = new BufferQueue();
+        queue.push(first);
+        queue.push(Buffer.alloc(0));
+        queue.push(second);
+        queue.push(third);
+        results.push( TestBufferQueue.check(1, "length", queue.getByteLength() === 16 && !queue.isEmpty()) );
+
+        // 2. peek does not remove anything and returns slices of the original buffers
+        let peeked = queue.peek(6);
+        results.push( TestBufferQueue.check(2, "peek", peeked.length === 2 && peeked[0] === first && peeked[1].toString() === "ef" && peeked[1].buffer === second.buffer && queue.getByteLength() === 16) );
+
+        // 3. consuming within a single buffer is zero-copy
+        let popped = queue.consumeBuffer(2);
+        results.push( TestBufferQueue.check(3, "consume within chunk", popped.toString() === "ab" && popped.buffer === first.buffer && queue.getByteLength() === 14) );
+
+        // 4. consuming across buffers yields a scatter list
+        let slices = queue.consume(8);
+        results.push( TestBufferQueue.check(4, "consume across chunks", slices.length === 3 && Buffer.concat(slices).toString() === "cdefghij" && queue.getByteLength() === 6) );
+
+        // 5. asking for more than is there gives what's left
+        popped = queue.consumeBuffer(100);
+        results.push( TestBufferQueue.check(5, "consume more than available", popped.toString() === "klmnop" && queue.isEmpty() && queue.consume(10).length === 0) );
+
+        // 6. lots of small writes, read in bigger chunks (this is what used to be quadratic)
+        queue = new BufferQueue();
+        let expected = "";
+        for (let i = 0; i < 1000; ++i) {
+            let text = "" + (i % 10);
+            queue.push(Buffer.from(text));
+            expected += text;
+        }
+        let output = "";
+        while (!queue.isEmpty()) {
+            output += queue.consumeBuffer(77).toString();
+        }
+        results.push( TestBufferQueue.check(6, "many small writes", output === expected) );
+
+        // 7. Stream send side
+        let stream = new Stream(EndpointType.Server, new Bignum(4));
+        stream.addData(Buffer.from("hello "));
+        stream.addData(Buffer.from("world"), true);
+        let fin = stream.getFinalSentOffset().toNumber() === 11;
+        let data = stream.popData(4).toString() + stream.popData().toString();
+        results.push( TestBufferQueue.check(7, "stream send buffer", fin && data === "hello world" && stream.getOutgoingDataSize() === 0) );
+
+        let result = true;
+        for (let entry of results) {
+            result = result && entry;
+        }
+
+        console.log("All BufferQueue testcases passed? " + result);
+        return result;
+    }
+}
+
+TestBufferQueue.execute();
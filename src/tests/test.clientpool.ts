@@ -0,0 +1,218 @@
+import { EventEmitter } from "events";
+import { Http3ClientPool, Http3ClientPoolEvent, Http3PoolRequest } from "../http/http3/client/http3.clientpool";
+import { Http3Client } from "../http/http3/client/http3.client";
+import { Http3ClientEvent } from "../http/http3/client/http3.client.events";
+import { Http3Message } from "../http/http3/common/http3.message";
+import { Bignum } from "../types/bignum";
+import { Constants } from "../utilities/constants";
+import { VerboseLogging } from "../utilities/logging/verbose.logging";
+
+
+// Stands in for an Http3Client: only the parts the pool uses, and the test decides when it connects, answers or is lost
+class FakeClient extends EventEmitter {
+    public credit: number = 100;
+    public closed: boolean = false;
+    // requests in flight, by request stream ID
+    public requests: Map<string, [Bignum, string]> = new Map<string, [Bignum, string]>();
+    private nextStreamID: number = 0;
+
+    public canSendRequests(): boolean {
+        return !this.closed;
+    }
+
+    public getRequestStreamCredit(): number {
+        return this.credit;
+    }
+
+    public get(path: string, authority: string): Bignum {
+        const streamID: Bignum = new Bignum(this.nextStreamID);
+        this.nextStreamID += 4;
+        this.credit = Math.max(0, this.credit - 1);
+        this.requests.set(streamID.toString(), [streamID, path]);
+        return streamID;
+    }
+
+    public close() {
+        this.closed = true;
+    }
+
+    public connect() {
+        this.emit(Http3ClientEvent.CLIENT_CONNECTED);
+    }
+
+    // answers the oldest request in flight
+    public respond() {
+        const [streamID, path]: [Bignum, string] = this.requests.values().next().value;
+        this.requests.delete(streamID.toString());
+        this.emit(Http3ClientEvent.RESPONSE_RECEIVED, path, <Http3Message><any>{}, streamID);
+    }
+
+    public paths(): string[] {
+        const paths: string[] = [];
+        this.requests.forEach(([streamID, path]: [Bignum, string]) => {
+            paths.push(path);
+        });
+        return paths;
+    }
+
+    public lose() {
+        this.closed = true;
+        this.requests.clear();
+        this.emit(Http3ClientEvent.CONNECTION_CLOSED);
+    }
+}
+
+// A pool on fake clients, which keeps track of what it reports
+class TestPool {
+    public pool: Http3ClientPool;
+    public clients: FakeClient[] = [];
+    public responses: string[] = [];
+    public failures: string[] = [];
+    public finished: number = 0;
+
+    public constructor(connectionsPerOrigin: number, failConnect: boolean = false) {
+        this.pool = new Http3ClientPool(connectionsPerOrigin, (host: string, port: number) => {
+            if (failConnect) {
+                throw new Error("TestClientPool : no network");
+            }
+            const client: FakeClient = new FakeClient();
+            this.clients.push(client);
+            return <Http3Client><any>client;
+        });
+        this.pool.on(Http3ClientPoolEvent.RESPONSE_RECEIVED, (request: Http3PoolRequest) => {
+            this.responses.push(request.path);
+        });
+        this.pool.on(Http3ClientPoolEvent.REQUEST_FAILED, (request: Http3PoolRequest) => {
+            this.failures.push(request.path);
+        });
+        this.pool.on(Http3ClientPoolEvent.ALL_REQUESTS_FINISHED, () => {
+            ++this.finished;
+        });
+    }
+
+    public get(path: string): Http3PoolRequest {
+        return this.pool.get("localhost", 4433, path, { mimeType: "text/html" });
+    }
+
+    public inFlight(): number[] {
+        return this.clients.map((client: FakeClient) => client.requests.size);
+    }
+}
+
+export class TestClientPool {
+
+    private static check(nr: number, description: string, result: boolean): boolean {
+        if (result)
+            VerboseLogging.info("TestClientPool : testcase " + nr + " : " + description + " : OK");
+        else
+            VerboseLogging.error("TestClientPool : testcase " + nr + " : " + description + " : FAILED");
+        return result;
+    }
+
+    private static equals(a: any, b: any): boolean {
+        return JSON.stringify(a) === JSON.stringify(b);
+    }
+
+    // every testcase ends with close(), which also stops the reconnect timers, so nothing keeps running after execute()
+    public static execute(): boolean {
+        let results = new Array<boolean>();
+        let equals = TestClientPool.equals;
+
+        // 1. requests go to the least loaded connection, and only to connections that are established
+        // (the connections of an origin are opened by its first request)
+        let test = new TestPool(2);
+        test.get("/a");
+        test.clients[0].connect();
+        test.get("/b");
+        let onlyConnected = equals(test.inFlight(), [2, 0]);
+        test.clients[1].connect();
+        test.get("/c");
+        test.get("/d");
+        test.get("/e");
+        results.push( TestClientPool.check(1, "least loaded", onlyConnected && equals(test.inFlight(), [3, 2]) && test.pool.getPendingRequestCount() === 5) );
+        test.pool.close();
+
+        // 2. zero credit: a connection is only used if it has nothing in flight, the rest waits for a response
+        test = new TestPool(2);
+        test.get("/a");
+        test.clients[0].credit = 0;
+        test.clients[1].credit = 0;
+        test.clients[0].connect();
+        test.clients[1].connect();
+        test.get("/b");
+        test.get("/c");
+        let waiting = equals(test.inFlight(), [1, 1]) && test.pool.getPendingRequestCount() === 3;
+        test.clients[1].respond();
+        results.push( TestClientPool.check(2, "zero credit", waiting && equals(test.inFlight(), [1, 1]) && equals(test.responses, ["/b"]) && equals(test.clients[1].paths(), ["/c"])) );
+        test.pool.close();
+
+        // 3. connection lost with requests in flight: they're sent again on the other connection, not failed
+        test = new TestPool(2);
+        let a = test.get("/a");
+        test.clients[0].connect();
+        test.clients[1].connect();
+        test.get("/b");
+        test.get("/c");
+        test.clients[0].lose();
+        let retried = equals(test.inFlight(), [0, 3]) && a.attempts === 2 && test.failures.length === 0 && test.pool.getConnectionCount() === 1;
+        // only answered once everything is in: close() doesn't close connections with requests in flight
+        test.pool.close();
+        let stillOpen = !test.clients[1].closed && test.finished === 0;
+        test.clients[1].respond();
+        test.clients[1].respond();
+        test.clients[1].respond();
+        results.push( TestClientPool.check(3, "connection lost", retried && stillOpen && test.responses.length === 3 && test.finished === 1 && test.clients[1].closed) );
+
+        // 4. a request is given up on after it was sent on HTTP3_POOL_MAX_ATTEMPTS connections that were all lost
+        test = new TestPool(Constants.HTTP3_POOL_MAX_ATTEMPTS + 1);
+        let request = test.get("/a");
+        for (let client of test.clients) {
+            client.connect();
+        }
+        let lost = 0;
+        while (test.failures.length === 0 && lost < Constants.HTTP3_POOL_MAX_ATTEMPTS + 1) {
+            test.clients.filter((client: FakeClient) => client.requests.size > 0)[0].lose();
+            ++lost;
+        }
+        results.push( TestClientPool.check(4, "request gives up", lost === Constants.HTTP3_POOL_MAX_ATTEMPTS && request.attempts === Constants.HTTP3_POOL_MAX_ATTEMPTS &&
+                                                                equals(test.failures, ["/a"]) && test.finished === 1 && test.pool.getPendingRequestCount() === 0) );
+        test.pool.close();
+
+        // 5. origin down: HTTP3_POOL_MAX_ATTEMPTS connections failed before they were established, the queue is failed
+        test = new TestPool(Constants.HTTP3_POOL_MAX_ATTEMPTS);
+        test.get("/a");
+        test.get("/b");
+        for (let i = 0; i < Constants.HTTP3_POOL_MAX_ATTEMPTS - 1; ++i) {
+            test.clients[i].lose();
+        }
+        let notYet = test.failures.length === 0;
+        test.clients[Constants.HTTP3_POOL_MAX_ATTEMPTS - 1].lose();
+        results.push( TestClientPool.check(5, "origin down", notYet && equals(test.failures, ["/a", "/b"]) && test.finished === 1) );
+        test.pool.close();
+
+        // 6. after close() no connections are replaced: a lost last connection fails its requests instead of queueing them forever
+        test = new TestPool(1);
+        test.get("/a");
+        test.clients[0].connect();
+        test.pool.close();
+        test.clients[0].lose();
+        results.push( TestClientPool.check(6, "lost after close", equals(test.failures, ["/a"]) && test.finished === 1 && test.pool.getPendingRequestCount() === 0) );
+
+        // 7. the client can't even be created: requests wait for the reconnect, until close() gives up on them
+        test = new TestPool(1, true);
+        test.get("/a");
+        let queued = test.failures.length === 0 && test.pool.getConnectionCount() === 0;
+        test.pool.close();
+        results.push( TestClientPool.check(7, "connect throws", queued && equals(test.failures, ["/a"]) && test.finished === 1) );
+
+        let result = true;
+        for (let entry of results) {
+            result = result && entry;
+        }
+
+        console.log("All ClientPool testcases passed? " + result);
+        return result;
+    }
+}
+
+TestClientPool.execute();
@@ -12,6 +12,7 @@ import { LongHeader } from '../packet/header/long.header';
 import { PacketParser } from '../utilities/parsers/packet.parser';
 import { Bignum } from '../types/bignum';
 import { Time } from '../types/time';
+import { TimerWheel } from '../types/timer.wheel';
 
 export class TestHeaderParser  {
 
@@ -52,7 +53,7 @@ export class TestHeaderParser  {
             let scid = (partialResult4[0].header as LongHeader).getSrcConnectionID();
             let dcid = (partialResult4[0].header as LongHeader).getDestConnectionID();
             
-            let connection:Connection = new Connection({address: "127.0.0.1", port: 1234, family: ""}, EndpointType.Server, socket, (partialResult4[0].header as LongHeader).getDestConnectionID() );
+            let connection:Connection = new Connection({address: "127.0.0.1", port: 1234, family: ""}, EndpointType.Server, socket, (partialResult4[0].header as LongHeader).getDestConnectionID(), new TimerWheel() );
             let qtls:QTLS = new QTLS(true, {}, connection);
             let aead:AEAD = new AEAD(qtls);
 
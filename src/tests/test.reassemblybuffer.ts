@@ -0,0 +1,105 @@
+import { ReassemblyBuffer } from "../types/reassembly.buffer";
+import { Stream, StreamEvent } from "../quicker/stream";
+import { EndpointType } from "../types/endpoint.type";
+import { Bignum } from "../types/bignum";
+import { VerboseLogging } from "../utilities/logging/verbose.logging";
+
+
+export class TestReassemblyBuffer {
+
+    private static check(nr: number, description: string, result: boolean): boolean {
+        if (result)
+            VerboseLogging.info("TestReassemblyBuffer : testcase " + nr + " : " + description + " : OK");
+        else
+            VerboseLogging.error("TestReassemblyBuffer : testcase " + nr + " : " + description + " : FAILED");
+        return result;
+    }
+
+    // the part of the alphabet between the given offsets, so every byte says where it belongs
+    private static data(start: number, end: number): Buffer {
+        return Buffer.from("abcdefghijklmnopqrstuvwxyz".substring(start, end));
+    }
+
+    private static pop(buffer: ReassemblyBuffer, readOffset: number): string {
+        return Buffer.concat(buffer.popContiguous(readOffset)).toString();
+    }
+
+    public static execute(): boolean {
+        let results = new Array<boolean>();
+        let data = TestReassemblyBuffer.data;
+
+        // 1. segments with gaps in between stay apart, nothing is contiguous until the front is filled
+        let buffer = new ReassemblyBuffer();
+        let added = buffer.insert(4, data(4, 8)) + buffer.insert(12, data(12, 16));
+        let nothing = buffer.popContiguous(0).length === 0;
+        results.push( TestReassemblyBuffer.check(1, "gaps", added === 8 && nothing && buffer.getSegmentCount() === 2 && buffer.getEndOffset() === 16) );
+
+        // 2. overlapping both neighbours: only the bytes in the gaps are added
+        added = buffer.insert(2, data(2, 14));
+        results.push( TestReassemblyBuffer.check(2, "overlap", added === 6 && buffer.getByteLength() === 14 && TestReassemblyBuffer.pop(buffer, 2) === data(2, 16).toString() && buffer.isEmpty()) );
+
+        // 3. data that's contained in what we have (or is an exact duplicate) adds nothing
+        buffer = new ReassemblyBuffer();
+        buffer.insert(4, data(4, 12));
+        let contained = buffer.insert(6, data(6, 10));
+        let duplicate = buffer.insert(4, data(4, 12));
+        results.push( TestReassemblyBuffer.check(3, "contained and duplicate", contained === 0 && duplicate === 0 && buffer.getSegmentCount() === 1 && buffer.getByteLength() === 8) );
+
+        // 4. a segment that contains several smaller ones: they're kept, the new data fills the holes around them
+        buffer = new ReassemblyBuffer();
+        buffer.insert(3, data(3, 5));
+        buffer.insert(8, data(8, 9));
+        added = buffer.insert(1, data(1, 12));
+        results.push( TestReassemblyBuffer.check(4, "containing", added === 8 && buffer.getByteLength() === 11 && TestReassemblyBuffer.pop(buffer, 1) === data(1, 12).toString()) );
+
+        // 5. data below the read offset is dropped, a segment straddling it is trimmed
+        buffer = new ReassemblyBuffer();
+        buffer.insert(2, data(2, 6));
+        buffer.insert(6, data(6, 10));
+        results.push( TestReassemblyBuffer.check(5, "trim below read offset", TestReassemblyBuffer.pop(buffer, 8) === data(8, 10).toString() && buffer.isEmpty() && buffer.getByteLength() === 0) );
+
+        // 6. out-of-order fill-in: every order of arrival gives the same result
+        let orders = [[0, 1, 2, 3], [3, 2, 1, 0], [2, 0, 3, 1], [1, 3, 0, 2]];
+        let inOrder = true;
+        for (let order of orders) {
+            buffer = new ReassemblyBuffer();
+            let output = "";
+            let readOffset = 0;
+            for (let piece of order) {
+                buffer.insert(piece * 5, data(piece * 5, piece * 5 + 5));
+                let popped = TestReassemblyBuffer.pop(buffer, readOffset);
+                output += popped;
+                readOffset += popped.length;
+            }
+            inOrder = inOrder && output === data(0, 20).toString() && buffer.isEmpty();
+        }
+        results.push( TestReassemblyBuffer.check(6, "out-of-order fill-in", inOrder) );
+
+        // 7. Stream: a retransmitted prefix that overlaps data we already delivered, and an overlapping out-of-order segment
+        let stream = new Stream(EndpointType.Server, new Bignum(4));
+        let received = "";
+        let ended = false;
+        stream.on(StreamEvent.DATA, (chunk: Buffer) => {
+            received += chunk.toString();
+        });
+        stream.on(StreamEvent.END, () => {
+            ended = true;
+        });
+        stream.receiveData(data(0, 6), new Bignum(0), false);
+        stream.receiveData(data(10, 16), new Bignum(10), true);
+        stream.receiveData(data(8, 12), new Bignum(8), false); // overlaps the buffered segment
+        stream.receiveData(data(0, 9), new Bignum(0), false); // retransmitted prefix, only 6-9 is new
+        stream.receiveData(data(2, 5), new Bignum(2), false); // completely delivered already
+        results.push( TestReassemblyBuffer.check(7, "stream retransmits", received === data(0, 16).toString() && ended && stream.getBufferSpaceUsed() === 0) );
+
+        let result = true;
+        for (let entry of results) {
+            result = result && entry;
+        }
+
+        console.log("All ReassemblyBuffer testcases passed? " + result);
+        return result;
+    }
+}
+
+TestReassemblyBuffer.execute();
@@ -0,0 +1,96 @@
+import { Http3ResourceParser, Http3ResourceParserEvent } from "../http/http3/common/parsers/http3.resource.parser";
+import { VerboseLogging } from "../utilities/logging/verbose.logging";
+
+
+export class TestResourceParser {
+
+    private static check(nr: number, description: string, result: boolean): boolean {
+        if (result)
+            VerboseLogging.info("TestResourceParser : testcase " + nr + " : " + description + " : OK");
+        else
+            VerboseLogging.error("TestResourceParser : testcase " + nr + " : " + description + " : FAILED");
+        return result;
+    }
+
+    // Feeds the document in chunks of chunkSize bytes, returns what was found in order
+    private static parse(document: string, mimeType: string, chunkSize: number, documentPath?: string): string[] {
+        let found = new Array<string>();
+        let parser = new Http3ResourceParser();
+        parser.on(Http3ResourceParserEvent.FILES_FOUND, (files: string[]) => {
+            found = found.concat(files);
+        });
+        let buffer = Buffer.from(document, "utf8");
+        parser.startDocument(mimeType, documentPath);
+        for (let offset = 0; offset < buffer.byteLength; offset += chunkSize) {
+            parser.parseChunk(buffer.slice(offset, offset + chunkSize));
+        }
+        parser.end();
+        return found;
+    }
+
+    public static execute(): boolean {
+        let results = new Array<boolean>();
+
+        let html = "<!doctype html>\n<html><head>\n" +
+                   "<link rel=\"stylesheet\" href=\"style.css\"><LINK HREF='/print.css' media=print>\n" +
+                   "<!-- <img src=\"commented.png\"> -->\n" +
+                   "<script src=\"/app.js\"></script><script>if (a<b) { document.write('<img src=\"inline.png\">'); }</script>\n" +
+                   "</head><body><a href=\"/other.html\">link</a> 1 < 2\n" +
+                   "<img alt=\"x\" src=images/ünïcode.png><img src=\"https://example.com/ad.png\"><img src=\"/app.js\">\n" +
+                   "<iframe src=\"/frame.html#top\"/></body></html>";
+        let expected = ["/style.css", "/print.css", "/app.js", "/images/ünïcode.png", "/frame.html"];
+
+        // 1. whole document at once
+        let found = TestResourceParser.parse(html, "text/html; charset=utf-8", html.length * 4, "/index.html");
+        results.push( TestResourceParser.check(1, "html", JSON.stringify(found) === JSON.stringify(expected)) );
+
+        // 2. every possible split: same result
+        let splits = true;
+        for (let chunkSize = 1; chunkSize < 40; ++chunkSize) {
+            splits = splits && JSON.stringify(TestResourceParser.parse(html, "text/html", chunkSize, "/index.html")) === JSON.stringify(expected);
+        }
+        results.push( TestResourceParser.check(2, "chunked html", splits) );
+
+        // 3. resources are found as soon as their attribute is complete
+        let parser = new Http3ResourceParser();
+        let early = new Array<string>();
+        parser.on(Http3ResourceParserEvent.FILES_FOUND, (files: string[]) => {
+            early = early.concat(files);
+        });
+        parser.startDocument("text/html");
+        parser.parseChunk(Buffer.from("<html><img src=\"/first.png\"><p>lots of text"));
+        let foundEarly = early.length === 1 && early[0] === "/first.png";
+        parser.parseChunk(Buffer.from("</p><img src=\"/second.png\"></html>"));
+        parser.end();
+        results.push( TestResourceParser.check(3, "early discovery", foundEarly && early.length === 2) );
+
+        // 4. javascript: only src assignments
+        let js = "var srcConnectionID = 1;\nimg.src = \"/footer_img.gif\";\nif (x.src == y) {}\nother.src='lib.js';";
+        found = TestResourceParser.parse(js, "application/javascript", 3, "/app.js");
+        results.push( TestResourceParser.check(4, "javascript", JSON.stringify(found) === JSON.stringify(["/footer_img.gif", "/lib.js"])) );
+
+        // 5. other types are ignored
+        found = TestResourceParser.parse("<img src=\"/a.png\">", "text/plain", 100);
+        results.push( TestResourceParser.check(5, "other mime types", found.length === 0) );
+
+        // 6. relative paths are resolved against the document's directory, never above the root
+        let nested = "<link rel=stylesheet href=\"../style.css\"><img src=\"img/a.png\"><script src=\"./b.js\"></script>" +
+                     "<img src=\"/abs/./c.png\"><img src=\"../../../../d.png\"><img src=\"e.png?v=2\">";
+        found = TestResourceParser.parse(nested, "text/html", 7, "/docs/guide/index.html?lang=en");
+        results.push( TestResourceParser.check(6, "relative paths", JSON.stringify(found) === JSON.stringify(["/docs/style.css", "/docs/guide/img/a.png", "/docs/guide/b.js", "/abs/c.png", "/d.png", "/docs/guide/e.png?v=2"])) );
+
+        // 7. without the document's path, they're reported as written (e.g., the static cache, which doesn't know the request path)
+        found = TestResourceParser.parse(nested, "text/html", 100);
+        results.push( TestResourceParser.check(7, "unresolved paths", JSON.stringify(found) === JSON.stringify(["../style.css", "img/a.png", "./b.js", "/abs/./c.png", "../../../../d.png", "e.png?v=2"])) );
+
+        let result = true;
+        for (let entry of results) {
+            result = result && entry;
+        }
+
+        console.log("All ResourceParser testcases passed? " + result);
+        return result;
+    }
+}
+
+TestResourceParser.execute();
@@ -0,0 +1,94 @@
+import { TimerWheel, WheelTimer } from "../types/timer.wheel";
+import { Time, TimeFormat } from "../types/time";
+import { VerboseLogging } from "../utilities/logging/verbose.logging";
+
+
+export class TestTimerWheel {
+
+    private static check(nr: number, description: string, result: boolean): boolean {
+        if (result)
+            VerboseLogging.info("TestTimerWheel : testcase " + nr + " : " + description + " : OK");
+        else
+            VerboseLogging.error("TestTimerWheel : testcase " + nr + " : " + description + " : FAILED");
+        return result;
+    }
+
+    // The wheel runs on real time, so every timer is armed at the start and the results are checked once the last one should have fired
+    public static execute(): Promise<boolean> {
+        let wheel = new TimerWheel();
+        let start = Time.now();
+        let elapsed = () => Time.now(start).format(TimeFormat.MilliSeconds);
+
+        // name and time (ms since start) of every timer that fired, in order
+        let fired = new Array<[string, number]>();
+        let create = (name: string) => {
+            return wheel.createTimer((timer: WheelTimer) => {
+                fired.push([name, elapsed()]);
+            });
+        };
+        let firedTimes = (name: string) => fired.filter((entry: [string, number]) => entry[0] === name).map((entry: [string, number]) => entry[1]);
+
+        // 1. + 2. armed out of order: fired in order of expiry, never early
+        create("c").start(30);
+        create("a").start(10);
+        create("b").start(20);
+
+        // 3. cancelled: never fires
+        let cancelled = create("cancelled");
+        cancelled.start(15);
+        let countBeforeCancel = wheel.getTimerCount();
+        cancelled.cancel();
+        let countAfterCancel = wheel.getTimerCount();
+
+        // 4. re-armed before it fired: only the last one counts
+        let rearmed = create("rearmed");
+        rearmed.start(5);
+        rearmed.start(40);
+
+        // 5. beyond one revolution of the lowest level (64 ticks of 1ms): these go through the higher levels and are cascaded down
+        create("far").start(150);
+        create("farther").start(300);
+
+        // 6. re-armed from its own callback
+        let periodicCount = 0;
+        let periodic = wheel.createTimer((timer: WheelTimer) => {
+            fired.push(["periodic", elapsed()]);
+            if (++periodicCount < 3) {
+                timer.start(10);
+            }
+        });
+        periodic.start(10);
+
+        return new Promise<boolean>((resolve) => {
+            setTimeout(() => {
+                let results = new Array<boolean>();
+
+                let order = fired.filter((entry: [string, number]) => ["a", "b", "c", "rearmed", "far", "farther"].indexOf(entry[0]) >= 0).map((entry: [string, number]) => entry[0]);
+                results.push( TestTimerWheel.check(1, "firing order", JSON.stringify(order) === JSON.stringify(["a", "b", "c", "rearmed", "far", "farther"])) );
+
+                let notEarly = firedTimes("a")[0] >= 10 && firedTimes("b")[0] >= 20 && firedTimes("c")[0] >= 30;
+                results.push( TestTimerWheel.check(2, "scheduling", notEarly) );
+
+                results.push( TestTimerWheel.check(3, "cancel", firedTimes("cancelled").length === 0 && countAfterCancel === countBeforeCancel - 1) );
+
+                results.push( TestTimerWheel.check(4, "re-arm", firedTimes("rearmed").length === 1 && firedTimes("rearmed")[0] >= 40) );
+
+                results.push( TestTimerWheel.check(5, "beyond one revolution", firedTimes("far").length === 1 && firedTimes("far")[0] >= 150 &&
+                                                                              firedTimes("farther").length === 1 && firedTimes("farther")[0] >= 300) );
+
+                let periodicTimes = firedTimes("periodic");
+                results.push( TestTimerWheel.check(6, "re-arm from callback", periodicTimes.length === 3 && periodicTimes[2] >= 30 && wheel.getTimerCount() === 0) );
+
+                let result = true;
+                for (let entry of results) {
+                    result = result && entry;
+                }
+
+                console.log("All TimerWheel testcases passed? " + result);
+                resolve(result);
+            }, 400);
+        });
+    }
+}
+
+TestTimerWheel.execute();
@@ -1,40 +1,38 @@
 import { EventEmitter } from "events";
-import { clearTimeout } from "timers";
+import { TimerWheel, WheelTimer } from "./timer.wheel";
 
 
+// Alarms are backed by a reusable timer on the endpoint's TimerWheel instead of having their own NodeJS timer
+// Listeners are registered once (typically in the owner's constructor): reset() only cancels the alarm and keeps the listeners,
+// so re-arming an alarm doesn't allocate anything
 export class Alarm extends EventEmitter {
 
-    private timer!: NodeJS.Timer;
-    private running: boolean;
+    private timer: WheelTimer;
     private duration:number;
 
-    public constructor() {
+    public constructor(timerWheel: TimerWheel) {
         super();
-        this.running = false;
         this.duration = 0;
+        this.timer = timerWheel.createTimer(() => {
+            this.onTimeout(this.duration);
+        });
     }
 
     public reset() {
-        clearTimeout(this.timer);
-        this.removeAllListeners();
-        this.running = false;
+        this.timer.cancel();
     }
 
     public start(timeInMs: number) {
-        this.running = true;
         this.duration = timeInMs;
-        this.timer = global.setTimeout(() => {
-            this.onTimeout(this.duration);
-        }, this.duration);
+        this.timer.start(timeInMs);
     }
 
     private onTimeout(timePassed:number) {
-        this.running = false;
         this.emit(AlarmEvent.TIMEOUT, timePassed);
     }
 
     public isRunning(): boolean {
-        return this.running;
+        return this.timer.isRunning();
     }
 
     public getDuration(): number{
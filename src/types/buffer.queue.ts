@@ -0,0 +1,119 @@
+
+// Queue of Buffers to be sent, used instead of a single Buffer that is Buffer.concat'ed on every write and re-sliced on every read
+// (which is quadratic in the amount of copying for large transfers)
+// We only keep references to the Buffers we're given: callers should not modify them after handing them over
+// Reading is zero-copy: peek() and consume() return slices of the original Buffers (a "scatter list")
+// Only consumeBuffer() copies, and only if the requested range spans more than one of the original Buffers
+export class BufferQueue {
+
+    private chunks: Buffer[];
+    // index of the first chunk that still holds data. Consumed chunks before it are cleaned up lazily, so consume() doesn't have to shift() the array every time
+    private head: number;
+    // amount of bytes already consumed from the first chunk
+    private headOffset: number;
+    private byteLength: number;
+
+    public constructor() {
+        this.chunks = [];
+        this.head = 0;
+        this.headOffset = 0;
+        this.byteLength = 0;
+    }
+
+    public push(data: Buffer): void {
+        if (data.byteLength === 0) {
+            return;
+        }
+        this.chunks.push(data);
+        this.byteLength += data.byteLength;
+    }
+
+    public getByteLength(): number {
+        return this.byteLength;
+    }
+
+    public isEmpty(): boolean {
+        return this.byteLength === 0;
+    }
+
+    /**
+     * Returns (at most) the first size bytes, without removing them, as a list of slices of the queued Buffers
+     */
+    public peek(size: number = this.byteLength): Buffer[] {
+        return this.collect(size, false);
+    }
+
+    /**
+     * Removes (at most) the first size bytes and returns them as a list of slices of the queued Buffers
+     */
+    public consume(size: number = this.byteLength): Buffer[] {
+        return this.collect(size, true);
+    }
+
+    /**
+     * Same as consume(), but returns a single Buffer. This only copies if the data spans more than one queued Buffer
+     */
+    public consumeBuffer(size: number = this.byteLength): Buffer {
+        let slices = this.consume(size);
+        if (slices.length === 0) {
+            return Buffer.alloc(0);
+        }
+        if (slices.length === 1) {
+            return slices[0];
+        }
+        return Buffer.concat(slices);
+    }
+
+    public clear(): void {
+        this.chunks = [];
+        this.head = 0;
+        this.headOffset = 0;
+        this.byteLength = 0;
+    }
+
+    private collect(size: number, remove: boolean): Buffer[] {
+        let output = new Array<Buffer>();
+        let total = Math.min(Math.max(size, 0), this.byteLength);
+        let left = total;
+
+        let index = this.head;
+        let offset = this.headOffset;
+        while (left > 0) {
+            let chunk = this.chunks[index];
+            let available = chunk.byteLength - offset;
+            let taken = Math.min(available, left);
+
+            output.push( (offset === 0 && taken === chunk.byteLength) ? chunk : chunk.slice(offset, offset + taken) );
+            left -= taken;
+
+            if (taken === available) {
+                index++;
+                offset = 0;
+            }
+            else {
+                offset += taken;
+            }
+        }
+
+        if (remove) {
+            for (let i = this.head; i < index; ++i) {
+                this.chunks[i] = <any> undefined; // let the GC have them as soon as possible
+            }
+            this.head = index;
+            this.headOffset = offset;
+            this.byteLength -= total;
+
+            // compact once the consumed part makes up at least half of the array, so the array doesn't keep growing on long-lived streams
+            if (this.head === this.chunks.length) {
+                this.chunks = [];
+                this.head = 0;
+            }
+            else if (this.head > 32 && this.head * 2 > this.chunks.length) {
+                this.chunks = this.chunks.slice(this.head);
+                this.head = 0;
+            }
+        }
+
+        return output;
+    }
+}
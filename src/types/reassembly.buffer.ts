@@ -0,0 +1,144 @@
+
+// Receive-side buffer for data that arrives out of order (e.g., STREAM or CRYPTO frames after loss or reordering)
+// Data is kept as a list of non-overlapping segments, sorted on offset: overlaps with data we already have are trimmed when inserting,
+// so every byte is stored only once and a segment never has to be split or re-sorted later on
+// Finding the insert position is a binary search, and in the common case (data arriving in order after a gap) it's simply appended at the end
+// Offsets are plain numbers instead of Bignums: they are compared a lot here and stream offsets won't go beyond 2^53 in practice
+export class ReassemblyBuffer {
+
+    private segments: Array<ReassemblySegment>;
+    private byteLength: number;
+
+    public constructor() {
+        this.segments = new Array<ReassemblySegment>();
+        this.byteLength = 0;
+    }
+
+    /**
+     * Stores the data, minus the parts that are already buffered
+     * @returns the amount of bytes that were actually added
+     */
+    public insert(offset: number, data: Buffer): number {
+        let start = offset;
+        let end = offset + data.byteLength;
+        if (start === end) {
+            return 0;
+        }
+
+        let first = this.findFirstEndingAfter(start);
+        let merged = new Array<ReassemblySegment>();
+        let cursor = start;
+        let added = 0;
+
+        let index = first;
+        while (index < this.segments.length && this.segments[index].offset < end) {
+            let segment = this.segments[index];
+            if (segment.offset > cursor) {
+                // gap before this segment: that part of the new data is really new
+                merged.push({ offset: cursor, data: data.slice(cursor - start, segment.offset - start) });
+                added += segment.offset - cursor;
+            }
+            merged.push(segment);
+            cursor = Math.max(cursor, segment.offset + segment.data.byteLength);
+            index++;
+        }
+        if (cursor < end) {
+            merged.push({ offset: cursor, data: data.slice(cursor - start) });
+            added += end - cursor;
+        }
+
+        if (added === 0) {
+            return 0;
+        }
+
+        if (first === this.segments.length) {
+            // appending at the end, no need to splice
+            for (let segment of merged) {
+                this.segments.push(segment);
+            }
+        }
+        else {
+            this.segments.splice(first, index - first, ...merged);
+        }
+        this.byteLength += added;
+        return added;
+    }
+
+    /**
+     * Removes and returns all data that is contiguous starting from readOffset, in order
+     * Data below readOffset (already delivered through other means) is discarded
+     */
+    public popContiguous(readOffset: number): Buffer[] {
+        let output = new Array<Buffer>();
+        let cursor = readOffset;
+        let count = 0;
+
+        while (count < this.segments.length) {
+            let segment = this.segments[count];
+            if (segment.offset > cursor) {
+                break;
+            }
+
+            let segmentEnd = segment.offset + segment.data.byteLength;
+            if (segmentEnd > cursor) {
+                output.push( (segment.offset === cursor) ? segment.data : segment.data.slice(cursor - segment.offset) );
+                cursor = segmentEnd;
+            }
+            this.byteLength -= segment.data.byteLength;
+            count++;
+        }
+
+        if (count > 0) {
+            this.segments.splice(0, count);
+        }
+        return output;
+    }
+
+    // offset right after the last byte we have buffered, or -1 if we have nothing
+    public getEndOffset(): number {
+        if (this.segments.length === 0) {
+            return -1;
+        }
+        let last = this.segments[this.segments.length - 1];
+        return last.offset + last.data.byteLength;
+    }
+
+    public getByteLength(): number {
+        return this.byteLength;
+    }
+
+    public getSegmentCount(): number {
+        return this.segments.length;
+    }
+
+    public isEmpty(): boolean {
+        return this.segments.length === 0;
+    }
+
+    public clear(): void {
+        this.segments = new Array<ReassemblySegment>();
+        this.byteLength = 0;
+    }
+
+    // index of the first segment whose data ends after the given offset (segments are disjoint, so their ends are sorted as well)
+    private findFirstEndingAfter(offset: number): number {
+        let low = 0;
+        let high = this.segments.length;
+        while (low < high) {
+            let middle = (low + high) >>> 1;
+            let segment = this.segments[middle];
+            if (segment.offset + segment.data.byteLength <= offset) {
+                low = middle + 1;
+            }
+            else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+}
+
+interface ReassemblySegment {
+    offset: number,
+    data: Buffer
+}
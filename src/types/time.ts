@@ -10,23 +10,20 @@ export class Time {
     }
 
     public format(format: TimeFormat) {
-        var secondsFormat = 1e12;
         var nanoFormat = 1;
         switch (format) {
             case TimeFormat.MicroSeconds:
-                secondsFormat = 1e6;
                 nanoFormat = 1e3;
                 break;
             case TimeFormat.MilliSeconds:
-                secondsFormat = 1e3;
                 nanoFormat = 1e6;
                 break;
             case TimeFormat.Seconds:
-                secondsFormat = 1;
                 nanoFormat = 1e9;
                 break;
         }
-        return (this.timeTuple[0] * secondsFormat + this.timeTuple[1]) / nanoFormat;
+        // timeTuple is [seconds, nanoseconds], so the seconds part always needs to be expressed in nanoseconds first
+        return (this.timeTuple[0] * 1e9 + this.timeTuple[1]) / nanoFormat;
     }
 
     public static now(diffTime?: Time): Time {
@@ -0,0 +1,319 @@
+import { Time, TimeFormat } from "./time";
+
+
+// Hierarchical timing wheel (Varghese & Lauck, as used in the Linux kernel)
+// Instead of giving every Alarm its own NodeJS timer, all timers of an endpoint are kept in a single wheel
+// that is driven by exactly one underlying setTimeout, armed for the earliest slot that has work in it.
+// Arming and cancelling a timer are O(1): a timer is simply linked into (or out of) the slot matching its expiry.
+//
+// Layout: LEVELS levels of SLOTS slots each. Level 0 has a resolution of 1 tick, level n a resolution of SLOTS^n ticks.
+// Timers that are far in the future are put in a higher level, and are "cascaded" down to a lower level
+// when the wheel reaches the start of their slot, until they end up in level 0, from which they are fired.
+// With 1ms ticks, 4 levels of 64 slots cover ~4.6 hours. Timers further away are parked in the top level and re-cascaded as needed.
+export class TimerWheel {
+
+    private static readonly LEVEL_BITS: number = 6;
+    private static readonly SLOTS: number = 1 << TimerWheel.LEVEL_BITS;
+    private static readonly SLOT_MASK: number = TimerWheel.SLOTS - 1;
+    private static readonly LEVELS: number = 4;
+    private static readonly MAX_RANGE: number = Math.pow(TimerWheel.SLOTS, TimerWheel.LEVELS) - 1;
+
+    private tickDuration: number; // in ms
+    private startTime: Time;
+
+    private levels: Array<Array<TimerSlot>>;
+    private levelCounts: Array<number>;
+    private count: number;
+
+    // all ticks < currentTick have been processed
+    private currentTick: number;
+
+    private nodeTimer?: NodeJS.Timer;
+    private scheduledTick: number;
+    private onNodeTimerFired: () => void; // bound once, so re-arming the NodeJS timer doesn't allocate a new closure
+
+    public constructor(tickDuration: number = 1) {
+        this.tickDuration = tickDuration;
+        this.startTime = Time.now();
+        this.currentTick = 0;
+        this.count = 0;
+        this.scheduledTick = Infinity;
+
+        this.levels = new Array<Array<TimerSlot>>();
+        this.levelCounts = new Array<number>();
+        for (let level = 0; level < TimerWheel.LEVELS; ++level) {
+            let slots = new Array<TimerSlot>();
+            for (let slot = 0; slot < TimerWheel.SLOTS; ++slot) {
+                slots.push(new TimerSlot(level));
+            }
+            this.levels.push(slots);
+            this.levelCounts.push(0);
+        }
+
+        this.onNodeTimerFired = () => {
+            this.nodeTimer = undefined;
+            this.scheduledTick = Infinity;
+            this.advance(this.getNowTick());
+            this.scheduleNext();
+        };
+    }
+
+    /**
+     * Creates a reusable timer handle. The callback is fixed for the lifetime of the handle,
+     * so it can be (re-)armed as often as needed without allocating anything new.
+     */
+    public createTimer(callback: (timer: WheelTimer) => void): WheelTimer {
+        return new WheelTimer(this, callback);
+    }
+
+    public getTimerCount(): number {
+        return this.count;
+    }
+
+    // internal: used by WheelTimer.start()
+    public arm(timer: WheelTimer, timeInMs: number): void {
+        if (timer.isRunning()) {
+            this.cancel(timer);
+        }
+
+        let nowMs = Time.now(this.startTime).format(TimeFormat.MilliSeconds);
+        let nowTick = Math.floor(nowMs / this.tickDuration);
+        if (this.count === 0 && nowTick > this.currentTick) {
+            // nothing pending: we can simply fast-forward the wheel without processing any of the intermediate ticks
+            this.currentTick = nowTick;
+        }
+
+        // never early: due at the first tick that starts at or after now + timeInMs. Counting from the start of the current tick instead
+        // would make it fire up to a tick too soon. A timer of 0ms fires on the next run of the wheel
+        timer.expiry = (timeInMs <= 0) ? nowTick : Math.ceil((nowMs + timeInMs) / this.tickDuration);
+        this.insert(timer);
+        this.count++;
+    }
+
+    // internal: used by WheelTimer.cancel()
+    public cancel(timer: WheelTimer): void {
+        let slot = timer.slot;
+        if (slot === undefined) {
+            return;
+        }
+
+        this.unlink(timer);
+        this.count--;
+        // NOTE: we do not re-arm the NodeJS timer here: if it fires for nothing, we just look for the next non-empty slot
+    }
+
+    private insert(timer: WheelTimer): void {
+        if (timer.expiry < this.currentTick) {
+            timer.expiry = this.currentTick;
+        }
+
+        let delta = timer.expiry - this.currentTick;
+        let placement = timer.expiry;
+        if (delta > TimerWheel.MAX_RANGE) {
+            // out of range: park it as far as we can, it will be re-inserted when cascaded
+            delta = TimerWheel.MAX_RANGE;
+            placement = this.currentTick + TimerWheel.MAX_RANGE;
+        }
+
+        let level = 0;
+        while (level < TimerWheel.LEVELS - 1 && delta >= Math.pow(TimerWheel.SLOTS, level + 1)) {
+            level++;
+        }
+
+        let shift = TimerWheel.LEVEL_BITS * level;
+        let slot = this.levels[level][Math.floor(placement / Math.pow(2, shift)) & TimerWheel.SLOT_MASK];
+
+        timer.next = slot.first;
+        timer.prev = undefined;
+        if (slot.first !== undefined) {
+            slot.first.prev = timer;
+        }
+        slot.first = timer;
+        timer.slot = slot;
+        this.levelCounts[level]++;
+
+        // level 0 timers are due at their expiry, higher levels need a wake-up when their slot starts, so they can be cascaded
+        let dueTick = (level === 0) ? placement : Math.floor(placement / Math.pow(2, shift)) * Math.pow(2, shift);
+        this.schedule(dueTick);
+    }
+
+    private unlink(timer: WheelTimer): void {
+        let slot = timer.slot!;
+
+        if (timer.prev !== undefined) {
+            timer.prev.next = timer.next;
+        }
+        else {
+            slot.first = timer.next;
+        }
+        if (timer.next !== undefined) {
+            timer.next.prev = timer.prev;
+        }
+
+        this.levelCounts[slot.level]--;
+        timer.prev = undefined;
+        timer.next = undefined;
+        timer.slot = undefined;
+    }
+
+    private detachSlot(slot: TimerSlot): WheelTimer | undefined {
+        let first = slot.first;
+        slot.first = undefined;
+
+        let timer = first;
+        while (timer !== undefined) {
+            timer.slot = undefined;
+            this.levelCounts[slot.level]--;
+            timer = timer.next;
+        }
+        return first;
+    }
+
+    private advance(targetTick: number): void {
+        while (this.currentTick <= targetTick) {
+            if (this.count === 0) {
+                this.currentTick = targetTick + 1;
+                return;
+            }
+
+            let tick = this.currentTick;
+
+            // skip stretches in which nothing can happen: if the lower levels are empty, the next thing to do is a cascade of the lowest non-empty level
+            if (this.levelCounts[0] === 0) {
+                let level = 1;
+                while (level < TimerWheel.LEVELS - 1 && this.levelCounts[level] === 0) {
+                    level++;
+                }
+                let resolution = Math.pow(TimerWheel.SLOTS, level);
+                let nextBoundary = Math.ceil(tick / resolution) * resolution;
+                if (nextBoundary > targetTick) {
+                    this.currentTick = targetTick + 1;
+                    return;
+                }
+                tick = nextBoundary;
+                this.currentTick = tick;
+            }
+
+            // cascade higher levels whose slot starts at this tick
+            for (let level = 1; level < TimerWheel.LEVELS; ++level) {
+                let resolution = Math.pow(TimerWheel.SLOTS, level);
+                if (tick % resolution !== 0) {
+                    break;
+                }
+                let slot = this.levels[level][Math.floor(tick / resolution) & TimerWheel.SLOT_MASK];
+                let timer = this.detachSlot(slot);
+                while (timer !== undefined) {
+                    let next = timer.next;
+                    timer.next = undefined;
+                    timer.prev = undefined;
+                    this.insert(timer);
+                    timer = next;
+                }
+            }
+
+            // move the wheel before firing, so timers that are re-armed from their callbacks end up in a future slot
+            this.currentTick = tick + 1;
+
+            let expired = this.detachSlot(this.levels[0][tick & TimerWheel.SLOT_MASK]);
+            while (expired !== undefined) {
+                let next = expired.next;
+                expired.next = undefined;
+                expired.prev = undefined;
+                this.count--;
+                expired.fire();
+                expired = next;
+            }
+        }
+    }
+
+    private scheduleNext(): void {
+        if (this.count === 0) {
+            return;
+        }
+
+        let earliest = Infinity;
+        for (let level = 0; level < TimerWheel.LEVELS; ++level) {
+            if (this.levelCounts[level] === 0) {
+                continue;
+            }
+
+            let resolution = Math.pow(TimerWheel.SLOTS, level);
+            // level 0 timers are always in [currentTick, currentTick + SLOTS[
+            // for higher levels, everything up to and including the block of the last processed tick has already been cascaded
+            let block = (level === 0) ? this.currentTick : Math.floor((this.currentTick - 1) / resolution);
+            let start = (level === 0) ? 0 : 1;
+            for (let i = start; i < start + TimerWheel.SLOTS; ++i) {
+                if (this.levels[level][(block + i) & TimerWheel.SLOT_MASK].first !== undefined) {
+                    earliest = Math.min(earliest, (block + i) * resolution);
+                    break;
+                }
+            }
+        }
+
+        this.schedule(earliest);
+    }
+
+    private schedule(tick: number): void {
+        if (tick >= this.scheduledTick || tick === Infinity) {
+            return;
+        }
+
+        if (this.nodeTimer !== undefined) {
+            global.clearTimeout(this.nodeTimer);
+        }
+
+        let delay = Math.max(0, tick * this.tickDuration - Time.now(this.startTime).format(TimeFormat.MilliSeconds));
+        this.scheduledTick = tick;
+        this.nodeTimer = global.setTimeout(this.onNodeTimerFired, delay);
+    }
+
+    private getNowTick(): number {
+        return Math.floor(Time.now(this.startTime).format(TimeFormat.MilliSeconds) / this.tickDuration);
+    }
+}
+
+export class TimerSlot {
+    public first?: WheelTimer;
+    public readonly level: number;
+
+    public constructor(level: number) {
+        this.level = level;
+    }
+}
+
+/**
+ * Reusable timer handle, created through TimerWheel.createTimer()
+ * Fields are public for the wheel's benefit only (intrusive doubly linked list per slot), don't touch them from the outside
+ */
+export class WheelTimer {
+
+    public expiry: number;
+    public prev?: WheelTimer;
+    public next?: WheelTimer;
+    public slot?: TimerSlot;
+
+    private wheel: TimerWheel;
+    private callback: (timer: WheelTimer) => void;
+
+    public constructor(wheel: TimerWheel, callback: (timer: WheelTimer) => void) {
+        this.wheel = wheel;
+        this.callback = callback;
+        this.expiry = 0;
+    }
+
+    public start(timeInMs: number): void {
+        this.wheel.arm(this, timeInMs);
+    }
+
+    public cancel(): void {
+        this.wheel.cancel(this);
+    }
+
+    public isRunning(): boolean {
+        return this.slot !== undefined;
+    }
+
+    public fire(): void {
+        this.callback(this);
+    }
+}
@@ -6,8 +6,38 @@ import { Buffer } from "buffer";
  */
 export class VLIE {
 
-    public static getEncodedByteLength(bignum: Bignum) {
-        return 2 ** this.getBytesNeeded(bignum);
+    static getEncodedByteLength(bignum: Bignum): number;
+    static getEncodedByteLength(num: number): number;
+    public static getEncodedByteLength(value: any): number {
+        if (value instanceof Bignum) {
+            return 2 ** this.getBytesNeeded(value);
+        }
+        return 2 ** this.getBytesNeededNumber(value);
+    }
+
+    /**
+     * Writes the encoded value directly into buffer at offset, instead of allocating a new Buffer like encode() does
+     * Returns the offset right after the encoded value 
+     */
+    static encodeInto(bignum: Bignum, buffer: Buffer, offset: number): number;
+    static encodeInto(num: number, buffer: Buffer, offset: number): number;
+    public static encodeInto(value: any, buffer: Buffer, offset: number): number {
+        let count = (value instanceof Bignum) ? this.getBytesNeeded(value) : this.getBytesNeededNumber(value);
+        let length = 2 ** count;
+
+        if (length <= 4) {
+            // always fits in a JS number, no need for Bignum arithmetic
+            let num = (value instanceof Bignum) ? value.toNumber() : value;
+            buffer.writeUIntBE(num, offset, length);
+        }
+        else {
+            let bignum = (value instanceof Bignum) ? value : new Bignum(value);
+            bignum.toBuffer(length).copy(buffer, offset);
+        }
+        // the 2 most significant bits hold the length
+        buffer.writeUInt8(buffer.readUInt8(offset) | (count << 6), offset);
+
+        return offset + length;
     }
 
     static encode(bignum: Bignum): Buffer;
@@ -155,6 +185,19 @@ export class VLIE {
         return 3;
     }
 
+    private static getBytesNeededNumber(num: number): number {
+        if (num < 0x40) {
+            return 0;
+        }
+        if (num < 0x4000) {
+            return 1;
+        }
+        if (num < 0x40000000) {
+            return 2;
+        }
+        return 3;
+    }
+
     /*
     public static getBytesNeededPn(bignum: Bignum): number {
         // getBytesNeeded would return 2 when size is bit
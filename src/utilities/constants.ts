@@ -64,18 +64,38 @@ export class Constants {
     public static readonly DEFAULT_MAX_STREAM_SERVER_BIDI = 12;
     public static readonly DEFAULT_MAX_STREAM_CLIENT_UNI = 12;
     public static readonly DEFAULT_MAX_STREAM_SERVER_UNI = 12;
-    public static readonly DEFAULT_MAX_STREAM_DATA = 50000 * 1024;
-    public static readonly DEFAULT_MAX_DATA = 50000 * 1024; // TODO: we have a bug in our connection-level flow control, that's why this is so big. See issue #70
+    // these are the initial receive windows: they are auto-tuned up to MAX_STREAM_RECEIVE_WINDOW and MAX_CONNECTION_RECEIVE_WINDOW (see FlowControlledObject)
+    public static readonly DEFAULT_MAX_STREAM_DATA = 256 * 1024;
+    public static readonly DEFAULT_MAX_DATA = 384 * 1024;
     public static readonly DEFAULT_ACK_DELAY_EXPONENT = 3;
     public static readonly DEFAULT_MAX_ACK_DELAY = 25; // ms
+    public static readonly DEFAULT_MIN_ACK_DELAY = 1000; // MICROseconds, only advertised if ACK_FREQUENCY_ENABLED
     public static readonly DEFAULT_IDLE_TIMEOUT = 10;
     public static readonly DEFAULT_MAX_PACKET_SIZE = 1400;//65527;
 
     public static readonly DEFAULT_DISABLE_MIGRATION = false;
     public static readonly DEFAULT_ACTIVE_CONNECTION_ID_LIMIT = 0;
 
-    public static readonly DEFAULT_MAX_STREAM_ID_INCREMENT = 100;
-    public static readonly DEFAULT_MAX_STREAM_ID_BUFFER_SPACE = 28;
+    // the DEFAULT_MAX_STREAM_* values above are also how many streams the peer can have open at the same time: credit is given back as streams close
+    // a new MAX_STREAMS frame is sent once this fraction of that amount has become available again
+    public static readonly MAX_STREAMS_UPDATE_THRESHOLD = 0.5;
+
+    /**
+     * Receive window auto-tuning
+     */
+    public static readonly MAX_STREAM_RECEIVE_WINDOW = 6 * 1024 * 1024;
+    public static readonly MAX_CONNECTION_RECEIVE_WINDOW = 15 * 1024 * 1024;
+    // the connection's window is kept at least this much larger than the largest stream window, so a single stream is never blocked on it
+    public static readonly CONNECTION_TO_STREAM_WINDOW_RATIO = 1.5;
+    // sum of all connection windows in this process, i.e., how much memory our peers can make us use in total
+    public static readonly GLOBAL_RECEIVE_WINDOW_BUDGET = 512 * 1024 * 1024;
+    // we send a window update (MAX_DATA/MAX_STREAM_DATA) once this fraction of the window has been used
+    public static readonly RECEIVE_WINDOW_UPDATE_THRESHOLD = 0.5;
+
+    /**
+     * QuicStream.write() returns false once this many bytes are waiting in the stream's send buffer (like NodeJS's writable highWaterMark)
+     */
+    public static readonly DEFAULT_STREAM_HIGH_WATER_MARK = 64 * 1024;
 
     /**
      * Initial packet must be at least 1200 octets
@@ -93,6 +113,17 @@ export class Constants {
 
     public static readonly MAXIMUM_CLOSE_FRAME_SEND = 5;
 
+    /**
+     * ACK policy
+     */
+    // amount of ack-eliciting packets we can receive before we have to send an ACK (RFC recommends 2)
+    public static readonly DEFAULT_ACK_ELICITING_THRESHOLD = 2;
+    // delayed ACK extension (ACK_FREQUENCY frames): if true, we let our peer tune our ACK rate and ask it to lower its own ACK rate if it supports it
+    // off by default: the extension is still an experimental draft
+    public static readonly ACK_FREQUENCY_ENABLED: boolean = false;
+    // amount of ack-eliciting packets we ask the peer to wait for before ACKing, if it supports the delayed ACK extension
+    public static readonly ACK_FREQUENCY_PACKET_TOLERANCE = 10;
+
     /**
      * Method for testing purposes only
      */
@@ -113,4 +144,22 @@ export class Constants {
      * HTTP/3
      */
     public static EXPOSED_SERVER_DIR?: string; // subdirectory of public/ that will be exposed to clients, just exposes public/ if left undefined
+    // files are read (and framed as DATA) in pieces of this size, while they are being sent (see Http3FileSource)
+    public static readonly HTTP3_FILE_CHUNK_SIZE = 16 * 1024;
+    // static files are kept in memory (see Http3StaticCache) up to this total size, least recently used ones are dropped first
+    public static readonly HTTP3_STATIC_CACHE_SIZE = 64 * 1024 * 1024;
+    // larger files only get their headers cached, their contents are still streamed from disk
+    public static readonly HTTP3_STATIC_CACHE_MAX_FILE_SIZE = 1024 * 1024;
+    // each entry keeps a file watcher open, so also limit the amount of entries
+    public static readonly HTTP3_STATIC_CACHE_MAX_ENTRIES = 2048;
+    // at most this many resources are pushed along with a single response (see Http3Server:setPushEnabled)
+    public static readonly HTTP3_MAX_PUSHES_PER_RESPONSE = 8;
+    // Http3ClientPool: connections it opens to every origin
+    public static readonly HTTP3_POOL_CONNECTIONS_PER_ORIGIN = 4;
+    // lost connections are replaced after this long (ms), doubled for every consecutive connection that failed before it was established
+    public static readonly HTTP3_POOL_RECONNECT_DELAY = 100;
+    public static readonly HTTP3_POOL_MAX_RECONNECT_DELAY = 10 * 1000;
+    // requests are sent again when their connection is lost, at most this many times in total. Also the amount of consecutive failed
+    // connection attempts after which the requests waiting for an origin are given up on
+    public static readonly HTTP3_POOL_MAX_ATTEMPTS = 3;
 }
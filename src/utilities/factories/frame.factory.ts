@@ -13,6 +13,7 @@ import { ConnectionCloseFrame, ApplicationCloseFrame } from '../../frame/close';
 import { MaxStreamIdFrame } from '../../frame/max.stream.id';
 import { StreamIdBlockedFrame } from '../../frame/stream.id.blocked';
 import { AckBlock, AckFrame } from '../../frame/ack';
+import { AckFrequencyFrame } from '../../frame/ack.frequency';
 import { ConnectionID } from '../../packet/header/header.properties';
 import { NewConnectionIdFrame } from '../../frame/new.connection.id';
 import { StopSendingFrame } from '../../frame/stop.sending';
@@ -23,11 +24,11 @@ import { FrameType } from '../../frame/base.frame';
 
 export class FrameFactory {
 
-    public static createStreamFrame(streamId: Bignum, data: Buffer, fin: boolean, len: boolean, offset?: Bignum): StreamFrame {
+    public static createStreamFrame(streamId: Bignum, data: Buffer | Buffer[], fin: boolean, len: boolean, offset?: Bignum): StreamFrame {
         var streamFrame = new StreamFrame(streamId, data);
         streamFrame.setFin(fin);
         if (len) {
-            streamFrame.setLength(new Bignum(data.byteLength));
+            streamFrame.setLength(new Bignum(streamFrame.getDataLength()));
         }
         if (offset !== undefined) {
             streamFrame.setOffset(offset);
@@ -89,6 +90,10 @@ export class FrameFactory {
         return new AckFrame(containsECNinfo, largestAck, ackDelay, ackBlockCount, firstAckBlock, ackBlocks);
     }
 
+    public static createAckFrequencyFrame(sequenceNumber: Bignum, packetTolerance: Bignum, updateMaxAckDelay: Bignum, ignoreOrder: boolean): AckFrequencyFrame {
+        return new AckFrequencyFrame(sequenceNumber, packetTolerance, updateMaxAckDelay, ignoreOrder);
+    }
+
     public static createStopSendingFrame(streamID: Bignum, applicationErrorCode: number): StopSendingFrame {
         return new StopSendingFrame(streamID, applicationErrorCode);
     }
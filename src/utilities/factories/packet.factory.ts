@@ -54,34 +54,25 @@ export class PacketFactory {
         var header = new LongHeader(LongHeaderType.Initial, dstConnectionID, connection.getSrcConnectionID(), new Bignum(0), connection.getVersion(), Buffer.alloc(0));
         var initial = new InitialPacket(header, frames);
 
-        let ackOnly:boolean = true;
-        for( let frame of frames ){
-            if( frame.getType() != FrameType.ACK ){
-                ackOnly = false;
-                break;
-            }
-        }
-
-        // for security purposes, we want our initial packet to always be the exact same size (1280 bytes)
-        // so we add PADDING frames to reach that size if the encrypted initial packet isn't long enough. 
-        // https://tools.ietf.org/html/draft-ietf-quic-transport#section-4.4.1
-        var size = initial.getSize();
-        //if( initial.getFrames()[0].getType() == FrameType.CRYPTO ){
-        //    let crypto = <CryptoFrame> initial.getFrames()[0];
-        //    console.log("Creating Initial packet, Longheader + Crypto size was ", size, crypto.toBuffer().byteLength, crypto.getLength(), crypto.getData().byteLength);
-        //}
-
-        // TODO: it's also allowed to fill this with 0-RTT request (not as frame in the initial packet, but as a coalesced 0-RTT quic packet in the same QUIC datagram)
-        // , which we currently don't support, but which would be much better!
-        // the first Initial packet sent by the client has to be padded to 1200 bytes (to prevent amplification attacks)
-        if (size < Constants.INITIAL_MIN_SIZE && connection.getEndpointType() == EndpointType.Client && !ackOnly ) {
-            var padding = new PaddingFrame(Constants.INITIAL_MIN_SIZE - size);
-            initial.getFrames().push(padding);
-        }
+        // NOTE: the first Initial packet sent by the client has to be padded to 1200 bytes (to prevent amplification attacks)
+        // This is not done here, but when the packet is put in a UDP datagram, since it's the datagram that needs to be large enough: 
+        // the Initial packet can share it with other (e.g., 0-RTT) packets instead of being padded. See padInitialPacket and CongestionControl:sendPackets
+        // https://tools.ietf.org/html/draft-ietf-quic-transport#section-14
         header.setPayloadLength(initial.getFrameSizes() + Constants.DEFAULT_AEAD_LENGTH);
         return initial;
     }
 
+    /**
+     * Adds PADDING to an Initial packet so its encrypted size grows by (at least) paddingSize bytes
+     */
+    public static padInitialPacket(initial: InitialPacket, paddingSize: number) {
+        if( paddingSize <= 0 )
+            return;
+
+        initial.getFrames().push( new PaddingFrame(paddingSize) );
+        (<LongHeader>initial.getHeader()).setPayloadLength(initial.getFrameSizes() + Constants.DEFAULT_AEAD_LENGTH);
+    }
+
     /**
      *  Method to create a Server Stateless Retry Packet, given the connection
      * 
@@ -5,6 +5,7 @@ import { Connection } from '../../quicker/connection';
 import { Bignum } from '../../types/bignum';
 import { BasePacket, PacketType } from '../../packet/base.packet';
 import { AckFrame, AckBlock } from '../../frame/ack';
+import { AckFrequencyFrame } from '../../frame/ack.frequency';
 import { TimeFormat, Time } from '../../types/time';
 import { TransportParameterId } from '../../crypto/transport.parameters';
 import { Alarm, AlarmEvent } from '../../types/alarm';
@@ -17,25 +18,49 @@ import { FrameFactory } from '../factories/frame.factory';
 
 
 interface ReceivedPacket {
+    packetNumber: Bignum,
     time: Time, // TODO: REFACTOR: replace with timestamp instead of Time Object to reduce memory? 
     ackOnly: boolean // TODO: potentially even use MSB of timestamp to encode ack or not? (highly unlikely server will run for years on end)
 }
 
+// ACK policy:
+// - non-ack-eliciting packets (e.g., ACK-only) are never acked on their own, only together with ack-eliciting ones
+// - Initial and Handshake packets are acked immediately, since the handshake can't progress without them
+// - 0/1-RTT packets are acked after ackElicitingThreshold ack-eliciting packets, or after our max_ack_delay, whichever comes first
+// - out-of-order packets (filling or creating a gap) are acked immediately, so the peer's loss detection can kick in sooner
+// The threshold, max delay and reordering behaviour can be tuned by the peer with ACK_FREQUENCY frames (delayed ACK extension)
 export class AckHandler {
 
     public DEBUGname = "";
 
-    private receivedPackets: { [key: string]: ReceivedPacket };
-    private largestPacketNumber!: Bignum;
+    // packets we still have to ACK, sorted by packet number (they mostly arrive in order, so inserting is usually just appending)
+    private receivedPackets: ReceivedPacket[];
+    private largestPacketNumber?: Bignum;
+    // the largest packet number acked by one of our ACK frames that the peer acked in turn: everything up to it is no longer acked (see onPacketAcked)
+    private largestAckAcked?: Bignum;
     private alarm: Alarm;
-    private ackablePacketsSinceLastAckFrameSent: number = 0; // count of ACK-able packets we have received since the last time we've sent an ACK frame
-    private totalPacketsSinceLastAckFrameSent: number = 0;
-    // ack wait in ms
-    private static readonly ACK_WAIT = 15;
-
-    public constructor(connection: Connection) {
-        this.receivedPackets = {};
-        this.alarm = new Alarm();
+
+    private isApplicationSpace: boolean;
+    // amount of ack-eliciting packets we can receive before we have to send an ACK
+    private ackElicitingThreshold: number;
+    // maximum time we wait before sending an ACK, in ms. If undefined, our own max_ack_delay transport parameter is used
+    private maxAckDelay?: number;
+    // if true, out-of-order packets don't trigger an immediate ACK
+    private ignoreOrder: boolean;
+    private lastAckFrequencySequenceNumber?: Bignum;
+
+    private ackElicitingPacketsSinceLastAckFrameSent: number = 0; // count of ACK-eliciting packets we have received since the last time we've sent an ACK frame
+    private ackImmediately: boolean = false; // true if the next packet we send should contain an ACK frame
+
+    public constructor(connection: Connection, isApplicationSpace: boolean = false) {
+        this.receivedPackets = [];
+        this.isApplicationSpace = isApplicationSpace;
+        this.ackElicitingThreshold = Constants.DEFAULT_ACK_ELICITING_THRESHOLD;
+        this.ignoreOrder = false;
+        this.alarm = new Alarm(connection.getTimerWheel());
+        this.alarm.on(AlarmEvent.TIMEOUT, () => {
+            this.onAlarm(connection);
+        });
     }
 
     // transformation from ACK frame contents to actual sent packets for our endpoint is done by the caller of this function
@@ -69,28 +94,28 @@ export class AckHandler {
         //          - this.receivedPackets is the "list of things to be ACKed" and still contains this nr. 5
         //          - since our ACK for received packet 5 was successfully received by the peer (as they have ACKed our packet nr. 20 in turn), we can safely remove it
 
-        // TODO: here, we keep ACKing older packets indefinitely
-        // in the spec, it says that upon reception of ACK-of-an-ACK (packet nr. 6 above), we can stop sending everything below the highest ACKed number
-        //  -> e.g., if our packet 20 had also acked packet 7 next to 5, we could drop everything below and 7 including 
-        //  see draft-15#4.4.3
+        // upon reception of ACK-of-an-ACK (packet nr. 6 above), we stop acking everything up to and including the largest number our ACK frame acked
+        //  -> e.g., if our packet 20 had also acked packet 7 next to 5, we drop everything up to and including 7
+        //  see draft-20#13.2.3 (this keeps our ACK frames small, even if the peer only sends ACK-only packets, which are never acked in turn)
 
         let sentPacket = <BaseEncryptedPacket>sentPacketIn;
 
         sentPacket.getFrames().forEach((frame: BaseFrame) => {
             if (frame.getType() === FrameType.ACK) {
                 let ackFrame = <AckFrame>frame;
-                let packetNumbers = ackFrame.determineAckedPacketNumbers();
-                VerboseLogging.info(this.DEBUGname + " ackHandler:onPacketAcked Sent Packet " + sentPacket.getHeader().getPacketNumber()!.getValue().toNumber() + " was acked by peer and contained ACKs for received packets " + (packetNumbers.map((val, idx, arr) => val.toNumber())).join(",") );
-
-                packetNumbers.forEach((packetNumber: Bignum) => {
-                    if (this.receivedPackets[packetNumber.toString('hex', 8)] !== undefined) {
-                        delete this.receivedPackets[packetNumber.toString('hex', 8)];
-                        VerboseLogging.info(this.DEBUGname + " ackHandler:onPacketAcked Received packet " + packetNumber.toNumber() + " is now removed from 'list of things to ack'" );
-                    }
-                    else{
-                        VerboseLogging.info(this.DEBUGname + " ackHandler:onPacketAcked Packet " + packetNumber.toNumber() + " was no longer in this.receivedPackets, previously acked?");
-                    }
-                });
+                let largestAcked = ackFrame.getLargestAcknowledged();
+                VerboseLogging.info(this.DEBUGname + " ackHandler:onPacketAcked Sent Packet " + sentPacket.getHeader().getPacketNumber()!.getValue().toNumber() + " was acked by peer and contained ACKs for received packets up to " + largestAcked.toNumber() );
+
+                // an older ACK frame being acked late doesn't tell us anything new
+                if (this.largestAckAcked !== undefined && largestAcked.lessThanOrEqual(this.largestAckAcked))
+                    return;
+                this.largestAckAcked = largestAcked;
+
+                // receivedPackets is sorted, so the packets to drop are all at the front
+                let dropCount = 0;
+                while (dropCount < this.receivedPackets.length && this.receivedPackets[dropCount].packetNumber.lessThanOrEqual(largestAcked))
+                    ++dropCount;
+                this.receivedPackets.splice(0, dropCount);
             }
         });
     }
@@ -102,75 +127,134 @@ export class AckHandler {
         }
         var header = packet.getHeader();
         var pn = header.getPacketNumber()!.getValue();
-        if (this.largestPacketNumber === undefined ||  pn.greaterThan(this.largestPacketNumber)) {
+
+        let outOfOrder = this.isOutOfOrder(pn);
+        if (this.largestPacketNumber === undefined || pn.greaterThan(this.largestPacketNumber)) {
             this.largestPacketNumber = pn;
         }
         
-        this.receivedPackets[pn.toString('hex', 8)] = {time: time, ackOnly: packet.isAckOnly()};
+        this.addReceivedPacket({packetNumber: pn, time: time, ackOnly: packet.isAckOnly()});
 
-        VerboseLogging.info(this.DEBUGname + " AckHandler:onPacketReceived : added packet " + pn.toNumber() + ", ackOnly=" + packet.isAckOnly() );
+        VerboseLogging.info(this.DEBUGname + " AckHandler:onPacketReceived : added packet " + pn.toNumber() + ", ackOnly=" + packet.isAckOnly() + ", outOfOrder=" + outOfOrder );
 
-        ++this.totalPacketsSinceLastAckFrameSent;
-
-        // we should only separately ACK packets containing other stuff than other ACKs and padding
+        // we should only ACK packets containing other stuff than ACKs and padding
         // the other packets should be acked (so are in this.receivedPackets) but only together with "real" packets
-        if( !packet.isAckOnly() && !packet.isPaddingOnly() ){
-            ++this.ackablePacketsSinceLastAckFrameSent;
-            if( !this.alarm.isRunning() ){
-                this.setAlarm(connection); 
-                VerboseLogging.info(this.DEBUGname + " AckHandler:onPacketReceived : starting ACK alarm to trigger new ACK frame in " + this.alarm.getDuration() + "ms. " + this.ackablePacketsSinceLastAckFrameSent + " ACK-able packets outstanding.");
-            }
+        if (!packet.isRetransmittable()) {
+            return;
         }
-        else if( this.ackablePacketsSinceLastAckFrameSent == 0 ){
-            this.alarm.reset(); // this SHOULDN'T be running, but just to make sure, let's reset it, ok?
-            VerboseLogging.info(this.DEBUGname + " AckHandler:onPacketReceived : no ACK-able packets outstanding, stopping ACK alarm. Total ack-only outstanding: " + this.totalPacketsSinceLastAckFrameSent);
+
+        ++this.ackElicitingPacketsSinceLastAckFrameSent;
+
+        let reason: string | undefined = undefined;
+        if (!this.isApplicationSpace)
+            reason = "handshake";
+        else if (outOfOrder && !this.ignoreOrder)
+            reason = "out-of-order";
+        else if (this.ackElicitingPacketsSinceLastAckFrameSent >= this.ackElicitingThreshold)
+            reason = "threshold of " + this.ackElicitingThreshold + " reached";
+
+        if (reason !== undefined) {
+            // we don't send right away: we're still processing the packet, and others from the same datagram/burst may follow
+            // if we send something before the alarm fires (e.g., a response to this packet), the ACK is included there
+            this.ackImmediately = true;
+            this.alarm.start(0);
+            VerboseLogging.info(this.DEBUGname + " AckHandler:onPacketReceived : ACK frame needed asap: " + reason);
+        }
+        else if (!this.alarm.isRunning()) {
+            this.alarm.start(this.getAckDelayTimeout(connection));
+            VerboseLogging.info(this.DEBUGname + " AckHandler:onPacketReceived : starting ACK alarm to trigger new ACK frame in " + this.alarm.getDuration() + "ms. " + this.ackElicitingPacketsSinceLastAckFrameSent + " ACK-eliciting packets outstanding.");
         }
     }
 
+    private addReceivedPacket(receivedPacket: ReceivedPacket): void {
+        // find the first entry with a packet number that isn't smaller, searching from the back (that's where new packets go)
+        let index = this.receivedPackets.length;
+        while (index > 0 && this.receivedPackets[index - 1].packetNumber.greaterThanOrEqual(receivedPacket.packetNumber))
+            --index;
 
+        if (index < this.receivedPackets.length && this.receivedPackets[index].packetNumber.equals(receivedPacket.packetNumber))
+            this.receivedPackets[index] = receivedPacket; // duplicate
+        else
+            this.receivedPackets.splice(index, 0, receivedPacket);
+    }
 
-    public getAckFrame(connection: Connection): AckFrame | undefined {
+    // a packet is out of order if it fills a gap (lower than the largest we've seen) or creates a new one (skips a number)
+    private isOutOfOrder(packetNumber: Bignum): boolean {
+        if (this.largestPacketNumber === undefined)
+            return false;
+
+        return packetNumber.lessThan(this.largestPacketNumber) || packetNumber.greaterThan(this.largestPacketNumber.add(1));
+    }
+
+    private getAckDelayTimeout(connection: Connection): number {
+        let maxAckDelay: number = this.maxAckDelay !== undefined ? this.maxAckDelay : 
+                                  (connection.getLocalTransportParameters() === undefined ? Constants.DEFAULT_MAX_ACK_DELAY : connection.getLocalTransportParameter(TransportParameterId.MAX_ACK_DELAY));
+
+        // the timer wheel can fire up to a tick late, and we promised the peer never to go over max_ack_delay
+        return Math.max(0, maxAckDelay - 1);
+    }
+
+    /**
+     * Applies an ACK_FREQUENCY frame from the peer (delayed ACK extension). Only valid for the 0/1-RTT packet number space.
+     */
+    public onAckFrequencyReceived(connection: Connection, frame: AckFrequencyFrame): void {
+        // frames can arrive out of order or be retransmitted: only the newest one counts
+        if (this.lastAckFrequencySequenceNumber !== undefined && frame.getSequenceNumber().lessThanOrEqual(this.lastAckFrequencySequenceNumber)) {
+            VerboseLogging.info(this.DEBUGname + " AckHandler:onAckFrequencyReceived : ignoring old ACK_FREQUENCY frame " + frame.getSequenceNumber().toNumber());
+            return;
+        }
+        this.lastAckFrequencySequenceNumber = frame.getSequenceNumber();
+
+        this.ackElicitingThreshold = Math.max(1, frame.getPacketTolerance().toNumber());
+        // the peer should never ask for less than our min_ack_delay, but let's make sure
+        let minAckDelay = connection.getLocalTransportParameter(TransportParameterId.MIN_ACK_DELAY);
+        this.maxAckDelay = Math.max(frame.getUpdateMaxAckDelay().toNumber(), minAckDelay) / 1000; // frame uses MICROseconds, we use MILLIseconds
+        this.ignoreOrder = frame.getIgnoreOrder();
+
+        VerboseLogging.info(this.DEBUGname + " AckHandler:onAckFrequencyReceived : ACK policy is now threshold=" + this.ackElicitingThreshold + ", maxAckDelay=" + this.maxAckDelay + "ms, ignoreOrder=" + this.ignoreOrder);
+    }
+
+    /**
+     * @param piggyback true if the caller is sending an ack-eliciting packet in this packet number space anyway. 
+     *                  An ACK frame is then also generated if it's not due yet, as long as there are new ack-eliciting packets to ACK.
+     */
+    public getAckFrame(connection: Connection, piggyback: boolean = false): AckFrame | undefined {
 
         VerboseLogging.trace(this.DEBUGname + " AckHandler:getAckFrame: START");
 
-        // we only want to generate ACK frames if we have actual ACK-able packets
-        // e.g., for ACK-only or PADDING-only packets, we don't want to generate ACK frames
-        // TODO: FIXME: limit of 10 is -very- arbitrary and shouldn't even be needed (everything should work without acks of acks), but as a quick fix, this should work
-        if( this.totalPacketsSinceLastAckFrameSent < 10 && this.ackablePacketsSinceLastAckFrameSent == 0 ){
-            VerboseLogging.trace(this.DEBUGname + " AckHandler:getAckFrame: no new ACK-able packets received since last ACK frame, not generating new one");
+        // we only want to generate ACK frames if the ACK policy says so (see onPacketReceived)
+        // e.g., for ACK-only or PADDING-only packets, we never generate ACK frames
+        let ackDue = this.ackImmediately || (piggyback && this.ackElicitingPacketsSinceLastAckFrameSent > 0);
+        if( !ackDue || this.receivedPackets.length === 0 ){
+            VerboseLogging.trace(this.DEBUGname + " AckHandler:getAckFrame: no ACK frame due yet, not generating new one");
             return undefined;
         }
 
-        this.ackablePacketsSinceLastAckFrameSent = 0; // we always ACK all newly received packets
-        this.totalPacketsSinceLastAckFrameSent = 0;
+        this.ackElicitingPacketsSinceLastAckFrameSent = 0; // we always ACK all newly received packets
+        this.ackImmediately = false;
 
         this.alarm.reset();
         /*
         if (Object.keys(this.receivedPackets).length === 0 || this.onlyAckPackets()) {
-            VerboseLogging.trace(this.DEBUGname + " AckHandler:getAckFrame: no ack frame to generate : " + Object.keys(this.receivedPackets).length + " || " + this.onlyAckPackets());
+            VerboseLogging.trace(this.DEBUGname + " AckHandler:getAckFrame: no ack frame to generate : " + this.receivedPackets.length + " || " + this.onlyAckPackets());
             return undefined;
         }
         */
 
+        // the peer decodes our ack_delay with the exponent WE advertised
         if (connection.getQuicTLS().getHandshakeState() === HandshakeState.COMPLETED) {
-            var ackDelayExponent: number = connection.getRemoteTransportParameter(TransportParameterId.ACK_DELAY_EXPONENT);
+            var ackDelayExponent: number = connection.getLocalTransportParameter(TransportParameterId.ACK_DELAY_EXPONENT);
         } else {
             var ackDelayExponent: number = Constants.DEFAULT_ACK_DELAY_EXPONENT;
         }
 
-        // TODO: optimize: store largestPacketNumber timing separately so we don't need to do hashmap lookup
-        // in that case, we can simply remove the timing from the hashmap alltogether? 
-        var ackDelay = Time.now(this.receivedPackets[this.largestPacketNumber.toString('hex', 8)].time).format(TimeFormat.MicroSeconds);
-        ackDelay = ackDelay / (2 ** ackDelayExponent);
+        // receivedPackets is sorted: largest first for the ACK frame
+        var packetnumbers: Bignum[] = this.receivedPackets.map((receivedPacket: ReceivedPacket) => receivedPacket.packetNumber).reverse();
+        // NOTE: this is not necessarily this.largestPacketNumber: that one can already have been removed after an ACK-of-ACK (see onPacketAcked)
+        var latestPacketNumber = packetnumbers[0];
 
-        var packetnumbers: Bignum[] = [];
-        Object.keys(this.receivedPackets).forEach((key) => packetnumbers.push(new Bignum(Buffer.from(key, 'hex'))));
-        packetnumbers.sort((a: Bignum, b: Bignum) => {
-            return a.compare(b);
-        });
-        packetnumbers.reverse();
-        var latestPacketNumber = this.largestPacketNumber;
-        var largestAckedTime = this.receivedPackets[this.largestPacketNumber.toString('hex', 8)];
+        var ackDelay = Time.now(this.receivedPackets[this.receivedPackets.length - 1].time).format(TimeFormat.MicroSeconds);
+        ackDelay = Math.floor(ackDelay / (2 ** ackDelayExponent));
 
         var ackBlockCount = 0;
         var blocks = [];
@@ -225,24 +309,19 @@ export class AckHandler {
         return ackFrame;
     }
 
-    private setAlarm(connection: Connection) {
-        this.alarm.on(AlarmEvent.TIMEOUT, () => {
-            VerboseLogging.debug(this.DEBUGname + " >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>////////////////////////////// AckHandler: ON ALARM "+ this.DEBUGname +" //////////////////////////////// ");
-            var ackFrame = this.getAckFrame(connection);
-            if (ackFrame !== undefined) {
-                connection.queueFrame(ackFrame);
-            }
-            VerboseLogging.debug(this.DEBUGname + " <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<////////////////////////////// AckHandler: END ALARM "+ this.DEBUGname +" //////////////////////////////// " + ackFrame);
-
-        });
-        this.alarm.start(AckHandler.ACK_WAIT);
+    private onAlarm(connection: Connection) {
+        VerboseLogging.debug(this.DEBUGname + " >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>////////////////////////////// AckHandler: ON ALARM "+ this.DEBUGname +" //////////////////////////////// ");
+        // don't queue the ACK frame ourselves: FlowControl knows which packet type goes with our packet number space and fetches it from getAckFrame
+        this.ackImmediately = true;
+        connection.sendPackets();
+        VerboseLogging.debug(this.DEBUGname + " <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<////////////////////////////// AckHandler: END ALARM "+ this.DEBUGname +" //////////////////////////////// ");
     }
 
     /*
     private onlyAckPackets(): boolean {
         var ackOnly = true;
-        Object.keys(this.receivedPackets).forEach((key: string) => {
-            if (!this.receivedPackets[key].ackOnly) {
+        this.receivedPackets.forEach((receivedPacket: ReceivedPacket) => {
+            if (!receivedPacket.ackOnly) {
                 ackOnly = false;
             }
         });
@@ -259,8 +338,11 @@ export class AckHandler {
     */
 
     public reset(): void {
-        this.receivedPackets = {};
+        this.receivedPackets = [];
         this.alarm.reset();
-        this.largestPacketNumber = new Bignum(-1);
+        this.largestPacketNumber = undefined;
+        this.largestAckAcked = undefined;
+        this.ackElicitingPacketsSinceLastAckFrameSent = 0;
+        this.ackImmediately = false;
     }
 }
\ No newline at end of file
@@ -15,6 +15,7 @@ import {StreamIdBlockedFrame} from '../../frame/stream.id.blocked';
 import {NewConnectionIdFrame} from '../../frame/new.connection.id';
 import {StopSendingFrame} from '../../frame/stop.sending';
 import {AckFrame} from '../../frame/ack';
+import {AckFrequencyFrame} from '../../frame/ack.frequency';
 import {CryptoFrame} from '../../frame/crypto';
 import {StreamFrame} from '../../frame/stream';
 import {PacketFactory} from '../factories/packet.factory';
@@ -109,6 +110,10 @@ export class FrameHandler {
                 let cryptoFrame:CryptoFrame = <CryptoFrame>frame;
                 this.handleCryptoFrame(connection, cryptoFrame);
                 break;
+            case FrameType.ACK_FREQUENCY:
+                let ackFrequencyFrame:AckFrequencyFrame = <AckFrequencyFrame>frame;
+                this.handleAckFrequencyFrame(connection, ackFrequencyFrame);
+                break;
         }
         if (frame.getType() >= FrameType.STREAM && frame.getType() <= FrameType.STREAM_MAX_NR) {
             var streamFrame = <StreamFrame>frame;
@@ -121,12 +126,16 @@ export class FrameHandler {
         if (Stream.isSendOnly(connection.getEndpointType(), streamId)) {
             throw new QuicError(ConnectionErrorCodes.PROTOCOL_VIOLATION);
         }
+        if (connection.getStreamManager().isRetiredStream(streamId)) {
+            return;
+        }
         var stream = connection.getStreamManager().getStream(rstStreamFrame.getStreamId());
         if (stream.getStreamState() === StreamState.Open) {
             stream.setStreamState(StreamState.RemoteClosed);
         } else if (stream.getStreamState() === StreamState.LocalClosed) {
             stream.setStreamState(StreamState.Closed);
         }
+        stream.onResetReceived();
     }
     private handleConnectionCloseFrame(connection: Connection, connectionCloseFrame: ConnectionCloseFrame) {
         // incoming connectionclose means that the other endpoint is already in its closing state.
@@ -174,19 +183,28 @@ export class FrameHandler {
         if (Stream.isSendOnly(connection.getEndpointType(), streamId) && !connection.getStreamManager().hasStream(streamId)) {
             throw new QuicError(ConnectionErrorCodes.PROTOCOL_VIOLATION);
         }
+        if (connection.getStreamManager().isRetiredStream(streamId)) {
+            return;
+        }
 
         var stream = connection.getStreamManager().getStream(maxDataStreamFrame.getStreamId());
         if (stream.getSendAllowance().lessThan(maxDataStreamFrame.getMaxData())) {
             stream.setSendAllowance(maxDataStreamFrame.getMaxData());
             stream.setBlockedSent(false);
+            connection.getStreamManager().activateStream(stream);
         }
     }
 
     private handleMaxStreamIdFrame(connection: Connection, maxStreamIdFrame: MaxStreamIdFrame) {
-        if (maxStreamIdFrame.getMaxStreamId().and(new Bignum(0x2)).equals(new Bignum(2))) {
-            connection.setRemoteMaxStreamUni(maxStreamIdFrame.getMaxStreamId());
+        // the frame carries a stream count, we keep it as a stream ID limit (same as for the transport parameters, see Connection:setRemoteTransportParameters)
+        if (maxStreamIdFrame.getType() === FrameType.MAX_STREAMS_UNI) {
+            if (maxStreamIdFrame.getMaxStreamId().multiply(4).greaterThan(connection.getRemoteMaxStreamUni())) {
+                connection.setRemoteMaxStreamUni(maxStreamIdFrame.getMaxStreamId().multiply(4));
+            }
         } else {
-            connection.setRemoteMaxStreamBidi(maxStreamIdFrame.getMaxStreamId());
+            if (maxStreamIdFrame.getMaxStreamId().multiply(4).greaterThan(connection.getRemoteMaxStreamBidi())) {
+                connection.setRemoteMaxStreamBidi(maxStreamIdFrame.getMaxStreamId().multiply(4));
+            }
         }
     }
 
@@ -205,7 +223,12 @@ export class FrameHandler {
         }
 
         var streamId = streamBlocked.getStreamId()
-        connection.getStreamManager().getStream(streamId).setPeerBlocked(true);
+        if (connection.getStreamManager().isRetiredStream(streamId)) {
+            return;
+        }
+        let stream = connection.getStreamManager().getStream(streamId);
+        stream.setPeerBlocked(true);
+        connection.getStreamManager().markReceiveStateChanged(stream);
     }
 
     private handleStreamIdBlockedFrame(connection: Connection, streamIdBlockedFrame: StreamIdBlockedFrame) {
@@ -225,6 +248,9 @@ export class FrameHandler {
         if (Stream.isReceiveOnly(connection.getEndpointType(), streamId)) {
             throw new QuicError(ConnectionErrorCodes.PROTOCOL_VIOLATION)
         }
+        if (connection.getStreamManager().isRetiredStream(streamId)) {
+            return;
+        }
 
         var stream = connection.getStreamManager().getStream(stopSendingFrame.getStreamId());
         if (stream.getStreamState() === StreamState.Open) {
@@ -247,6 +273,17 @@ export class FrameHandler {
     
     }
 
+    private handleAckFrequencyFrame(connection: Connection, ackFrequencyFrame: AckFrequencyFrame) {
+        // peer shouldn't send these if we didn't advertise min_ack_delay, but being lenient doesn't hurt here: we can just ignore them
+        if (!Constants.ACK_FREQUENCY_ENABLED) {
+            VerboseLogging.warn("FrameHandler:handleAckFrequencyFrame : received ACK_FREQUENCY frame, but we don't support the delayed ACK extension. Ignoring.");
+            return;
+        }
+
+        // can only be sent in 1-RTT packets, so always applies to the 0/1-RTT packet number space
+        connection.getEncryptionContext( EncryptionLevel.ONE_RTT )!.getAckHandler().onAckFrequencyReceived( connection, ackFrequencyFrame );
+    }
+
     private handlePathChallengeFrame(connection: Connection, pathChallengeFrame: PathChallengeFrame) {
         var pathResponse = FrameFactory.createPathResponseFrame(pathChallengeFrame.getData());
         connection.queueFrame(pathResponse);
@@ -270,7 +307,15 @@ export class FrameHandler {
             throw new QuicError(ConnectionErrorCodes.PROTOCOL_VIOLATION, "Receiving data on send-only stream " + streamId.toDecimalString() );
         }
 
+        if (connection.getStreamManager().isRetiredStream(streamId)) {
+            // the stream was already done in both directions, so this can only be a retransmit of data we already have
+            VerboseLogging.debug("FrameHandler:handleStreamFrame : ignoring data for retired stream " + streamId.toDecimalString() );
+            return;
+        }
+
         let stream = connection.getStreamManager().getStream(streamId);
+        // marked first: if this data finishes the stream, it's retired (and unmarked again) during receiveData
+        connection.getStreamManager().markReceiveStateChanged(stream);
         stream.receiveData(streamFrame.getData(), streamFrame.getOffset(), streamFrame.getFin());
     }
 }
\ No newline at end of file
@@ -546,6 +546,11 @@ export class QlogWrapper{
     }
 
     public onHTTPFrame_Data(frame:Http3DataFrame, trigger:("TX"|"RX")){
+        this.onHTTPFrame_DataLength(frame.getEncodedLength(), trigger);
+    }
+
+    // for DATA frames that are passed on piece by piece, before their whole payload is there (see Http3StreamFrameParser)
+    public onHTTPFrame_DataLength(payloadLength:number, trigger:("TX"|"RX")){
 
         let evt:any = [
             123, 
@@ -553,7 +558,7 @@ export class QlogWrapper{
             "DATA_FRAME_NEW",
             trigger,
             {
-                payload_length: frame.getEncodedLength(),
+                payload_length: payloadLength,
             }
         ];
 
@@ -16,6 +16,7 @@ import {StopSendingFrame} from '../../frame/stop.sending';
 import {StreamFrame} from '../../frame/stream';
 import { AckBlock, AckFrame } from '../../frame/ack';
 import { PaddingFrame } from '../../frame/padding';
+import { AckFrequencyFrame } from '../../frame/ack.frequency';
 import { ConnectionErrorCodes } from '../errors/quic.codes';
 import { QuicError } from '../errors/connection.error';
 import { FrameFactory } from '../factories/frame.factory';
@@ -45,6 +46,12 @@ export class FrameParser {
             return undefined;
         }
         var type = buffer.readUInt8(offset++);
+        // frame types are varints: all core frames fit in a single byte, but extension frames (e.g., ACK_FREQUENCY) can be longer
+        if (type > 0x3f) {
+            var typeOffset = VLIE.decode(buffer, offset - 1);
+            type = typeOffset.value.toNumber();
+            offset = typeOffset.offset;
+        }
         VerboseLogging.trace("FrameParser:ParseFrame : type=" + FrameType[type] + ", length=" + buffer.byteLength);
         switch (type) {
             case FrameType.PADDING:
@@ -89,6 +96,8 @@ export class FrameParser {
                 return this.parseAck(true, buffer, offset);
             case FrameType.NEW_TOKEN:
                 return this.parseNewToken(buffer, offset);
+            case FrameType.ACK_FREQUENCY:
+                return this.parseAckFrequency(buffer, offset);
         }
         if (type >= FrameType.STREAM && type <= FrameType.STREAM_MAX_NR) {
             return this.parseStream(type, buffer, offset);
@@ -183,6 +192,18 @@ export class FrameParser {
         };
     }
 
+    private parseAckFrequency(buffer: Buffer, offset: number): FrameOffset {
+        var sequenceNumber = VLIE.decode(buffer, offset);
+        var packetTolerance = VLIE.decode(buffer, sequenceNumber.offset);
+        var updateMaxAckDelay = VLIE.decode(buffer, packetTolerance.offset);
+        offset = updateMaxAckDelay.offset;
+        var ignoreOrder = buffer.readUInt8(offset++) !== 0;
+        return {
+            frame: FrameFactory.createAckFrequencyFrame(sequenceNumber.value, packetTolerance.value, updateMaxAckDelay.value, ignoreOrder),
+            offset: offset
+        };
+    }
+
     private parseBlocked(buffer: Buffer, offset: number): FrameOffset {
         var blockedOffset = VLIE.decode(buffer, offset);
         return {